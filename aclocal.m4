@@ -1381,3 +1381,4 @@ m4_include([auxdir/x_ac_slurm_ssl.m4])
 m4_include([auxdir/x_ac_srun.m4])
 m4_include([auxdir/x_ac_sun_const.m4])
 m4_include([auxdir/x_ac_xcpu.m4])
+m4_include([auxdir/x_ac_zlib.m4])
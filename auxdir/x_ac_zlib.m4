@@ -0,0 +1,57 @@
+##*****************************************************************************
+#  SYNOPSIS:
+#    X_AC_ZLIB
+#
+#  DESCRIPTION:
+#    Determine if the zlib compression library exists. It is used by sbcast
+#    to optionally compress file blocks on the wire.
+##*****************************************************************************
+
+AC_DEFUN([X_AC_ZLIB],
+[
+  _x_ac_zlib_dirs="/usr /usr/local"
+  _x_ac_zlib_libs="lib64 lib"
+
+  AC_ARG_WITH(
+    [zlib],
+    AS_HELP_STRING(--with-zlib=PATH,Specify path to zlib installation),
+    [_x_ac_zlib_dirs="$withval $_x_ac_zlib_dirs"])
+
+  AC_CACHE_CHECK(
+    [for zlib installation],
+    [x_ac_cv_zlib_dir],
+    [
+      for d in $_x_ac_zlib_dirs; do
+        test -d "$d" || continue
+        test -d "$d/include" || continue
+        test -f "$d/include/zlib.h" || continue
+	for bit in $_x_ac_zlib_libs; do
+          test -d "$d/$bit" || continue
+          _x_ac_zlib_cppflags_save="$CPPFLAGS"
+          CPPFLAGS="-I$d/include $CPPFLAGS"
+ 	  _x_ac_zlib_libs_save="$LIBS"
+          LIBS="-L$d/$bit -lz $LIBS"
+          AC_LINK_IFELSE(
+            AC_LANG_CALL([], compress2),
+            AS_VAR_SET(x_ac_cv_zlib_dir, $d))
+          CPPFLAGS="$_x_ac_zlib_cppflags_save"
+          LIBS="$_x_ac_zlib_libs_save"
+          test -n "$x_ac_cv_zlib_dir" && break
+	done
+        test -n "$x_ac_cv_zlib_dir" && break
+      done
+    ])
+
+  if test -z "$x_ac_cv_zlib_dir"; then
+    AC_MSG_WARN([unable to locate zlib installation, sbcast compression disabled])
+  else
+    ZLIB_CPPFLAGS="-I$x_ac_cv_zlib_dir/include"
+    ZLIB_LDFLAGS="-L$x_ac_cv_zlib_dir/$bit"
+    ZLIB_LIBS="-lz"
+    AC_DEFINE(HAVE_ZLIB, 1, [Define to 1 if zlib library found])
+  fi
+
+  AC_SUBST(ZLIB_LIBS)
+  AC_SUBST(ZLIB_CPPFLAGS)
+  AC_SUBST(ZLIB_LDFLAGS)
+])
@@ -189,6 +189,8 @@ enum {
 	ESLURM_PARTITION_IN_USE,
 	ESLURM_STEP_LIMIT,
 	ESLURM_JOB_SUSPENDED,
+	ESLURM_RPC_RATE_LIMITED,
+	ESLURM_INVALID_JOB_COUNT,
 
 	/* switch specific error codes, specific values defined in plugin module */
 	ESLURM_SWITCH_MIN = 3000,
@@ -44,6 +44,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <grp.h>
+#include <pthread.h>
 #include <pwd.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -57,9 +58,12 @@
 
 #include "src/common/forward.h"
 #include "src/common/node_select.h"
+#include "src/common/macros.h"
+#include "src/common/pack.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_pack.h"
 #include "src/common/uid.h"
 #include "src/common/xstring.h"
 
@@ -832,12 +836,115 @@ line15:
 
 }
 
+/* Records of the last SHOW_DELTA response merged with those since */
+static pthread_mutex_t job_delta_lock = PTHREAD_MUTEX_INITIALIZER;
+static info_delta_msg_t *job_delta_cache = NULL;
+static uint16_t job_delta_flags = 0;
+
+/* Unpack merged delta records as a RESPONSE_JOB_INFO message */
+static int _job_delta_unpack(info_delta_msg_t *cache, job_info_msg_t **resp)
+{
+	slurm_msg_t msg;
+	Buf buffer;
+	uint32_t i;
+	int rc;
+
+	buffer = init_buf(BUF_SIZE);
+	pack32(cache->record_count, buffer);
+	pack_time(cache->last_update, buffer);
+	for (i = 0; i < cache->record_count; i++) {
+		packmem_array(cache->record_data[i], cache->record_size[i],
+			      buffer);
+	}
+	set_buf_offset(buffer, 0);
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = RESPONSE_JOB_INFO;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	rc = unpack_msg(&msg, buffer);
+	free_buf(buffer);
+	if (rc != SLURM_SUCCESS)
+		return SLURM_ERROR;
+	*resp = (job_info_msg_t *) msg.data;
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Load all jobs as slurm_load_jobs(), but transfer only the records changed
+ * since the previous SHOW_DELTA call and merge them into a copy kept here
+ */
+static int _load_jobs_delta(time_t update_time, job_info_msg_t **resp,
+			     uint16_t show_flags)
+{
+	int rc = SLURM_SUCCESS;
+	slurm_msg_t resp_msg;
+	slurm_msg_t req_msg;
+	job_info_request_msg_t req;
+
+	slurm_mutex_lock(&job_delta_lock);
+	if (job_delta_cache && (job_delta_flags != show_flags)) {
+		slurm_free_info_delta_msg(job_delta_cache);
+		job_delta_cache = NULL;
+	}
+	job_delta_flags = show_flags;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	if (job_delta_cache)
+		req.last_update = job_delta_cache->last_update;
+	else
+		req.last_update = (time_t) 0;
+	req.show_flags   = show_flags;
+	req_msg.msg_type = REQUEST_JOB_INFO;
+	req_msg.data     = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0) {
+		slurm_mutex_unlock(&job_delta_lock);
+		return SLURM_ERROR;
+	}
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_JOB_INFO_DELTA:
+		slurm_merge_info_delta(&job_delta_cache,
+				       (info_delta_msg_t *) resp_msg.data);
+		break;
+	case RESPONSE_JOB_INFO:
+		/* controller does not support deltas for this request */
+		slurm_free_info_delta_msg(job_delta_cache);
+		job_delta_cache = NULL;
+		slurm_mutex_unlock(&job_delta_lock);
+		*resp = (job_info_msg_t *) resp_msg.data;
+		return SLURM_PROTOCOL_SUCCESS;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		/* the caller's copy may be older than ours */
+		if ((rc == SLURM_NO_CHANGE_IN_DATA) && job_delta_cache &&
+		    (update_time < job_delta_cache->last_update))
+			rc = SLURM_SUCCESS;
+		break;
+	default:
+		rc = SLURM_UNEXPECTED_MSG_ERROR;
+		break;
+	}
+
+	if ((rc == SLURM_SUCCESS) && job_delta_cache)
+		rc = _job_delta_unpack(job_delta_cache, resp);
+	else if (rc == SLURM_SUCCESS)
+		rc = SLURM_UNEXPECTED_MSG_ERROR;
+	slurm_mutex_unlock(&job_delta_lock);
+	if (rc)
+		slurm_seterrno_ret(rc);
+	return SLURM_PROTOCOL_SUCCESS;
+}
+
 /*
  * slurm_load_jobs - issue RPC to get all job configuration
  *	information if changed since update_time
  * IN update_time - time of current configuration data
  * IN job_info_msg_pptr - place to store a job configuration pointer
- * IN show_flags -  job filtering option: 0, SHOW_ALL or SHOW_DETAIL
+ * IN show_flags -  job filtering option: 0, SHOW_ALL or SHOW_DETAIL,
+ *	plus SHOW_DELTA to transfer only jobs changed since the last call
  * RET 0 or -1 on error
  * NOTE: free the response using slurm_free_job_info_msg
  */
@@ -850,6 +957,9 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **resp,
 	slurm_msg_t req_msg;
 	job_info_request_msg_t req;
 
+	if (show_flags & SHOW_DELTA)
+		return _load_jobs_delta(update_time, resp, show_flags);
+
 	slurm_msg_t_init(&req_msg);
 	slurm_msg_t_init(&resp_msg);
 
@@ -924,6 +1034,55 @@ slurm_load_job (job_info_msg_t **resp, uint32_t job_id, uint16_t show_flags)
 	return SLURM_PROTOCOL_SUCCESS ;
 }
 
+/*
+ * slurm_load_job_user - issue RPC to get job information for the jobs of
+ *	one user and/or with one job name
+ * IN job_info_msg_pptr - place to store a job configuration pointer
+ * IN user_id - ID of user whose jobs we want, NO_VAL for any user
+ * IN job_name - name of jobs we want, NULL for any name
+ * IN show_flags -  job filtering option: 0, SHOW_ALL or SHOW_DETAIL
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_job_info_msg
+ */
+extern int
+slurm_load_job_user (job_info_msg_t **resp, uint32_t user_id, char *job_name,
+		     uint16_t show_flags)
+{
+	int rc;
+	slurm_msg_t resp_msg;
+	slurm_msg_t req_msg;
+	job_user_id_msg_t req;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+
+	req.user_id    = user_id;
+	req.job_name   = job_name;
+	req.show_flags = show_flags;
+	req_msg.msg_type = REQUEST_JOB_USER_INFO;
+	req_msg.data     = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_JOB_INFO:
+		*resp = (job_info_msg_t *)resp_msg.data;
+		break;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if (rc)
+			slurm_seterrno_ret(rc);
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+		break;
+	}
+
+	return SLURM_PROTOCOL_SUCCESS ;
+}
+
 /*
  * slurm_pid2jobid - issue RPC to get the slurm job_id given a process_id
  *	on this machine
@@ -47,6 +47,7 @@
 #endif
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -57,8 +58,11 @@
 
 #include "slurm/slurm.h"
 
+#include "src/common/macros.h"
+#include "src/common/pack.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_pack.h"
 #include "src/common/uid.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -291,12 +295,116 @@ slurm_sprint_node_table (node_info_t * node_ptr,
 }
 
 
+/* Records of the last SHOW_DELTA response merged with those since */
+static pthread_mutex_t node_delta_lock = PTHREAD_MUTEX_INITIALIZER;
+static info_delta_msg_t *node_delta_cache = NULL;
+static uint16_t node_delta_flags = 0;
+
+/* Unpack merged delta records as a RESPONSE_NODE_INFO message */
+static int _node_delta_unpack(info_delta_msg_t *cache, node_info_msg_t **resp)
+{
+	slurm_msg_t msg;
+	Buf buffer;
+	uint32_t i;
+	int rc;
+
+	buffer = init_buf(BUF_SIZE);
+	pack32(cache->record_count, buffer);
+	pack32(cache->node_scaling, buffer);
+	pack_time(cache->last_update, buffer);
+	for (i = 0; i < cache->record_count; i++) {
+		packmem_array(cache->record_data[i], cache->record_size[i],
+			      buffer);
+	}
+	set_buf_offset(buffer, 0);
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = RESPONSE_NODE_INFO;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	rc = unpack_msg(&msg, buffer);
+	free_buf(buffer);
+	if (rc != SLURM_SUCCESS)
+		return SLURM_ERROR;
+	*resp = (node_info_msg_t *) msg.data;
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Load all nodes as slurm_load_node(), but transfer only the records changed
+ * since the previous SHOW_DELTA call and merge them into a copy kept here
+ */
+static int _load_nodes_delta(time_t update_time, node_info_msg_t **resp,
+			     uint16_t show_flags)
+{
+	int rc = SLURM_SUCCESS;
+	slurm_msg_t resp_msg;
+	slurm_msg_t req_msg;
+	node_info_request_msg_t req;
+
+	slurm_mutex_lock(&node_delta_lock);
+	if (node_delta_cache && (node_delta_flags != show_flags)) {
+		slurm_free_info_delta_msg(node_delta_cache);
+		node_delta_cache = NULL;
+	}
+	node_delta_flags = show_flags;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	if (node_delta_cache)
+		req.last_update = node_delta_cache->last_update;
+	else
+		req.last_update = (time_t) 0;
+	req.show_flags   = show_flags;
+	req_msg.msg_type = REQUEST_NODE_INFO;
+	req_msg.data     = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0) {
+		slurm_mutex_unlock(&node_delta_lock);
+		return SLURM_ERROR;
+	}
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_NODE_INFO_DELTA:
+		slurm_merge_info_delta(&node_delta_cache,
+				       (info_delta_msg_t *) resp_msg.data);
+		break;
+	case RESPONSE_NODE_INFO:
+		/* controller does not support deltas for this request */
+		slurm_free_info_delta_msg(node_delta_cache);
+		node_delta_cache = NULL;
+		slurm_mutex_unlock(&node_delta_lock);
+		*resp = (node_info_msg_t *) resp_msg.data;
+		return SLURM_PROTOCOL_SUCCESS;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		/* the caller's copy may be older than ours */
+		if ((rc == SLURM_NO_CHANGE_IN_DATA) && node_delta_cache &&
+		    (update_time < node_delta_cache->last_update))
+			rc = SLURM_SUCCESS;
+		break;
+	default:
+		rc = SLURM_UNEXPECTED_MSG_ERROR;
+		break;
+	}
+
+	if ((rc == SLURM_SUCCESS) && node_delta_cache)
+		rc = _node_delta_unpack(node_delta_cache, resp);
+	else if (rc == SLURM_SUCCESS)
+		rc = SLURM_UNEXPECTED_MSG_ERROR;
+	slurm_mutex_unlock(&node_delta_lock);
+	if (rc)
+		slurm_seterrno_ret(rc);
+	return SLURM_PROTOCOL_SUCCESS;
+}
+
 /*
  * slurm_load_node - issue RPC to get slurm all node configuration information
  *	if changed since update_time
  * IN update_time - time of current configuration data
  * IN node_info_msg_pptr - place to store a node configuration pointer
- * IN show_flags - node filtering options
+ * IN show_flags - node filtering options, SHOW_DELTA to transfer only
+ *	nodes changed since the last call
  * RET 0 or a slurm error code
  * NOTE: free the response using slurm_free_node_info_msg
  */
@@ -308,6 +416,9 @@ extern int slurm_load_node (time_t update_time,
 	slurm_msg_t resp_msg;
 	node_info_request_msg_t req;
 
+	if (show_flags & SHOW_DELTA)
+		return _load_nodes_delta(update_time, resp, show_flags);
+
 	slurm_msg_t_init(&req_msg);
 	slurm_msg_t_init(&resp_msg);
 	req.last_update  = update_time;
@@ -261,8 +261,10 @@ _server_readable(eio_obj_t *obj)
 		return false;
 	}
 
+	/* With tree I/O, a connection may still announce more nodes */
 	if (s->remote_stdout_objs > 0 || s->remote_stderr_objs > 0 ||
-	    s->testing_connection) {
+	    s->testing_connection ||
+	    (s->cio->io_tree && s->cio->ioservers_ready < s->cio->num_nodes)) {
 		debug4("remote_stdout_objs = %d", s->remote_stdout_objs);
 		debug4("remote_stderr_objs = %d", s->remote_stderr_objs);
 		return true;
@@ -283,12 +285,86 @@ _server_readable(eio_obj_t *obj)
 	return false;
 }
 
+/*
+ * Report lost I/O for the node of this connection and for all nodes whose
+ * I/O was relayed through it (tree I/O).
+ */
+static void
+_server_notify_io_failure(eio_obj_t *obj)
+{
+	struct server_io_info *s = (struct server_io_info *) obj->arg;
+	int i;
+
+	if (s->cio->sls == NULL)
+		return;
+	step_launch_notify_io_failure(s->cio->sls, s->node_id);
+	if (!s->cio->io_tree)
+		return;
+	for (i = 0; i < s->cio->num_nodes; i++) {
+		if ((i != s->node_id) && (s->cio->ioserver[i] == obj))
+			step_launch_notify_io_failure(s->cio->sls, i);
+	}
+}
+
+/*
+ * Handle the io init msg of a node whose I/O a slurmstepd relays through
+ * this connection (tree I/O). From now on this connection is that node's
+ * ioserver, to which its stdin and connection tests are sent.
+ */
+static void
+_server_node_init(eio_obj_t *obj, struct io_buf *msg)
+{
+	struct server_io_info *s = (struct server_io_info *) obj->arg;
+	client_io_t *cio = s->cio;
+	struct slurm_io_init_msg init;
+	Buf packbuf;
+	int rc;
+
+	packbuf = create_buf(msg->data, msg->length);
+	rc = io_init_msg_unpack(&init, packbuf);
+	/* free the Buf packbuf, but not the memory to which it points */
+	packbuf->head = NULL;
+	free_buf(packbuf);
+
+	if (!cio->io_tree || (rc != SLURM_SUCCESS) ||
+	    (io_init_msg_validate(&init, cio->io_key) < 0)) {
+		error("IO: Invalid relayed io init message from node %d",
+		      s->node_id);
+		return;
+	}
+	if (init.nodeid >= cio->num_nodes) {
+		error("Invalid relayed nodeid %u from node %d",
+		      init.nodeid, s->node_id);
+		return;
+	}
+	debug2("Validated IO connection of node rank %u relayed by %d",
+	       init.nodeid, s->node_id);
+
+	pthread_mutex_lock(&cio->ioservers_lock);
+	if (cio->ioserver[init.nodeid] != NULL) {
+		error("IO: Node %u already established stream!", init.nodeid);
+		pthread_mutex_unlock(&cio->ioservers_lock);
+		return;
+	} else if (bit_test(cio->ioservers_ready_bits, init.nodeid)) {
+		error("IO: Hey, you told me node %u was down!", init.nodeid);
+	}
+	cio->ioserver[init.nodeid] = obj;
+	s->remote_stdout_objs += init.stdout_objs;
+	s->remote_stderr_objs += init.stderr_objs;
+	bit_set(cio->ioservers_ready_bits, init.nodeid);
+	cio->ioservers_ready = bit_set_count(cio->ioservers_ready_bits);
+	pthread_mutex_unlock(&cio->ioservers_lock);
+
+	if (cio->sls)
+		step_launch_clear_questionable_state(cio->sls, init.nodeid);
+}
+
 static int
 _server_read(eio_obj_t *obj, List objs)
 {
 	struct server_io_info *s = (struct server_io_info *) obj->arg;
 	void *buf;
-	int n;
+	int n, nodeid;
 
 	debug4("Entering _server_read");
 	if (s->in_msg == NULL) {
@@ -300,10 +376,21 @@ _server_read(eio_obj_t *obj, List objs)
 		}
 
 		n = io_hdr_read_fd(obj->fd, &s->header);
+		if ((n == 0) && s->cio->io_tree && !s->testing_connection &&
+		    (s->remote_stdout_objs == 0) &&
+		    (s->remote_stderr_objs == 0)) {
+			/* a slurmstepd with nothing more to send */
+			debug3("got eof on _server_read header");
+			close(obj->fd);
+			obj->fd = -1;
+			s->in_eof = true;
+			s->out_eof = true;
+			list_enqueue(s->cio->free_outgoing, s->in_msg);
+			s->in_msg = NULL;
+			return SLURM_SUCCESS;
+		}
 		if (n <= 0) { /* got eof or error on socket read */
-			if (s->cio->sls)
-				step_launch_notify_io_failure(s->cio->sls,
-							      s->node_id);
+			_server_notify_io_failure(obj);
 			debug3("got error or unexpected eof "
 			       "on _server_read header");
 			close(obj->fd);
@@ -315,9 +402,14 @@ _server_read(eio_obj_t *obj, List objs)
 			return SLURM_SUCCESS;
 		}
 		if (s->header.type == SLURM_IO_CONNECTION_TEST) {
+			/* a relaying slurmstepd names the tested node */
+			nodeid = s->node_id;
+			if ((s->header.gtaskid < s->cio->num_nodes) &&
+			    (s->cio->ioserver[s->header.gtaskid] == obj))
+				nodeid = s->header.gtaskid;
 			if (s->cio->sls)
 				step_launch_clear_questionable_state(
-					s->cio->sls, s->node_id);
+					s->cio->sls, nodeid);
 			list_enqueue(s->cio->free_outgoing, s->in_msg);
 			s->in_msg = NULL;
 			s->testing_connection = false;
@@ -369,9 +461,7 @@ _server_read(eio_obj_t *obj, List objs)
 			}
 		}
 		if (n <= 0) { /* got eof or unhandled error */
-			if (s->cio->sls)
-				step_launch_notify_io_failure(
-					s->cio->sls, s->node_id);
+			_server_notify_io_failure(obj);
 			debug3("got error or unexpected eof "
 			       "on _server_read body");
 			close(obj->fd);
@@ -391,6 +481,13 @@ _server_read(eio_obj_t *obj, List objs)
 		debug3("***** passing on eof message");
 	}
 
+	if (s->in_msg->header.type == SLURM_IO_NODE_INIT) {
+		_server_node_init(obj, s->in_msg);
+		list_enqueue(s->cio->free_outgoing, s->in_msg);
+		s->in_msg = NULL;
+		return SLURM_SUCCESS;
+	}
+
 	/*
 	 * Route the message to the proper output
 	 */
@@ -735,16 +832,23 @@ again:
 		int i;
 		struct server_io_info *server;
 		for (i = 0; i < info->cio->num_nodes; i++) {
-			msg->ref_count++;
-			if (info->cio->ioserver[i] == NULL)
+			if (info->cio->ioserver[i] == NULL) {
 				/* client_io_handler_abort() or 
 				 * client_io_handler_downnodes() called */
 				verbose("ioserver stream of node %d not yet "
 					"initialized", i);
-			else {
-				server = info->cio->ioserver[i]->arg;
-				list_enqueue(server->msg_queue, msg);
+				continue;
 			}
+			server = info->cio->ioserver[i]->arg;
+			if (server->node_id != i)
+				continue;	/* relayed by another node */
+			msg->ref_count++;
+			list_enqueue(server->msg_queue, msg);
+		}
+		if (msg->ref_count == 0) {
+			pthread_mutex_lock(&info->cio->ioservers_lock);
+			list_enqueue(info->cio->free_incoming, msg);
+			pthread_mutex_unlock(&info->cio->ioservers_lock);
 		}
 	} else if (header.type == SLURM_IO_STDIN) {
 		uint32_t nodeid;
@@ -1220,6 +1324,10 @@ client_io_handler_downnodes(client_io_t *cio,
 		    && cio->ioserver[node_id] != NULL) {
 			tmp = cio->ioserver[node_id]->arg;
 			info = (struct server_io_info *)tmp;
+			/* The relaying node reports the streams of a lost
+			 * node as closed itself */
+			if (info->node_id != node_id)
+				continue;
 			info->remote_stdout_objs = 0;
 			info->remote_stderr_objs = 0;
 			info->testing_connection = false;
@@ -1295,7 +1403,7 @@ int client_io_handler_send_test_message(client_io_t *cio, int node_id,
 	 * enqueue a test message, which would be ignored by the slurmstepd
 	 */
 	header.type = SLURM_IO_CONNECTION_TEST;
-	header.gtaskid = 0;  /* Unused */
+	header.gtaskid = node_id;  /* Used to route it with tree I/O */
 	header.ltaskid = 0;  /* Unused */
 	header.length = 0;
 
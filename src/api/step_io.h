@@ -47,6 +47,7 @@ struct client_io {
 	bool label;
 	int label_width;
 	char *io_key;
+	bool io_tree;		/* slurmstepds may relay other nodes' I/O */
 
 	/* internal variables */
 	pthread_t ioid;		/* stdio thread id 		  */
@@ -284,6 +284,10 @@ int slurm_step_launch (slurm_step_ctx_t *ctx,
 		/* The client_io_t gets a pointer back to the slurm_launch_state
 		   to notify it of I/O errors. */
 		ctx->launch_state->io.normal->sls = ctx->launch_state;
+		if (params->io_tree) {
+			launch.task_flags |= TASK_IO_TREE;
+			ctx->launch_state->io.normal->io_tree = true;
+		}
 
 		if (client_io_handler_start(ctx->launch_state->io.normal)
 		    != SLURM_SUCCESS) {
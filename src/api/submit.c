@@ -43,6 +43,7 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 
@@ -52,8 +53,10 @@ extern pid_t getsid(pid_t pid);		/* missing from <unistd.h> */
 
 #include "slurm/slurm.h"
 
+#include "src/common/macros.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
 
 /*
  * slurm_submit_batch_job - issue RPC to submit a job for later execution
@@ -119,3 +122,110 @@ slurm_submit_batch_job (job_desc_msg_t *req,
 
 	return SLURM_PROTOCOL_SUCCESS;
 }
+
+/*
+ * slurm_submit_batch_job_multi - issue RPC to submit job_cnt identical
+ *	jobs for later execution, sharing one script and environment
+ * NOTE: free the response using slurm_free_submit_multi_response_msg
+ * NOTE: if fewer than job_cnt jobs could be submitted, the response
+ *	records those submitted and the error_code which stopped submission
+ * IN job_desc_msg - description of batch job request
+ * IN job_cnt - number of jobs to submit
+ * OUT slurm_alloc_msg - response to request
+ * RET 0 on success, otherwise return -1 and set errno to indicate the error
+ */
+int
+slurm_submit_batch_job_multi (job_desc_msg_t *req, uint32_t job_cnt,
+			      submit_multi_response_msg_t **resp)
+{
+	int rc = SLURM_SUCCESS;
+	slurm_msg_t req_msg;
+	slurm_msg_t resp_msg;
+	job_desc_multi_msg_t multi_msg;
+	submit_multi_response_msg_t *part_resp, *tot_resp;
+	bool host_set = false;
+	char host[64];
+
+	if (job_cnt == 0)
+		slurm_seterrno_ret(EINVAL);
+
+	/*
+	 * set Node and session id for this request
+	 */
+	if (req->alloc_sid == NO_VAL)
+		req->alloc_sid = getsid(0);
+
+	if ( (req->alloc_node == NULL)
+	    && (gethostname_short(host, sizeof(host)) == 0) ) {
+		req->alloc_node = host;
+		host_set  = true;
+	}
+
+	tot_resp = xmalloc(sizeof(submit_multi_response_msg_t));
+	tot_resp->job_id = xmalloc(sizeof(uint32_t) * job_cnt);
+	multi_msg.job_desc = req;
+	while (tot_resp->job_cnt < job_cnt) {
+		slurm_msg_t_init(&req_msg);
+		slurm_msg_t_init(&resp_msg);
+		multi_msg.job_cnt = MIN(job_cnt - tot_resp->job_cnt,
+					SUBMIT_MULTI_MAX_JOBS);
+		req_msg.msg_type = REQUEST_SUBMIT_BATCH_JOB_MULTI;
+		req_msg.data     = &multi_msg;
+
+		if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) ==
+		    SLURM_SOCKET_ERROR) {
+			rc = slurm_get_errno();
+			break;
+		}
+
+		if (resp_msg.msg_type == RESPONSE_SLURM_RC) {
+			rc = ((return_code_msg_t *) resp_msg.data)->
+			     return_code;
+			slurm_free_return_code_msg(resp_msg.data);
+			if (rc == SLURM_SUCCESS)
+				rc = SLURM_UNEXPECTED_MSG_ERROR;
+			break;
+		} else if (resp_msg.msg_type !=
+			   RESPONSE_SUBMIT_BATCH_JOB_MULTI) {
+			slurm_free_msg_data(resp_msg.msg_type, resp_msg.data);
+			rc = SLURM_UNEXPECTED_MSG_ERROR;
+			break;
+		}
+
+		part_resp = (submit_multi_response_msg_t *) resp_msg.data;
+		if (part_resp->job_cnt > multi_msg.job_cnt)
+			part_resp->job_cnt = multi_msg.job_cnt;
+		memcpy(tot_resp->job_id + tot_resp->job_cnt, part_resp->job_id,
+		       sizeof(uint32_t) * part_resp->job_cnt);
+		tot_resp->job_cnt += part_resp->job_cnt;
+		tot_resp->error_code = part_resp->error_code;
+		if (part_resp->job_cnt < multi_msg.job_cnt) {
+			/* controller stopped submitting jobs */
+			if (tot_resp->error_code == SLURM_SUCCESS)
+				tot_resp->error_code = SLURM_ERROR;
+			slurm_free_submit_multi_response_msg(part_resp);
+			break;
+		}
+		slurm_free_submit_multi_response_msg(part_resp);
+	}
+
+	/*
+	 *  Clear this hostname if set internally to this function
+	 *    (memory is on the stack)
+	 */
+	if (host_set)
+		req->alloc_node = NULL;
+
+	if (tot_resp->job_cnt == 0) {
+		if (rc == SLURM_SUCCESS)
+			rc = tot_resp->error_code;
+		slurm_free_submit_multi_response_msg(tot_resp);
+		*resp = NULL;
+		slurm_seterrno_ret(rc);
+	}
+	if (rc != SLURM_SUCCESS)
+		tot_resp->error_code = rc;
+	*resp = tot_resp;
+
+	return SLURM_PROTOCOL_SUCCESS;
+}
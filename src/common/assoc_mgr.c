@@ -38,6 +38,7 @@
 
 #include "assoc_mgr.h"
 
+#include <ctype.h>
 #include <sys/types.h>
 #include <pwd.h>
 #include <fcntl.h>
@@ -52,6 +53,7 @@
 slurmdb_association_rec_t *assoc_mgr_root_assoc = NULL;
 uint32_t g_qos_max_priority = 0;
 uint32_t g_qos_count = 0;
+uint32_t assoc_mgr_update_cnt = 0;
 List assoc_mgr_association_list = NULL;
 List assoc_mgr_qos_list = NULL;
 List assoc_mgr_user_list = NULL;
@@ -70,6 +72,509 @@ void (*update_resvs) () = NULL;
 static pthread_mutex_t locks_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t locks_cond = PTHREAD_COND_INITIALIZER;
 
+/* Hash tables indexing the records of the assoc_mgr lists. Each index is
+ * protected by the lock of the list it indexes and must be kept current
+ * by every function adding a record to, or removing a record from, the
+ * list or changing the uid or name of one of its records. */
+typedef struct assoc_mgr_hash_ent {
+	uint32_t hash;
+	void *rec;
+	struct assoc_mgr_hash_ent *next;
+} assoc_mgr_hash_ent_t;
+
+typedef struct {
+	assoc_mgr_hash_ent_t **table;
+	uint32_t size;		/* count of buckets, a power of 2 */
+	uint32_t count;		/* count of records indexed */
+} assoc_mgr_hash_t;
+
+static assoc_mgr_hash_t assoc_id_hash;		/* by id */
+static assoc_mgr_hash_t assoc_user_hash;	/* by uid and account */
+static assoc_mgr_hash_t qos_id_hash;		/* by id */
+static assoc_mgr_hash_t qos_name_hash;		/* by name */
+static assoc_mgr_hash_t user_uid_hash;		/* by uid */
+static assoc_mgr_hash_t user_name_hash;		/* by name */
+static assoc_mgr_hash_t wckey_id_hash;		/* by id */
+static assoc_mgr_hash_t wckey_user_hash;	/* by uid and name */
+
+/* Lookup statistics, see assoc_mgr_log_lookup_stats() */
+enum {
+	LOOKUP_ASSOC,
+	LOOKUP_USER,
+	LOOKUP_QOS,
+	LOOKUP_WCKEY,
+	LOOKUP_COORD,
+	LOOKUP_TYPE_CNT
+};
+static const char *lookup_type_name[LOOKUP_TYPE_CNT] = {
+	"assoc", "user", "qos", "wckey", "coord" };
+static uint32_t lookup_cnt[LOOKUP_TYPE_CNT];
+static uint32_t lookup_miss[LOOKUP_TYPE_CNT];
+static uint64_t lookup_probes[LOOKUP_TYPE_CNT];
+static pthread_mutex_t lookup_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline uint32_t _hash_uint(uint32_t val)
+{
+	return val * 2654435761U;
+}
+
+/* Case insensitive hash of a string, names are compared with strcasecmp() */
+static uint32_t _hash_str(const char *str)
+{
+	uint32_t hash = 2166136261U;
+
+	if (!str)
+		return hash;
+	while (*str) {
+		hash ^= (uint32_t) tolower((int) *str++);
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+static inline uint32_t _hash_inx(assoc_mgr_hash_t *hash, uint32_t key)
+{
+	return (key ^ (key >> 16)) & (hash->size - 1);
+}
+
+static void _hash_free(assoc_mgr_hash_t *hash)
+{
+	assoc_mgr_hash_ent_t *ent, *next;
+	uint32_t i;
+
+	for (i = 0; i < hash->size; i++) {
+		for (ent = hash->table[i]; ent; ent = next) {
+			next = ent->next;
+			xfree(ent);
+		}
+	}
+	xfree(hash->table);
+	hash->size = 0;
+	hash->count = 0;
+}
+
+/* Resize the hash table to have at least rec_cnt buckets */
+static void _hash_resize(assoc_mgr_hash_t *hash, uint32_t rec_cnt)
+{
+	assoc_mgr_hash_ent_t **old_table = hash->table, *ent, *next;
+	uint32_t i, inx, old_size = hash->size, size = 64;
+
+	while (size < rec_cnt)
+		size *= 2;
+	if (size == old_size)
+		return;
+
+	hash->table = xmalloc(sizeof(assoc_mgr_hash_ent_t *) * size);
+	hash->size = size;
+	for (i = 0; i < old_size; i++) {
+		for (ent = old_table[i]; ent; ent = next) {
+			next = ent->next;
+			inx = _hash_inx(hash, ent->hash);
+			ent->next = hash->table[inx];
+			hash->table[inx] = ent;
+		}
+	}
+	xfree(old_table);
+}
+
+static void _hash_add(assoc_mgr_hash_t *hash, uint32_t key, void *rec)
+{
+	assoc_mgr_hash_ent_t *ent;
+	uint32_t inx;
+
+	if (hash->count >= hash->size)
+		_hash_resize(hash, hash->count + 1);
+
+	ent = xmalloc(sizeof(assoc_mgr_hash_ent_t));
+	ent->hash = key;
+	ent->rec = rec;
+	inx = _hash_inx(hash, key);
+	ent->next = hash->table[inx];
+	hash->table[inx] = ent;
+	hash->count++;
+}
+
+static void _hash_remove(assoc_mgr_hash_t *hash, uint32_t key, void *rec)
+{
+	assoc_mgr_hash_ent_t **ent_pptr, *ent;
+
+	if (!hash->size)
+		return;
+	ent_pptr = &hash->table[_hash_inx(hash, key)];
+	while ((ent = *ent_pptr)) {
+		if (ent->rec == rec) {
+			*ent_pptr = ent->next;
+			xfree(ent);
+			hash->count--;
+			return;
+		}
+		ent_pptr = &ent->next;
+	}
+}
+
+/* Return the first entry of the bucket which key maps to, the caller
+ * must test the hash and record of this entry and those following */
+static inline assoc_mgr_hash_ent_t *_hash_first(assoc_mgr_hash_t *hash,
+						uint32_t key)
+{
+	if (!hash->size)
+		return NULL;
+	return hash->table[_hash_inx(hash, key)];
+}
+
+static inline uint32_t _assoc_user_key(uint32_t uid, char *acct)
+{
+	return _hash_uint(uid) ^ _hash_str(acct);
+}
+
+static inline uint32_t _wckey_user_key(uint32_t uid, char *name)
+{
+	return _hash_uint(uid) ^ _hash_str(name);
+}
+
+static void _add_assoc_hash(slurmdb_association_rec_t *assoc)
+{
+	_hash_add(&assoc_id_hash, _hash_uint(assoc->id), assoc);
+	_hash_add(&assoc_user_hash, _assoc_user_key(assoc->uid, assoc->acct),
+		  assoc);
+}
+
+static void _remove_assoc_hash(slurmdb_association_rec_t *assoc)
+{
+	_hash_remove(&assoc_id_hash, _hash_uint(assoc->id), assoc);
+	_hash_remove(&assoc_user_hash,
+		     _assoc_user_key(assoc->uid, assoc->acct), assoc);
+}
+
+/* Rebuild the association indexes from assoc_mgr_association_list.
+ * If ids_only is set, only the association id index is rebuilt. */
+static void _rebuild_assoc_hash(bool ids_only)
+{
+	slurmdb_association_rec_t *assoc;
+	ListIterator itr;
+	uint32_t cnt = 0;
+
+	_hash_free(&assoc_id_hash);
+	_hash_free(&assoc_user_hash);
+	if (!assoc_mgr_association_list)
+		return;
+
+	cnt = list_count(assoc_mgr_association_list);
+	_hash_resize(&assoc_id_hash, cnt);
+	if (!ids_only)
+		_hash_resize(&assoc_user_hash, cnt);
+	itr = list_iterator_create(assoc_mgr_association_list);
+	while ((assoc = list_next(itr))) {
+		_hash_add(&assoc_id_hash, _hash_uint(assoc->id), assoc);
+		if (!ids_only) {
+			_hash_add(&assoc_user_hash,
+				  _assoc_user_key(assoc->uid, assoc->acct),
+				  assoc);
+		}
+	}
+	list_iterator_destroy(itr);
+}
+
+/* Rebuild only the association uid/account index, after changing the
+ * uid of associations */
+static void _rebuild_assoc_user_hash(void)
+{
+	slurmdb_association_rec_t *assoc;
+	ListIterator itr;
+
+	_hash_free(&assoc_user_hash);
+	if (!assoc_mgr_association_list)
+		return;
+
+	_hash_resize(&assoc_user_hash, list_count(assoc_mgr_association_list));
+	itr = list_iterator_create(assoc_mgr_association_list);
+	while ((assoc = list_next(itr))) {
+		_hash_add(&assoc_user_hash,
+			  _assoc_user_key(assoc->uid, assoc->acct), assoc);
+	}
+	list_iterator_destroy(itr);
+}
+
+static void _add_qos_hash(slurmdb_qos_rec_t *qos)
+{
+	_hash_add(&qos_id_hash, _hash_uint(qos->id), qos);
+	_hash_add(&qos_name_hash, _hash_str(qos->name), qos);
+}
+
+static void _remove_qos_hash(slurmdb_qos_rec_t *qos)
+{
+	_hash_remove(&qos_id_hash, _hash_uint(qos->id), qos);
+	_hash_remove(&qos_name_hash, _hash_str(qos->name), qos);
+}
+
+static void _rebuild_qos_hash(void)
+{
+	slurmdb_qos_rec_t *qos;
+	ListIterator itr;
+
+	_hash_free(&qos_id_hash);
+	_hash_free(&qos_name_hash);
+	if (!assoc_mgr_qos_list)
+		return;
+
+	itr = list_iterator_create(assoc_mgr_qos_list);
+	while ((qos = list_next(itr)))
+		_add_qos_hash(qos);
+	list_iterator_destroy(itr);
+}
+
+static void _add_user_hash(slurmdb_user_rec_t *user)
+{
+	_hash_add(&user_uid_hash, _hash_uint(user->uid), user);
+	_hash_add(&user_name_hash, _hash_str(user->name), user);
+}
+
+static void _remove_user_hash(slurmdb_user_rec_t *user)
+{
+	_hash_remove(&user_uid_hash, _hash_uint(user->uid), user);
+	_hash_remove(&user_name_hash, _hash_str(user->name), user);
+}
+
+static void _rebuild_user_hash(void)
+{
+	slurmdb_user_rec_t *user;
+	ListIterator itr;
+	uint32_t cnt;
+
+	_hash_free(&user_uid_hash);
+	_hash_free(&user_name_hash);
+	if (!assoc_mgr_user_list)
+		return;
+
+	cnt = list_count(assoc_mgr_user_list);
+	_hash_resize(&user_uid_hash, cnt);
+	_hash_resize(&user_name_hash, cnt);
+	itr = list_iterator_create(assoc_mgr_user_list);
+	while ((user = list_next(itr)))
+		_add_user_hash(user);
+	list_iterator_destroy(itr);
+}
+
+static void _add_wckey_hash(slurmdb_wckey_rec_t *wckey)
+{
+	_hash_add(&wckey_id_hash, _hash_uint(wckey->id), wckey);
+	_hash_add(&wckey_user_hash, _wckey_user_key(wckey->uid, wckey->name),
+		  wckey);
+}
+
+static void _remove_wckey_hash(slurmdb_wckey_rec_t *wckey)
+{
+	_hash_remove(&wckey_id_hash, _hash_uint(wckey->id), wckey);
+	_hash_remove(&wckey_user_hash,
+		     _wckey_user_key(wckey->uid, wckey->name), wckey);
+}
+
+static void _rebuild_wckey_hash(void)
+{
+	slurmdb_wckey_rec_t *wckey;
+	ListIterator itr;
+	uint32_t cnt;
+
+	_hash_free(&wckey_id_hash);
+	_hash_free(&wckey_user_hash);
+	if (!assoc_mgr_wckey_list)
+		return;
+
+	cnt = list_count(assoc_mgr_wckey_list);
+	_hash_resize(&wckey_id_hash, cnt);
+	_hash_resize(&wckey_user_hash, cnt);
+	itr = list_iterator_create(assoc_mgr_wckey_list);
+	while ((wckey = list_next(itr)))
+		_add_wckey_hash(wckey);
+	list_iterator_destroy(itr);
+}
+
+static slurmdb_association_rec_t *_find_assoc_id(uint32_t id,
+						 uint32_t *probes)
+{
+	assoc_mgr_hash_ent_t *ent;
+	slurmdb_association_rec_t *assoc;
+	uint32_t key = _hash_uint(id);
+
+	for (ent = _hash_first(&assoc_id_hash, key); ent; ent = ent->next) {
+		if (ent->hash != key)
+			continue;
+		assoc = ent->rec;
+		if (probes)
+			(*probes)++;
+		if (assoc->id == id)
+			return assoc;
+	}
+	return NULL;
+}
+
+/* Find the association of assoc's uid, account, partition and (on the
+ * slurmdbd) cluster. If assoc names a partition and the user has no
+ * association for it, return the association without a partition. */
+static slurmdb_association_rec_t *_find_assoc_user(
+	slurmdb_association_rec_t *assoc, uint32_t *probes)
+{
+	assoc_mgr_hash_ent_t *ent;
+	slurmdb_association_rec_t *found_assoc, *ret_assoc = NULL;
+	uint32_t key = _assoc_user_key(assoc->uid, assoc->acct);
+
+	for (ent = _hash_first(&assoc_user_hash, key); ent; ent = ent->next) {
+		if (ent->hash != key)
+			continue;
+		found_assoc = ent->rec;
+		(*probes)++;
+		if (assoc->uid != found_assoc->uid) {
+			debug4("not the right user %u != %u",
+			       assoc->uid, found_assoc->uid);
+			continue;
+		}
+
+		if (found_assoc->acct
+		    && strcasecmp(assoc->acct, found_assoc->acct)) {
+			debug4("not the right account %s != %s",
+			       assoc->acct, found_assoc->acct);
+			continue;
+		}
+
+		/* only check for on the slurmdbd */
+		if (!assoc_mgr_cluster_name && found_assoc->cluster
+		    && strcasecmp(assoc->cluster, found_assoc->cluster)) {
+			debug4("not the right cluster");
+			continue;
+		}
+
+		if (assoc->partition) {
+			if (!found_assoc->partition) {
+				ret_assoc = found_assoc;
+				debug3("found association for no partition");
+				continue;
+			} else if (strcasecmp(assoc->partition,
+					      found_assoc->partition)) {
+				debug4("not the right partition");
+				continue;
+			}
+		} else if (found_assoc->partition) {
+			debug4("partition specific association "
+			       "looking for one without.");
+			continue;
+		}
+		ret_assoc = found_assoc;
+		break;
+	}
+
+	return ret_assoc;
+}
+
+static slurmdb_user_rec_t *_find_user_uid(uint32_t uid, uint32_t *probes)
+{
+	assoc_mgr_hash_ent_t *ent;
+	slurmdb_user_rec_t *user;
+	uint32_t key = _hash_uint(uid);
+
+	for (ent = _hash_first(&user_uid_hash, key); ent; ent = ent->next) {
+		if (ent->hash != key)
+			continue;
+		user = ent->rec;
+		if (probes)
+			(*probes)++;
+		if (user->uid == uid)
+			return user;
+	}
+	return NULL;
+}
+
+static slurmdb_user_rec_t *_find_user_name(char *name, uint32_t *probes)
+{
+	assoc_mgr_hash_ent_t *ent;
+	slurmdb_user_rec_t *user;
+	uint32_t key = _hash_str(name);
+
+	for (ent = _hash_first(&user_name_hash, key); ent; ent = ent->next) {
+		if (ent->hash != key)
+			continue;
+		user = ent->rec;
+		if (probes)
+			(*probes)++;
+		if (user->name && !strcasecmp(name, user->name))
+			return user;
+	}
+	return NULL;
+}
+
+static slurmdb_wckey_rec_t *_find_wckey_id(uint32_t id, uint32_t *probes)
+{
+	assoc_mgr_hash_ent_t *ent;
+	slurmdb_wckey_rec_t *wckey;
+	uint32_t key = _hash_uint(id);
+
+	for (ent = _hash_first(&wckey_id_hash, key); ent; ent = ent->next) {
+		if (ent->hash != key)
+			continue;
+		wckey = ent->rec;
+		if (probes)
+			(*probes)++;
+		if (wckey->id == id)
+			return wckey;
+	}
+	return NULL;
+}
+
+/* Test if found_wckey is the wckey of wckey's user (by uid if known,
+ * else by name), name and (on the slurmdbd) cluster */
+static bool _match_wckey(slurmdb_wckey_rec_t *wckey,
+			 slurmdb_wckey_rec_t *found_wckey)
+{
+	if (wckey->uid != NO_VAL) {
+		if (wckey->uid != found_wckey->uid) {
+			debug4("not the right user %u != %u",
+			       wckey->uid, found_wckey->uid);
+			return false;
+		}
+	} else if (wckey->user && strcasecmp(wckey->user, found_wckey->user))
+		return false;
+
+	if (wckey->name
+	    && (!found_wckey->name
+		|| strcasecmp(wckey->name, found_wckey->name))) {
+		debug4("not the right name %s != %s",
+		       wckey->name, found_wckey->name);
+		return false;
+	}
+
+	/* only check for on the slurmdbd */
+	if (!assoc_mgr_cluster_name) {
+		if (!wckey->cluster) {
+			error("No cluster name was given to check against, "
+			      "we need one to get a wckey.");
+			return false;
+		}
+
+		if (found_wckey->cluster
+		    && strcasecmp(wckey->cluster, found_wckey->cluster)) {
+			debug4("not the right cluster");
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Used with list_find() to position an iterator on a record found
+ * through one of the hash tables */
+static int _list_find_rec(void *x, void *key)
+{
+	return (x == key);
+}
+
+static void _lookup_stat(int type, uint32_t probes, bool found)
+{
+	slurm_mutex_lock(&lookup_stats_mutex);
+	lookup_cnt[type]++;
+	lookup_probes[type] += probes;
+	if (!found)
+		lookup_miss[type]++;
+	slurm_mutex_unlock(&lookup_stats_mutex);
+}
+
 /* you should check for assoc == NULL before this function */
 static void _normalize_assoc_shares(slurmdb_association_rec_t *assoc)
 {
@@ -196,6 +701,11 @@ static int _change_user_name(slurmdb_user_rec_t *user)
 		list_iterator_destroy(itr);
 	}
 
+	/* The uids and names indexed have changed */
+	_rebuild_user_hash();
+	_rebuild_assoc_user_hash();
+	_rebuild_wckey_hash();
+
 	return rc;
 }
 
@@ -298,22 +808,15 @@ static void _set_user_default_acct(slurmdb_association_rec_t *assoc)
 
 	/* set up the default if this is it */
 	if ((assoc->is_def == 1) && (assoc->uid != NO_VAL)) {
-		slurmdb_user_rec_t *user = NULL;
-		ListIterator user_itr =
-			list_iterator_create(assoc_mgr_user_list);
-		while ((user = list_next(user_itr))) {
-			if (user->uid != assoc->uid)
-				continue;
-			if (!user->default_acct
-			    || strcmp(user->default_acct, assoc->acct)) {
-				xfree(user->default_acct);
-				user->default_acct = xstrdup(assoc->acct);
-				debug2("user %s default acct is %s",
-				       user->name, user->default_acct);
-			}
-			break;
+		slurmdb_user_rec_t *user = _find_user_uid(assoc->uid, NULL);
+
+		if (user && (!user->default_acct
+			     || strcmp(user->default_acct, assoc->acct))) {
+			xfree(user->default_acct);
+			user->default_acct = xstrdup(assoc->acct);
+			debug2("user %s default acct is %s",
+			       user->name, user->default_acct);
 		}
-		list_iterator_destroy(user_itr);
 	}
 }
 
@@ -326,22 +829,15 @@ static void _set_user_default_wckey(slurmdb_wckey_rec_t *wckey)
 
 	/* set up the default if this is it */
 	if ((wckey->is_def == 1) && (wckey->uid != NO_VAL)) {
-		slurmdb_user_rec_t *user = NULL;
-		ListIterator user_itr =
-			list_iterator_create(assoc_mgr_user_list);
-		while ((user = list_next(user_itr))) {
-			if (user->uid != wckey->uid)
-				continue;
-			if (!user->default_wckey
-			    || strcmp(user->default_wckey, wckey->name)) {
-				xfree(user->default_wckey);
-				user->default_wckey = xstrdup(wckey->name);
-				debug2("user %s default wckey is %s",
-				       user->name, user->default_wckey);
-			}
-			break;
+		slurmdb_user_rec_t *user = _find_user_uid(wckey->uid, NULL);
+
+		if (user && (!user->default_wckey
+			     || strcmp(user->default_wckey, wckey->name))) {
+			xfree(user->default_wckey);
+			user->default_wckey = xstrdup(wckey->name);
+			debug2("user %s default wckey is %s",
+			       user->name, user->default_wckey);
 		}
-		list_iterator_destroy(user_itr);
 	}
 }
 
@@ -373,7 +869,7 @@ static int _set_assoc_parent_and_user(slurmdb_association_rec_t *assoc,
 		   if the last parent we had was what we are looking
 		   for.  Then if that isn't panning out look at the
 		   last account parent.  If still we don't have it we
-		   will look for it in the list.  If it isn't there we
+		   will look it up by id.  If it isn't there we
 		   will just add it to the parent and call it good
 		*/
 		if (last_parent && assoc->parent_id == last_parent->id) {
@@ -382,19 +878,15 @@ static int _set_assoc_parent_and_user(slurmdb_association_rec_t *assoc,
 			   && assoc->parent_id == last_acct_parent->id) {
 			assoc->usage->parent_assoc_ptr = last_acct_parent;
 		} else {
-			slurmdb_association_rec_t *assoc2 = NULL;
-			ListIterator itr = list_iterator_create(assoc_list);
-			while ((assoc2 = list_next(itr))) {
-				if (assoc2->id == assoc->parent_id) {
-					assoc->usage->parent_assoc_ptr = assoc2;
-					if (assoc->user)
-						last_parent = assoc2;
-					else
-						last_acct_parent = assoc2;
-					break;
-				}
+			slurmdb_association_rec_t *assoc2 =
+				_find_assoc_id(assoc->parent_id, NULL);
+			if (assoc2) {
+				assoc->usage->parent_assoc_ptr = assoc2;
+				if (assoc->user)
+					last_parent = assoc2;
+				else
+					last_acct_parent = assoc2;
 			}
-			list_iterator_destroy(itr);
 		}
 		if (assoc->usage->parent_assoc_ptr && setup_children) {
 			if (!assoc->usage->parent_assoc_ptr->usage)
@@ -485,7 +977,8 @@ static void _set_qos_norm_priority(slurmdb_qos_rec_t *qos)
 		(double)qos->priority / (double)g_qos_max_priority;
 }
 
-/* transfer slurmdb assoc list to be assoc_mgr assoc list */
+/* transfer slurmdb assoc list to be assoc_mgr assoc list,
+ * assoc_list must already be assoc_mgr_association_list */
 static int _post_association_list(List assoc_list)
 {
 	slurmdb_association_rec_t *assoc = NULL;
@@ -496,6 +989,11 @@ static int _post_association_list(List assoc_list)
 	if (!assoc_list)
 		return SLURM_ERROR;
 
+	xassert(assoc_list == assoc_mgr_association_list);
+	assoc_mgr_update_cnt++;
+	/* parents are found by id, the uids are only set below */
+	_rebuild_assoc_hash(true);
+
 	itr = list_iterator_create(assoc_list);
 
 	//START_TIMER;
@@ -534,6 +1032,7 @@ static int _post_association_list(List assoc_list)
 	}
 	list_iterator_destroy(itr);
 
+	_rebuild_assoc_user_hash();
 	slurmdb_sort_hierarchical_assoc_list(assoc_list);
 
 	//END_TIMER2("load_associations");
@@ -596,6 +1095,7 @@ static int _post_qos_list(List qos_list)
 
 	g_qos_count = 0;
 	g_qos_max_priority = 0;
+	assoc_mgr_update_cnt++;
 
 	while ((qos = list_next(itr))) {
 		if (qos->flags & QOS_FLAG_NOTSET)
@@ -663,6 +1163,7 @@ static int _get_assoc_mgr_association_list(void *db_conn, int enforce)
 		   isn't anything there */
 		assoc_mgr_association_list =
 			list_create(slurmdb_destroy_association_rec);
+		_rebuild_assoc_hash(false);
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_ASSOCS) {
 			error("_get_assoc_mgr_association_list: "
@@ -694,6 +1195,7 @@ static int _get_assoc_mgr_qos_list(void *db_conn, int enforce)
 	assoc_mgr_qos_list = acct_storage_g_get_qos(db_conn, uid, NULL);
 
 	if (!assoc_mgr_qos_list) {
+		_rebuild_qos_hash();
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_ASSOCS) {
 			error("_get_assoc_mgr_qos_list: no list was made.");
@@ -704,6 +1206,7 @@ static int _get_assoc_mgr_qos_list(void *db_conn, int enforce)
 	}
 
 	_post_qos_list(assoc_mgr_qos_list);
+	_rebuild_qos_hash();
 
 	assoc_mgr_unlock(&locks);
 	return SLURM_SUCCESS;
@@ -725,6 +1228,7 @@ static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 	assoc_mgr_user_list = acct_storage_g_get_users(db_conn, uid, &user_q);
 
 	if (!assoc_mgr_user_list) {
+		_rebuild_user_hash();
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_ASSOCS) {
 			error("_get_assoc_mgr_user_list: "
@@ -736,6 +1240,7 @@ static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 	}
 
 	_post_user_list(assoc_mgr_user_list);
+	_rebuild_user_hash();
 
 	assoc_mgr_unlock(&locks);
 	return SLURM_SUCCESS;
@@ -776,6 +1281,7 @@ static int _get_assoc_mgr_wckey_list(void *db_conn, int enforce)
 		/* create list so we don't keep calling this if there
 		   isn't anything there */
 		assoc_mgr_wckey_list = list_create(slurmdb_destroy_wckey_rec);
+		_rebuild_wckey_hash();
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_WCKEYS) {
 			error("_get_assoc_mgr_wckey_list: "
@@ -789,6 +1295,7 @@ static int _get_assoc_mgr_wckey_list(void *db_conn, int enforce)
 	}
 
 	_post_wckey_list(assoc_mgr_wckey_list);
+	_rebuild_wckey_hash();
 
 	assoc_mgr_unlock(&locks);
 
@@ -801,7 +1308,6 @@ static int _refresh_assoc_mgr_association_list(void *db_conn, int enforce)
 	List current_assocs = NULL;
 	uid_t uid = getuid();
 	ListIterator curr_itr = NULL;
-	ListIterator assoc_mgr_itr = NULL;
 	slurmdb_association_rec_t *curr_assoc = NULL, *assoc = NULL;
 	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
@@ -846,17 +1352,13 @@ static int _refresh_assoc_mgr_association_list(void *db_conn, int enforce)
 	}
 
 	curr_itr = list_iterator_create(current_assocs);
-	assoc_mgr_itr = list_iterator_create(assoc_mgr_association_list);
 
 	/* add used limits We only look for the user associations to
 	 * do the parents since a parent may have moved */
 	while ((curr_assoc = list_next(curr_itr))) {
 		if (!curr_assoc->user)
 			continue;
-		while ((assoc = list_next(assoc_mgr_itr))) {
-			if (assoc->id == curr_assoc->id)
-				break;
-		}
+		assoc = _find_assoc_id(curr_assoc->id, NULL);
 
 		while (assoc) {
 			_addto_used_info(assoc, curr_assoc);
@@ -864,11 +1366,9 @@ static int _refresh_assoc_mgr_association_list(void *db_conn, int enforce)
 			   different than the one we are updating from */
 			assoc = assoc->usage->parent_assoc_ptr;
 		}
-		list_iterator_reset(assoc_mgr_itr);
 	}
 
 	list_iterator_destroy(curr_itr);
-	list_iterator_destroy(assoc_mgr_itr);
 
 	assoc_mgr_unlock(&locks);
 
@@ -903,6 +1403,7 @@ static int _refresh_assoc_mgr_qos_list(void *db_conn, int enforce)
 		list_destroy(assoc_mgr_qos_list);
 
 	assoc_mgr_qos_list = current_qos;
+	_rebuild_qos_hash();
 
 	assoc_mgr_unlock(&locks);
 
@@ -938,6 +1439,7 @@ static int _refresh_assoc_mgr_user_list(void *db_conn, int enforce)
 		list_destroy(assoc_mgr_user_list);
 
 	assoc_mgr_user_list = current_users;
+	_rebuild_user_hash();
 
 	assoc_mgr_unlock(&locks);
 
@@ -983,6 +1485,7 @@ static int _refresh_assoc_wckey_list(void *db_conn, int enforce)
 		list_destroy(assoc_mgr_wckey_list);
 
 	assoc_mgr_wckey_list = current_wckeys;
+	_rebuild_wckey_hash();
 	assoc_mgr_unlock(&locks);
 
 	return SLURM_SUCCESS;
@@ -1154,6 +1657,10 @@ extern int assoc_mgr_fini(char *state_save_location)
 	assoc_mgr_qos_list = NULL;
 	assoc_mgr_user_list = NULL;
 	assoc_mgr_wckey_list = NULL;
+	_rebuild_assoc_hash(false);
+	_rebuild_qos_hash();
+	_rebuild_user_hash();
+	_rebuild_wckey_hash();
 
 	return SLURM_SUCCESS;
 }
@@ -1309,9 +1816,8 @@ extern int assoc_mgr_fill_in_assoc(void *db_conn,
 				   int enforce,
 				   slurmdb_association_rec_t **assoc_pptr)
 {
-	ListIterator itr = NULL;
-	slurmdb_association_rec_t * found_assoc = NULL;
 	slurmdb_association_rec_t * ret_assoc = NULL;
+	uint32_t probes = 0;
 	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -1380,63 +1886,11 @@ extern int assoc_mgr_fill_in_assoc(void *db_conn,
 /* 	     assoc->user, assoc->uid, assoc->acct, */
 /* 	     assoc->cluster, assoc->partition); */
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(assoc_mgr_association_list);
-	while ((found_assoc = list_next(itr))) {
-		if (assoc->id) {
-			if (assoc->id == found_assoc->id) {
-				ret_assoc = found_assoc;
-				break;
-			}
-			continue;
-		} else {
-			if (assoc->uid == NO_VAL
-			    && found_assoc->uid != NO_VAL) {
-				debug3("we are looking for a "
-				       "nonuser association");
-				continue;
-			} else if (assoc->uid != found_assoc->uid) {
-				debug4("not the right user %u != %u",
-				       assoc->uid, found_assoc->uid);
-				continue;
-			}
-
-			if (found_assoc->acct
-			    && strcasecmp(assoc->acct, found_assoc->acct)) {
-				debug4("not the right account %s != %s",
-				       assoc->acct, found_assoc->acct);
-				continue;
-			}
-
-			/* only check for on the slurmdbd */
-			if (!assoc_mgr_cluster_name && found_assoc->cluster
-			    && strcasecmp(assoc->cluster,
-					  found_assoc->cluster)) {
-				debug4("not the right cluster");
-				continue;
-			}
-
-			if (assoc->partition) {
-				if (!found_assoc->partition) {
-					ret_assoc = found_assoc;
-					debug3("found association "
-					       "for no partition");
-					continue;
-				} else if (strcasecmp(assoc->partition,
-						      found_assoc->partition)) {
-					debug4("not the right partition");
-					continue;
-				}
-			} else if (found_assoc->partition) {
-				debug4("partition specific association "
-				       "looking for one without.");
-				continue;
-			}
-		}
-		ret_assoc = found_assoc;
-		break;
-	}
-	list_iterator_destroy(itr);
-
+	if (assoc->id)
+		ret_assoc = _find_assoc_id(assoc->id, &probes);
+	else
+		ret_assoc = _find_assoc_user(assoc, &probes);
+	_lookup_stat(LOOKUP_ASSOC, probes, (ret_assoc != NULL));
 	if (!ret_assoc) {
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_ASSOCS)
@@ -1536,8 +1990,8 @@ extern int assoc_mgr_fill_in_user(void *db_conn, slurmdb_user_rec_t *user,
 				  int enforce,
 				  slurmdb_user_rec_t **user_pptr)
 {
-	ListIterator itr = NULL;
 	slurmdb_user_rec_t * found_user = NULL;
+	uint32_t probes = 0;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK,
 				   NO_LOCK, READ_LOCK, NO_LOCK };
 
@@ -1552,16 +2006,11 @@ extern int assoc_mgr_fill_in_user(void *db_conn, slurmdb_user_rec_t *user,
 		return SLURM_SUCCESS;
 
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (user->uid != NO_VAL) {
-			if (user->uid == found_user->uid)
-				break;
-		} else if (user->name
-			   && !strcasecmp(user->name, found_user->name))
-			break;
-	}
-	list_iterator_destroy(itr);
+	if (user->uid != NO_VAL)
+		found_user = _find_user_uid(user->uid, &probes);
+	else if (user->name)
+		found_user = _find_user_name(user->name, &probes);
+	_lookup_stat(LOOKUP_USER, probes, (found_user != NULL));
 
 	if (!found_user) {
 		assoc_mgr_unlock(&locks);
@@ -1604,8 +2053,9 @@ extern int assoc_mgr_fill_in_qos(void *db_conn, slurmdb_qos_rec_t *qos,
 				 int enforce,
 				 slurmdb_qos_rec_t **qos_pptr)
 {
-	ListIterator itr = NULL;
+	assoc_mgr_hash_ent_t *ent;
 	slurmdb_qos_rec_t * found_qos = NULL;
+	uint32_t key, probes = 0;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
 
@@ -1620,14 +2070,31 @@ extern int assoc_mgr_fill_in_qos(void *db_conn, slurmdb_qos_rec_t *qos,
 		return SLURM_SUCCESS;
 
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(assoc_mgr_qos_list);
-	while ((found_qos = list_next(itr))) {
-		if (qos->id == found_qos->id)
-			break;
-		else if (qos->name && !strcasecmp(qos->name, found_qos->name))
+	key = _hash_uint(qos->id);
+	for (ent = _hash_first(&qos_id_hash, key); ent; ent = ent->next) {
+		if (ent->hash != key)
+			continue;
+		probes++;
+		if (qos->id == ((slurmdb_qos_rec_t *) ent->rec)->id) {
+			found_qos = ent->rec;
 			break;
+		}
 	}
-	list_iterator_destroy(itr);
+	if (!found_qos && qos->name) {
+		key = _hash_str(qos->name);
+		for (ent = _hash_first(&qos_name_hash, key); ent;
+		     ent = ent->next) {
+			if (ent->hash != key)
+				continue;
+			probes++;
+			found_qos = ent->rec;
+			if (found_qos->name
+			    && !strcasecmp(qos->name, found_qos->name))
+				break;
+			found_qos = NULL;
+		}
+	}
+	_lookup_stat(LOOKUP_QOS, probes, (found_qos != NULL));
 
 	if (!found_qos) {
 		assoc_mgr_unlock(&locks);
@@ -1710,8 +2177,10 @@ extern int assoc_mgr_fill_in_wckey(void *db_conn, slurmdb_wckey_rec_t *wckey,
 				   slurmdb_wckey_rec_t **wckey_pptr)
 {
 	ListIterator itr = NULL;
+	assoc_mgr_hash_ent_t *ent;
 	slurmdb_wckey_rec_t * found_wckey = NULL;
 	slurmdb_wckey_rec_t * ret_wckey = NULL;
+	uint32_t key, probes = 0;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, READ_LOCK };
 
@@ -1791,55 +2260,33 @@ extern int assoc_mgr_fill_in_wckey(void *db_conn, slurmdb_wckey_rec_t *wckey,
 /* 	     wckey->user, wckey->uid, wckey->name, */
 /* 	     wckey->cluster); */
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(assoc_mgr_wckey_list);
-	while ((found_wckey = list_next(itr))) {
-		if (wckey->id) {
-			if (wckey->id == found_wckey->id) {
-				ret_wckey = found_wckey;
-				break;
-			}
-			continue;
-		} else {
-			if (wckey->uid != NO_VAL) {
-				if (wckey->uid != found_wckey->uid) {
-					debug4("not the right user %u != %u",
-					       wckey->uid, found_wckey->uid);
-					continue;
-				}
-			} else if (wckey->user && strcasecmp(wckey->user,
-							     found_wckey->user))
-				continue;
-
-			if (wckey->name
-			    && (!found_wckey->name
-				|| strcasecmp(wckey->name,
-					      found_wckey->name))) {
-				debug4("not the right name %s != %s",
-				       wckey->name, found_wckey->name);
+	if (wckey->id)
+		ret_wckey = _find_wckey_id(wckey->id, &probes);
+	else if (wckey->uid != NO_VAL) {
+		/* The wckeys of a user are indexed by uid and name */
+		key = _wckey_user_key(wckey->uid, wckey->name);
+		for (ent = _hash_first(&wckey_user_hash, key); ent;
+		     ent = ent->next) {
+			if (ent->hash != key)
 				continue;
+			probes++;
+			if (_match_wckey(wckey, ent->rec)) {
+				ret_wckey = ent->rec;
+				break;
 			}
-
-			/* only check for on the slurmdbd */
-			if (!assoc_mgr_cluster_name) {
-				if (!wckey->cluster) {
-					error("No cluster name was given "
-					      "to check against, "
-					      "we need one to get a wckey.");
-					continue;
-				}
-
-				if (found_wckey->cluster
-				    && strcasecmp(wckey->cluster,
-						  found_wckey->cluster)) {
-					debug4("not the right cluster");
-					continue;
-				}
+		}
+	} else {
+		itr = list_iterator_create(assoc_mgr_wckey_list);
+		while ((found_wckey = list_next(itr))) {
+			probes++;
+			if (_match_wckey(wckey, found_wckey)) {
+				ret_wckey = found_wckey;
+				break;
 			}
 		}
-		ret_wckey = found_wckey;
-		break;
+		list_iterator_destroy(itr);
 	}
-	list_iterator_destroy(itr);
+	_lookup_stat(LOOKUP_WCKEY, probes, (ret_wckey != NULL));
 
 	if (!ret_wckey) {
 		assoc_mgr_unlock(&locks);
@@ -1874,8 +2321,9 @@ extern int assoc_mgr_fill_in_wckey(void *db_conn, slurmdb_wckey_rec_t *wckey,
 extern slurmdb_admin_level_t assoc_mgr_get_admin_level(void *db_conn,
 						       uint32_t uid)
 {
-	ListIterator itr = NULL;
 	slurmdb_user_rec_t * found_user = NULL;
+	slurmdb_admin_level_t admin_level = SLURMDB_ADMIN_NOTSET;
+	uint32_t probes = 0;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK,
 				   NO_LOCK, READ_LOCK, NO_LOCK };
 
@@ -1887,18 +2335,13 @@ extern slurmdb_admin_level_t assoc_mgr_get_admin_level(void *db_conn,
 		return SLURMDB_ADMIN_NOTSET;
 
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (uid == found_user->uid)
-			break;
-	}
-	list_iterator_destroy(itr);
-	assoc_mgr_unlock(&locks);
-
+	found_user = _find_user_uid(uid, &probes);
 	if (found_user)
-		return found_user->admin_level;
+		admin_level = found_user->admin_level;
+	assoc_mgr_unlock(&locks);
+	_lookup_stat(LOOKUP_USER, probes, (found_user != NULL));
 
-	return SLURMDB_ADMIN_NOTSET;
+	return admin_level;
 }
 
 extern bool assoc_mgr_is_user_acct_coord(void *db_conn,
@@ -1908,6 +2351,7 @@ extern bool assoc_mgr_is_user_acct_coord(void *db_conn,
 	ListIterator itr = NULL;
 	slurmdb_coord_rec_t *acct = NULL;
 	slurmdb_user_rec_t * found_user = NULL;
+	uint32_t probes = 0;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK,
 				   NO_LOCK, READ_LOCK, NO_LOCK };
 
@@ -1919,29 +2363,24 @@ extern bool assoc_mgr_is_user_acct_coord(void *db_conn,
 		return false;
 
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (uid == found_user->uid)
-			break;
-	}
-	list_iterator_destroy(itr);
-
+	found_user = _find_user_uid(uid, &probes);
 	if (!found_user || !found_user->coord_accts) {
 		assoc_mgr_unlock(&locks);
+		_lookup_stat(LOOKUP_COORD, probes, false);
 		return false;
 	}
 	itr = list_iterator_create(found_user->coord_accts);
 	while ((acct = list_next(itr))) {
+		probes++;
 		if (!strcmp(acct_name, acct->name))
 			break;
 	}
 	list_iterator_destroy(itr);
+	assoc_mgr_unlock(&locks);
+	_lookup_stat(LOOKUP_COORD, probes, (acct != NULL));
 
-	if (acct) {
-		assoc_mgr_unlock(&locks);
+	if (acct)
 		return true;
-	}
-	assoc_mgr_unlock(&locks);
 
 	return false;
 }
@@ -2187,6 +2626,7 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update)
 		return SLURM_SUCCESS;
 
 	assoc_mgr_lock(&locks);
+	assoc_mgr_update_cnt++;
 	itr = list_iterator_create(assoc_mgr_association_list);
 	while ((object = list_pop(update->objects))) {
 		bool update_jobs = false;
@@ -2210,14 +2650,11 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update)
 			object->cluster = xstrdup("test");
 		}
 
-		list_iterator_reset(itr);
-		while ((rec = list_next(itr))) {
-			if (object->id) {
-				if (object->id == rec->id) {
-					break;
-				}
-				continue;
-			} else {
+		if (object->id)
+			rec = _find_assoc_id(object->id, NULL);
+		else {
+			list_iterator_reset(itr);
+			while ((rec = list_next(itr))) {
 				if (!object->user && rec->user) {
 					debug4("we are looking for a "
 					       "nonuser association");
@@ -2418,6 +2855,7 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update)
 			if (object->is_def != 1)
 				object->is_def = 0;
 			list_append(assoc_mgr_association_list, object);
+			_add_assoc_hash(object);
 			object = NULL;
 			parents_changed = 1; /* set since we need to
 						set the parent
@@ -2439,6 +2877,9 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update)
 							set the shares
 							of surrounding childern
 						     */
+			_remove_assoc_hash(rec);
+			list_iterator_reset(itr);
+			list_find(itr, _list_find_rec, rec);
 			if (remove_assoc_notify) {
 				/* since there are some deadlock
 				   issues while inside our lock here
@@ -2542,6 +2983,8 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update)
 				log_assoc_rec(object, assoc_mgr_qos_list);
 			}
 		}
+		/* The uid of new associations was just set */
+		_rebuild_assoc_user_hash();
 	} else if (resort)
 		slurmdb_sort_hierarchical_assoc_list(
 			assoc_mgr_association_list);
@@ -2602,14 +3045,11 @@ extern int assoc_mgr_update_wckeys(slurmdb_update_object_t *update)
 			continue;
 		}
 
-		list_iterator_reset(itr);
-		while ((rec = list_next(itr))) {
-			if (object->id) {
-				if (object->id == rec->id) {
-					break;
-				}
-				continue;
-			} else {
+		if (object->id)
+			rec = _find_wckey_id(object->id, NULL);
+		else {
+			list_iterator_reset(itr);
+			while ((rec = list_next(itr))) {
 				if (object->uid != rec->uid) {
 					debug4("not the right user");
 					continue;
@@ -2670,6 +3110,7 @@ extern int assoc_mgr_update_wckeys(slurmdb_update_object_t *update)
 			else
 				object->is_def = 0;
 			list_append(assoc_mgr_wckey_list, object);
+			_add_wckey_hash(object);
 			object = NULL;
 			break;
 		case SLURMDB_REMOVE_WCKEY:
@@ -2677,6 +3118,9 @@ extern int assoc_mgr_update_wckeys(slurmdb_update_object_t *update)
 				//rc = SLURM_ERROR;
 				break;
 			}
+			_remove_wckey_hash(rec);
+			list_iterator_reset(itr);
+			list_find(itr, _list_find_rec, rec);
 			list_delete_item(itr);
 			break;
 		default:
@@ -2708,16 +3152,10 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update)
 	assoc_mgr_lock(&locks);
 	itr = list_iterator_create(assoc_mgr_user_list);
 	while ((object = list_pop(update->objects))) {
-		list_iterator_reset(itr);
-		while ((rec = list_next(itr))) {
-			char *name;
-			if (object->old_name)
-				name = object->old_name;
-			else
-				name = object->name;
-			if (!strcasecmp(name, rec->name))
-				break;
-		}
+		if (object->old_name)
+			rec = _find_user_name(object->old_name, NULL);
+		else
+			rec = _find_user_name(object->name, NULL);
 
 		//info("%d user %s", update->type, object->name);
 		switch(update->type) {
@@ -2769,6 +3207,7 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update)
 			} else
 				object->uid = pw_uid;
 			list_append(assoc_mgr_user_list, object);
+			_add_user_hash(object);
 			object = NULL;
 			break;
 		case SLURMDB_REMOVE_USER:
@@ -2776,6 +3215,9 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update)
 				//rc = SLURM_ERROR;
 				break;
 			}
+			_remove_user_hash(rec);
+			list_iterator_reset(itr);
+			list_find(itr, _list_find_rec, rec);
 			list_delete_item(itr);
 			break;
 		case SLURMDB_ADD_COORD:
@@ -2828,6 +3270,7 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update)
 		return SLURM_SUCCESS;
 
 	assoc_mgr_lock(&locks);
+	assoc_mgr_update_cnt++;
 	itr = list_iterator_create(assoc_mgr_qos_list);
 	while ((object = list_pop(update->objects))) {
 		bool update_jobs = false;
@@ -2849,6 +3292,7 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update)
 			if (!object->usage)
 				object->usage = create_assoc_mgr_qos_usage();
 			list_append(assoc_mgr_qos_list, object);
+			_add_qos_hash(object);
 /* 			char *tmp = get_qos_complete_str_bitstr( */
 /* 				assoc_mgr_qos_list, */
 /* 				object->preempt_bitstr); */
@@ -3004,6 +3448,7 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update)
 			if (rec->priority == g_qos_max_priority)
 				redo_priority = 2;
 
+			_remove_qos_hash(rec);
 			if (remove_qos_notify) {
 				/* since there are some deadlock
 				   issues while inside our lock here
@@ -3108,8 +3553,8 @@ extern int assoc_mgr_validate_assoc_id(void *db_conn,
 				       uint32_t assoc_id,
 				       int enforce)
 {
-	ListIterator itr = NULL;
 	slurmdb_association_rec_t * found_assoc = NULL;
+	uint32_t probes = 0;
 	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -3124,13 +3569,9 @@ extern int assoc_mgr_validate_assoc_id(void *db_conn,
 		return SLURM_SUCCESS;
 
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(assoc_mgr_association_list);
-	while ((found_assoc = list_next(itr))) {
-		if (assoc_id == found_assoc->id)
-			break;
-	}
-	list_iterator_destroy(itr);
+	found_assoc = _find_assoc_id(assoc_id, &probes);
 	assoc_mgr_unlock(&locks);
+	_lookup_stat(LOOKUP_ASSOC, probes, (found_assoc != NULL));
 
 	if (found_assoc || !(enforce & ACCOUNTING_ENFORCE_ASSOCS))
 		return SLURM_SUCCESS;
@@ -3208,6 +3649,7 @@ extern void assoc_mgr_remove_assoc_usage(slurmdb_association_rec_t *assoc)
 
 	old_usage_raw = assoc->usage->usage_raw;
 	old_grp_used_wall = assoc->usage->grp_used_wall;
+	assoc_mgr_update_cnt++;
 /*
  *	Reset this association's raw and group usages and subtract its
  *	current usages from all parental units
@@ -3776,6 +4218,7 @@ extern int load_assoc_mgr_state(char *state_save_location)
 				list_destroy(assoc_mgr_user_list);
 			assoc_mgr_user_list = msg->my_list;
 			_post_user_list(assoc_mgr_user_list);
+			_rebuild_user_hash();
 			debug("Recovered %u users",
 			      list_count(assoc_mgr_user_list));
 			msg->my_list = NULL;
@@ -3794,6 +4237,7 @@ extern int load_assoc_mgr_state(char *state_save_location)
 				list_destroy(assoc_mgr_qos_list);
 			assoc_mgr_qos_list = msg->my_list;
 			_post_qos_list(assoc_mgr_qos_list);
+			_rebuild_qos_hash();
 			debug("Recovered %u qos",
 			      list_count(assoc_mgr_qos_list));
 			msg->my_list = NULL;
@@ -3811,6 +4255,7 @@ extern int load_assoc_mgr_state(char *state_save_location)
 			if (assoc_mgr_wckey_list)
 				list_destroy(assoc_mgr_wckey_list);
 			assoc_mgr_wckey_list = msg->my_list;
+			_rebuild_wckey_hash();
 			debug("Recovered %u wckeys",
 			      list_count(assoc_mgr_wckey_list));
 			msg->my_list = NULL;
@@ -3875,6 +4320,7 @@ extern int assoc_mgr_set_missing_uids()
 {
 	uid_t pw_uid;
 	ListIterator itr = NULL;
+	bool changed = false;
 	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK,
 				   NO_LOCK, WRITE_LOCK, WRITE_LOCK };
 
@@ -3889,11 +4335,16 @@ extern int assoc_mgr_set_missing_uids()
 					debug2("refresh association "
 					       "couldn't get a uid for user %s",
 					       object->user);
-				} else
+				} else {
 					object->uid = pw_uid;
+					changed = true;
+				}
 			}
 		}
 		list_iterator_destroy(itr);
+		if (changed)
+			_rebuild_assoc_user_hash();
+		changed = false;
 	}
 
 	if (assoc_mgr_wckey_list) {
@@ -3906,11 +4357,16 @@ extern int assoc_mgr_set_missing_uids()
 					debug2("refresh wckey "
 					       "couldn't get a uid for user %s",
 					       object->user);
-				} else
+				} else {
 					object->uid = pw_uid;
+					changed = true;
+				}
 			}
 		}
 		list_iterator_destroy(itr);
+		if (changed)
+			_rebuild_wckey_hash();
+		changed = false;
 	}
 
 	if (assoc_mgr_user_list) {
@@ -3923,13 +4379,33 @@ extern int assoc_mgr_set_missing_uids()
 					debug3("refresh user couldn't get "
 					       "a uid for user %s",
 					       object->name);
-				} else
+				} else {
 					object->uid = pw_uid;
+					changed = true;
+				}
 			}
 		}
 		list_iterator_destroy(itr);
+		if (changed)
+			_rebuild_user_hash();
 	}
 	assoc_mgr_unlock(&locks);
 
 	return SLURM_SUCCESS;
 }
+
+extern void assoc_mgr_log_lookup_stats(void)
+{
+	int i;
+
+	slurm_mutex_lock(&lookup_stats_mutex);
+	info("Association manager lookups:");
+	for (i = 0; i < LOOKUP_TYPE_CNT; i++) {
+		if (lookup_cnt[i] == 0)
+			continue;
+		info("  %-6s cnt:%u miss:%u probe_avg:%.2f",
+		     lookup_type_name[i], lookup_cnt[i], lookup_miss[i],
+		     (double) lookup_probes[i] / lookup_cnt[i]);
+	}
+	slurm_mutex_unlock(&lookup_stats_mutex);
+}
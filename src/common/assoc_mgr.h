@@ -160,6 +160,10 @@ extern List assoc_mgr_wckey_list;
 extern slurmdb_association_rec_t *assoc_mgr_root_assoc;
 
 extern uint32_t g_qos_max_priority; /* max priority in all qos's */
+/* Incremented whenever the associations or QOS are loaded, added, removed
+ * or modified or an association's usage is reset, so values derived from
+ * them can be revalidated */
+extern uint32_t assoc_mgr_update_cnt;
 extern uint32_t g_qos_count; /* count used for generating qos bitstr's */
 
 
@@ -368,4 +372,10 @@ extern int assoc_mgr_refresh_lists(void *db_conn, assoc_init_args_t *args);
  */
 extern int assoc_mgr_set_missing_uids();
 
+/*
+ * Log the count of association, user, QOS, wckey and coordinator lookups
+ * made since startup and the average count of records examined by each.
+ */
+extern void assoc_mgr_log_lookup_stats(void);
+
 #endif /* _SLURM_ASSOC_MGR_H */
@@ -55,6 +55,7 @@
  * for details.
  */
 strong_alias(bit_alloc,		slurm_bit_alloc);
+strong_alias(bit_alloc_sparse,	slurm_bit_alloc_sparse);
 strong_alias(bit_test,		slurm_bit_test);
 strong_alias(bit_set,		slurm_bit_set);
 strong_alias(bit_clear,		slurm_bit_clear);
@@ -62,6 +63,7 @@ strong_alias(bit_nclear,	slurm_bit_nclear);
 strong_alias(bit_nset,		slurm_bit_nset);
 strong_alias(bit_ffc,		slurm_bit_ffc);
 strong_alias(bit_ffs,		slurm_bit_ffs);
+strong_alias(bit_ffs_from_bit,	slurm_bit_ffs_from_bit);
 strong_alias(bit_free,		slurm_bit_free);
 strong_alias(bit_realloc,	slurm_bit_realloc);
 strong_alias(bit_size,		slurm_bit_size);
@@ -85,6 +87,8 @@ strong_alias(bit_fls,		slurm_bit_fls);
 strong_alias(bit_fill_gaps,	slurm_bit_fill_gaps);
 strong_alias(bit_super_set,	slurm_bit_super_set);
 strong_alias(bit_overlap,	slurm_bit_overlap);
+strong_alias(bit_overlap_any,	slurm_bit_overlap_any);
+strong_alias(bit_and_not,	slurm_bit_and_not);
 strong_alias(bit_equal,		slurm_bit_equal);
 strong_alias(bit_copy,		slurm_bit_copy);
 strong_alias(bit_pick_cnt,	slurm_bit_pick_cnt);
@@ -95,6 +99,503 @@ strong_alias(bit_copybits,	slurm_bit_copybits);
 strong_alias(bit_get_bit_num,	slurm_bit_get_bit_num);
 strong_alias(bit_get_pos_num,	slurm_bit_get_pos_num);
 
+/*
+ * Word level helpers.
+ *
+ * The data words of a bitstring follow the BITSTR_OVERHEAD header words.
+ * Bits beyond _bitstr_bits() in the last word are not guaranteed to be
+ * clear (bit_not() flips them), so any operation whose result depends upon
+ * them must apply _bit_tail_mask() to the last word.
+ */
+#ifdef USE_64BIT_BITSTR
+typedef uint64_t bitword_t;
+#else
+typedef uint32_t bitword_t;
+#endif
+
+#define BITSTR_WORD_BITS	((int) (sizeof(bitstr_t) * 8))
+
+/* number of data words in a bitstring of nbits bits */
+#define _bit_data_words(nbits)	(_bitstr_words(nbits) - BITSTR_OVERHEAD)
+
+/* number of data words in which every bit is valid */
+#define _bit_full_words(nbits)	((nbits) >> BITSTR_SHIFT)
+
+/* mask for the valid bits of a partial last word holding nbits bits */
+#ifdef SLURM_BIGENDIAN
+#define _bit_tail_mask(nbits) \
+	((bitstr_t) ~((bitword_t) ~0 >> ((nbits) & BITSTR_MAXPOS)))
+#else
+#define _bit_tail_mask(nbits) \
+	((bitstr_t) (((bitword_t) 1 << ((nbits) & BITSTR_MAXPOS)) - 1))
+#endif
+
+#if defined(__GNUC__)
+#  ifdef USE_64BIT_BITSTR
+#    define _word_ctz(w)	__builtin_ctzll((uint64_t) (w))
+#    define _word_clz(w)	__builtin_clzll((uint64_t) (w))
+#  else
+#    define _word_ctz(w)	__builtin_ctz((uint32_t) (w))
+#    define _word_clz(w)	__builtin_clz((uint32_t) (w))
+#  endif
+#endif
+
+/* Runtime selection of AVX2 and POPCNT kernels requires gcc 4.9 or later */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#  define BITSTR_CPU_DISPATCH 1
+#  include <immintrin.h>
+#endif
+
+/*
+ * Return the position within a non-zero word of its lowest numbered set bit
+ */
+static inline int
+_word_ffs(bitstr_t word)
+{
+#if defined(__GNUC__)
+#  ifdef SLURM_BIGENDIAN
+	return _word_clz(word);
+#  else
+	return _word_ctz(word);
+#  endif
+#else
+	int pos = 0;
+
+	while (!(word & _bit_mask(pos)))
+		pos++;
+	return pos;
+#endif
+}
+
+/*
+ * Return the position within a non-zero word of its highest numbered set bit
+ */
+static inline int
+_word_fls(bitstr_t word)
+{
+#if defined(__GNUC__)
+#  ifdef SLURM_BIGENDIAN
+	return BITSTR_MAXPOS - _word_ctz(word);
+#  else
+	return BITSTR_MAXPOS - _word_clz(word);
+#  endif
+#else
+	int pos = BITSTR_MAXPOS;
+
+	while (!(word & _bit_mask(pos)))
+		pos--;
+	return pos;
+#endif
+}
+
+#if !defined(USE_64BIT_BITSTR)
+/*
+ * Returns the hamming weight (i.e. the number of bits set) in a word.
+ * NOTE: This routine borrowed from Linux 2.4.9 <linux/bitops.h>.
+ */
+static uint32_t
+hweight(uint32_t w)
+{
+	uint32_t res;
+
+	res = (w   & 0x55555555) + ((w >> 1)    & 0x55555555);
+	res = (res & 0x33333333) + ((res >> 2)  & 0x33333333);
+	res = (res & 0x0F0F0F0F) + ((res >> 4)  & 0x0F0F0F0F);
+	res = (res & 0x00FF00FF) + ((res >> 8)  & 0x00FF00FF);
+	res = (res & 0x0000FFFF) + ((res >> 16) & 0x0000FFFF);
+
+	return res;
+}
+#else
+/*
+ * A 64 bit version crafted from 32-bit one borrowed above.
+ */
+static uint64_t
+hweight(uint64_t w)
+{
+	uint64_t res;
+
+	res = (w   & 0x5555555555555555) + ((w >> 1)    & 0x5555555555555555);
+	res = (res & 0x3333333333333333) + ((res >> 2)  & 0x3333333333333333);
+	res = (res & 0x0F0F0F0F0F0F0F0F) + ((res >> 4)  & 0x0F0F0F0F0F0F0F0F);
+	res = (res & 0x00FF00FF00FF00FF) + ((res >> 8)  & 0x00FF00FF00FF00FF);
+	res = (res & 0x0000FFFF0000FFFF) + ((res >> 16) & 0x0000FFFF0000FFFF);
+	res = (res & 0x00000000FFFFFFFF) + ((res >> 32) & 0x00000000FFFFFFFF);
+
+	return res;
+}
+#endif /* !USE_64BIT_BITSTR */
+
+/*
+ * Multi-word kernels. Each operates on cnt data words. The portable
+ * versions are always built; on x86 AVX2 and POPCNT versions are also
+ * built and selected by _bit_kernel_init() if the CPU supports them.
+ */
+static void
+_and_words(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+
+	for (i = 0; i < cnt; i++)
+		w1[i] &= w2[i];
+}
+
+static void
+_or_words(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+
+	for (i = 0; i < cnt; i++)
+		w1[i] |= w2[i];
+}
+
+static void
+_and_not_words(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+
+	for (i = 0; i < cnt; i++)
+		w1[i] &= ~w2[i];
+}
+
+/* return 1 if every bit set in w1 is also set in w2 */
+static int
+_subset_words(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+
+	for (i = 0; i < cnt; i++) {
+		if (w1[i] & ~w2[i])
+			return 0;
+	}
+	return 1;
+}
+
+/* return 1 if any bit is set in both w1 and w2 */
+static int
+_intersect_words(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+
+	for (i = 0; i < cnt; i++) {
+		if (w1[i] & w2[i])
+			return 1;
+	}
+	return 0;
+}
+
+static int
+_count_words(bitstr_t *w, bitoff_t cnt)
+{
+	bitoff_t i;
+	int count = 0;
+
+	for (i = 0; i < cnt; i++)
+		count += hweight(w[i]);
+	return count;
+}
+
+static int
+_and_count_words(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+	int count = 0;
+
+	for (i = 0; i < cnt; i++)
+		count += hweight(w1[i] & w2[i]);
+	return count;
+}
+
+#ifdef BITSTR_CPU_DISPATCH
+/* bitstr_t words per 256-bit vector */
+#define BITSTR_VEC_WORDS	(32 / sizeof(bitstr_t))
+
+__attribute__((target("avx2"))) static void
+_and_words_avx2(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+	__m256i v1, v2;
+
+	for (i = 0; i + BITSTR_VEC_WORDS <= cnt; i += BITSTR_VEC_WORDS) {
+		v1 = _mm256_loadu_si256((__m256i *) (w1 + i));
+		v2 = _mm256_loadu_si256((__m256i *) (w2 + i));
+		_mm256_storeu_si256((__m256i *) (w1 + i),
+				    _mm256_and_si256(v1, v2));
+	}
+	_and_words(w1 + i, w2 + i, cnt - i);
+}
+
+__attribute__((target("avx2"))) static void
+_or_words_avx2(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+	__m256i v1, v2;
+
+	for (i = 0; i + BITSTR_VEC_WORDS <= cnt; i += BITSTR_VEC_WORDS) {
+		v1 = _mm256_loadu_si256((__m256i *) (w1 + i));
+		v2 = _mm256_loadu_si256((__m256i *) (w2 + i));
+		_mm256_storeu_si256((__m256i *) (w1 + i),
+				    _mm256_or_si256(v1, v2));
+	}
+	_or_words(w1 + i, w2 + i, cnt - i);
+}
+
+__attribute__((target("avx2"))) static void
+_and_not_words_avx2(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+	__m256i v1, v2;
+
+	for (i = 0; i + BITSTR_VEC_WORDS <= cnt; i += BITSTR_VEC_WORDS) {
+		v1 = _mm256_loadu_si256((__m256i *) (w1 + i));
+		v2 = _mm256_loadu_si256((__m256i *) (w2 + i));
+		/* _mm256_andnot_si256(a, b) is ~a & b */
+		_mm256_storeu_si256((__m256i *) (w1 + i),
+				    _mm256_andnot_si256(v2, v1));
+	}
+	_and_not_words(w1 + i, w2 + i, cnt - i);
+}
+
+__attribute__((target("avx2"))) static int
+_subset_words_avx2(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+	__m256i v1, v2;
+
+	for (i = 0; i + BITSTR_VEC_WORDS <= cnt; i += BITSTR_VEC_WORDS) {
+		v1 = _mm256_loadu_si256((__m256i *) (w1 + i));
+		v2 = _mm256_loadu_si256((__m256i *) (w2 + i));
+		/* _mm256_testc_si256(a, b) is 1 if (~a & b) == 0 */
+		if (!_mm256_testc_si256(v2, v1))
+			return 0;
+	}
+	return _subset_words(w1 + i, w2 + i, cnt - i);
+}
+
+__attribute__((target("avx2"))) static int
+_intersect_words_avx2(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+	__m256i v1, v2;
+
+	for (i = 0; i + BITSTR_VEC_WORDS <= cnt; i += BITSTR_VEC_WORDS) {
+		v1 = _mm256_loadu_si256((__m256i *) (w1 + i));
+		v2 = _mm256_loadu_si256((__m256i *) (w2 + i));
+		/* _mm256_testz_si256(a, b) is 1 if (a & b) == 0 */
+		if (!_mm256_testz_si256(v1, v2))
+			return 1;
+	}
+	return _intersect_words(w1 + i, w2 + i, cnt - i);
+}
+
+/* Count 64 bits at a time regardless of the size of bitstr_t */
+#define BITSTR_U64_WORDS	(sizeof(uint64_t) / sizeof(bitstr_t))
+
+__attribute__((target("popcnt"))) static int
+_count_words_popcnt(bitstr_t *w, bitoff_t cnt)
+{
+	bitoff_t i;
+	uint64_t u;
+	int count = 0;
+
+	for (i = 0; i + BITSTR_U64_WORDS <= cnt; i += BITSTR_U64_WORDS) {
+		memcpy(&u, w + i, sizeof(uint64_t));
+		count += __builtin_popcountll(u);
+	}
+	for ( ; i < cnt; i++)
+		count += __builtin_popcount((bitword_t) w[i]);
+	return count;
+}
+
+__attribute__((target("popcnt"))) static int
+_and_count_words_popcnt(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt)
+{
+	bitoff_t i;
+	uint64_t u1, u2;
+	int count = 0;
+
+	for (i = 0; i + BITSTR_U64_WORDS <= cnt; i += BITSTR_U64_WORDS) {
+		memcpy(&u1, w1 + i, sizeof(uint64_t));
+		memcpy(&u2, w2 + i, sizeof(uint64_t));
+		count += __builtin_popcountll(u1 & u2);
+	}
+	for ( ; i < cnt; i++)
+		count += __builtin_popcount((bitword_t) (w1[i] & w2[i]));
+	return count;
+}
+#endif	/* BITSTR_CPU_DISPATCH */
+
+static struct {
+	void	(*and_words)(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt);
+	void	(*or_words)(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt);
+	void	(*and_not_words)(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt);
+	int	(*subset_words)(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt);
+	int	(*intersect_words)(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt);
+	int	(*count_words)(bitstr_t *w, bitoff_t cnt);
+	int	(*and_count_words)(bitstr_t *w1, bitstr_t *w2, bitoff_t cnt);
+} bit_kernel = {
+	_and_words,
+	_or_words,
+	_and_not_words,
+	_subset_words,
+	_intersect_words,
+	_count_words,
+	_and_count_words
+};
+
+#ifdef BITSTR_CPU_DISPATCH
+/*
+ * Select the kernels for the CPU we are running on. This runs when the
+ * library is loaded, before any thread can use a bitstring.
+ */
+static void __attribute__((constructor))
+_bit_kernel_init(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		bit_kernel.and_words       = _and_words_avx2;
+		bit_kernel.or_words        = _or_words_avx2;
+		bit_kernel.and_not_words   = _and_not_words_avx2;
+		bit_kernel.subset_words    = _subset_words_avx2;
+		bit_kernel.intersect_words = _intersect_words_avx2;
+	}
+	if (__builtin_cpu_supports("popcnt")) {
+		bit_kernel.count_words     = _count_words_popcnt;
+		bit_kernel.and_count_words = _and_count_words_popcnt;
+	}
+}
+#endif
+
+/*
+ * Summary bitmap of a bitstring allocated with bit_alloc_sparse().
+ *
+ * Summary bit N corresponds to data word N. A clear summary bit means the
+ * data word is zero; a set summary bit means it may be non-zero. Clearing
+ * bits individually does not clear summary bits, bulk operations refresh
+ * them.
+ */
+#define _bitstr_has_summary(name) \
+	(_bitstr_magic(name) == BITSTR_MAGIC_SUMMARY)
+
+/* words of summary for a bitstring of nbits bits */
+#define _bit_summary_words(nbits) \
+	((_bit_data_words(nbits) + BITSTR_MAXPOS) >> BITSTR_SHIFT)
+
+/* address of the summary of a bitstring */
+#define _bit_summary(name)	((name) + _bitstr_words(_bitstr_bits(name)))
+
+static inline void
+_summary_set(bitstr_t *b, bitoff_t word)
+{
+	_bit_summary(b)[word >> BITSTR_SHIFT] |= _bit_mask(word);
+}
+
+static inline void
+_summary_clear(bitstr_t *b, bitoff_t word)
+{
+	_bit_summary(b)[word >> BITSTR_SHIFT] &= ~_bit_mask(word);
+}
+
+/* mask of the valid bits in data word "word" of a bitstring of nbits bits */
+static inline bitstr_t
+_bit_word_mask(bitoff_t nbits, bitoff_t word)
+{
+	if ((word + 1) <= _bit_full_words(nbits))
+		return (bitstr_t) ~0;
+	return _bit_tail_mask(nbits);
+}
+
+/* Recompute the summary bits of data words first through last */
+static void
+_summary_refresh(bitstr_t *b, bitoff_t first, bitoff_t last)
+{
+	bitstr_t *sum = _bit_summary(b), *data = b + BITSTR_OVERHEAD;
+	bitoff_t word;
+
+	for (word = first; word <= last; word++) {
+		if (data[word])
+			sum[word >> BITSTR_SHIFT] |= _bit_mask(word);
+		else
+			sum[word >> BITSTR_SHIFT] &= ~_bit_mask(word);
+	}
+}
+
+static void
+_summary_rebuild(bitstr_t *b)
+{
+	bitoff_t nwords = _bit_data_words(_bitstr_bits(b));
+
+	if (nwords)
+		_summary_refresh(b, 0, nwords - 1);
+}
+
+/*
+ * Return the index of the first data word at or after word which may have
+ * bits set, -1 if none. Uses the summary if present.
+ */
+static bitoff_t
+_bit_next_word(bitstr_t *b, bitoff_t word, bitoff_t nwords)
+{
+	bitstr_t *sum, tmp;
+	bitoff_t sword, nsum;
+
+	if (word >= nwords)
+		return -1;
+	if (!_bitstr_has_summary(b)) {
+		while (b[word + BITSTR_OVERHEAD] == 0) {
+			if (++word >= nwords)
+				return -1;
+		}
+		return word;
+	}
+
+	sum = _bit_summary(b);
+	nsum = _bit_summary_words(_bitstr_bits(b));
+	sword = word >> BITSTR_SHIFT;
+	tmp = sum[sword] & ~_bit_tail_mask(word);
+	while (tmp == 0) {
+		if (++sword >= nsum)
+			return -1;
+		tmp = sum[sword];
+	}
+	word = (sword << BITSTR_SHIFT) + _word_ffs(tmp);
+	return (word < nwords) ? word : -1;
+}
+
+/*
+ * Return the index of the last data word at or before word which may have
+ * bits set, -1 if none. Uses the summary if present.
+ */
+static bitoff_t
+_bit_prev_word(bitstr_t *b, bitoff_t word)
+{
+	bitstr_t *sum, tmp;
+	bitoff_t sword;
+
+	if (word < 0)
+		return -1;
+	if (!_bitstr_has_summary(b)) {
+		while (b[word + BITSTR_OVERHEAD] == 0) {
+			if (--word < 0)
+				return -1;
+		}
+		return word;
+	}
+
+	sum = _bit_summary(b);
+	sword = word >> BITSTR_SHIFT;
+	tmp = sum[sword];
+	if ((word + 1) & BITSTR_MAXPOS)
+		tmp &= _bit_tail_mask(word + 1);
+	while (tmp == 0) {
+		if (--sword < 0)
+			return -1;
+		tmp = sum[sword];
+	}
+	return (sword << BITSTR_SHIFT) + _word_fls(tmp);
+}
+
 /*
  * Allocate a bitstring.
  *   nbits (IN)		valid bits in new bitstring, initialized to all clear
@@ -113,6 +614,27 @@ bit_alloc(bitoff_t nbits)
 	return new;
 }
 
+/*
+ * Allocate a bitstring with a summary of which words have bits set, for
+ * large bitmaps expected to have few bits set (e.g. cores allocated to
+ * jobs). Use it like any other bitstring.
+ *   nbits (IN)		valid bits in new bitstring, initialized to all clear
+ *   RETURN		new bitstring
+ */
+bitstr_t *
+bit_alloc_sparse(bitoff_t nbits)
+{
+	bitstr_t *new;
+
+	new = (bitstr_t *)calloc(_bitstr_words(nbits) +
+				 _bit_summary_words(nbits), sizeof(bitstr_t));
+	if (new) {
+		_bitstr_magic(new) = BITSTR_MAGIC_SUMMARY;
+		_bitstr_bits(new) = nbits;
+	}
+	return new;
+}
+
 /*
  * Reallocate a bitstring (expand or contract size).
  *   b (IN)		pointer to old bitstring
@@ -127,6 +649,20 @@ bit_realloc(bitstr_t *b, bitoff_t nbits)
 
 	_assert_bitstr_valid(b);
 	obits = _bitstr_bits(b);
+	if (_bitstr_has_summary(b)) {
+		/* the summary follows the data, so build a new bitstring */
+		new = bit_alloc_sparse(nbits);
+		if (new) {
+			memcpy(new + BITSTR_OVERHEAD, b + BITSTR_OVERHEAD,
+			       MIN(_bit_data_words(obits),
+				   _bit_data_words(nbits)) * sizeof(bitstr_t));
+			if (nbits > obits)
+				bit_nclear(new, obits, nbits - 1);
+			_summary_rebuild(new);
+			bit_free(b);
+		}
+		return new;
+	}
 	new = realloc(b, _bitstr_words(nbits) * sizeof(bitstr_t));
 	if (new) {
 		_assert_bitstr_valid(new);
@@ -145,7 +681,8 @@ void
 bit_free(bitstr_t *b)
 {
 	assert(b);
-	assert(_bitstr_magic(b) == BITSTR_MAGIC);
+	assert(_bitstr_magic(b) == BITSTR_MAGIC ||
+	       _bitstr_magic(b) == BITSTR_MAGIC_SUMMARY);
 	_bitstr_magic(b) = 0;
 	free(b);
 }
@@ -187,6 +724,8 @@ bit_set(bitstr_t *b, bitoff_t bit)
 	_assert_bitstr_valid(b);
 	_assert_bit_valid(b, bit);
 	b[_bit_word(bit)] |= _bit_mask(bit);
+	if (_bitstr_has_summary(b))
+		_summary_set(b, bit >> BITSTR_SHIFT);
 }
 
 /*
@@ -211,6 +750,9 @@ bit_clear(bitstr_t *b, bitoff_t bit)
 void
 bit_nset(bitstr_t *b, bitoff_t start, bitoff_t stop)
 {
+	bitoff_t first_word = start >> BITSTR_SHIFT;
+	bitoff_t last_word = stop >> BITSTR_SHIFT;
+
 	_assert_bitstr_valid(b);
 	_assert_bit_valid(b, start);
 	_assert_bit_valid(b, stop);
@@ -223,6 +765,8 @@ bit_nset(bitstr_t *b, bitoff_t start, bitoff_t stop)
 		assert((stop-start+1) % 8 == 0);
 		memset(_bit_byteaddr(b, start), 0xff, (stop-start+1) / 8);
 	}
+	if (_bitstr_has_summary(b))
+		_summary_refresh(b, first_word, last_word);
 }
 
 /*
@@ -234,6 +778,9 @@ bit_nset(bitstr_t *b, bitoff_t start, bitoff_t stop)
 void
 bit_nclear(bitstr_t *b, bitoff_t start, bitoff_t stop)
 {
+	bitoff_t first_word = start >> BITSTR_SHIFT;
+	bitoff_t last_word = stop >> BITSTR_SHIFT;
+
 	_assert_bitstr_valid(b);
 	_assert_bit_valid(b, start);
 	_assert_bit_valid(b, stop);
@@ -246,6 +793,8 @@ bit_nclear(bitstr_t *b, bitoff_t start, bitoff_t stop)
 		assert((stop-start+1) % 8 == 0);
 		memset(_bit_byteaddr(b, start), 0, (stop-start+1) / 8);
 	}
+	if (_bitstr_has_summary(b))
+		_summary_refresh(b, first_word, last_word);
 }
 
 /*
@@ -257,25 +806,22 @@ bit_nclear(bitstr_t *b, bitoff_t start, bitoff_t stop)
 bitoff_t
 bit_ffc(bitstr_t *b)
 {
-	bitoff_t bit = 0, value = -1;
+	bitoff_t word, nwords, bit_cnt, value = -1;
+	bitstr_t tmp;
 
 	_assert_bitstr_valid(b);
 
-	while (bit < _bitstr_bits(b) && value == -1) {
-		int word = _bit_word(bit);
-
-		if (b[word] == BITSTR_MAXPOS) {
-			bit += sizeof(bitstr_t)*8;
+	bit_cnt = _bitstr_bits(b);
+	nwords = _bit_data_words(bit_cnt);
+	for (word = 0; word < nwords; word++) {
+		tmp = ~b[word + BITSTR_OVERHEAD];
+		if (tmp == 0)
 			continue;
-		}
-		while (bit < _bitstr_bits(b) && _bit_word(bit) == word) {
-			if (!bit_test(b, bit)) {
-				value = bit;
-				break;
-			}
-			bit++;
-		}
+		value = (word << BITSTR_SHIFT) + _word_ffs(tmp);
+		break;
 	}
+	if (value >= bit_cnt)	/* only unused bits of last word clear */
+		value = -1;
 	return value;
 }
 
@@ -288,13 +834,34 @@ bitoff_t
 bit_nffc(bitstr_t *b, int n)
 {
 	bitoff_t value = -1;
-	bitoff_t bit;
+	bitoff_t bit, bit_cnt;
+	bitstr_t word;
 	int cnt = 0;
 
 	_assert_bitstr_valid(b);
 	assert(n > 0 && n < _bitstr_bits(b));
 
-	for (bit = 0; bit < _bitstr_bits(b); bit++) {
+	bit_cnt = _bitstr_bits(b);
+	for (bit = 0; bit < bit_cnt; ) {
+		if (((bit & BITSTR_MAXPOS) == 0) &&
+		    ((bit + BITSTR_WORD_BITS) <= bit_cnt)) {
+			/* handle whole words that are all clear or all set */
+			word = b[_bit_word(bit)];
+			if (word == 0) {
+				if ((cnt + BITSTR_WORD_BITS) >= n) {
+					value = bit - cnt;
+					break;
+				}
+				cnt += BITSTR_WORD_BITS;
+				bit += BITSTR_WORD_BITS;
+				continue;
+			}
+			if (word == (bitstr_t) ~0) {
+				cnt = 0;
+				bit += BITSTR_WORD_BITS;
+				continue;
+			}
+		}
 		if (bit_test(b, bit)) {		/* fail */
 			cnt = 0;
 		} else {
@@ -304,6 +871,7 @@ bit_nffc(bitstr_t *b, int n)
 				break;
 			}
 		}
+		bit++;
 	}
 
 	return value;
@@ -367,14 +935,40 @@ bitoff_t
 bit_nffs(bitstr_t *b, int n)
 {
 	bitoff_t value = -1;
-	bitoff_t bit;
+	bitoff_t bit, bit_cnt;
+	bitstr_t word;
 	int cnt = 0;
 
 	_assert_bitstr_valid(b);
 	assert(n > 0 && n <= _bitstr_bits(b));
 
-	for (bit = 0; bit <= _bitstr_bits(b) - n; bit++) {
+	bit_cnt = _bitstr_bits(b);
+	for (bit = 0; bit < bit_cnt; ) {
+		if (((bit & BITSTR_MAXPOS) == 0) &&
+		    ((bit + BITSTR_WORD_BITS) <= bit_cnt)) {
+			/* handle whole words that are all clear or all set */
+			word = b[_bit_word(bit)];
+			if (word == (bitstr_t) ~0) {
+				if ((cnt + BITSTR_WORD_BITS) >= n) {
+					value = bit - cnt;
+					break;
+				}
+				cnt += BITSTR_WORD_BITS;
+				bit += BITSTR_WORD_BITS;
+				continue;
+			}
+			if (word == 0) {
+				/* too few bits left for a run of n */
+				if ((bit_cnt - bit - BITSTR_WORD_BITS) < n)
+					break;
+				cnt = 0;
+				bit += BITSTR_WORD_BITS;
+				continue;
+			}
+		}
 		if (!bit_test(b, bit)) {	/* fail */
+			if ((bit_cnt - bit - 1) < n)
+				break;
 			cnt = 0;
 		} else {
 			cnt++;
@@ -383,6 +977,7 @@ bit_nffs(bitstr_t *b, int n)
 				break;
 			}
 		}
+		bit++;
 	}
 
 	return value;
@@ -396,25 +991,39 @@ bit_nffs(bitstr_t *b, int n)
 bitoff_t
 bit_ffs(bitstr_t *b)
 {
-	bitoff_t bit = 0, value = -1;
+	return bit_ffs_from_bit(b, 0);
+}
 
-	_assert_bitstr_valid(b);
+/*
+ * Find first bit set in b at or after position bit.
+ *   b (IN)		bitstring to search
+ *   bit (IN)		position at which to begin search
+ *   RETURN 		resulting bit position (-1 if none found)
+ */
+bitoff_t
+bit_ffs_from_bit(bitstr_t *b, bitoff_t bit)
+{
+	bitoff_t word, nwords, bit_cnt, value;
+	bitstr_t tmp;
 
-	while (bit < _bitstr_bits(b) && value == -1) {
-		int word = _bit_word(bit);
+	_assert_bitstr_valid(b);
+	assert(bit >= 0);
 
-		if (b[word] == 0) {
-			bit += sizeof(bitstr_t)*8;
-			continue;
-		}
-		while (bit < _bitstr_bits(b) && _bit_word(bit) == word) {
-			if (bit_test(b, bit)) {
-				value = bit;
-				break;
-			}
-			bit++;
-		}
+	bit_cnt = _bitstr_bits(b);
+	if (bit >= bit_cnt)
+		return -1;
+	nwords = _bit_data_words(bit_cnt);
+	word = bit >> BITSTR_SHIFT;
+	tmp = b[word + BITSTR_OVERHEAD] & ~_bit_tail_mask(bit);
+	while (tmp == 0) {
+		word = _bit_next_word(b, word + 1, nwords);
+		if (word < 0)
+			return -1;
+		tmp = b[word + BITSTR_OVERHEAD];
 	}
+	value = (word << BITSTR_SHIFT) + _word_ffs(tmp);
+	if (value >= bit_cnt)	/* only unused bits of last word set */
+		value = -1;
 	return value;
 }
 
@@ -426,39 +1035,24 @@ bit_ffs(bitstr_t *b)
 bitoff_t
 bit_fls(bitstr_t *b)
 {
-	bitoff_t bit, value = -1;
-	int word;
+	bitoff_t word, bit_cnt;
+	bitstr_t tmp;
 
 	_assert_bitstr_valid(b);
 
-	if (_bitstr_bits(b) == 0)	/* empty bitstring */
+	bit_cnt = _bitstr_bits(b);
+	if (bit_cnt == 0)	/* empty bitstring */
 		return -1;
 
-	bit = _bitstr_bits(b) - 1;	/* zero origin */
-
-	while (bit >= 0 && 		/* test partitial words */
-		(_bit_word(bit) == _bit_word(bit + 1))) {
-		if (bit_test(b, bit)) {
-			value = bit;
-			break;
-		}
-		bit--;
+	word = _bit_data_words(bit_cnt) - 1;
+	tmp = b[word + BITSTR_OVERHEAD] & _bit_word_mask(bit_cnt, word);
+	while (tmp == 0) {
+		word = _bit_prev_word(b, word - 1);
+		if (word < 0)
+			return -1;
+		tmp = b[word + BITSTR_OVERHEAD];
 	}
-	while (bit >= 0 && value == -1) {	/* test whole words */
-		word = _bit_word(bit);
-		if (b[word] == 0) {
-			bit -= sizeof(bitstr_t) * 8;
-			continue;
-		}
-		while (bit >= 0) {
-			if (bit_test(b, bit)) {
-				value = bit;
-				break;
-			}
-			bit--;
-		}
-	}
-	return value;
+	return (word << BITSTR_SHIFT) + _word_fls(tmp);
 }
 
 /*
@@ -486,18 +1080,35 @@ bit_fill_gaps(bitstr_t *b) {
  */
 int
 bit_super_set(bitstr_t *b1, bitstr_t *b2)  {
-	bitoff_t bit;
+	bitoff_t bit_cnt, nwords;
+	bitstr_t *w1, *w2;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	assert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != (b1[_bit_word(bit)] &
-		                           b2[_bit_word(bit)]))
-			return 0;
+	bit_cnt = _bitstr_bits(b1);
+	w1 = b1 + BITSTR_OVERHEAD;
+	w2 = b2 + BITSTR_OVERHEAD;
+	if (_bitstr_has_summary(b1)) {
+		bitoff_t word;
+		nwords = _bit_data_words(bit_cnt);
+		for (word = _bit_next_word(b1, 0, nwords); word >= 0;
+		     word = _bit_next_word(b1, word + 1, nwords)) {
+			if (w1[word] & ~w2[word] &
+			    _bit_word_mask(bit_cnt, word))
+				return 0;
+		}
+		return 1;
 	}
 
+	nwords = _bit_full_words(bit_cnt);
+	if (!bit_kernel.subset_words(w1, w2, nwords))
+		return 0;
+	if ((bit_cnt & BITSTR_MAXPOS) &&
+	    (w1[nwords] & ~w2[nwords] & _bit_tail_mask(bit_cnt)))
+		return 0;
+
 	return 1;
 }
 
@@ -507,7 +1118,8 @@ bit_super_set(bitstr_t *b1, bitstr_t *b2)  {
 extern int
 bit_equal(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitoff_t bit_cnt, nwords;
+	bitstr_t *w1, *w2;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
@@ -515,10 +1127,15 @@ bit_equal(bitstr_t *b1, bitstr_t *b2)
 	if (_bitstr_bits(b1) != _bitstr_bits(b2))
 		return 0;
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != b2[_bit_word(bit)])
-			return 0;
-	}
+	bit_cnt = _bitstr_bits(b1);
+	nwords = _bit_full_words(bit_cnt);
+	w1 = b1 + BITSTR_OVERHEAD;
+	w2 = b2 + BITSTR_OVERHEAD;
+	if (memcmp(w1, w2, nwords * sizeof(bitstr_t)))
+		return 0;
+	if ((bit_cnt & BITSTR_MAXPOS) &&
+	    ((w1[nwords] ^ w2[nwords]) & _bit_tail_mask(bit_cnt)))
+		return 0;
 
 	return 1;
 }
@@ -532,14 +1149,56 @@ bit_equal(bitstr_t *b1, bitstr_t *b2)
  */
 void
 bit_and(bitstr_t *b1, bitstr_t *b2) {
-	bitoff_t bit;
+	bitoff_t word, nwords;
+	bitstr_t *w1, *w2;
+
+	_assert_bitstr_valid(b1);
+	_assert_bitstr_valid(b2);
+	assert(_bitstr_bits(b1) == _bitstr_bits(b2));
+
+	nwords = _bit_data_words(_bitstr_bits(b1));
+	w1 = b1 + BITSTR_OVERHEAD;
+	w2 = b2 + BITSTR_OVERHEAD;
+	if (!_bitstr_has_summary(b1)) {
+		bit_kernel.and_words(w1, w2, nwords);
+		return;
+	}
+	/* only words which may be set in b1 can change */
+	for (word = _bit_next_word(b1, 0, nwords); word >= 0;
+	     word = _bit_next_word(b1, word + 1, nwords)) {
+		w1[word] &= w2[word];
+		if (w1[word] == 0)
+			_summary_clear(b1, word);
+	}
+}
+
+/*
+ * b1 &= ~b2, clear in b1 all bits set in b2
+ *   b1 (IN/OUT)	first bitmap
+ *   b2 (IN)		second bitmap, not modified
+ */
+void
+bit_and_not(bitstr_t *b1, bitstr_t *b2) {
+	bitoff_t word, nwords;
+	bitstr_t *w1, *w2;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	assert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
+	nwords = _bit_data_words(_bitstr_bits(b1));
+	w1 = b1 + BITSTR_OVERHEAD;
+	w2 = b2 + BITSTR_OVERHEAD;
+	if (!_bitstr_has_summary(b1)) {
+		bit_kernel.and_not_words(w1, w2, nwords);
+		return;
+	}
+	for (word = _bit_next_word(b1, 0, nwords); word >= 0;
+	     word = _bit_next_word(b1, word + 1, nwords)) {
+		w1[word] &= ~w2[word];
+		if (w1[word] == 0)
+			_summary_clear(b1, word);
+	}
 }
 
 /*
@@ -548,12 +1207,15 @@ bit_and(bitstr_t *b1, bitstr_t *b2) {
  */
 void
 bit_not(bitstr_t *b) {
-	bitoff_t bit;
+	bitoff_t word, nwords;
 
 	_assert_bitstr_valid(b);
 
-	for (bit = 0; bit < _bitstr_bits(b); bit += sizeof(bitstr_t)*8)
-		b[_bit_word(bit)] = ~b[_bit_word(bit)];
+	nwords = _bitstr_words(_bitstr_bits(b));
+	for (word = BITSTR_OVERHEAD; word < nwords; word++)
+		b[word] = ~b[word];
+	if (_bitstr_has_summary(b))
+		_summary_rebuild(b);
 }
 
 /*
@@ -563,14 +1225,29 @@ bit_not(bitstr_t *b) {
  */
 void
 bit_or(bitstr_t *b1, bitstr_t *b2) {
-	bitoff_t bit;
+	bitoff_t word, nwords;
+	bitstr_t *w1, *w2;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	assert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= b2[_bit_word(bit)];
+	nwords = _bit_data_words(_bitstr_bits(b1));
+	w1 = b1 + BITSTR_OVERHEAD;
+	w2 = b2 + BITSTR_OVERHEAD;
+	if (_bitstr_has_summary(b2)) {
+		/* only words which may be set in b2 can change */
+		for (word = _bit_next_word(b2, 0, nwords); word >= 0;
+		     word = _bit_next_word(b2, word + 1, nwords)) {
+			w1[word] |= w2[word];
+			if (_bitstr_has_summary(b1))
+				_summary_set(b1, word);
+		}
+		return;
+	}
+	bit_kernel.or_words(w1, w2, nwords);
+	if (_bitstr_has_summary(b1))
+		_summary_rebuild(b1);
 }
 
 
@@ -589,7 +1266,12 @@ bit_copy(bitstr_t *b)
 
 	newsize_bits  = bit_size(b);
 	len = (_bitstr_words(newsize_bits) - BITSTR_OVERHEAD)*sizeof(bitstr_t);
-	new = bit_alloc(newsize_bits);
+	if (_bitstr_has_summary(b)) {
+		/* copy the summary along with the data */
+		len += _bit_summary_words(newsize_bits) * sizeof(bitstr_t);
+		new = bit_alloc_sparse(newsize_bits);
+	} else
+		new = bit_alloc(newsize_bits);
 	if (new)
 		memcpy(&new[BITSTR_OVERHEAD], &b[BITSTR_OVERHEAD], len);
 
@@ -607,45 +1289,15 @@ bit_copybits(bitstr_t *dest, bitstr_t *src)
 
 	len = (_bitstr_words(bit_size(src)) - BITSTR_OVERHEAD)*sizeof(bitstr_t);
 	memcpy(&dest[BITSTR_OVERHEAD], &src[BITSTR_OVERHEAD], len);
+	if (!_bitstr_has_summary(dest))
+		return;
+	if (_bitstr_has_summary(src)) {
+		memcpy(_bit_summary(dest), _bit_summary(src),
+		       _bit_summary_words(bit_size(src)) * sizeof(bitstr_t));
+	} else
+		_summary_rebuild(dest);
 }
 
-#if !defined(USE_64BIT_BITSTR)
-/*
- * Returns the hamming weight (i.e. the number of bits set) in a word.
- * NOTE: This routine borrowed from Linux 2.4.9 <linux/bitops.h>.
- */
-static uint32_t
-hweight(uint32_t w)
-{
-	uint32_t res;
-
-	res = (w   & 0x55555555) + ((w >> 1)    & 0x55555555);
-	res = (res & 0x33333333) + ((res >> 2)  & 0x33333333);
-	res = (res & 0x0F0F0F0F) + ((res >> 4)  & 0x0F0F0F0F);
-	res = (res & 0x00FF00FF) + ((res >> 8)  & 0x00FF00FF);
-	res = (res & 0x0000FFFF) + ((res >> 16) & 0x0000FFFF);
-
-	return res;
-}
-#else
-/*
- * A 64 bit version crafted from 32-bit one borrowed above.
- */
-static uint64_t
-hweight(uint64_t w)
-{
-	uint64_t res;
-
-	res = (w   & 0x5555555555555555) + ((w >> 1)    & 0x5555555555555555);
-	res = (res & 0x3333333333333333) + ((res >> 2)  & 0x3333333333333333);
-	res = (res & 0x0F0F0F0F0F0F0F0F) + ((res >> 4)  & 0x0F0F0F0F0F0F0F0F);
-	res = (res & 0x00FF00FF00FF00FF) + ((res >> 8)  & 0x00FF00FF00FF00FF);
-	res = (res & 0x0000FFFF0000FFFF) + ((res >> 16) & 0x0000FFFF0000FFFF);
-	res = (res & 0x00000000FFFFFFFF) + ((res >> 32) & 0x00000000FFFFFFFF);
-
-	return res;
-}
-#endif /* !USE_64BIT_BITSTR */
 
 /*
  * Count the number of bits set in bitstring.
@@ -655,21 +1307,29 @@ hweight(uint64_t w)
 int
 bit_set_count(bitstr_t *b)
 {
-	int count = 0;
-	bitoff_t bit, bit_cnt;
-	int word_size = sizeof(bitstr_t) * 8;
+	int count;
+	bitoff_t bit_cnt, nwords;
 
 	_assert_bitstr_valid(b);
 
 	bit_cnt = _bitstr_bits(b);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
-		if ((bit + word_size - 1) >= bit_cnt)
-			break;
-		count += hweight(b[_bit_word(bit)]);
+	if (_bitstr_has_summary(b)) {
+		bitoff_t word;
+		count = 0;
+		nwords = _bit_data_words(bit_cnt);
+		for (word = _bit_next_word(b, 0, nwords); word >= 0;
+		     word = _bit_next_word(b, word + 1, nwords)) {
+			count += hweight(b[word + BITSTR_OVERHEAD] &
+					 _bit_word_mask(bit_cnt, word));
+		}
+		return count;
 	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b, bit))
-			count++;
+
+	nwords = _bit_full_words(bit_cnt);
+	count = bit_kernel.count_words(b + BITSTR_OVERHEAD, nwords);
+	if (bit_cnt & BITSTR_MAXPOS) {
+		count += hweight(b[nwords + BITSTR_OVERHEAD] &
+				 _bit_tail_mask(bit_cnt));
 	}
 
 	return count;
@@ -681,28 +1341,80 @@ bit_set_count(bitstr_t *b)
 extern int
 bit_overlap(bitstr_t *b1, bitstr_t *b2)
 {
-	int count = 0;
-	bitoff_t bit, bit_cnt;
-	int word_size = sizeof(bitstr_t) * 8;
+	int count;
+	bitoff_t bit_cnt, nwords;
+	bitstr_t *w1, *w2;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	assert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
 	bit_cnt = _bitstr_bits(b1);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
-		if ((bit + word_size - 1) >= bit_cnt)
-			break;
-		count += hweight(b1[_bit_word(bit)] & b2[_bit_word(bit)]);
+	w1 = b1 + BITSTR_OVERHEAD;
+	w2 = b2 + BITSTR_OVERHEAD;
+	if (_bitstr_has_summary(b1) || _bitstr_has_summary(b2)) {
+		bitstr_t *sb = _bitstr_has_summary(b1) ? b1 : b2;
+		bitoff_t word;
+		count = 0;
+		nwords = _bit_data_words(bit_cnt);
+		for (word = _bit_next_word(sb, 0, nwords); word >= 0;
+		     word = _bit_next_word(sb, word + 1, nwords)) {
+			count += hweight(w1[word] & w2[word] &
+					 _bit_word_mask(bit_cnt, word));
+		}
+		return count;
 	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b1, bit) && bit_test(b2, bit))
-			count++;
+
+	nwords = _bit_full_words(bit_cnt);
+	count = bit_kernel.and_count_words(w1, w2, nwords);
+	if (bit_cnt & BITSTR_MAXPOS) {
+		count += hweight(w1[nwords] & w2[nwords] &
+				 _bit_tail_mask(bit_cnt));
 	}
 
 	return count;
 }
 
+/*
+ * return 1 if any bit set in b1 is also set in b2, 0 if no overlap.
+ * Faster than bit_overlap() when only the existence of overlap matters.
+ */
+extern int
+bit_overlap_any(bitstr_t *b1, bitstr_t *b2)
+{
+	bitoff_t bit_cnt, nwords;
+	bitstr_t *w1, *w2;
+
+	_assert_bitstr_valid(b1);
+	_assert_bitstr_valid(b2);
+	assert(_bitstr_bits(b1) == _bitstr_bits(b2));
+
+	bit_cnt = _bitstr_bits(b1);
+	w1 = b1 + BITSTR_OVERHEAD;
+	w2 = b2 + BITSTR_OVERHEAD;
+	if (_bitstr_has_summary(b1) || _bitstr_has_summary(b2)) {
+		bitstr_t *sb = _bitstr_has_summary(b1) ? b1 : b2;
+		bitoff_t word;
+		nwords = _bit_data_words(bit_cnt);
+		for (word = _bit_next_word(sb, 0, nwords); word >= 0;
+		     word = _bit_next_word(sb, word + 1, nwords)) {
+			if (w1[word] & w2[word] &
+			    _bit_word_mask(bit_cnt, word))
+				return 1;
+		}
+		return 0;
+	}
+
+	nwords = _bit_full_words(bit_cnt);
+	if (bit_kernel.intersect_words(w1, w2, nwords))
+		return 1;
+	if ((bit_cnt & BITSTR_MAXPOS) &&
+	    (w1[nwords] & w2[nwords] & _bit_tail_mask(bit_cnt)))
+		return 1;
+
+	return 0;
+}
+
 /*
  * Count the number of bits clear in bitstring.
  *   b (IN)		bitstring to check
@@ -726,11 +1438,31 @@ bit_nset_max_count(bitstr_t *b)
 	int cnt = 0;
 	int maxcnt = 0;
 	uint32_t bitsize;
+	bitstr_t word;
 
 	_assert_bitstr_valid(b);
 	bitsize = _bitstr_bits(b);
 
 	for (bit = 0; bit < bitsize; bit++) {
+		if (((bit & BITSTR_MAXPOS) == 0) &&
+		    ((bit + BITSTR_WORD_BITS) <= bitsize)) {
+			/* handle whole words that are all clear or all set */
+			word = b[_bit_word(bit)];
+			if (word == 0) {
+				if ((bitsize - bit) < maxcnt)
+					break;	/* already found max */
+				cnt = 0;
+				bit += BITSTR_WORD_BITS - 1;
+				continue;
+			}
+			if (word == (bitstr_t) ~0) {
+				cnt += BITSTR_WORD_BITS;
+				if (cnt > maxcnt)
+					maxcnt = cnt;
+				bit += BITSTR_WORD_BITS - 1;
+				continue;
+			}
+		}
 		if (!bit_test(b, bit)) {	/* no longer continuous */
 			cnt = 0;
 		} else {
@@ -756,15 +1488,25 @@ bit_nset_max_count(bitstr_t *b)
  */
 int
 int_and_set_count(int *i1, int ilen, bitstr_t *b2) {
-	bitoff_t bit;
+	bitoff_t bit, bit_cnt, word, nwords;
+	bitstr_t tmp;
 	int sum;
 
 	_assert_bitstr_valid(b2);
 
 	sum = 0;
-	for (bit = 0; bit < _bitstr_bits(b2); bit++) {
-	    	if (bit_test(b2, bit))
+	bit_cnt = _bitstr_bits(b2);
+	nwords = _bit_data_words(bit_cnt);
+	for (word = _bit_next_word(b2, 0, nwords); word >= 0;
+	     word = _bit_next_word(b2, word + 1, nwords)) {
+		tmp = b2[word + BITSTR_OVERHEAD];
+		while (tmp) {
+			bit = (word << BITSTR_SHIFT) + _word_ffs(tmp);
+			if (bit >= bit_cnt)
+				break;
 			sum += i1[bit % ilen];
+			tmp &= ~_bit_mask(bit);
+		}
 	}
 	return(sum);
 }
@@ -905,37 +1647,31 @@ bit_pick_cnt(bitstr_t *b, bitoff_t nbits) {
 char *
 bit_fmt(char *str, int len, bitstr_t *b)
 {
-	int count = 0, ret, word;
+	int count = 0, ret;
 	bitoff_t start, bit;
 
 	_assert_bitstr_valid(b);
 	assert(len > 0);
 	*str = '\0';
-	for (bit = 0; bit < _bitstr_bits(b); ) {
-		word = _bit_word(bit);
-		if (b[word] == 0) {
-			bit += sizeof(bitstr_t)*8;
-			continue;
-		}
-
-		if (bit_test(b, bit)) {
+	for (bit = bit_ffs(b); bit >= 0; ) {
+		count++;
+		start = bit;
+		while (bit+1 < _bitstr_bits(b) && bit_test(b, bit+1)) {
+			bit++;
 			count++;
-			start = bit;
-			while (bit+1 < _bitstr_bits(b) && bit_test(b, bit+1)) {
-				bit++;
-				count++;
-			}
-			if (bit == start)	/* add single bit position */
-				ret = snprintf(str+strlen(str),
-				               len-strlen(str),
-				               BITSTR_SINGLE_FMT, start);
-			else 			/* add bit position range */
-				ret = snprintf(str+strlen(str),
-				               len-strlen(str),
-				               BITSTR_RANGE_FMT, start, bit);
-			assert(ret != -1);
 		}
-		bit++;
+		if (bit == start)	/* add single bit position */
+			ret = snprintf(str+strlen(str),
+			               len-strlen(str),
+			               BITSTR_SINGLE_FMT, start);
+		else 			/* add bit position range */
+			ret = snprintf(str+strlen(str),
+			               len-strlen(str),
+			               BITSTR_RANGE_FMT, start, bit);
+		assert(ret != -1);
+		if (++bit >= _bitstr_bits(b))
+			break;
+		bit = bit_ffs_from_bit(b, bit);
 	}
 	if (count > 0)
 		str[strlen(str) - 1] = '\0'; 	/* zap trailing comma */
@@ -1227,26 +1963,36 @@ int bit_unfmt_binmask(bitstr_t * bitmap, const char* str)
 bitoff_t
 bit_get_bit_num(bitstr_t *b, int pos)
 {
-	bitoff_t bit;
-	int cnt = 0;
+	bitoff_t bit, word, nwords;
+	bitstr_t tmp;
+	int cnt = 0, word_cnt;
 	bitoff_t bit_cnt;
 
 	_assert_bitstr_valid(b);
 	bit_cnt = _bitstr_bits(b);
 	assert(pos <= bit_cnt);
 
-	for (bit = 0; bit < bit_cnt; bit++) {
-		if (bit_test(b, bit)) {	/* we got one */
-			if(cnt == pos)
-				break;
+	nwords = _bit_data_words(bit_cnt);
+	for (word = _bit_next_word(b, 0, nwords); word >= 0;
+	     word = _bit_next_word(b, word + 1, nwords)) {
+		tmp = b[word + BITSTR_OVERHEAD];
+		word_cnt = hweight(tmp);
+		if ((cnt + word_cnt) <= pos) {	/* skip whole word */
+			cnt += word_cnt;
+			continue;
+		}
+		while (1) {
+			bit = (word << BITSTR_SHIFT) + _word_ffs(tmp);
+			if (bit >= bit_cnt)
+				return -1;
+			if (cnt == pos)
+				return bit;
 			cnt++;
+			tmp &= ~_bit_mask(bit);
 		}
 	}
 
-	if(bit >= bit_cnt)
-		bit = -1;
-
-	return bit;
+	return -1;
 }
 
 /* Find want nth the bit pos is set in bitstr b.
@@ -1258,7 +2004,7 @@ bit_get_bit_num(bitstr_t *b, int pos)
 int
 bit_get_pos_num(bitstr_t *b, bitoff_t pos)
 {
-	bitoff_t bit;
+	bitoff_t word;
 	int cnt = -1;
 	bitoff_t bit_cnt;
 
@@ -1270,11 +2016,13 @@ bit_get_pos_num(bitstr_t *b, bitoff_t pos)
 		error("bit %d not set", pos);
 		return cnt;
 	}
-	for (bit = 0; bit <= pos; bit++) {
-		if (bit_test(b, bit)) {	/* we got one */
-			cnt++;
-		}
-	}
+	/* count the whole words below pos, then bits 0..pos of its word */
+	word = pos >> BITSTR_SHIFT;
+	cnt += bit_kernel.count_words(b + BITSTR_OVERHEAD, word);
+	if ((pos + 1) & BITSTR_MAXPOS)
+		cnt += hweight(b[_bit_word(pos)] & _bit_tail_mask(pos + 1));
+	else
+		cnt += hweight(b[_bit_word(pos)]);
 
 	return cnt;
 }
@@ -49,6 +49,12 @@
  *
  * bitstrings are zero origin
  *
+ * A bitstr_t allocated with bit_alloc_sparse() is followed by a summary
+ * bitmap holding one bit per data word, set if that word may have bits set.
+ * Searches, counts and iteration over set bits use it to skip empty regions
+ * of large, sparsely populated bitmaps. Such a bitstr_t is otherwise used
+ * like any other.
+ *
  * bitstrings are always stored in a little-endian fashion.  In other words,
  * bit "1" is always in the byte of a word at the lowest memory address,
  * regardless of the native architecture endianness.
@@ -99,6 +105,7 @@ typedef bitstr_t bitoff_t;
 /* bitstr_t signature in first word */
 #define BITSTR_MAGIC 		0x42434445
 #define BITSTR_MAGIC_STACK	0x42434446 /* signature if on stack */
+#define BITSTR_MAGIC_SUMMARY	0x42434447 /* signature if summary present */
 
 /* max bit position in word */
 #define BITSTR_MAXPOS		(sizeof(bitstr_t)*8 - 1)
@@ -131,7 +138,8 @@ typedef bitstr_t bitoff_t;
 #define _assert_bitstr_valid(name) do { \
 	assert((name) != NULL); \
 	assert(_bitstr_magic(name) == BITSTR_MAGIC \
-			    || _bitstr_magic(name) == BITSTR_MAGIC_STACK); \
+			    || _bitstr_magic(name) == BITSTR_MAGIC_STACK \
+			    || _bitstr_magic(name) == BITSTR_MAGIC_SUMMARY); \
 } while (0)
 
 /* check bit position */
@@ -160,15 +168,18 @@ void bit_nset(bitstr_t *b, bitoff_t start, bitoff_t stop);
 /* changed interface from Vixie macros */
 bitoff_t bit_ffc(bitstr_t *b);
 bitoff_t bit_ffs(bitstr_t *b);
+bitoff_t bit_ffs_from_bit(bitstr_t *b, bitoff_t bit);
 
 /* new */
 bitoff_t bit_nffs(bitstr_t *b, int n);
 bitoff_t bit_nffc(bitstr_t *b, int n);
 bitoff_t bit_noc(bitstr_t *b, int n, int seed);
 void	bit_free(bitstr_t *b);
+bitstr_t *bit_alloc_sparse(bitoff_t nbits);
 bitstr_t *bit_realloc(bitstr_t *b, bitoff_t nbits);
 bitoff_t bit_size(bitstr_t *b);
 void	bit_and(bitstr_t *b1, bitstr_t *b2);
+void	bit_and_not(bitstr_t *b1, bitstr_t *b2);
 void	bit_not(bitstr_t *b);
 void	bit_or(bitstr_t *b1, bitstr_t *b2);
 int	bit_set_count(bitstr_t *b);
@@ -190,6 +201,7 @@ bitoff_t bit_fls(bitstr_t *b);
 void	bit_fill_gaps(bitstr_t *b);
 int	bit_super_set(bitstr_t *b1, bitstr_t *b2);
 int     bit_overlap(bitstr_t *b1, bitstr_t *b2);
+int     bit_overlap_any(bitstr_t *b1, bitstr_t *b2);
 int     bit_equal(bitstr_t *b1, bitstr_t *b2);
 void    bit_copybits(bitstr_t *dest, bitstr_t *src);
 bitstr_t *bit_copy(bitstr_t *b);
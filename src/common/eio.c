@@ -40,9 +40,14 @@
 #endif
 
 #include <sys/poll.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
 
+#ifdef HAVE_SYS_EPOLL_H
+#  include <sys/epoll.h>
+#endif
+
 #include "src/common/xmalloc.h"
 #include "src/common/xassert.h"
 #include "src/common/log.h"
@@ -64,8 +69,36 @@ struct eio_handle_components {
 	int  fds[2];
 	List obj_list;
 	List new_objs;
+	bool use_poll;		/* never use epoll for this handle */
+};
+
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * State of eio_handle_mainloop when using epoll. Each registration is
+ * identified by its fd and a generation number, so that events left over
+ * from an fd which an object has since closed are recognized.
+ */
+struct eio_ready {
+	eio_obj_t *obj;
+	short revents;
 };
 
+struct eio_epoll {
+	int epfd;
+	uint32_t gen;			/* generation of last registration */
+	eio_obj_t **owner;		/* registered object by fd */
+	int owner_size;
+	struct epoll_event *events;
+	int max_events;
+	struct eio_ready *ready;	/* objects ready without epoll */
+	int nready, max_ready;
+	eio_obj_t **objs;		/* copy of the handle's obj_list */
+	int nobjs, max_objs;
+};
+
+#define EIO_EPOLL_FALLBACK	-2	/* continue with poll() */
+#endif
+
 
 /* Function prototypes
  */
@@ -76,6 +109,10 @@ static void         _poll_dispatch(struct pollfd *, unsigned int, eio_obj_t **,
 		                   List objList);
 static void         _poll_handle_event(short revents, eio_obj_t *obj,
 		                       List objList);
+static int          _poll_mainloop(eio_handle_t *eio);
+#ifdef HAVE_SYS_EPOLL_H
+static int          _epoll_mainloop(eio_handle_t *eio);
+#endif
 
 eio_handle_t *eio_handle_create(void)
 {
@@ -115,6 +152,14 @@ void eio_handle_destroy(eio_handle_t *eio)
 	xfree(eio);
 }
 
+void eio_handle_use_poll(eio_handle_t *eio)
+{
+	xassert(eio != NULL);
+	xassert(eio->magic == EIO_MAGIC);
+
+	eio->use_poll = true;
+}
+
 bool eio_message_socket_readable(eio_obj_t *obj)
 {
 	debug3("Called eio_message_socket_readable %d %d",
@@ -242,6 +287,21 @@ static int _eio_wakeup_handler(eio_handle_t *eio)
 }
 
 int eio_handle_mainloop(eio_handle_t *eio)
+{
+	xassert (eio != NULL);
+	xassert (eio->magic == EIO_MAGIC);
+
+#ifdef HAVE_SYS_EPOLL_H
+	if (!eio->use_poll) {
+		int rc = _epoll_mainloop(eio);
+		if (rc != EIO_EPOLL_FALLBACK)
+			return rc;
+	}
+#endif
+	return _poll_mainloop(eio);
+}
+
+static int _poll_mainloop(eio_handle_t *eio)
 {
 	int            retval  = 0;
 	struct pollfd *pollfds = NULL;
@@ -249,9 +309,6 @@ int eio_handle_mainloop(eio_handle_t *eio)
 	unsigned int   maxnfds = 0, nfds = 0;
 	unsigned int   n       = 0;
 
-	xassert (eio != NULL);
-	xassert (eio->magic == EIO_MAGIC);
-
 	for (;;) {
 
 		/* Alloc memory for pfds and map if needed */
@@ -438,6 +495,294 @@ _poll_handle_event(short revents, eio_obj_t *obj, List objList)
 	}
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+static short
+_epoll_to_poll_events(uint32_t events)
+{
+	short revents = 0;
+
+	if (events & EPOLLIN)
+		revents |= POLLIN;
+	if (events & EPOLLOUT)
+		revents |= POLLOUT;
+	if (events & EPOLLERR)
+		revents |= POLLERR;
+	if (events & EPOLLHUP)
+		revents |= POLLHUP;
+	return revents;
+}
+
+/* Report an object as ready without asking epoll, as poll() would */
+static void
+_epoll_add_ready(struct eio_epoll *ep, eio_obj_t *obj, short revents)
+{
+	if (ep->nready >= ep->max_ready) {
+		ep->max_ready = MAX(16, ep->max_ready * 2);
+		xrealloc(ep->ready, ep->max_ready * sizeof(struct eio_ready));
+	}
+	ep->ready[ep->nready].obj = obj;
+	ep->ready[ep->nready].revents = revents;
+	ep->nready++;
+}
+
+/* Forget an object's registration, the kernel may already have done so */
+static void
+_epoll_unregister(struct eio_epoll *ep, eio_obj_t *obj)
+{
+	struct epoll_event ev;	/* for kernels before 2.6.9 */
+
+	if (obj->reg_fd < 0)
+		return;
+	if (!obj->reg_always)
+		(void) epoll_ctl(ep->epfd, EPOLL_CTL_DEL, obj->reg_fd, &ev);
+	if ((obj->reg_fd < ep->owner_size) && (ep->owner[obj->reg_fd] == obj))
+		ep->owner[obj->reg_fd] = NULL;
+	obj->reg_fd = -1;
+	obj->reg_events = 0;
+	obj->reg_gen = 0;
+	obj->reg_always = false;
+}
+
+/*
+ * Make the registration of "obj" match the "events" it now waits for.
+ * Returns SLURM_SUCCESS or EIO_EPOLL_FALLBACK.
+ */
+static int
+_epoll_update(struct eio_epoll *ep, eio_obj_t *obj, uint32_t events)
+{
+	struct epoll_event ev;
+	eio_obj_t *other;
+	int fd = obj->fd;
+
+	/* Objects that wait for nothing must not be registered at all,
+	 * epoll always reports EPOLLERR and EPOLLHUP */
+	if ((obj->reg_fd >= 0) && ((obj->reg_fd != fd) || (events == 0)))
+		_epoll_unregister(ep, obj);
+	if ((events == 0) || (fd < 0))
+		return SLURM_SUCCESS;	/* poll() ignores fd -1 as well */
+
+	if (obj->reg_fd == fd) {
+		if (obj->reg_always) {
+			_epoll_add_ready(ep, obj,
+					 _epoll_to_poll_events(events));
+			return SLURM_SUCCESS;
+		}
+		if (obj->reg_events == events)
+			return SLURM_SUCCESS;
+		ev.events = events;
+		ev.data.u64 = ((uint64_t) obj->reg_gen << 32) | fd;
+		if (epoll_ctl(ep->epfd, EPOLL_CTL_MOD, fd, &ev) == 0) {
+			obj->reg_events = events;
+			return SLURM_SUCCESS;
+		}
+		/* The fd was closed and reopened, register it anew */
+		_epoll_unregister(ep, obj);
+	}
+
+	if (fd >= ep->owner_size) {
+		int old_size = ep->owner_size;
+		ep->owner_size = MAX(fd + 1, ep->owner_size * 2);
+		xrealloc(ep->owner, ep->owner_size * sizeof(eio_obj_t *));
+		memset(ep->owner + old_size, 0,
+		       (ep->owner_size - old_size) * sizeof(eio_obj_t *));
+	}
+	if ((other = ep->owner[fd])) {
+		if (other->fd == fd) {
+			debug2("eio: fd %d used by two objects", fd);
+			return EIO_EPOLL_FALLBACK;
+		}
+		/* The other object has given up this fd */
+		_epoll_unregister(ep, other);
+	}
+
+	if (++ep->gen == 0)
+		ep->gen = 1;	/* generation 0 is the wakeup fd */
+	ev.events = events;
+	ev.data.u64 = ((uint64_t) ep->gen << 32) | fd;
+	if (epoll_ctl(ep->epfd, EPOLL_CTL_ADD, fd, &ev) == 0) {
+		obj->reg_always = false;
+	} else if (errno == EPERM) {
+		/* Regular files do not support epoll, but are always ready */
+		obj->reg_always = true;
+		_epoll_add_ready(ep, obj, _epoll_to_poll_events(events));
+	} else if (errno == EBADF) {
+		_epoll_add_ready(ep, obj, POLLNVAL);
+		return SLURM_SUCCESS;
+	} else {
+		debug2("eio: epoll_ctl(%d): %m", fd);
+		return EIO_EPOLL_FALLBACK;
+	}
+	obj->reg_fd = fd;
+	obj->reg_events = events;
+	obj->reg_gen = ep->gen;
+	ep->owner[fd] = obj;
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Bring the registrations up to date with what each object waits for.
+ * Returns the number of objects waiting for something, as poll() would
+ * have been called with, or EIO_EPOLL_FALLBACK.
+ */
+static int
+_epoll_setup(struct eio_epoll *ep, List l)
+{
+	eio_obj_t    *obj  = NULL;
+	int           i, nobj = 0;
+	uint32_t      events;
+
+	/* Objects are only ever added to the list while the mainloop runs,
+	 * so walk a copy of it rather than lock the list for every object */
+	if ((i = list_count(l)) != ep->nobjs) {
+		ListIterator iter = list_iterator_create(l);
+		if (i > ep->max_objs) {
+			ep->max_objs = i;
+			xrealloc(ep->objs, ep->max_objs * sizeof(eio_obj_t *));
+		}
+		for (i = 0; (obj = list_next(iter)) && (i < ep->max_objs); i++)
+			ep->objs[i] = obj;
+		ep->nobjs = i;
+		list_iterator_destroy(iter);
+	}
+
+	ep->nready = 0;
+	for (i = 0; i < ep->nobjs; i++) {
+		obj = ep->objs[i];
+		events = 0;
+		if (_is_writable(obj))
+			events |= EPOLLOUT;
+		if (_is_readable(obj))
+			events |= EPOLLIN;
+		if (events)
+			nobj++;
+		if (_epoll_update(ep, obj, events) != SLURM_SUCCESS)
+			return EIO_EPOLL_FALLBACK;
+	}
+	return nobj;
+}
+
+static void
+_epoll_cleanup(struct eio_epoll *ep, List l)
+{
+	ListIterator  i   = list_iterator_create(l);
+	eio_obj_t    *obj = NULL;
+
+	while ((obj = list_next(i))) {
+		obj->reg_fd = -1;
+		obj->reg_events = 0;
+		obj->reg_gen = 0;
+		obj->reg_always = false;
+	}
+	list_iterator_destroy(i);
+
+	if (ep->epfd >= 0)
+		close(ep->epfd);
+	xfree(ep->owner);
+	xfree(ep->events);
+	xfree(ep->ready);
+	xfree(ep->objs);
+}
+
+static int _epoll_mainloop(eio_handle_t *eio)
+{
+	struct eio_epoll ep;
+	struct epoll_event ev;
+	eio_obj_t *obj;
+	uint32_t gen;
+	int retval = 0, n, i, fd, nobj;
+
+	memset(&ep, 0, sizeof(struct eio_epoll));
+	if ((ep.epfd = epoll_create(64)) < 0) {
+		debug2("eio: epoll_create: %m");
+		return EIO_EPOLL_FALLBACK;
+	}
+	fd_set_close_on_exec(ep.epfd);
+
+	/* Setup eio handle signalling fd */
+	ev.events = EPOLLIN;
+	ev.data.u64 = (uint64_t) eio->fds[0];
+	if (epoll_ctl(ep.epfd, EPOLL_CTL_ADD, eio->fds[0], &ev) < 0) {
+		debug2("eio: epoll_ctl(%d): %m", eio->fds[0]);
+		retval = EIO_EPOLL_FALLBACK;
+		goto done;
+	}
+
+	for (;;) {
+		debug4("eio: handling events for %d objects",
+		       list_count(eio->obj_list));
+		nobj = _epoll_setup(&ep, eio->obj_list);
+		if (nobj == EIO_EPOLL_FALLBACK) {
+			retval = EIO_EPOLL_FALLBACK;
+			goto done;
+		}
+		if (nobj <= 0)
+			goto done;
+
+		if (ep.max_events < nobj + 1) {
+			ep.max_events = nobj + 1;
+			xrealloc(ep.events,
+				 ep.max_events * sizeof(struct epoll_event));
+		}
+
+		/* Objects ready without epoll must not wait for others */
+		while ((n = epoll_wait(ep.epfd, ep.events, ep.max_events,
+				       ep.nready ? 0 : -1)) < 0) {
+			if (errno == EINTR) {
+				n = 0;
+				/* like poll(), dispatch nothing */
+				ep.nready = 0;
+				break;
+			}
+			error("epoll_wait: %m");
+			retval = -1;
+			goto done;
+		}
+
+		/* Verify all events before dispatching any of them, the
+		 * handlers might change the objects */
+		for (i = 0; i < n; i++) {
+			fd  = (int) (ep.events[i].data.u64 & 0xffffffff);
+			gen = (uint32_t) (ep.events[i].data.u64 >> 32);
+			if (gen == 0) {
+				if (fd == eio->fds[0])
+					continue;
+			} else if ((fd < ep.owner_size) &&
+				   (obj = ep.owner[fd]) &&
+				   (obj->reg_gen == gen)) {
+				continue;
+			}
+			/* An fd closed by an object, but kept open by
+			 * another process. Start over without epoll. */
+			debug2("eio: stale epoll event for fd %d", fd);
+			retval = EIO_EPOLL_FALLBACK;
+			goto done;
+		}
+
+		for (i = 0; i < n; i++) {
+			if ((ep.events[i].data.u64 >> 32) == 0 &&
+			    (ep.events[i].events & EPOLLIN))
+				_eio_wakeup_handler(eio);
+		}
+
+		for (i = 0; i < n; i++) {
+			if ((ep.events[i].data.u64 >> 32) == 0)
+				continue;
+			fd  = (int) (ep.events[i].data.u64 & 0xffffffff);
+			_poll_handle_event(
+				_epoll_to_poll_events(ep.events[i].events),
+				ep.owner[fd], eio->obj_list);
+		}
+		for (i = 0; i < ep.nready; i++) {
+			_poll_handle_event(ep.ready[i].revents,
+					   ep.ready[i].obj, eio->obj_list);
+		}
+	}
+  done:
+	_epoll_cleanup(&ep, eio->obj_list);
+	return retval;
+}
+#endif	/* HAVE_SYS_EPOLL_H */
+
 static struct io_operations *
 _ops_copy(struct io_operations *ops)
 {
@@ -456,6 +801,7 @@ eio_obj_create(int fd, struct io_operations *ops, void *arg)
 	obj->arg = arg;
 	obj->ops = _ops_copy(ops);
 	obj->shutdown = false;
+	obj->reg_fd = -1;
 	return obj;
 }
 
@@ -67,11 +67,24 @@ struct eio_obj {
 	void *arg;                        /* application-specific data       */
 	struct io_operations *ops;        /* pointer to ops struct for obj   */
 	bool shutdown;
+
+	/* epoll registration, private to eio.c */
+	int reg_fd;                       /* fd registered, -1 if none       */
+	uint32_t reg_events;              /* events registered for reg_fd    */
+	uint32_t reg_gen;                 /* generation of that registration */
+	bool reg_always;                  /* reg_fd can not be epolled, it is
+					   * always ready (regular file)     */
 };
 
 eio_handle_t *eio_handle_create(void);
 void eio_handle_destroy(eio_handle_t *eio);
 
+/*
+ * Have eio_handle_mainloop use poll() rather than epoll, where available.
+ * Must be called before the mainloop is started.
+ */
+void eio_handle_use_poll(eio_handle_t *eio);
+
 /*
  * Add an eio_obj_t "obj" to an eio_handle_t "eio"'s internal object list.
  *
@@ -91,6 +104,15 @@ void eio_new_obj(eio_handle_t *eio, eio_obj_t *obj);
 /* This routine will watch for activtiy on the fd's as long
  * as obj->readable() or obj->writable() returns >0
  *
+ * Where available the fd's are kept registered with epoll, so that only
+ * a change of what an object waits for costs a system call and only
+ * ready objects are dispatched. The readable() and writable() functions
+ * are still called for every object each time around the loop. Objects
+ * epoll can not watch are handled the way poll() would: regular files
+ * are always ready, closed fd's get POLLNVAL. Should the registrations
+ * no longer match the objects (e.g. two objects with one fd), the loop
+ * continues with poll().
+ *
  * routine returns 0 when either list is empty or no objects in list are
  * readable() or writable().
  *
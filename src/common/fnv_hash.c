@@ -0,0 +1,57 @@
+/*****************************************************************************\
+ *  fnv_hash.c - Fowler/Noll/Vo (FNV-1a) hash of a byte array
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://www.schedmd.com/slurmdocs/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "src/common/fnv_hash.h"
+
+#define FNV_OFFSET_BASIS_64	0xcbf29ce484222325ULL
+#define FNV_PRIME_64		0x100000001b3ULL
+
+extern uint64_t fnv_hash64(const void *data, uint32_t size)
+{
+	const unsigned char *ptr = data;
+	uint64_t hash = FNV_OFFSET_BASIS_64;
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		hash ^= ptr[i];
+		hash *= FNV_PRIME_64;
+	}
+	return hash;
+}
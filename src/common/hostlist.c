@@ -105,11 +105,13 @@ strong_alias(hostlist_iterator_reset,	slurm_hostlist_iterator_reset);
 strong_alias(hostlist_next,		slurm_hostlist_next);
 strong_alias(hostlist_next_range,	slurm_hostlist_next_range);
 strong_alias(hostlist_nth,		slurm_hostlist_nth);
+strong_alias(hostlist_nth_range,	slurm_hostlist_nth_range);
 strong_alias(hostlist_pop,		slurm_hostlist_pop);
 strong_alias(hostlist_pop_range,	slurm_hostlist_pop_range);
 strong_alias(hostlist_push,		slurm_hostlist_push);
 strong_alias(hostlist_push_host_dims,	slurm_hostlist_push_host_dims);
 strong_alias(hostlist_push_host,	slurm_hostlist_push_host);
+strong_alias(hostlist_push_host_range,	slurm_hostlist_push_host_range);
 strong_alias(hostlist_push_list,	slurm_hostlist_push_list);
 strong_alias(hostlist_ranged_string_dims,
 	                                slurm_hostlist_ranged_string_dims);
@@ -2003,6 +2005,18 @@ int hostlist_push_host(hostlist_t hl, const char *str)
 	return hostlist_push_host_dims(hl, str, dims);
 }
 
+int hostlist_push_host_range(hostlist_t hl, const char *prefix,
+			     unsigned long lo, unsigned long hi, int width)
+{
+	if (!prefix || !hl || (hi < lo))
+		return 0;
+
+	if (hostlist_push_hr(hl, (char *) prefix, lo, hi, width) < 0)
+		return 0;
+
+	return (int) (hi - lo + 1);
+}
+
 int hostlist_push_list(hostlist_t h1, hostlist_t h2)
 {
 	int i, n = 0;
@@ -2266,6 +2280,38 @@ char * hostlist_nth(hostlist_t hl, int n)
 	return host;
 }
 
+int hostlist_nth_range(hostlist_t hl, int n, char **prefix,
+		       unsigned long *lo, unsigned long *hi, int *width)
+{
+	hostrange_t hr;
+	int retval;
+
+	if (!hl || !prefix)
+		return -1;
+	LOCK_HOSTLIST(hl);
+	if ((n < 0) || (n >= hl->nranges)) {
+		UNLOCK_HOSTLIST(hl);
+		return -1;
+	}
+
+	hr = hl->hr[n];
+	if (!(*prefix = strdup(hr->prefix))) {
+		UNLOCK_HOSTLIST(hl);
+		seterrno_ret(ENOMEM, -2);
+	}
+	if (hr->singlehost) {
+		retval = 0;
+	} else {
+		*lo    = hr->lo;
+		*hi    = hr->hi;
+		*width = hr->width;
+		retval = 1;
+	}
+	UNLOCK_HOSTLIST(hl);
+
+	return retval;
+}
+
 
 int hostlist_delete_nth(hostlist_t hl, int n)
 {
@@ -199,6 +199,17 @@ int hostlist_push(hostlist_t hl, const char *hosts);
 int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims);
 int hostlist_push_host(hostlist_t hl, const char *host);
 
+/* hostlist_push_host_range():
+ *
+ * Push the hosts prefix[lo-hi] onto the hostlist hl, with the numeric
+ * suffix zero padded to width. Unlike hostlist_push(), no hostname is
+ * formatted or parsed, so this is the cheap way to add a large range.
+ *
+ * Returns the number of hosts pushed, or 0 on failure.
+ */
+int hostlist_push_host_range(hostlist_t hl, const char *prefix,
+			     unsigned long lo, unsigned long hi, int width);
+
 
 /* hostlist_push_list():
  *
@@ -223,6 +234,22 @@ char * hostlist_pop(hostlist_t hl);
 
 char * hostlist_nth(hostlist_t hl, int n);
 
+/* hostlist_nth_range():
+ *
+ * Return the components of the n'th range of hostlist hl without
+ * expanding it. *prefix is set to a copy of the range's prefix. For a
+ * range with a numeric suffix, *lo, *hi and *width are set and 1 is
+ * returned. For a single host without a numeric suffix, *prefix is the
+ * entire hostname and 0 is returned.
+ *
+ * Returns -1 if n is out of range, or -2 and sets errno to ENOMEM if
+ * *prefix could not be allocated.
+ *
+ * Note: Caller is responsible for freeing *prefix.
+ */
+int hostlist_nth_range(hostlist_t hl, int n, char **prefix,
+		       unsigned long *lo, unsigned long *hi, int *width);
+
 /* hostlist_shift():
  *
  * Returns the string representation of the first host in the hostlist
@@ -65,6 +65,7 @@
 #define SLURM_IO_STDERR 2
 #define SLURM_IO_ALLSTDIN 3
 #define SLURM_IO_CONNECTION_TEST 4
+#define SLURM_IO_NODE_INIT 5	/* packed io init msg of a relayed node */
 
 struct slurm_io_init_msg {
 	uint16_t      version;
@@ -97,4 +98,13 @@ int io_init_msg_validate(struct slurm_io_init_msg *msg, const char *sig);
 int io_init_msg_write_to_fd(int fd, struct slurm_io_init_msg *msg);
 int io_init_msg_read_from_fd(int fd, struct slurm_io_init_msg *msg);
 
+/*
+ * Pack and unpack an io init msg, used to carry the io init msg of a
+ * slurmstepd that relays its stdio through another in a SLURM_IO_NODE_INIT
+ * message
+ */
+int io_init_msg_packed_size(void);
+void io_init_msg_pack(struct slurm_io_init_msg *hdr, Buf buffer);
+int io_init_msg_unpack(struct slurm_io_init_msg *hdr, Buf buffer);
+
 #endif /* !_HAVE_IO_HDR_H */
@@ -1213,7 +1213,7 @@ extern void add_job_to_cores(job_resources_t *job_resrcs_ptr,
 		uint32_t size = 0;
 		for (i = 0; i < node_record_count; i++)
 			size += bits_per_node[i];
-		*full_core_bitmap = bit_alloc(size);
+		*full_core_bitmap = bit_alloc_sparse(size);
 		if (!*full_core_bitmap)
 			fatal("add_job_to_cores: bitmap memory error");
 	}
@@ -1255,7 +1255,7 @@ extern void remove_job_from_cores(job_resources_t *job_resrcs_ptr,
 		uint32_t size = 0;
 		for (i = 0; i < node_record_count; i++)
 			size += bits_per_node[i];
-		*full_core_bitmap = bit_alloc(size);
+		*full_core_bitmap = bit_alloc_sparse(size);
 		if (!*full_core_bitmap)
 			fatal("add_job_to_cores: bitmap memory error");
 	}
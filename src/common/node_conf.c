@@ -4,7 +4,9 @@
  *                 related to slurmctld usage of nodes)
  *	Note: there is a global node table (node_record_table_ptr), its
  *	hash table (node_hash_table), time stamp (last_node_update) and
- *	configuration list (config_list)
+ *	configuration list (config_list). Runs of nodes with numbered names
+ *	are also recorded (node_range_table) so hostlist expressions can be
+ *	converted to and from node bitmaps range by range.
  *****************************************************************************
  *  Copyright (C) 2002-2007 The Regents of the University of California.
  *  Copyright (C) 2008-2010 Lawrence Livermore National Security.
@@ -71,6 +73,7 @@
 #include "src/common/read_config.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_topology.h"
+#include "src/common/working_cluster.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -86,7 +89,29 @@ struct node_record *node_record_table_ptr = NULL;	/* node records */
 struct node_record **node_hash_table = NULL;	/* node_record hash table */
 int node_record_count = 0;		/* count in node_record_table_ptr */
 
+/* A run of node records with consecutive indexes whose names are a common
+ * prefix followed by consecutive numbers (e.g. "nid00001" to "nid09999").
+ * Names with a zero padded number are kept apart from those without, so a
+ * number and its width map to at most one run. */
+typedef struct node_range {
+	char *prefix;		/* name without numeric suffix */
+	int width;		/* padded suffix width, 0 if not padded */
+	unsigned long lo, hi;	/* numeric suffixes of the run */
+	int first_inx;		/* node_record_table_ptr index of lo */
+} node_range_t;
+
+/* Longest numeric suffix considered for node_range_table, keeps powers
+ * of ten within an unsigned long */
+#define NODE_RANGE_MAX_DIGITS	9
+
+static node_range_t *node_range_table = NULL;	/* sorted by prefix, width
+						 * then lo */
+static int node_range_count = 0;	/* count in node_range_table */
+static int *node_range_map = NULL;	/* node index to node_range_table
+					 * index, -1 if not in a run */
+
 static void	_add_config_feature(char *feature, bitstr_t *node_bitmap);
+static void	_build_node_range_table(void);
 static int	_build_single_nodeline_info(slurm_conf_node_t *node_ptr,
 					    struct config_record *config_ptr);
 static int	_delete_config_record (void);
@@ -94,11 +119,22 @@ static int	_delete_config_record (void);
 static void	_dump_hash (void);
 #endif
 static struct node_record *_find_alias_node_record (char *name);
+static node_range_t *_find_node_range(char *prefix, int width,
+				      unsigned long num);
+static void	_free_node_range_table(void);
 static int	_hash_index (char *name);
 static void	_list_delete_config (void *config_entry);
 static void	_list_delete_feature (void *feature_entry);
 static int	_list_find_config (void *config_entry, void *key);
 static int	_list_find_feature (void *feature_entry, void *key);
+static int	_node_name2bit(char *node_name, bitstr_t *bitmap);
+static int	_node_range_cmp(const void *x, const void *y);
+static int	_node_range2bitmap(char *prefix, unsigned long lo,
+				   unsigned long hi, int width,
+				   bitstr_t *bitmap);
+static int	_num_digits(unsigned long num);
+static bool	_split_node_name(char *name, int *prefix_len,
+				 unsigned long *num, int *width);
 
 
 static void _add_config_feature(char *feature, bitstr_t *node_bitmap)
@@ -271,6 +307,165 @@ static int _delete_config_record (void)
 }
 
 
+/* _num_digits - return the number of decimal digits in num */
+static int _num_digits(unsigned long num)
+{
+	int digits = 1;
+
+	while (num >= 10) {
+		num /= 10;
+		digits++;
+	}
+	return digits;
+}
+
+/*
+ * _split_node_name - split a node name into a prefix and numeric suffix in
+ *	the same way as hostlist_create() does for a one dimensional system
+ * IN name - node name
+ * OUT prefix_len - length of the prefix
+ * OUT num - value of the numeric suffix
+ * OUT width - width of a zero padded suffix, 0 if not zero padded
+ * RET true if name has a numeric suffix usable in node_range_table
+ */
+static bool _split_node_name(char *name, int *prefix_len,
+			     unsigned long *num, int *width)
+{
+	int len = strlen(name), idx = len, digits;
+
+	while ((idx > 0) && isdigit((int)name[idx - 1]))
+		idx--;
+	digits = len - idx;
+	if ((digits == 0) || (digits > NODE_RANGE_MAX_DIGITS))
+		return false;
+
+	*prefix_len = idx;
+	*num = strtoul(name + idx, NULL, 10);
+	if (digits > _num_digits(*num))
+		*width = digits;
+	else
+		*width = 0;
+	return true;
+}
+
+/* _node_range_cmp - qsort comparison of node_range_t by prefix, width
+ *	then first suffix */
+static int _node_range_cmp(const void *x, const void *y)
+{
+	const node_range_t *r1 = (const node_range_t *) x;
+	const node_range_t *r2 = (const node_range_t *) y;
+	int diff;
+
+	diff = strcmp(r1->prefix, r2->prefix);
+	if (diff)
+		return diff;
+	if (r1->width != r2->width)
+		return (r1->width < r2->width) ? -1 : 1;
+	if (r1->lo != r2->lo)
+		return (r1->lo < r2->lo) ? -1 : 1;
+	return 0;
+}
+
+/* _free_node_range_table - release node_range_table and node_range_map */
+static void _free_node_range_table(void)
+{
+	int i;
+
+	for (i = 0; i < node_range_count; i++)
+		xfree(node_range_table[i].prefix);
+	xfree(node_range_table);
+	xfree(node_range_map);
+	node_range_count = 0;
+}
+
+/*
+ * _build_node_range_table - record runs of node records with numbered names
+ *	in node_range_table and node_range_map. Not built for systems with
+ *	multi-dimensional node names, for which hostlist ranges do not map
+ *	onto runs of decimal suffixes.
+ * global: node_record_table_ptr - pointer to global node table
+ */
+static void _build_node_range_table(void)
+{
+	int i, j, prefix_len, width;
+	unsigned long num;
+	struct node_record *node_ptr = node_record_table_ptr;
+	node_range_t *range = NULL;
+
+	_free_node_range_table();
+	if ((node_record_count == 0) ||
+	    (slurmdb_setup_cluster_name_dims() > 1))
+		return;
+
+	node_range_table = xmalloc(sizeof(node_range_t) * node_record_count);
+	for (i = 0; i < node_record_count; i++, node_ptr++) {
+		if ((node_ptr->name == NULL) ||
+		    (node_ptr->name[0] == '\0') ||
+		    !_split_node_name(node_ptr->name, &prefix_len, &num,
+				      &width)) {
+			range = NULL;
+			continue;
+		}
+		if (range && (range->width == width) && (range->hi + 1 == num) &&
+		    (strlen(range->prefix) == prefix_len) &&
+		    !strncmp(range->prefix, node_ptr->name, prefix_len)) {
+			range->hi = num;
+			continue;
+		}
+		range = &node_range_table[node_range_count++];
+		range->prefix = xstrndup(node_ptr->name, prefix_len);
+		range->width = width;
+		range->lo = num;
+		range->hi = num;
+		range->first_inx = i;
+	}
+
+	qsort(node_range_table, node_range_count, sizeof(node_range_t),
+	      _node_range_cmp);
+	node_range_map = xmalloc(sizeof(int) * node_record_count);
+	for (i = 0; i < node_record_count; i++)
+		node_range_map[i] = -1;
+	for (i = 0; i < node_range_count; i++) {
+		range = &node_range_table[i];
+		for (j = 0; j <= (range->hi - range->lo); j++)
+			node_range_map[range->first_inx + j] = i;
+	}
+	debug2("built %d node name ranges for %d nodes",
+	       node_range_count, node_record_count);
+}
+
+/*
+ * _find_node_range - find the run of nodes containing a numbered node name
+ * IN prefix - name without numeric suffix
+ * IN width - padded suffix width, 0 if not padded
+ * IN num - numeric suffix
+ * RET pointer to the node_range_table entry or NULL if not found
+ */
+static node_range_t *_find_node_range(char *prefix, int width,
+				      unsigned long num)
+{
+	node_range_t key, *range;
+	int lo = 0, hi = node_range_count - 1, mid, diff;
+
+	key.prefix = prefix;
+	key.width  = width;
+	key.lo     = num;
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		range = &node_range_table[mid];
+		diff = _node_range_cmp(&key, range);
+		if (diff < 0)
+			hi = mid - 1;
+		else if ((diff == 0) ||
+			 ((num <= range->hi) && (width == range->width) &&
+			  !strcmp(prefix, range->prefix)))
+			return range;
+		else
+			lo = mid + 1;
+	}
+	return NULL;
+}
+
 #if _DEBUG
 /*
  * _dump_hash - print the node_hash_table contents, used for debugging
@@ -435,7 +630,8 @@ static int _list_find_config (void *config_entry, void *key)
  */
 char * bitmap2node_name (bitstr_t *bitmap)
 {
-	int i, first, last;
+	int i, j, first, last, range_last;
+	node_range_t *range;
 	hostlist_t hl;
 	char *buf;
 
@@ -453,7 +649,22 @@ char * bitmap2node_name (bitstr_t *bitmap)
 	for (i = first; i <= last; i++) {
 		if (bit_test(bitmap, i) == 0)
 			continue;
-		hostlist_push(hl, node_record_table_ptr[i].name);
+		if (!node_range_map || (node_range_map[i] == -1)) {
+			hostlist_push(hl, node_record_table_ptr[i].name);
+			continue;
+		}
+		/* Push the set bits within this run as one range */
+		range = &node_range_table[node_range_map[i]];
+		range_last = range->first_inx + (range->hi - range->lo);
+		for (j = i; (j < last) && (j < range_last); j++) {
+			if (bit_test(bitmap, j + 1) == 0)
+				break;
+		}
+		hostlist_push_host_range(hl, range->prefix,
+					 range->lo + (i - range->first_inx),
+					 range->lo + (j - range->first_inx),
+					 range->width);
+		i = j;
 	}
 	hostlist_uniq(hl);
 	buf = hostlist_ranged_string_xmalloc(hl);
@@ -623,13 +834,12 @@ extern void  build_config_feature_list(struct config_record *config_ptr)
 	feature_iter = list_iterator_create(feature_list);
 	if (feature_iter == NULL)
 		fatal("list_iterator_create malloc failure");
-	bit_not(config_ptr->node_bitmap);
 	while ((feature_ptr = (struct features_record *)
 			list_next(feature_iter))) {
-		bit_and(feature_ptr->node_bitmap, config_ptr->node_bitmap);
+		bit_and_not(feature_ptr->node_bitmap,
+			    config_ptr->node_bitmap);
 	}
 	list_iterator_destroy(feature_iter);
-	bit_not(config_ptr->node_bitmap);
 
 	if (config_ptr->feature) {
 		i = strlen(config_ptr->feature) + 1;	/* oversized */
@@ -793,6 +1003,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xfree(node_hash_table);
+	_free_node_range_table();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -830,24 +1041,97 @@ extern void node_fini2 (void)
 
 	xfree(node_record_table_ptr);
 	xfree(node_hash_table);
+	_free_node_range_table();
 	node_record_count = 0;
 }
 
 
+/*
+ * _node_name2bit - set the bit for a node name in a node bitmap
+ * IN node_name - name of the node
+ * IN/OUT bitmap - node bitmap
+ * RET 0 if no error, otherwise EINVAL
+ */
+static int _node_name2bit(char *node_name, bitstr_t *bitmap)
+{
+	struct node_record *node_ptr;
+
+	node_ptr = find_node_record (node_name);
+	if (node_ptr == NULL) {
+		error ("node_name2bitmap: invalid node specified %s",
+		       node_name);
+		return EINVAL;
+	}
+	bit_set (bitmap, (bitoff_t) (node_ptr - node_record_table_ptr));
+	return SLURM_SUCCESS;
+}
+
+/*
+ * _node_range2bitmap - set the bits for a numeric hostlist range in a node
+ *	bitmap, using node_range_table for the names it covers and looking
+ *	up the rest one at a time
+ * IN prefix, lo, hi, width - the hostlist range prefix[lo-hi]
+ * IN/OUT bitmap - node bitmap
+ * RET 0 if no error, otherwise EINVAL
+ */
+static int _node_range2bitmap(char *prefix, unsigned long lo,
+			      unsigned long hi, int width, bitstr_t *bitmap)
+{
+	int rc = SLURM_SUCCESS, i, range_width;
+	unsigned long num, end, last, pad_limit = 0;
+	node_range_t *range = NULL;
+	char *node_name;
+	bool use_table = (width <= NODE_RANGE_MAX_DIGITS);
+
+	if (use_table && (width > 1)) {
+		/* Suffixes below pad_limit are zero padded to width */
+		for (i = 1, pad_limit = 1; i < width; i++)
+			pad_limit *= 10;
+	}
+
+	for (num = lo; num <= hi; num = last + 1) {
+		if (num < pad_limit) {
+			range_width = width;
+			end = MIN(hi, pad_limit - 1);
+		} else {
+			range_width = 0;
+			end = hi;
+		}
+		if (use_table)
+			range = _find_node_range(prefix, range_width, num);
+		if (range) {
+			last = MIN(end, range->hi);
+			bit_nset(bitmap, range->first_inx + (num - range->lo),
+				 range->first_inx + (last - range->lo));
+		} else {
+			last = num;
+			node_name = xstrdup_printf("%s%0*lu", prefix, width,
+						   num);
+			if (_node_name2bit(node_name, bitmap))
+				rc = EINVAL;
+			xfree(node_name);
+		}
+		if (last == hi)
+			break;
+	}
+	return rc;
+}
+
 /*
  * node_name2bitmap - given a node name regular expression, build a bitmap
  *	representation
  * IN node_names  - list of nodes
  * IN best_effort - if set don't return an error on invalid node name entries
  * OUT bitmap     - set to bitmap, may not have all bits set on error
- * RET 0 if no error, otherwise EINVAL
+ * RET 0 if no error, ENOMEM if out of memory, otherwise EINVAL
  * NOTE: call FREE_NULL_BITMAP() to free bitmap memory when no longer required
  */
 extern int node_name2bitmap (char *node_names, bool best_effort,
 			     bitstr_t **bitmap)
 {
-	int rc = SLURM_SUCCESS;
-	char *this_node_name;
+	int rc = SLURM_SUCCESS, range_rc, i, width;
+	unsigned long lo, hi;
+	char *this_node_name, *prefix;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
 
@@ -869,19 +1153,38 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
-	while ( (this_node_name = hostlist_shift (host_list)) ) {
-		struct node_record *node_ptr;
-		node_ptr = find_node_record (this_node_name);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("node_name2bitmap: invalid node specified %s",
-			       this_node_name);
-			if (!best_effort)
+	if (node_range_table == NULL) {
+		while ( (this_node_name = hostlist_shift (host_list)) ) {
+			if (_node_name2bit(this_node_name, my_bitmap) &&
+			    !best_effort)
 				rc = EINVAL;
+			free (this_node_name);
+		}
+		hostlist_destroy (host_list);
+		return rc;
+	}
+
+	/* Map each range of the hostlist onto runs of node records
+	 * rather than expanding it into individual names */
+	for (i = 0; ; i++) {
+		range_rc = hostlist_nth_range (host_list, i, &prefix,
+					       &lo, &hi, &width);
+		if (range_rc == 1)
+			range_rc = _node_range2bitmap(prefix, lo, hi, width,
+						      my_bitmap);
+		else if (range_rc == 0)
+			range_rc = _node_name2bit(prefix, my_bitmap);
+		else if (range_rc == -1)
+			break;	/* no more ranges */
+		else {
+			/* don't return a partial bitmap, even best effort */
+			error("node_name2bitmap: hostlist_nth_range: %m");
+			rc = ENOMEM;
+			break;
 		}
-		free (this_node_name);
+		if (range_rc && !best_effort)
+			rc = EINVAL;
+		free (prefix);
 	}
 	hostlist_destroy (host_list);
 
@@ -908,7 +1211,8 @@ extern void purge_node_rec (struct node_record *node_ptr)
 
 
 /*
- * rehash_node - build a hash table of the node_record entries.
+ * rehash_node - build a hash table of the node_record entries and the
+ *	table of numbered node name runs used by node_name2bitmap()
  * NOTE: manages memory for node_hash_table
  */
 extern void rehash_node (void)
@@ -929,6 +1233,8 @@ extern void rehash_node (void)
 		node_hash_table[inx] = node_ptr;
 	}
 
+	_build_node_range_table();
+
 #if _DEBUG
 	_dump_hash();
 #endif
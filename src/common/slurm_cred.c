@@ -2235,7 +2235,7 @@ void delete_sbcast_cred(sbcast_cred_t *sbcast_cred)
  *	recent signature on file (in our cache).
  * RET 0 on success, -1 on error */
 int extract_sbcast_cred(slurm_cred_ctx_t ctx,
-			sbcast_cred_t *sbcast_cred, uint16_t block_no,
+			sbcast_cred_t *sbcast_cred, uint32_t block_no,
 			uint32_t *job_id, char **nodes)
 {
 	static time_t   cache_expire[SBCAST_CACHE_SIZE];
@@ -280,6 +280,10 @@ static slurm_errtab_t slurm_errtab[] = {
 	  "Step limit reached for this job"			},
 	{ ESLURM_JOB_SUSPENDED,
 	  "Job is current suspended, requested operation disabled"	},
+	{ ESLURM_RPC_RATE_LIMITED,
+	  "RPC rate limit exceeded, try again later"		},
+	{ ESLURM_INVALID_JOB_COUNT,
+	  "Too many jobs in one submission"			},
 
 	/* slurmd error codes */
 
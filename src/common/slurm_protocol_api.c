@@ -80,6 +80,10 @@
 #define _DEBUG	0
 #define MAX_SHUTDOWN_RETRY 5
 #define MAX_RETRIES 3
+/* Delay before resending an RPC rejected by slurmctld's rate limiter,
+ * doubled with each retry, in microseconds */
+#define RATE_LIMIT_DELAY_MIN	100000
+#define RATE_LIMIT_DELAY_MAX	5000000
 
 /* STATIC VARIABLES */
 /* static pthread_mutex_t config_lock = PTHREAD_MUTEX_INITIALIZER; */
@@ -3184,8 +3188,9 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 	int retry = 1;
 	slurm_ctl_conf_t *conf;
 	bool backup_controller_flag;
-	uint16_t slurmctld_timeout;
+	uint16_t slurmctld_timeout, msg_timeout;
 	slurm_addr_t ctrl_addr;
+	int rate_limit_delay = RATE_LIMIT_DELAY_MIN;
 
 	/* Just in case the caller didn't initialize his slurm_msg_t, and
 	 * since we KNOW that we are only sending to one node (the controller),
@@ -3206,6 +3211,7 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 	conf = slurm_conf_lock();
 	backup_controller_flag = conf->backup_controller ? true : false;
 	slurmctld_timeout = conf->slurmctld_timeout;
+	msg_timeout = conf->msg_timeout;
 	slurm_conf_unlock();
 
 	while (retry) {
@@ -3236,6 +3242,25 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 			} else {
 				retry = 1;
 			}
+		} else if ((rc == 0)
+		    && (resp->msg_type == RESPONSE_SLURM_RC)
+		    && ((((return_code_msg_t *) resp->data)->return_code)
+			== ESLURM_RPC_RATE_LIMITED)
+		    && (difftime(time(NULL), start_time) < msg_timeout)) {
+			/* Back off and resend until MessageTimeout, then
+			 * return the error to the caller */
+			debug("RPC rate limited by controller, retry in %d "
+			      "usec", rate_limit_delay);
+			slurm_free_return_code_msg(resp->data);
+			usleep(rate_limit_delay);
+			rate_limit_delay = MIN(rate_limit_delay * 2,
+					       RATE_LIMIT_DELAY_MAX);
+			if ((fd = slurm_open_controller_conn(&ctrl_addr))
+			    < 0) {
+				rc = -1;
+			} else {
+				retry = 1;
+			}
 		}
 
 		if (rc == -1)
@@ -301,6 +301,14 @@ extern void slurm_free_job_id_msg(job_id_msg_t * msg)
 	xfree(msg);
 }
 
+extern void slurm_free_job_user_id_msg(job_user_id_msg_t * msg)
+{
+	if (msg) {
+		xfree(msg->job_name);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_job_step_id_msg(job_step_id_msg_t * msg)
 {
 	xfree(msg);
@@ -352,6 +360,14 @@ extern void slurm_free_part_info_request_msg(part_info_request_msg_t *msg)
 	xfree(msg);
 }
 
+extern void slurm_free_job_desc_multi_msg(job_desc_multi_msg_t * msg)
+{
+	if (msg) {
+		slurm_free_job_desc_msg(msg->job_desc);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_job_desc_msg(job_desc_msg_t * msg)
 {
 	int i;
@@ -856,6 +872,135 @@ extern void slurm_free_spank_env_responce_msg(spank_env_responce_msg_t *msg)
 	xfree(msg);
 }
 
+extern void slurm_free_info_delta_msg(info_delta_msg_t *msg)
+{
+	uint32_t i;
+
+	if (msg) {
+		for (i = 0; i < msg->record_count; i++)
+			xfree(msg->record_data[i]);
+		xfree(msg->record_data);
+		xfree(msg->record_id);
+		xfree(msg->record_size);
+		xfree(msg->delete_id);
+		xfree(msg);
+	}
+}
+
+/* Return the index of a record ID in the first sorted_cnt records of a
+ * cache sorted by record_id or -1 if not found */
+static int _info_delta_find(info_delta_msg_t *cache, uint32_t sorted_cnt,
+			    uint32_t id)
+{
+	int lo = 0, hi = (int) sorted_cnt - 1, mid;
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		if (cache->record_id[mid] == id)
+			return mid;
+		if (cache->record_id[mid] < id)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return -1;
+}
+
+/* Sort the records of a cache by record_id. Insertion sort is used since
+ * new records are appended to a sorted array and usually have the highest
+ * IDs (new jobs) or are already in order (a full response). */
+static void _info_delta_sort(info_delta_msg_t *cache, uint32_t sorted_cnt)
+{
+	uint32_t i, j, id, size;
+	char *data;
+
+	for (i = MAX(sorted_cnt, 1); i < cache->record_count; i++) {
+		id   = cache->record_id[i];
+		size = cache->record_size[i];
+		data = cache->record_data[i];
+		for (j = i; (j > 0) && (cache->record_id[j-1] > id); j--) {
+			cache->record_id[j]   = cache->record_id[j-1];
+			cache->record_size[j] = cache->record_size[j-1];
+			cache->record_data[j] = cache->record_data[j-1];
+		}
+		cache->record_id[j]   = id;
+		cache->record_size[j] = size;
+		cache->record_data[j] = data;
+	}
+}
+
+/*
+ * slurm_merge_info_delta - merge records changed since the last response
+ *	into a copy of all records, kept in record_id order
+ * IN/OUT cache - all records from earlier responses, replaced if the
+ *	delta is a full response
+ * IN/OUT delta - changed records, moved into the cache and freed
+ */
+extern void slurm_merge_info_delta(info_delta_msg_t **cache,
+				   info_delta_msg_t *delta)
+{
+	info_delta_msg_t *cache_ptr = *cache;
+	uint32_t i, j, sorted_cnt;
+	int inx;
+
+	if (delta->full || (cache_ptr == NULL)) {
+		slurm_free_info_delta_msg(cache_ptr);
+		delta->full = 0;
+		delta->delete_count = 0;
+		xfree(delta->delete_id);
+		_info_delta_sort(delta, 0);
+		*cache = delta;
+		return;
+	}
+
+	cache_ptr->last_update  = delta->last_update;
+	cache_ptr->node_scaling = delta->node_scaling;
+
+	/* Mark deleted records with a NULL record_data */
+	sorted_cnt = cache_ptr->record_count;
+	for (i = 0; i < delta->delete_count; i++) {
+		inx = _info_delta_find(cache_ptr, sorted_cnt,
+				       delta->delete_id[i]);
+		if (inx >= 0)
+			xfree(cache_ptr->record_data[inx]);
+	}
+
+	for (i = 0; i < delta->record_count; i++) {
+		inx = _info_delta_find(cache_ptr, sorted_cnt,
+				       delta->record_id[i]);
+		if (inx < 0) {
+			inx = cache_ptr->record_count++;
+			xrealloc(cache_ptr->record_id,
+				 sizeof(uint32_t) * cache_ptr->record_count);
+			xrealloc(cache_ptr->record_size,
+				 sizeof(uint32_t) * cache_ptr->record_count);
+			xrealloc(cache_ptr->record_data,
+				 sizeof(char *) * cache_ptr->record_count);
+			cache_ptr->record_id[inx] = delta->record_id[i];
+		} else
+			xfree(cache_ptr->record_data[inx]);
+		cache_ptr->record_size[inx] = delta->record_size[i];
+		cache_ptr->record_data[inx] = delta->record_data[i];
+		delta->record_data[i] = NULL;
+	}
+	slurm_free_info_delta_msg(delta);
+
+	/* Remove deleted records */
+	for (i = 0, j = 0; i < cache_ptr->record_count; i++) {
+		if (cache_ptr->record_data[i] == NULL) {
+			if (i < sorted_cnt)
+				sorted_cnt--;
+			continue;
+		}
+		cache_ptr->record_id[j]   = cache_ptr->record_id[i];
+		cache_ptr->record_size[j] = cache_ptr->record_size[i];
+		cache_ptr->record_data[j] = cache_ptr->record_data[i];
+		j++;
+	}
+	cache_ptr->record_count = j;
+	_info_delta_sort(cache_ptr, sorted_cnt);
+}
+
 /* Given a job's reason for waiting, return a descriptive string */
 extern char *job_reason_string(enum job_state_reason inx)
 {
@@ -945,6 +1090,320 @@ extern void slurm_free_will_run_response_msg(will_run_response_msg_t *msg)
         }
 }
 
+extern char *rpc_num2string(uint16_t opcode)
+{
+	switch (opcode) {
+	case REQUEST_NODE_REGISTRATION_STATUS:
+		return "REQUEST_NODE_REGISTRATION_STATUS";
+	case MESSAGE_NODE_REGISTRATION_STATUS:
+		return "MESSAGE_NODE_REGISTRATION_STATUS";
+	case REQUEST_RECONFIGURE:
+		return "REQUEST_RECONFIGURE";
+	case RESPONSE_RECONFIGURE:
+		return "RESPONSE_RECONFIGURE";
+	case REQUEST_SHUTDOWN:
+		return "REQUEST_SHUTDOWN";
+	case REQUEST_SHUTDOWN_IMMEDIATE:
+		return "REQUEST_SHUTDOWN_IMMEDIATE";
+	case RESPONSE_SHUTDOWN:
+		return "RESPONSE_SHUTDOWN";
+	case REQUEST_PING:
+		return "REQUEST_PING";
+	case REQUEST_CONTROL:
+		return "REQUEST_CONTROL";
+	case REQUEST_SET_DEBUG_LEVEL:
+		return "REQUEST_SET_DEBUG_LEVEL";
+	case REQUEST_HEALTH_CHECK:
+		return "REQUEST_HEALTH_CHECK";
+	case REQUEST_TAKEOVER:
+		return "REQUEST_TAKEOVER";
+	case REQUEST_SET_SCHEDLOG_LEVEL:
+		return "REQUEST_SET_SCHEDLOG_LEVEL";
+	case REQUEST_SET_DEBUG_FLAGS:
+		return "REQUEST_SET_DEBUG_FLAGS";
+	case REQUEST_BUILD_INFO:
+		return "REQUEST_BUILD_INFO";
+	case RESPONSE_BUILD_INFO:
+		return "RESPONSE_BUILD_INFO";
+	case REQUEST_JOB_INFO:
+		return "REQUEST_JOB_INFO";
+	case RESPONSE_JOB_INFO:
+		return "RESPONSE_JOB_INFO";
+	case REQUEST_JOB_STEP_INFO:
+		return "REQUEST_JOB_STEP_INFO";
+	case RESPONSE_JOB_STEP_INFO:
+		return "RESPONSE_JOB_STEP_INFO";
+	case REQUEST_NODE_INFO:
+		return "REQUEST_NODE_INFO";
+	case RESPONSE_NODE_INFO:
+		return "RESPONSE_NODE_INFO";
+	case REQUEST_PARTITION_INFO:
+		return "REQUEST_PARTITION_INFO";
+	case RESPONSE_PARTITION_INFO:
+		return "RESPONSE_PARTITION_INFO";
+	case REQUEST_ACCTING_INFO:
+		return "REQUEST_ACCTING_INFO";
+	case RESPONSE_ACCOUNTING_INFO:
+		return "RESPONSE_ACCOUNTING_INFO";
+	case REQUEST_JOB_ID:
+		return "REQUEST_JOB_ID";
+	case RESPONSE_JOB_ID:
+		return "RESPONSE_JOB_ID";
+	case REQUEST_BLOCK_INFO:
+		return "REQUEST_BLOCK_INFO";
+	case RESPONSE_BLOCK_INFO:
+		return "RESPONSE_BLOCK_INFO";
+	case REQUEST_TRIGGER_SET:
+		return "REQUEST_TRIGGER_SET";
+	case REQUEST_TRIGGER_GET:
+		return "REQUEST_TRIGGER_GET";
+	case REQUEST_TRIGGER_CLEAR:
+		return "REQUEST_TRIGGER_CLEAR";
+	case RESPONSE_TRIGGER_GET:
+		return "RESPONSE_TRIGGER_GET";
+	case REQUEST_JOB_INFO_SINGLE:
+		return "REQUEST_JOB_INFO_SINGLE";
+	case REQUEST_SHARE_INFO:
+		return "REQUEST_SHARE_INFO";
+	case RESPONSE_SHARE_INFO:
+		return "RESPONSE_SHARE_INFO";
+	case REQUEST_RESERVATION_INFO:
+		return "REQUEST_RESERVATION_INFO";
+	case RESPONSE_RESERVATION_INFO:
+		return "RESPONSE_RESERVATION_INFO";
+	case REQUEST_PRIORITY_FACTORS:
+		return "REQUEST_PRIORITY_FACTORS";
+	case RESPONSE_PRIORITY_FACTORS:
+		return "RESPONSE_PRIORITY_FACTORS";
+	case REQUEST_TOPO_INFO:
+		return "REQUEST_TOPO_INFO";
+	case RESPONSE_TOPO_INFO:
+		return "RESPONSE_TOPO_INFO";
+	case REQUEST_TRIGGER_PULL:
+		return "REQUEST_TRIGGER_PULL";
+	case REQUEST_FRONT_END_INFO:
+		return "REQUEST_FRONT_END_INFO";
+	case RESPONSE_FRONT_END_INFO:
+		return "RESPONSE_FRONT_END_INFO";
+	case REQUEST_SPANK_ENVIRONMENT:
+		return "REQUEST_SPANK_ENVIRONMENT";
+	case RESPONCE_SPANK_ENVIRONMENT:
+		return "RESPONCE_SPANK_ENVIRONMENT";
+	case RESPONSE_JOB_INFO_DELTA:
+		return "RESPONSE_JOB_INFO_DELTA";
+	case RESPONSE_NODE_INFO_DELTA:
+		return "RESPONSE_NODE_INFO_DELTA";
+	case REQUEST_STATS_INFO:
+		return "REQUEST_STATS_INFO";
+	case RESPONSE_STATS_INFO:
+		return "RESPONSE_STATS_INFO";
+	case REQUEST_UPDATE_JOB:
+		return "REQUEST_UPDATE_JOB";
+	case REQUEST_UPDATE_NODE:
+		return "REQUEST_UPDATE_NODE";
+	case REQUEST_CREATE_PARTITION:
+		return "REQUEST_CREATE_PARTITION";
+	case REQUEST_DELETE_PARTITION:
+		return "REQUEST_DELETE_PARTITION";
+	case REQUEST_UPDATE_PARTITION:
+		return "REQUEST_UPDATE_PARTITION";
+	case REQUEST_CREATE_RESERVATION:
+		return "REQUEST_CREATE_RESERVATION";
+	case RESPONSE_CREATE_RESERVATION:
+		return "RESPONSE_CREATE_RESERVATION";
+	case REQUEST_DELETE_RESERVATION:
+		return "REQUEST_DELETE_RESERVATION";
+	case REQUEST_UPDATE_RESERVATION:
+		return "REQUEST_UPDATE_RESERVATION";
+	case REQUEST_UPDATE_BLOCK:
+		return "REQUEST_UPDATE_BLOCK";
+	case REQUEST_UPDATE_FRONT_END:
+		return "REQUEST_UPDATE_FRONT_END";
+	case REQUEST_RESOURCE_ALLOCATION:
+		return "REQUEST_RESOURCE_ALLOCATION";
+	case RESPONSE_RESOURCE_ALLOCATION:
+		return "RESPONSE_RESOURCE_ALLOCATION";
+	case REQUEST_SUBMIT_BATCH_JOB:
+		return "REQUEST_SUBMIT_BATCH_JOB";
+	case RESPONSE_SUBMIT_BATCH_JOB:
+		return "RESPONSE_SUBMIT_BATCH_JOB";
+	case REQUEST_BATCH_JOB_LAUNCH:
+		return "REQUEST_BATCH_JOB_LAUNCH";
+	case REQUEST_CANCEL_JOB:
+		return "REQUEST_CANCEL_JOB";
+	case RESPONSE_CANCEL_JOB:
+		return "RESPONSE_CANCEL_JOB";
+	case REQUEST_JOB_RESOURCE:
+		return "REQUEST_JOB_RESOURCE";
+	case RESPONSE_JOB_RESOURCE:
+		return "RESPONSE_JOB_RESOURCE";
+	case REQUEST_JOB_ATTACH:
+		return "REQUEST_JOB_ATTACH";
+	case RESPONSE_JOB_ATTACH:
+		return "RESPONSE_JOB_ATTACH";
+	case REQUEST_JOB_WILL_RUN:
+		return "REQUEST_JOB_WILL_RUN";
+	case RESPONSE_JOB_WILL_RUN:
+		return "RESPONSE_JOB_WILL_RUN";
+	case REQUEST_JOB_ALLOCATION_INFO:
+		return "REQUEST_JOB_ALLOCATION_INFO";
+	case RESPONSE_JOB_ALLOCATION_INFO:
+		return "RESPONSE_JOB_ALLOCATION_INFO";
+	case REQUEST_JOB_ALLOCATION_INFO_LITE:
+		return "REQUEST_JOB_ALLOCATION_INFO_LITE";
+	case RESPONSE_JOB_ALLOCATION_INFO_LITE:
+		return "RESPONSE_JOB_ALLOCATION_INFO_LITE";
+	case REQUEST_UPDATE_JOB_TIME:
+		return "REQUEST_UPDATE_JOB_TIME";
+	case REQUEST_JOB_READY:
+		return "REQUEST_JOB_READY";
+	case RESPONSE_JOB_READY:
+		return "RESPONSE_JOB_READY";
+	case REQUEST_JOB_END_TIME:
+		return "REQUEST_JOB_END_TIME";
+	case REQUEST_JOB_NOTIFY:
+		return "REQUEST_JOB_NOTIFY";
+	case REQUEST_JOB_SBCAST_CRED:
+		return "REQUEST_JOB_SBCAST_CRED";
+	case RESPONSE_JOB_SBCAST_CRED:
+		return "RESPONSE_JOB_SBCAST_CRED";
+	case REQUEST_SUBMIT_BATCH_JOB_MULTI:
+		return "REQUEST_SUBMIT_BATCH_JOB_MULTI";
+	case RESPONSE_SUBMIT_BATCH_JOB_MULTI:
+		return "RESPONSE_SUBMIT_BATCH_JOB_MULTI";
+	case REQUEST_JOB_USER_INFO:
+		return "REQUEST_JOB_USER_INFO";
+	case REQUEST_JOB_STEP_CREATE:
+		return "REQUEST_JOB_STEP_CREATE";
+	case RESPONSE_JOB_STEP_CREATE:
+		return "RESPONSE_JOB_STEP_CREATE";
+	case REQUEST_RUN_JOB_STEP:
+		return "REQUEST_RUN_JOB_STEP";
+	case RESPONSE_RUN_JOB_STEP:
+		return "RESPONSE_RUN_JOB_STEP";
+	case REQUEST_CANCEL_JOB_STEP:
+		return "REQUEST_CANCEL_JOB_STEP";
+	case RESPONSE_CANCEL_JOB_STEP:
+		return "RESPONSE_CANCEL_JOB_STEP";
+	case REQUEST_UPDATE_JOB_STEP:
+		return "REQUEST_UPDATE_JOB_STEP";
+	case DEFUNCT_RESPONSE_COMPLETE_JOB_STEP:
+		return "DEFUNCT_RESPONSE_COMPLETE_JOB_STEP";
+	case REQUEST_CHECKPOINT:
+		return "REQUEST_CHECKPOINT";
+	case RESPONSE_CHECKPOINT:
+		return "RESPONSE_CHECKPOINT";
+	case REQUEST_CHECKPOINT_COMP:
+		return "REQUEST_CHECKPOINT_COMP";
+	case REQUEST_CHECKPOINT_TASK_COMP:
+		return "REQUEST_CHECKPOINT_TASK_COMP";
+	case RESPONSE_CHECKPOINT_COMP:
+		return "RESPONSE_CHECKPOINT_COMP";
+	case REQUEST_SUSPEND:
+		return "REQUEST_SUSPEND";
+	case RESPONSE_SUSPEND:
+		return "RESPONSE_SUSPEND";
+	case REQUEST_STEP_COMPLETE:
+		return "REQUEST_STEP_COMPLETE";
+	case REQUEST_COMPLETE_JOB_ALLOCATION:
+		return "REQUEST_COMPLETE_JOB_ALLOCATION";
+	case REQUEST_COMPLETE_BATCH_SCRIPT:
+		return "REQUEST_COMPLETE_BATCH_SCRIPT";
+	case REQUEST_JOB_STEP_STAT:
+		return "REQUEST_JOB_STEP_STAT";
+	case RESPONSE_JOB_STEP_STAT:
+		return "RESPONSE_JOB_STEP_STAT";
+	case REQUEST_STEP_LAYOUT:
+		return "REQUEST_STEP_LAYOUT";
+	case RESPONSE_STEP_LAYOUT:
+		return "RESPONSE_STEP_LAYOUT";
+	case REQUEST_JOB_REQUEUE:
+		return "REQUEST_JOB_REQUEUE";
+	case REQUEST_DAEMON_STATUS:
+		return "REQUEST_DAEMON_STATUS";
+	case RESPONSE_SLURMD_STATUS:
+		return "RESPONSE_SLURMD_STATUS";
+	case RESPONSE_SLURMCTLD_STATUS:
+		return "RESPONSE_SLURMCTLD_STATUS";
+	case REQUEST_JOB_STEP_PIDS:
+		return "REQUEST_JOB_STEP_PIDS";
+	case RESPONSE_JOB_STEP_PIDS:
+		return "RESPONSE_JOB_STEP_PIDS";
+	case REQUEST_LAUNCH_TASKS:
+		return "REQUEST_LAUNCH_TASKS";
+	case RESPONSE_LAUNCH_TASKS:
+		return "RESPONSE_LAUNCH_TASKS";
+	case MESSAGE_TASK_EXIT:
+		return "MESSAGE_TASK_EXIT";
+	case REQUEST_SIGNAL_TASKS:
+		return "REQUEST_SIGNAL_TASKS";
+	case REQUEST_CHECKPOINT_TASKS:
+		return "REQUEST_CHECKPOINT_TASKS";
+	case REQUEST_TERMINATE_TASKS:
+		return "REQUEST_TERMINATE_TASKS";
+	case REQUEST_REATTACH_TASKS:
+		return "REQUEST_REATTACH_TASKS";
+	case RESPONSE_REATTACH_TASKS:
+		return "RESPONSE_REATTACH_TASKS";
+	case REQUEST_KILL_TIMELIMIT:
+		return "REQUEST_KILL_TIMELIMIT";
+	case REQUEST_SIGNAL_JOB:
+		return "REQUEST_SIGNAL_JOB";
+	case REQUEST_TERMINATE_JOB:
+		return "REQUEST_TERMINATE_JOB";
+	case MESSAGE_EPILOG_COMPLETE:
+		return "MESSAGE_EPILOG_COMPLETE";
+	case REQUEST_ABORT_JOB:
+		return "REQUEST_ABORT_JOB";
+	case REQUEST_FILE_BCAST:
+		return "REQUEST_FILE_BCAST";
+	case TASK_USER_MANAGED_IO_STREAM:
+		return "TASK_USER_MANAGED_IO_STREAM";
+	case REQUEST_KILL_PREEMPTED:
+		return "REQUEST_KILL_PREEMPTED";
+	case REQUEST_IO_RELAY_PORT:
+		return "REQUEST_IO_RELAY_PORT";
+	case RESPONSE_IO_RELAY_PORT:
+		return "RESPONSE_IO_RELAY_PORT";
+	case SRUN_PING:
+		return "SRUN_PING";
+	case SRUN_TIMEOUT:
+		return "SRUN_TIMEOUT";
+	case SRUN_NODE_FAIL:
+		return "SRUN_NODE_FAIL";
+	case SRUN_JOB_COMPLETE:
+		return "SRUN_JOB_COMPLETE";
+	case SRUN_USER_MSG:
+		return "SRUN_USER_MSG";
+	case SRUN_EXEC:
+		return "SRUN_EXEC";
+	case SRUN_STEP_MISSING:
+		return "SRUN_STEP_MISSING";
+	case SRUN_REQUEST_SUSPEND:
+		return "SRUN_REQUEST_SUSPEND";
+	case PMI_KVS_PUT_REQ:
+		return "PMI_KVS_PUT_REQ";
+	case PMI_KVS_PUT_RESP:
+		return "PMI_KVS_PUT_RESP";
+	case PMI_KVS_GET_REQ:
+		return "PMI_KVS_GET_REQ";
+	case PMI_KVS_GET_RESP:
+		return "PMI_KVS_GET_RESP";
+	case RESPONSE_SLURM_RC:
+		return "RESPONSE_SLURM_RC";
+	case RESPONSE_FORWARD_FAILED:
+		return "RESPONSE_FORWARD_FAILED";
+	case ACCOUNTING_UPDATE_MSG:
+		return "ACCOUNTING_UPDATE_MSG";
+	case ACCOUNTING_FIRST_REG:
+		return "ACCOUNTING_FIRST_REG";
+	case ACCOUNTING_REGISTER_CTLD:
+		return "ACCOUNTING_REGISTER_CTLD";
+	default:
+		return "UNKNOWN";
+	}
+}
+
 extern char *preempt_mode_string(uint16_t preempt_mode)
 {
 	char *gang_str;
@@ -1796,6 +2255,21 @@ extern void slurm_free_submit_response_response_msg(submit_response_msg_t * msg)
 	xfree(msg);
 }
 
+/*
+ * slurm_free_submit_multi_response_msg - free slurm multiple job submit
+ *	response message
+ * IN msg - pointer to job submit response message
+ * NOTE: buffer is loaded by slurm_submit_batch_job_multi
+ */
+extern void slurm_free_submit_multi_response_msg(
+	submit_multi_response_msg_t * msg)
+{
+	if (msg) {
+		xfree(msg->job_id);
+		xfree(msg);
+	}
+}
+
 
 /*
  * slurm_free_ctl_conf - free slurm control information response message
@@ -2267,6 +2741,60 @@ extern void slurm_free_priority_factors_response_msg(
 	}
 }
 
+extern void slurm_free_stats_info_request_msg(stats_info_request_msg_t *msg)
+{
+	xfree(msg);
+}
+
+extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
+{
+	uint32_t i;
+
+	if (msg) {
+		for (i = 0; msg->lock_type_name &&
+			    (i < msg->lock_type_size); i++)
+			xfree(msg->lock_type_name[i]);
+		xfree(msg->lock_type_name);
+		xfree(msg->lock_type_cnt);
+		xfree(msg->lock_type_contended);
+		xfree(msg->lock_type_wait);
+		xfree(msg->lock_type_wait_max);
+		xfree(msg->lock_type_hold);
+		xfree(msg->lock_type_hold_max);
+		for (i = 0; msg->lock_caller_name &&
+			    (i < msg->lock_caller_size); i++)
+			xfree(msg->lock_caller_name[i]);
+		xfree(msg->lock_caller_name);
+		xfree(msg->lock_caller_cnt);
+		xfree(msg->lock_caller_wait);
+		xfree(msg->lock_caller_wait_max);
+		xfree(msg->lock_caller_hold);
+		xfree(msg->lock_caller_hold_max);
+		for (i = 0; msg->rpc_queue_name &&
+			    (i < msg->rpc_queue_size); i++)
+			xfree(msg->rpc_queue_name[i]);
+		xfree(msg->rpc_queue_name);
+		xfree(msg->rpc_queue_cnt);
+		xfree(msg->rpc_queue_depth);
+		xfree(msg->rpc_queue_depth_max);
+		xfree(msg->rpc_queue_wait);
+		xfree(msg->rpc_queue_wait_max);
+		xfree(msg->rpc_queue_run);
+		xfree(msg->rpc_queue_run_max);
+		xfree(msg->rpc_type_id);
+		xfree(msg->rpc_type_cnt);
+		xfree(msg->rpc_type_time);
+		xfree(msg->rpc_type_time_max);
+		xfree(msg->rpc_type_limited);
+		xfree(msg->rpc_user_id);
+		xfree(msg->rpc_user_cnt);
+		xfree(msg->rpc_user_time);
+		xfree(msg->rpc_user_time_max);
+		xfree(msg->rpc_user_limited);
+		xfree(msg);
+	}
+}
+
 
 extern void slurm_free_accounting_update_msg(accounting_update_msg_t *msg)
 {
@@ -2319,11 +2847,19 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_UPDATE_JOB:
 		slurm_free_job_desc_msg(data);
 		break;
+	case REQUEST_SUBMIT_BATCH_JOB_MULTI:
+		slurm_free_job_desc_multi_msg(data);
+		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_MULTI:
+		slurm_free_submit_multi_response_msg(data);
+		break;
 	case MESSAGE_NODE_REGISTRATION_STATUS:
 		slurm_free_node_registration_status_msg(data);
 		break;
 	case REQUEST_JOB_END_TIME:
 	case REQUEST_JOB_ALLOCATION_INFO:
+	case REQUEST_JOB_ALLOCATION_INFO_LITE:
+	case REQUEST_JOB_SBCAST_CRED:
 		slurm_free_job_alloc_info_msg(data);
 		break;
 	case REQUEST_SHUTDOWN:
@@ -2377,6 +2913,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_JOB_INFO_SINGLE:
 		slurm_free_job_id_msg(data);
 		break;
+	case REQUEST_JOB_USER_INFO:
+		slurm_free_job_user_id_msg(data);
+		break;
 	case REQUEST_SHARE_INFO:
 		slurm_free_shares_request_msg(data);
 		break;
@@ -2389,6 +2928,12 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case RESPONSE_PRIORITY_FACTORS:
 		slurm_free_priority_factors_response_msg(data);
 		break;
+	case REQUEST_STATS_INFO:
+		slurm_free_stats_info_request_msg(data);
+		break;
+	case RESPONSE_STATS_INFO:
+		slurm_free_stats_response_msg(data);
+		break;
 	case REQUEST_BLOCK_INFO:
 		slurm_free_block_info_request_msg(data);
 		break;
@@ -2440,6 +2985,7 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_FILE_BCAST:
 		slurm_free_file_bcast_msg(data);
 		break;
+	case RESPONSE_IO_RELAY_PORT:
 	case RESPONSE_SLURM_RC:
 		slurm_free_return_code_msg(data);
 		break;
@@ -2475,9 +3021,29 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_SPANK_ENVIRONMENT:
 		slurm_free_spank_env_request_msg(data);
 		break;
+	case REQUEST_STEP_LAYOUT:
+	case REQUEST_IO_RELAY_PORT:
+		slurm_free_job_step_id_msg(data);
+		break;
+	case REQUEST_TRIGGER_SET:
+	case REQUEST_TRIGGER_GET:
+	case REQUEST_TRIGGER_CLEAR:
+	case REQUEST_TRIGGER_PULL:
+		slurm_free_trigger_msg(data);
+		break;
+	case REQUEST_JOB_NOTIFY:
+		slurm_free_job_notify_msg(data);
+		break;
+	case REQUEST_UPDATE_BLOCK:
+		slurm_free_block_info(data);
+		break;
 	case RESPONCE_SPANK_ENVIRONMENT:
 		slurm_free_spank_env_responce_msg(data);
 		break;
+	case RESPONSE_JOB_INFO_DELTA:
+	case RESPONSE_NODE_INFO_DELTA:
+		slurm_free_info_delta_msg(data);
+		break;
 	default:
 		error("invalid type trying to be freed %u", type);
 		break;
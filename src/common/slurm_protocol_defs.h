@@ -149,7 +149,7 @@
  */
 enum task_flag_vals {
 	TASK_PARALLEL_DEBUG = 0x1,
-	TASK_UNUSED1 = 0x2,
+	TASK_IO_TREE = 0x2,	/* relay stdio through parent slurmstepds */
 	TASK_UNUSED2 = 0x4
 };
 
@@ -210,6 +210,10 @@ typedef enum {
 	RESPONSE_FRONT_END_INFO,
 	REQUEST_SPANK_ENVIRONMENT,
 	RESPONCE_SPANK_ENVIRONMENT,
+	RESPONSE_JOB_INFO_DELTA,
+	RESPONSE_NODE_INFO_DELTA,
+	REQUEST_STATS_INFO,
+	RESPONSE_STATS_INFO,
 
 	REQUEST_UPDATE_JOB = 3001,
 	REQUEST_UPDATE_NODE,
@@ -247,6 +251,9 @@ typedef enum {
 	REQUEST_JOB_NOTIFY,
 	REQUEST_JOB_SBCAST_CRED,
 	RESPONSE_JOB_SBCAST_CRED,
+	REQUEST_SUBMIT_BATCH_JOB_MULTI,
+	RESPONSE_SUBMIT_BATCH_JOB_MULTI,
+	REQUEST_JOB_USER_INFO,
 
 	REQUEST_JOB_STEP_CREATE = 5001,
 	RESPONSE_JOB_STEP_CREATE,
@@ -294,6 +301,9 @@ typedef enum {
 	REQUEST_FILE_BCAST,
 	TASK_USER_MANAGED_IO_STREAM,
 	REQUEST_KILL_PREEMPTED,
+	REQUEST_IO_RELAY_PORT,	/* job_step_id_msg_t */
+	RESPONSE_IO_RELAY_PORT,	/* return_code_msg_t, return_code is the
+				 * stdio relay port or zero if none */
 
 	SRUN_PING = 7001,
 	SRUN_TIMEOUT,
@@ -473,6 +483,22 @@ typedef struct job_id_msg {
 	uint16_t show_flags;
 } job_id_msg_t;
 
+typedef struct job_user_id_msg {
+	uint32_t user_id;	/* NO_VAL for jobs of any user */
+	char *   job_name;	/* NULL for jobs of any name */
+	uint16_t show_flags;
+} job_user_id_msg_t;
+
+/* Maximum number of jobs submitted by one REQUEST_SUBMIT_BATCH_JOB_MULTI
+ * RPC. slurmctld holds the job write lock while creating all of them and
+ * rejects larger requests. */
+#define SUBMIT_MULTI_MAX_JOBS 1000
+
+typedef struct job_desc_multi_msg {
+	uint32_t job_cnt;		/* number of jobs to submit */
+	job_desc_msg_t *job_desc;	/* description shared by all jobs */
+} job_desc_multi_msg_t;
+
 typedef struct job_step_id_msg {
 	uint32_t job_id;
 	uint32_t step_id;
@@ -689,6 +715,7 @@ typedef struct task_user_managed_io_msg {
 
 typedef struct partition_info partition_desc_msg_t;
 
+/* Also used by RESPONSE_IO_RELAY_PORT to carry a port number */
 typedef struct return_code_msg {
 	uint32_t return_code;
 } return_code_msg_t;
@@ -846,9 +873,17 @@ typedef struct kvs_get_msg {
 	char * hostname;	/* hostname to be sent the kvs data */
 } kvs_get_msg_t;
 
+/* Codec applied to the data of a file_bcast_msg_t */
+#define BCAST_COMPRESS_NONE	0
+#define BCAST_COMPRESS_ZLIB	1
+
+/* Largest file_bcast_msg_t block, before any compression */
+#define BCAST_MAX_BLOCK_SIZE	(64 * 1024 * 1024)
+
 typedef struct file_bcast_msg {
 	char *fname;		/* name of the destination file */
-	uint16_t block_no;	/* block number of this data */
+	uint32_t block_no;	/* block number of this data */
+	uint64_t block_offset;	/* offset of this data in the file */
 	uint16_t last_block;	/* last block of bcast if set */
 	uint16_t force;		/* replace existing file if set */
 	uint16_t modes;		/* access rights for destination file */
@@ -857,6 +892,8 @@ typedef struct file_bcast_msg {
 	time_t atime;		/* last access time for destination file */
 	time_t mtime;		/* last modification time for dest file */
 	sbcast_cred_t *cred;	/* credential for the RPC */
+	uint16_t compress;	/* BCAST_COMPRESS_* codec of block */
+	uint32_t uncomp_len;	/* length of block once uncompressed */
 	uint32_t block_len;	/* length of this data block */
 	char *block;		/* data for this block */
 } file_bcast_msg_t;
@@ -930,6 +967,22 @@ typedef struct {
 	char **spank_job_env;	/* spank environment */
 } spank_env_responce_msg_t;
 
+/* Job or node records changed since the last_update of a request with
+ * SHOW_DELTA set. Each record is packed as in RESPONSE_JOB_INFO or
+ * RESPONSE_NODE_INFO so that libslurm can merge them into its copy of the
+ * previous response and unpack the result as a full response. */
+typedef struct info_delta_msg {
+	time_t last_update;	/* time of latest info */
+	uint16_t full;		/* if set records replace any cached copy */
+	uint32_t node_scaling;	/* node info only */
+	uint32_t record_count;	/* number of changed records */
+	uint32_t *record_id;	/* job ID or node index of each record */
+	uint32_t *record_size;	/* size of each packed record */
+	char **record_data;	/* packed records */
+	uint32_t delete_count;	/* number of removed records */
+	uint32_t *delete_id;	/* job ID or node index of removed records */
+} info_delta_msg_t;
+
 typedef struct slurm_ctl_conf slurm_ctl_conf_info_msg_t;
 /*****************************************************************************\
  *	SLURM MESSAGE INITIALIZATION
@@ -982,6 +1035,7 @@ extern void slurm_free_priority_factors_request_msg(
 	priority_factors_request_msg_t *msg);
 extern void slurm_free_priority_factors_response_msg(
 	priority_factors_response_msg_t *msg);
+extern void slurm_free_stats_info_request_msg(stats_info_request_msg_t *msg);
 
 #define	slurm_free_timelimit_msg(msg) \
 	slurm_free_kill_job_msg(msg)
@@ -989,6 +1043,7 @@ extern void slurm_free_priority_factors_response_msg(
 extern void slurm_free_shutdown_msg(shutdown_msg_t * msg);
 
 extern void slurm_free_job_desc_msg(job_desc_msg_t * msg);
+extern void slurm_free_job_desc_multi_msg(job_desc_multi_msg_t * msg);
 
 extern void
 slurm_free_node_registration_status_msg(slurm_node_registration_status_msg_t *
@@ -998,6 +1053,7 @@ extern void slurm_free_job_info(job_info_t * job);
 extern void slurm_free_job_info_members(job_info_t * job);
 
 extern void slurm_free_job_id_msg(job_id_msg_t * msg);
+extern void slurm_free_job_user_id_msg(job_user_id_msg_t * msg);
 extern void slurm_free_job_id_request_msg(job_id_request_msg_t * msg);
 extern void slurm_free_job_id_response_msg(job_id_response_msg_t * msg);
 
@@ -1089,6 +1145,17 @@ extern void slurm_free_job_notify_msg(job_notify_msg_t * msg);
 extern void slurm_free_accounting_update_msg(accounting_update_msg_t *msg);
 extern void slurm_free_spank_env_request_msg(spank_env_request_msg_t *msg);
 extern void slurm_free_spank_env_responce_msg(spank_env_responce_msg_t *msg);
+extern void slurm_free_info_delta_msg(info_delta_msg_t *msg);
+
+/*
+ * slurm_merge_info_delta - merge records changed since the last response
+ *	into a copy of all records, kept in record_id order
+ * IN/OUT cache - all records from earlier responses, replaced if the
+ *	delta is a full response
+ * IN/OUT delta - changed records, moved into the cache and freed
+ */
+extern void slurm_merge_info_delta(info_delta_msg_t **cache,
+				   info_delta_msg_t *delta);
 
 extern int slurm_free_msg_data(slurm_msg_type_t type, void *data);
 extern uint32_t slurm_get_return_code(slurm_msg_type_t type, void *data);
@@ -1096,6 +1163,9 @@ extern uint32_t slurm_get_return_code(slurm_msg_type_t type, void *data);
 extern char *preempt_mode_string(uint16_t preempt_mode);
 extern uint16_t preempt_mode_num(const char *preempt_mode);
 
+/* Translate a slurm_msg_type_t to its name */
+extern char *rpc_num2string(uint16_t opcode);
+
 extern char *sched_param_type_string(uint16_t select_type_param);
 extern char *job_reason_string(enum job_state_reason inx);
 extern char *job_state_string(uint16_t inx);
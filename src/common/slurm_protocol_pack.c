@@ -142,6 +142,20 @@ _unpack_job_alloc_info_response_msg(job_alloc_info_response_msg_t ** msg,
 				    Buf buffer,
 				    uint16_t protocol_version);
 
+static void _pack_job_desc_multi_msg(job_desc_multi_msg_t * msg, Buf buffer,
+				     uint16_t protocol_version);
+static int  _unpack_job_desc_multi_msg(job_desc_multi_msg_t ** msg,
+				       Buf buffer, uint16_t protocol_version);
+static void _pack_submit_multi_response_msg(submit_multi_response_msg_t * msg,
+					    Buf buffer,
+					    uint16_t protocol_version);
+static int  _unpack_submit_multi_response_msg(
+	submit_multi_response_msg_t ** msg, Buf buffer,
+	uint16_t protocol_version);
+static void _pack_job_user_id_msg(job_user_id_msg_t * msg, Buf buffer,
+				  uint16_t protocol_version);
+static int  _unpack_job_user_id_msg(job_user_id_msg_t ** msg, Buf buffer,
+				    uint16_t protocol_version);
 static void _pack_submit_response_msg(submit_response_msg_t * msg,
 				      Buf buffer,
 				      uint16_t protocol_version);
@@ -599,6 +613,19 @@ static void _pack_spank_env_responce_msg(spank_env_responce_msg_t * msg,
 static int _unpack_spank_env_responce_msg(spank_env_responce_msg_t ** msg_ptr,
 					  Buf buffer, uint16_t protocol_version);
 
+static int _unpack_info_delta_msg(info_delta_msg_t ** msg_ptr,
+				  Buf buffer, uint16_t protocol_version);
+
+static void _pack_stats_request_msg(stats_info_request_msg_t *msg,
+				    Buf buffer, uint16_t protocol_version);
+static int  _unpack_stats_request_msg(stats_info_request_msg_t **msg_ptr,
+				      Buf buffer, uint16_t protocol_version);
+
+static void _pack_stats_response_msg(stats_info_response_msg_t *msg,
+				     Buf buffer, uint16_t protocol_version);
+static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
+				       Buf buffer, uint16_t protocol_version);
+
 /* pack_header
  * packs a slurm protocol header that precedes every slurm message
  * IN header - the header structure to pack
@@ -766,6 +793,16 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 					  msg->data, buffer,
 					  msg->protocol_version);
 		break;
+	case REQUEST_SUBMIT_BATCH_JOB_MULTI:
+		_pack_job_desc_multi_msg((job_desc_multi_msg_t *)
+					 msg->data, buffer,
+					 msg->protocol_version);
+		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_MULTI:
+		_pack_submit_multi_response_msg((submit_multi_response_msg_t *)
+						msg->data, buffer,
+						msg->protocol_version);
+		break;
 	case RESPONSE_JOB_ALLOCATION_INFO_LITE:
 	case RESPONSE_RESOURCE_ALLOCATION:
 		_pack_resource_allocation_response_msg
@@ -898,6 +935,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 	case REQUEST_STEP_LAYOUT:
 	case REQUEST_JOB_STEP_STAT:
 	case REQUEST_JOB_STEP_PIDS:
+	case REQUEST_IO_RELAY_PORT:
 		_pack_job_step_id_msg((job_step_id_msg_t *)msg->data, buffer,
 				      msg->protocol_version);
 		break;
@@ -961,6 +999,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 					   msg->protocol_version);
 		break;
 	case RESPONSE_JOB_READY:
+	case RESPONSE_IO_RELAY_PORT:
 	case RESPONSE_SLURM_RC:
 		_pack_return_code_msg((return_code_msg_t *) msg->data,
 				      buffer,
@@ -1050,6 +1089,10 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 		_pack_job_ready_msg((job_id_msg_t *)msg->data, buffer,
 				    msg->protocol_version);
 		break;
+	case REQUEST_JOB_USER_INFO:
+		_pack_job_user_id_msg((job_user_id_msg_t *)msg->data, buffer,
+				      msg->protocol_version);
+		break;
 
 	case REQUEST_SHARE_INFO:
 		_pack_shares_request_msg((shares_request_msg_t *)msg->data,
@@ -1073,6 +1116,14 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 			buffer,
 			msg->protocol_version);
 		break;
+	case REQUEST_STATS_INFO:
+		_pack_stats_request_msg((stats_info_request_msg_t *)msg->data,
+					buffer, msg->protocol_version);
+		break;
+	case RESPONSE_STATS_INFO:
+		_pack_stats_response_msg((stats_info_response_msg_t *)msg->data,
+					 buffer, msg->protocol_version);
+		break;
 	case REQUEST_BLOCK_INFO:
 		_pack_block_info_req_msg(
 			(block_info_request_msg_t *) msg->data, buffer,
@@ -1159,6 +1210,10 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 			(spank_env_responce_msg_t *)msg->data, buffer,
 			msg->protocol_version);
 		break;
+	case RESPONSE_JOB_INFO_DELTA:
+	case RESPONSE_NODE_INFO_DELTA:
+		_pack_buffer_msg((slurm_msg_t *) msg, buffer);
+		break;
 	default:
 		debug("No pack method for msg type %u", msg->msg_type);
 		return EINVAL;
@@ -1274,6 +1329,16 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 						 & (msg->data), buffer,
 						 msg->protocol_version);
 		break;
+	case REQUEST_SUBMIT_BATCH_JOB_MULTI:
+		rc = _unpack_job_desc_multi_msg((job_desc_multi_msg_t **)
+						& (msg->data), buffer,
+						msg->protocol_version);
+		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_MULTI:
+		rc = _unpack_submit_multi_response_msg(
+			(submit_multi_response_msg_t **) & (msg->data),
+			buffer, msg->protocol_version);
+		break;
 	case RESPONSE_JOB_ALLOCATION_INFO_LITE:
 	case RESPONSE_RESOURCE_ALLOCATION:
 		rc = _unpack_resource_allocation_response_msg(
@@ -1416,6 +1481,7 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 	case REQUEST_STEP_LAYOUT:
 	case REQUEST_JOB_STEP_STAT:
 	case REQUEST_JOB_STEP_PIDS:
+	case REQUEST_IO_RELAY_PORT:
 		_unpack_job_step_id_msg((job_step_id_msg_t **)&msg->data,
 					buffer,
 					msg->protocol_version);
@@ -1487,6 +1553,7 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 						  msg->protocol_version);
 		break;
 	case RESPONSE_JOB_READY:
+	case RESPONSE_IO_RELAY_PORT:
 	case RESPONSE_SLURM_RC:
 		rc = _unpack_return_code_msg((return_code_msg_t **)
 					     & (msg->data), buffer,
@@ -1583,6 +1650,11 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 					   & msg->data, buffer,
 					   msg->protocol_version);
 		break;
+	case REQUEST_JOB_USER_INFO:
+		rc = _unpack_job_user_id_msg((job_user_id_msg_t **)
+					     & msg->data, buffer,
+					     msg->protocol_version);
+		break;
 	case REQUEST_SHARE_INFO:
 		rc = _unpack_shares_request_msg(
 			(shares_request_msg_t **)&msg->data,
@@ -1607,6 +1679,16 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 			buffer,
 			msg->protocol_version);
 		break;
+	case REQUEST_STATS_INFO:
+		rc = _unpack_stats_request_msg(
+			(stats_info_request_msg_t **)&msg->data,
+			buffer, msg->protocol_version);
+		break;
+	case RESPONSE_STATS_INFO:
+		rc = _unpack_stats_response_msg(
+			(stats_info_response_msg_t **)&msg->data,
+			buffer, msg->protocol_version);
+		break;
 	case REQUEST_BLOCK_INFO:
 		rc = _unpack_block_info_req_msg(
 			(block_info_request_msg_t **) &msg->data,
@@ -1703,6 +1785,12 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 			(spank_env_responce_msg_t **)&msg->data, buffer,
 			msg->protocol_version);
 		break;
+	case RESPONSE_JOB_INFO_DELTA:
+	case RESPONSE_NODE_INFO_DELTA:
+		rc = _unpack_info_delta_msg(
+			(info_delta_msg_t **)&msg->data, buffer,
+			msg->protocol_version);
+		break;
 	default:
 		debug("No unpack method for msg type %u", msg->msg_type);
 		return EINVAL;
@@ -2651,6 +2739,106 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void
+_pack_job_desc_multi_msg(job_desc_multi_msg_t * msg, Buf buffer,
+			 uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+
+	pack32(msg->job_cnt, buffer);
+	_pack_job_desc_msg(msg->job_desc, buffer, protocol_version);
+}
+
+static int
+_unpack_job_desc_multi_msg(job_desc_multi_msg_t ** msg, Buf buffer,
+			   uint16_t protocol_version)
+{
+	job_desc_multi_msg_t *tmp_ptr;
+
+	xassert(msg != NULL);
+	tmp_ptr = xmalloc(sizeof(job_desc_multi_msg_t));
+	*msg = tmp_ptr;
+
+	safe_unpack32(&tmp_ptr->job_cnt, buffer);
+	/* Sanity check only, so the job ID array of the response can be
+	 * packed. slurmctld rejects counts over SUBMIT_MULTI_MAX_JOBS with
+	 * ESLURM_INVALID_JOB_COUNT. */
+	if (tmp_ptr->job_cnt > (MAX_BUF_SIZE / sizeof(uint32_t)))
+		goto unpack_error;
+	if (_unpack_job_desc_msg(&tmp_ptr->job_desc, buffer,
+				 protocol_version))
+		goto unpack_error;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_job_desc_multi_msg(tmp_ptr);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
+static void
+_pack_submit_multi_response_msg(submit_multi_response_msg_t * msg,
+				Buf buffer, uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+
+	pack32_array(msg->job_id, msg->job_cnt, buffer);
+	pack32(msg->error_code, buffer);
+}
+
+static int
+_unpack_submit_multi_response_msg(submit_multi_response_msg_t ** msg,
+				  Buf buffer, uint16_t protocol_version)
+{
+	submit_multi_response_msg_t *tmp_ptr;
+
+	xassert(msg != NULL);
+	tmp_ptr = xmalloc(sizeof(submit_multi_response_msg_t));
+	*msg = tmp_ptr;
+
+	safe_unpack32_array(&tmp_ptr->job_id, &tmp_ptr->job_cnt, buffer);
+	safe_unpack32(&tmp_ptr->error_code, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_submit_multi_response_msg(tmp_ptr);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
+static void
+_pack_job_user_id_msg(job_user_id_msg_t * msg, Buf buffer,
+		      uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+
+	pack32(msg->user_id, buffer);
+	packstr(msg->job_name, buffer);
+	pack16(msg->show_flags, buffer);
+}
+
+static int
+_unpack_job_user_id_msg(job_user_id_msg_t ** msg, Buf buffer,
+			uint16_t protocol_version)
+{
+	job_user_id_msg_t *tmp_ptr;
+	uint32_t uint32_tmp;
+
+	xassert(msg != NULL);
+	tmp_ptr = xmalloc(sizeof(job_user_id_msg_t));
+	*msg = tmp_ptr;
+
+	safe_unpack32(&tmp_ptr->user_id, buffer);
+	safe_unpackstr_xmalloc(&tmp_ptr->job_name, &uint32_tmp, buffer);
+	safe_unpack16(&tmp_ptr->show_flags, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_job_user_id_msg(tmp_ptr);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static int
 _unpack_node_info_msg(node_info_msg_t ** msg, Buf buffer,
 		      uint16_t protocol_version)
@@ -9169,27 +9357,49 @@ static void _pack_file_bcast(file_bcast_msg_t * msg , Buf buffer,
 
 	grow_buf(buffer,  msg->block_len);
 
-	pack16 ( msg->block_no, buffer );
-	pack16 ( msg->last_block, buffer );
-	pack16 ( msg->force, buffer );
-	pack16 ( msg->modes, buffer );
+	if (protocol_version >= SLURM_2_4_PROTOCOL_VERSION) {
+		pack32 ( msg->block_no, buffer );
+		pack64 ( msg->block_offset, buffer );
+		pack16 ( msg->last_block, buffer );
+		pack16 ( msg->force, buffer );
+		pack16 ( msg->modes, buffer );
+
+		pack32 ( msg->uid, buffer );
+		pack32 ( msg->gid, buffer );
+
+		pack_time ( msg->atime, buffer );
+		pack_time ( msg->mtime, buffer );
+
+		packstr ( msg->fname, buffer );
+		pack16 ( msg->compress, buffer );
+		pack32 ( msg->uncomp_len, buffer );
+		pack32 ( msg->block_len, buffer );
+		packmem ( msg->block, msg->block_len, buffer );
+		pack_sbcast_cred( msg->cred, buffer );
+	} else {
+		pack16 ( (uint16_t) msg->block_no, buffer );
+		pack16 ( msg->last_block, buffer );
+		pack16 ( msg->force, buffer );
+		pack16 ( msg->modes, buffer );
 
-	pack32 ( msg->uid, buffer );
-	pack32 ( msg->gid, buffer );
+		pack32 ( msg->uid, buffer );
+		pack32 ( msg->gid, buffer );
 
-	pack_time ( msg->atime, buffer );
-	pack_time ( msg->mtime, buffer );
+		pack_time ( msg->atime, buffer );
+		pack_time ( msg->mtime, buffer );
 
-	packstr ( msg->fname, buffer );
-	pack32 ( msg->block_len, buffer );
-	packmem ( msg->block, msg->block_len, buffer );
-	pack_sbcast_cred( msg->cred, buffer );
+		packstr ( msg->fname, buffer );
+		pack32 ( msg->block_len, buffer );
+		packmem ( msg->block, msg->block_len, buffer );
+		pack_sbcast_cred( msg->cred, buffer );
+	}
 }
 
 static int _unpack_file_bcast(file_bcast_msg_t ** msg_ptr , Buf buffer,
 			      uint16_t protocol_version)
 {
 	uint32_t uint32_tmp;
+	uint16_t uint16_tmp;
 	file_bcast_msg_t *msg ;
 
 	xassert ( msg_ptr != NULL );
@@ -9197,22 +9407,49 @@ static int _unpack_file_bcast(file_bcast_msg_t ** msg_ptr , Buf buffer,
 	msg = xmalloc ( sizeof (file_bcast_msg_t) ) ;
 	*msg_ptr = msg;
 
-	safe_unpack16 ( & msg->block_no, buffer );
-	safe_unpack16 ( & msg->last_block, buffer );
-	safe_unpack16 ( & msg->force, buffer );
-	safe_unpack16 ( & msg->modes, buffer );
-
-	safe_unpack32 ( & msg->uid, buffer );
-	safe_unpack32 ( & msg->gid, buffer );
-
-	safe_unpack_time ( & msg->atime, buffer );
-	safe_unpack_time ( & msg->mtime, buffer );
-
-	safe_unpackstr_xmalloc ( & msg->fname, &uint32_tmp, buffer );
-	safe_unpack32 ( & msg->block_len, buffer );
-	safe_unpackmem_xmalloc ( & msg->block, &uint32_tmp , buffer ) ;
-	if ( uint32_tmp != msg->block_len )
-		goto unpack_error;
+	if (protocol_version >= SLURM_2_4_PROTOCOL_VERSION) {
+		safe_unpack32 ( & msg->block_no, buffer );
+		safe_unpack64 ( & msg->block_offset, buffer );
+		safe_unpack16 ( & msg->last_block, buffer );
+		safe_unpack16 ( & msg->force, buffer );
+		safe_unpack16 ( & msg->modes, buffer );
+
+		safe_unpack32 ( & msg->uid, buffer );
+		safe_unpack32 ( & msg->gid, buffer );
+
+		safe_unpack_time ( & msg->atime, buffer );
+		safe_unpack_time ( & msg->mtime, buffer );
+
+		safe_unpackstr_xmalloc ( & msg->fname, &uint32_tmp, buffer );
+		safe_unpack16 ( & msg->compress, buffer );
+		safe_unpack32 ( & msg->uncomp_len, buffer );
+		safe_unpack32 ( & msg->block_len, buffer );
+		safe_unpackmem_xmalloc ( & msg->block, &uint32_tmp , buffer ) ;
+		if ( uint32_tmp != msg->block_len )
+			goto unpack_error;
+	} else {
+		safe_unpack16 ( & uint16_tmp, buffer );
+		msg->block_no = uint16_tmp;
+		/* blocks arrive in order, appended to the file */
+		msg->block_offset = NO_VAL64;
+		safe_unpack16 ( & msg->last_block, buffer );
+		safe_unpack16 ( & msg->force, buffer );
+		safe_unpack16 ( & msg->modes, buffer );
+
+		safe_unpack32 ( & msg->uid, buffer );
+		safe_unpack32 ( & msg->gid, buffer );
+
+		safe_unpack_time ( & msg->atime, buffer );
+		safe_unpack_time ( & msg->mtime, buffer );
+
+		safe_unpackstr_xmalloc ( & msg->fname, &uint32_tmp, buffer );
+		safe_unpack32 ( & msg->block_len, buffer );
+		safe_unpackmem_xmalloc ( & msg->block, &uint32_tmp , buffer ) ;
+		if ( uint32_tmp != msg->block_len )
+			goto unpack_error;
+		msg->compress = BCAST_COMPRESS_NONE;
+		msg->uncomp_len = msg->block_len;
+	}
 
 	msg->cred = unpack_sbcast_cred( buffer );
 	if (msg->cred == NULL)
@@ -9949,6 +10186,294 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* The message body is packed by the controller in pack_all_jobs() and
+ * pack_all_node(), RESPONSE_*_INFO_DELTA use _pack_buffer_msg() */
+static int _unpack_info_delta_msg(info_delta_msg_t ** msg_ptr,
+				  Buf buffer, uint16_t protocol_version)
+{
+	info_delta_msg_t *msg;
+	uint32_t i;
+
+	xassert(msg_ptr != NULL);
+	msg = xmalloc(sizeof(info_delta_msg_t));
+	*msg_ptr = msg;
+
+	safe_unpack_time(&msg->last_update, buffer);
+	safe_unpack16(&msg->full, buffer);
+	safe_unpack32(&msg->node_scaling, buffer);
+	safe_unpack32(&msg->record_count, buffer);
+	if (msg->record_count > remaining_buf(buffer))
+		goto unpack_error;
+	msg->record_id   = xmalloc(sizeof(uint32_t) * msg->record_count);
+	msg->record_size = xmalloc(sizeof(uint32_t) * msg->record_count);
+	msg->record_data = xmalloc(sizeof(char *)   * msg->record_count);
+	for (i = 0; i < msg->record_count; i++) {
+		safe_unpack32(&msg->record_id[i], buffer);
+		safe_unpackmem_xmalloc(&msg->record_data[i],
+				       &msg->record_size[i], buffer);
+	}
+	safe_unpack32_array(&msg->delete_id, &msg->delete_count, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_info_delta_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
+static void _pack_stats_request_msg(stats_info_request_msg_t *msg,
+				    Buf buffer, uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+
+	pack16(msg->command_id, buffer);
+}
+
+static int _unpack_stats_request_msg(stats_info_request_msg_t **msg_ptr,
+				     Buf buffer, uint16_t protocol_version)
+{
+	stats_info_request_msg_t *msg;
+
+	xassert(msg_ptr != NULL);
+	msg = xmalloc(sizeof(stats_info_request_msg_t));
+	*msg_ptr = msg;
+
+	safe_unpack16(&msg->command_id, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_stats_info_request_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
+static void _pack_stats_response_msg(stats_info_response_msg_t *msg,
+				     Buf buffer, uint16_t protocol_version)
+{
+	uint32_t i;
+
+	xassert(msg != NULL);
+
+	pack_time(msg->req_time, buffer);
+	pack_time(msg->req_time_start, buffer);
+	pack32(msg->server_thread_count, buffer);
+	pack32(msg->agent_queue_size, buffer);
+	pack32(msg->agent_count, buffer);
+	pack32(msg->dbd_agent_queue_size, buffer);
+
+	pack32(msg->schedule_cycle_counter, buffer);
+	pack32(msg->schedule_cycle_last, buffer);
+	pack32(msg->schedule_cycle_max, buffer);
+	pack64(msg->schedule_cycle_sum, buffer);
+	pack64(msg->schedule_cycle_depth, buffer);
+	pack32(msg->schedule_queue_len, buffer);
+
+	pack32(msg->bf_cycle_counter, buffer);
+	pack32(msg->bf_cycle_last, buffer);
+	pack32(msg->bf_cycle_max, buffer);
+	pack64(msg->bf_cycle_sum, buffer);
+	pack64(msg->bf_depth_sum, buffer);
+	pack32(msg->bf_last_depth, buffer);
+	pack32(msg->bf_queue_len, buffer);
+	pack32(msg->bf_backfilled_jobs, buffer);
+	pack_time(msg->bf_when_last_cycle, buffer);
+	pack16(msg->bf_active, buffer);
+
+	pack32(msg->state_save_counter, buffer);
+	pack32(msg->state_save_last, buffer);
+	pack32(msg->state_save_max, buffer);
+	pack64(msg->state_save_sum, buffer);
+
+	packstr_array(msg->lock_type_name, msg->lock_type_size, buffer);
+	pack32_array(msg->lock_type_cnt, msg->lock_type_size, buffer);
+	pack32_array(msg->lock_type_contended, msg->lock_type_size, buffer);
+	for (i = 0; i < msg->lock_type_size; i++)
+		pack64(msg->lock_type_wait[i], buffer);
+	pack32_array(msg->lock_type_wait_max, msg->lock_type_size, buffer);
+	for (i = 0; i < msg->lock_type_size; i++)
+		pack64(msg->lock_type_hold[i], buffer);
+	pack32_array(msg->lock_type_hold_max, msg->lock_type_size, buffer);
+
+	packstr_array(msg->lock_caller_name, msg->lock_caller_size, buffer);
+	pack32_array(msg->lock_caller_cnt, msg->lock_caller_size, buffer);
+	for (i = 0; i < msg->lock_caller_size; i++)
+		pack64(msg->lock_caller_wait[i], buffer);
+	pack32_array(msg->lock_caller_wait_max, msg->lock_caller_size, buffer);
+	for (i = 0; i < msg->lock_caller_size; i++)
+		pack64(msg->lock_caller_hold[i], buffer);
+	pack32_array(msg->lock_caller_hold_max, msg->lock_caller_size, buffer);
+
+	pack32(msg->rpc_queue_workers, buffer);
+	pack32(msg->rpc_queue_conn_depth, buffer);
+	packstr_array(msg->rpc_queue_name, msg->rpc_queue_size, buffer);
+	pack32_array(msg->rpc_queue_cnt, msg->rpc_queue_size, buffer);
+	pack32_array(msg->rpc_queue_depth, msg->rpc_queue_size, buffer);
+	pack32_array(msg->rpc_queue_depth_max, msg->rpc_queue_size, buffer);
+	for (i = 0; i < msg->rpc_queue_size; i++)
+		pack64(msg->rpc_queue_wait[i], buffer);
+	pack32_array(msg->rpc_queue_wait_max, msg->rpc_queue_size, buffer);
+	for (i = 0; i < msg->rpc_queue_size; i++)
+		pack64(msg->rpc_queue_run[i], buffer);
+	pack32_array(msg->rpc_queue_run_max, msg->rpc_queue_size, buffer);
+
+	pack16_array(msg->rpc_type_id, msg->rpc_type_size, buffer);
+	pack32_array(msg->rpc_type_cnt, msg->rpc_type_size, buffer);
+	for (i = 0; i < msg->rpc_type_size; i++)
+		pack64(msg->rpc_type_time[i], buffer);
+	pack32_array(msg->rpc_type_time_max, msg->rpc_type_size, buffer);
+	pack32_array(msg->rpc_type_limited, msg->rpc_type_size, buffer);
+
+	pack32_array(msg->rpc_user_id, msg->rpc_user_size, buffer);
+	pack32_array(msg->rpc_user_cnt, msg->rpc_user_size, buffer);
+	for (i = 0; i < msg->rpc_user_size; i++)
+		pack64(msg->rpc_user_time[i], buffer);
+	pack32_array(msg->rpc_user_time_max, msg->rpc_user_size, buffer);
+	pack32_array(msg->rpc_user_limited, msg->rpc_user_size, buffer);
+}
+
+static int _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
+				      Buf buffer, uint16_t protocol_version)
+{
+	stats_info_response_msg_t *msg;
+	uint32_t i, uint32_tmp;
+
+	xassert(msg_ptr != NULL);
+	msg = xmalloc(sizeof(stats_info_response_msg_t));
+	*msg_ptr = msg;
+
+	safe_unpack_time(&msg->req_time, buffer);
+	safe_unpack_time(&msg->req_time_start, buffer);
+	safe_unpack32(&msg->server_thread_count, buffer);
+	safe_unpack32(&msg->agent_queue_size, buffer);
+	safe_unpack32(&msg->agent_count, buffer);
+	safe_unpack32(&msg->dbd_agent_queue_size, buffer);
+
+	safe_unpack32(&msg->schedule_cycle_counter, buffer);
+	safe_unpack32(&msg->schedule_cycle_last, buffer);
+	safe_unpack32(&msg->schedule_cycle_max, buffer);
+	safe_unpack64(&msg->schedule_cycle_sum, buffer);
+	safe_unpack64(&msg->schedule_cycle_depth, buffer);
+	safe_unpack32(&msg->schedule_queue_len, buffer);
+
+	safe_unpack32(&msg->bf_cycle_counter, buffer);
+	safe_unpack32(&msg->bf_cycle_last, buffer);
+	safe_unpack32(&msg->bf_cycle_max, buffer);
+	safe_unpack64(&msg->bf_cycle_sum, buffer);
+	safe_unpack64(&msg->bf_depth_sum, buffer);
+	safe_unpack32(&msg->bf_last_depth, buffer);
+	safe_unpack32(&msg->bf_queue_len, buffer);
+	safe_unpack32(&msg->bf_backfilled_jobs, buffer);
+	safe_unpack_time(&msg->bf_when_last_cycle, buffer);
+	safe_unpack16(&msg->bf_active, buffer);
+
+	safe_unpack32(&msg->state_save_counter, buffer);
+	safe_unpack32(&msg->state_save_last, buffer);
+	safe_unpack32(&msg->state_save_max, buffer);
+	safe_unpack64(&msg->state_save_sum, buffer);
+
+	safe_unpackstr_array(&msg->lock_type_name, &msg->lock_type_size,
+			     buffer);
+	safe_unpack32_array(&msg->lock_type_cnt, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->lock_type_size)
+		goto unpack_error;
+	safe_unpack32_array(&msg->lock_type_contended, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->lock_type_size)
+		goto unpack_error;
+	msg->lock_type_wait = xmalloc(sizeof(uint64_t) * msg->lock_type_size);
+	for (i = 0; i < msg->lock_type_size; i++)
+		safe_unpack64(&msg->lock_type_wait[i], buffer);
+	safe_unpack32_array(&msg->lock_type_wait_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->lock_type_size)
+		goto unpack_error;
+	msg->lock_type_hold = xmalloc(sizeof(uint64_t) * msg->lock_type_size);
+	for (i = 0; i < msg->lock_type_size; i++)
+		safe_unpack64(&msg->lock_type_hold[i], buffer);
+	safe_unpack32_array(&msg->lock_type_hold_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->lock_type_size)
+		goto unpack_error;
+
+	safe_unpackstr_array(&msg->lock_caller_name, &msg->lock_caller_size,
+			     buffer);
+	safe_unpack32_array(&msg->lock_caller_cnt, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->lock_caller_size)
+		goto unpack_error;
+	msg->lock_caller_wait = xmalloc(sizeof(uint64_t) *
+					msg->lock_caller_size);
+	for (i = 0; i < msg->lock_caller_size; i++)
+		safe_unpack64(&msg->lock_caller_wait[i], buffer);
+	safe_unpack32_array(&msg->lock_caller_wait_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->lock_caller_size)
+		goto unpack_error;
+	msg->lock_caller_hold = xmalloc(sizeof(uint64_t) *
+					msg->lock_caller_size);
+	for (i = 0; i < msg->lock_caller_size; i++)
+		safe_unpack64(&msg->lock_caller_hold[i], buffer);
+	safe_unpack32_array(&msg->lock_caller_hold_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->lock_caller_size)
+		goto unpack_error;
+
+	safe_unpack32(&msg->rpc_queue_workers, buffer);
+	safe_unpack32(&msg->rpc_queue_conn_depth, buffer);
+	safe_unpackstr_array(&msg->rpc_queue_name, &msg->rpc_queue_size,
+			     buffer);
+	safe_unpack32_array(&msg->rpc_queue_cnt, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_queue_size)
+		goto unpack_error;
+	safe_unpack32_array(&msg->rpc_queue_depth, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_queue_size)
+		goto unpack_error;
+	safe_unpack32_array(&msg->rpc_queue_depth_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_queue_size)
+		goto unpack_error;
+	msg->rpc_queue_wait = xmalloc(sizeof(uint64_t) * msg->rpc_queue_size);
+	for (i = 0; i < msg->rpc_queue_size; i++)
+		safe_unpack64(&msg->rpc_queue_wait[i], buffer);
+	safe_unpack32_array(&msg->rpc_queue_wait_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_queue_size)
+		goto unpack_error;
+	msg->rpc_queue_run = xmalloc(sizeof(uint64_t) * msg->rpc_queue_size);
+	for (i = 0; i < msg->rpc_queue_size; i++)
+		safe_unpack64(&msg->rpc_queue_run[i], buffer);
+	safe_unpack32_array(&msg->rpc_queue_run_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_queue_size)
+		goto unpack_error;
+
+	safe_unpack16_array(&msg->rpc_type_id, &msg->rpc_type_size, buffer);
+	safe_unpack32_array(&msg->rpc_type_cnt, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_type_size)
+		goto unpack_error;
+	msg->rpc_type_time = xmalloc(sizeof(uint64_t) * msg->rpc_type_size);
+	for (i = 0; i < msg->rpc_type_size; i++)
+		safe_unpack64(&msg->rpc_type_time[i], buffer);
+	safe_unpack32_array(&msg->rpc_type_time_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_type_size)
+		goto unpack_error;
+	safe_unpack32_array(&msg->rpc_type_limited, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_type_size)
+		goto unpack_error;
+
+	safe_unpack32_array(&msg->rpc_user_id, &msg->rpc_user_size, buffer);
+	safe_unpack32_array(&msg->rpc_user_cnt, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_user_size)
+		goto unpack_error;
+	msg->rpc_user_time = xmalloc(sizeof(uint64_t) * msg->rpc_user_size);
+	for (i = 0; i < msg->rpc_user_size; i++)
+		safe_unpack64(&msg->rpc_user_time[i], buffer);
+	safe_unpack32_array(&msg->rpc_user_time_max, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_user_size)
+		goto unpack_error;
+	safe_unpack32_array(&msg->rpc_user_limited, &uint32_tmp, buffer);
+	if (uint32_tmp != msg->rpc_user_size)
+		goto unpack_error;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_stats_response_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 
 /* template
    void pack_ ( * msg , Buf buffer )
@@ -79,6 +79,7 @@
 
 /* bitstring.[ch] functions*/
 #define	bit_alloc		slurm_bit_alloc
+#define	bit_alloc_sparse	slurm_bit_alloc_sparse
 #define	bit_test		slurm_bit_test
 #define	bit_set			slurm_bit_set
 #define	bit_clear		slurm_bit_clear
@@ -86,10 +87,12 @@
 #define	bit_nset		slurm_bit_nset
 #define	bit_ffc			slurm_bit_ffc
 #define	bit_ffs			slurm_bit_ffs
+#define	bit_ffs_from_bit	slurm_bit_ffs_from_bit
 #define	bit_free		slurm_bit_free
 #define	bit_realloc		slurm_bit_realloc
 #define	bit_size		slurm_bit_size
 #define	bit_and			slurm_bit_and
+#define	bit_and_not		slurm_bit_and_not
 #define	bit_not			slurm_bit_not
 #define	bit_or			slurm_bit_or
 #define	bit_set_count		slurm_bit_set_count
@@ -108,6 +111,7 @@
 #define	bit_fls			slurm_bit_fls
 #define	bit_fill_gaps		slurm_bit_fill_gaps
 #define	bit_super_set		slurm_bit_super_set
+#define	bit_overlap_any		slurm_bit_overlap_any
 #define	bit_copy		slurm_bit_copy
 #define	bit_pick_cnt		slurm_bit_pick_cnt
 #define bit_nffc		slurm_bit_nffc
@@ -141,10 +145,12 @@
 #define	hostlist_next		slurm_hostlist_next
 #define	hostlist_next_range	slurm_hostlist_next_range
 #define	hostlist_nth		slurm_hostlist_nth
+#define	hostlist_nth_range	slurm_hostlist_nth_range
 #define	hostlist_pop            slurm_hostlist_pop
 #define	hostlist_pop_range      slurm_hostlist_pop_range
 #define	hostlist_push		slurm_hostlist_push
 #define	hostlist_push_host	slurm_hostlist_push_host
+#define	hostlist_push_host_range slurm_hostlist_push_host_range
 #define	hostlist_push_list	slurm_hostlist_push_list
 #define	hostlist_ranged_string	slurm_hostlist_ranged_string
 #define	hostlist_ranged_string_malloc \
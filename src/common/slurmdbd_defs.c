@@ -389,6 +389,19 @@ extern int slurm_send_slurmdbd_msg(uint16_t rpc_version, slurmdbd_msg_t *req)
 	return rc;
 }
 
+/* Return the count of RPCs queued by the agent for the SlurmDBD */
+extern int slurmdbd_agent_queue_count(void)
+{
+	int cnt = 0;
+
+	slurm_mutex_lock(&agent_lock);
+	if (agent_list)
+		cnt = list_count(agent_list);
+	slurm_mutex_unlock(&agent_lock);
+
+	return cnt;
+}
+
 /* Open a connection to the Slurm DBD and set slurmdbd_fd */
 static void _open_slurmdbd_fd(bool need_db)
 {
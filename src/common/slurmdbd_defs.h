@@ -422,6 +422,9 @@ extern int slurm_send_slurmdbd_recv_rc_msg(uint16_t rpc_version,
 					   slurmdbd_msg_t *req,
 					   int *rc);
 
+/* Return the count of RPCs queued by the agent for the SlurmDBD */
+extern int slurmdbd_agent_queue_count(void);
+
 extern Buf pack_slurmdbd_msg(slurmdbd_msg_t *req, uint16_t rpc_version);
 extern int unpack_slurmdbd_msg(slurmdbd_msg_t *resp,
 			       uint16_t rpc_version, Buf buffer);
@@ -1005,3 +1005,20 @@ rwfail:
 	return SLURM_ERROR;
 }
 
+/*
+ * Return the port on which the slurmstepd accepts stdio relay connections,
+ * or 0 if there is none.
+ */
+uint16_t
+stepd_io_relay_port(int fd)
+{
+	int req = REQUEST_STEP_IO_RELAY_PORT;
+	uint16_t port;
+
+	safe_write(fd, &req, sizeof(int));
+	safe_read(fd, &port, sizeof(uint16_t));
+
+	return port;
+rwfail:
+	return 0;
+}
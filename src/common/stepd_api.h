@@ -74,6 +74,7 @@ typedef enum {
 	REQUEST_STEP_LIST_PIDS,
 	REQUEST_STEP_RECONFIGURE,
 	REQUEST_STEP_STAT,
+	REQUEST_STEP_IO_RELAY_PORT,
 } step_msg_t;
 
 typedef enum {
@@ -249,5 +250,12 @@ int stepd_task_info(int fd, slurmstepd_task_info_t **task_info,
 
 int stepd_list_pids(int fd, uint32_t **pids_array, uint32_t *pids_count);
 
+/*
+ * Return the port on which the slurmstepd accepts stdio relay connections
+ * from the slurmstepds below it in the step's reverse tree, or 0 if it has
+ * not (yet) opened one.
+ */
+uint16_t stepd_io_relay_port(int fd);
+
 
 #endif /* _STEPD_API_H */
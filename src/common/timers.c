@@ -36,9 +36,11 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
 \*****************************************************************************/
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <sys/time.h>
 #include "src/common/log.h"
+#include "src/common/timers.h"
 
 /*
  * slurm_diff_tv_str - build a string showing the time difference between two
@@ -82,3 +84,19 @@ extern long slurm_diff_tv(struct timeval *tv1, struct timeval *tv2)
 	delta_t +=  tv2->tv_usec - tv1->tv_usec;
 	return delta_t;
 }
+
+/*
+ * slurm_diff_tv_usec - return the difference between two times for use in
+ *		        statistics
+ * IN tv1 - start of event
+ * IN tv2 - end of event
+ * RET time in micro-seconds, zero if the clock moved backwards
+ */
+extern uint32_t slurm_diff_tv_usec(struct timeval *tv1, struct timeval *tv2)
+{
+	long delta_t = slurm_diff_tv(tv1, tv2);
+
+	if (delta_t < 0)
+		return 0;
+	return (uint32_t) delta_t;
+}
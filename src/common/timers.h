@@ -39,6 +39,7 @@
 #ifndef _HAVE_TIMERS_H
 #define _HAVE_TIMERS_H
 
+#include <inttypes.h>
 #include <sys/time.h>
 
 #define DEF_TIMERS	struct timeval tv1, tv2; char tv_str[20]
@@ -74,4 +75,13 @@ extern void slurm_diff_tv_str(struct timeval *tv1,struct timeval *tv2,
  */
 extern long slurm_diff_tv(struct timeval *tv1, struct timeval *tv2);
 
+/*
+ * slurm_diff_tv_usec - return the difference between two times for use in
+ *		        statistics
+ * IN tv1 - start of event
+ * IN tv2 - end of event
+ * RET time in micro-seconds, zero if the clock moved backwards
+ */
+extern uint32_t slurm_diff_tv_usec(struct timeval *tv1, struct timeval *tv2);
+
 #endif
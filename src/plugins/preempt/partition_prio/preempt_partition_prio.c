@@ -112,8 +112,8 @@ extern List find_preemptable_jobs(struct job_record *job_ptr)
 		    (job_p->part_ptr->priority >= job_ptr->part_ptr->priority))
 			continue;
 		if ((job_p->node_bitmap == NULL) ||
-		    (bit_overlap(job_p->node_bitmap,
-				 job_ptr->part_ptr->node_bitmap) == 0))
+		    (bit_overlap_any(job_p->node_bitmap,
+				     job_ptr->part_ptr->node_bitmap) == 0))
 			continue;
 		if (job_ptr->details &&
 		    (job_ptr->details->expanding_jobid == job_p->job_id))
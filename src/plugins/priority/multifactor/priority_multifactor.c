@@ -52,6 +52,7 @@
 
 #include <sys/stat.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
 
 #include <math.h>
@@ -61,11 +62,13 @@
 #include "src/common/xstring.h"
 #include "src/common/assoc_mgr.h"
 #include "src/common/parse_time.h"
+#include "src/common/timers.h"
 
 #include "src/slurmctld/locks.h"
 
 #define SECS_PER_DAY	(24 * 60 * 60)
 #define SECS_PER_WEEK	(7 * SECS_PER_DAY)
+#define MAX_PRIO_THREADS 64
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
  * overwritten when linking with the slurmctld.
@@ -74,10 +77,12 @@
 uint32_t cluster_cpus __attribute__((weak_import)) = NO_VAL;
 List job_list  __attribute__((weak_import)) = NULL;
 time_t last_job_update __attribute__((weak_import));
+time_t last_part_update __attribute__((weak_import));
 #else
 uint32_t cluster_cpus = NO_VAL;
 List job_list = NULL;
 time_t last_job_update;
+time_t last_part_update;
 #endif
 
 /*
@@ -127,6 +132,33 @@ static uint32_t weight_js; /* weight for Job Size factor */
 static uint32_t weight_part; /* weight for Partition factor */
 static uint32_t weight_qos; /* weight for QOS factor */
 
+static uint16_t prio_threads = 1; /* threads calculating job priorities */
+
+/* A job's priority together with the inputs it is calculated from,
+ * gathered so that the calculation needs no locks */
+typedef struct {
+	uint32_t job_id;
+	bool fixed;		/* priority is not calculated */
+	uint32_t age;		/* seconds since the job became eligible */
+	bool use_fs;		/* usage_efctv and shares_norm are set */
+	long double usage_efctv;
+	double shares_norm;
+	uint32_t cpu_cnt;
+	uint32_t min_nodes;
+	double part_prio;	/* normalized partition priority */
+	double qos_prio;	/* normalized QOS priority */
+	uint16_t nice;
+
+	uint32_t priority;
+	priority_factors_object_t factors;
+} job_prio_t;
+
+/* A slice of the job_prio_t array given to a calculation thread */
+typedef struct {
+	job_prio_t *prio_array;
+	int prio_cnt;
+} prio_slice_t;
+
 extern void priority_p_set_assoc_usage(slurmdb_association_rec_t *assoc);
 extern double priority_p_calc_fs_factor(long double usage_efctv,
 					long double shares_norm);
@@ -388,25 +420,29 @@ static int _set_children_usage_efctv(List childern_list)
 	return SLURM_SUCCESS;
 }
 
-/* job_ptr should already have the partition priority and such added
- * here before had we will be adding to it
+/*
+ * Get the effective usage and normalized shares which determine the
+ * fair-share factor of a job, calculating the effective usage of its
+ * association if needed.
+ * RET false if the job has no association
  */
-static double _get_fairshare_priority( struct job_record *job_ptr)
+static bool _get_fairshare_inputs(struct job_record *job_ptr,
+				  long double *usage_efctv,
+				  double *shares_norm)
 {
 	slurmdb_association_rec_t *job_assoc =
 		(slurmdb_association_rec_t *)job_ptr->assoc_ptr;
 	slurmdb_association_rec_t *fs_assoc = NULL;
-	double priority_fs = 0.0;
 	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
 	if (!calc_fairshare)
-		return 0;
+		return false;
 
 	if (!job_assoc) {
 		error("Job %u has no association.  Unable to "
 		      "compute fairshare.", job_ptr->job_id);
-		return 0;
+		return false;
 	}
 
 	fs_assoc = job_assoc;
@@ -423,147 +459,173 @@ static double _get_fairshare_priority( struct job_record *job_ptr)
 	if (fuzzy_equal(fs_assoc->usage->usage_efctv, NO_VAL))
 		priority_p_set_assoc_usage(fs_assoc);
 
-	/* Priority is 0 -> 1 */
-	priority_fs = priority_p_calc_fs_factor(
-		fs_assoc->usage->usage_efctv,
-		(long double)fs_assoc->usage->shares_norm);
+	*usage_efctv = fs_assoc->usage->usage_efctv;
+	*shares_norm = fs_assoc->usage->shares_norm;
 	if (priority_debug) {
 		info("Fairshare priority of job %u for user %s in acct"
-		     " %s is 2**(-%Lf/%f) = %f",
+		     " %s is 2**(-%Lf/%f)",
 		     job_ptr->job_id, job_assoc->user, job_assoc->acct,
-		     fs_assoc->usage->usage_efctv,
-		     fs_assoc->usage->shares_norm, priority_fs);
+		     *usage_efctv, *shares_norm);
 	}
 
 	assoc_mgr_unlock(&locks);
 
-	return priority_fs;
+	return true;
 }
 
-static void _get_priority_factors(time_t start_time, struct job_record *job_ptr)
+/*
+ * Gather everything a job's priority depends upon into prio so that it
+ * can be calculated by _calc_priority() without the job's locks.
+ * RET false if the job's priority is not to be calculated, in which case
+ * prio->priority is the priority the job is to have
+ */
+static bool _get_priority_inputs(time_t start_time,
+				 struct job_record *job_ptr, job_prio_t *prio)
 {
 	slurmdb_qos_rec_t *qos_ptr = NULL;
 
 	xassert(job_ptr);
 
-	if (!job_ptr->prio_factors)
-		job_ptr->prio_factors =
-			xmalloc(sizeof(priority_factors_object_t));
-	else
-		memset(job_ptr->prio_factors, 0,
-		       sizeof(priority_factors_object_t));
+	memset(prio, 0, sizeof(job_prio_t));
+	prio->job_id = job_ptr->job_id;
+
+	if (job_ptr->direct_set_prio) {
+		prio->priority = job_ptr->priority;
+		return false;
+	}
+
+	if (!job_ptr->details) {
+		error("_get_priority_internal: job %u does not have a "
+		      "details symbol set, can't set priority",
+		      job_ptr->job_id);
+		prio->priority = 0;
+		return false;
+	}
+	/*
+	 * This means the job is not eligible yet
+	 */
+	if (!job_ptr->details->begin_time
+	    || (job_ptr->details->begin_time > start_time)) {
+		prio->priority = 1;
+		return false;
+	}
+
+	prio->age = start_time - job_ptr->details->begin_time;
+
+	if (job_ptr->assoc_ptr && weight_fs) {
+		prio->use_fs = _get_fairshare_inputs(job_ptr,
+						     &prio->usage_efctv,
+						     &prio->shares_norm);
+	}
+
+	/* On the initial run of this we don't have total_cpus
+	   so go off the requesting.  After the first shot
+	   total_cpus should be filled in.
+	*/
+	if (job_ptr->total_cpus)
+		prio->cpu_cnt = job_ptr->total_cpus;
+	else if (job_ptr->details->max_cpus != NO_VAL)
+		prio->cpu_cnt = job_ptr->details->max_cpus;
+	else if (job_ptr->details->min_cpus)
+		prio->cpu_cnt = job_ptr->details->min_cpus;
+	prio->min_nodes = job_ptr->details->min_nodes;
+
+	if (job_ptr->part_ptr && job_ptr->part_ptr->priority)
+		prio->part_prio = job_ptr->part_ptr->norm_priority;
 
 	qos_ptr = (slurmdb_qos_rec_t *)job_ptr->qos_ptr;
+	if (qos_ptr && qos_ptr->priority)
+		prio->qos_prio = qos_ptr->usage->norm_priority;
+
+	prio->nice = job_ptr->details->nice;
+
+	return true;
+}
+
+static void _get_priority_factors(job_prio_t *prio)
+{
+	priority_factors_object_t *factors = &prio->factors;
+
+	memset(factors, 0, sizeof(priority_factors_object_t));
 
 	if (weight_age) {
-		uint32_t diff = start_time - job_ptr->details->begin_time;
-		if (job_ptr->details->begin_time) {
-			if (diff < max_age)
-				job_ptr->prio_factors->priority_age =
-					(double)diff / (double)max_age;
-			else
-				job_ptr->prio_factors->priority_age = 1.0;
-		}
+		if (prio->age < max_age)
+			factors->priority_age =
+				(double)prio->age / (double)max_age;
+		else
+			factors->priority_age = 1.0;
 	}
 
-	if (job_ptr->assoc_ptr && weight_fs) {
-		job_ptr->prio_factors->priority_fs =
-			_get_fairshare_priority(job_ptr);
+	if (prio->use_fs) {
+		/* Priority is 0 -> 1 */
+		factors->priority_fs = priority_p_calc_fs_factor(
+			prio->usage_efctv, (long double)prio->shares_norm);
 	}
 
 	if (weight_js) {
-		uint32_t cpu_cnt = 0;
-		/* On the initial run of this we don't have total_cpus
-		   so go off the requesting.  After the first shot
-		   total_cpus should be filled in.
-		*/
-		if (job_ptr->total_cpus)
-			cpu_cnt = job_ptr->total_cpus;
-		else if (job_ptr->details
-			 && (job_ptr->details->max_cpus != NO_VAL))
-			cpu_cnt = job_ptr->details->max_cpus;
-		else if (job_ptr->details && job_ptr->details->min_cpus)
-			cpu_cnt = job_ptr->details->min_cpus;
-
 		if (favor_small) {
-			job_ptr->prio_factors->priority_js =
+			factors->priority_js =
 				(double)(node_record_count
-					 - job_ptr->details->min_nodes)
+					 - prio->min_nodes)
 				/ (double)node_record_count;
-			if (cpu_cnt) {
-				job_ptr->prio_factors->priority_js +=
-					(double)(cluster_cpus - cpu_cnt)
+			if (prio->cpu_cnt) {
+				factors->priority_js +=
+					(double)(cluster_cpus - prio->cpu_cnt)
 					/ (double)cluster_cpus;
-				job_ptr->prio_factors->priority_js /= 2;
+				factors->priority_js /= 2;
 			}
 		} else {
-			job_ptr->prio_factors->priority_js =
-				(double)job_ptr->details->min_nodes
+			factors->priority_js =
+				(double)prio->min_nodes
 				/ (double)node_record_count;
-			if (cpu_cnt) {
-				job_ptr->prio_factors->priority_js +=
-					(double)cpu_cnt / (double)cluster_cpus;
-				job_ptr->prio_factors->priority_js /= 2;
+			if (prio->cpu_cnt) {
+				factors->priority_js +=
+					(double)prio->cpu_cnt
+					/ (double)cluster_cpus;
+				factors->priority_js /= 2;
 			}
 		}
-		if (job_ptr->prio_factors->priority_js < .0)
-			job_ptr->prio_factors->priority_js = 0.0;
-		else if (job_ptr->prio_factors->priority_js > 1.0)
-			job_ptr->prio_factors->priority_js = 1.0;
+		if (factors->priority_js < .0)
+			factors->priority_js = 0.0;
+		else if (factors->priority_js > 1.0)
+			factors->priority_js = 1.0;
 	}
 
-	if (job_ptr->part_ptr && job_ptr->part_ptr->priority && weight_part) {
-		job_ptr->prio_factors->priority_part =
-			job_ptr->part_ptr->norm_priority;
-	}
+	if (weight_part)
+		factors->priority_part = prio->part_prio;
 
-	if (qos_ptr && qos_ptr->priority && weight_qos) {
-		job_ptr->prio_factors->priority_qos =
-			qos_ptr->usage->norm_priority;
-	}
+	if (weight_qos)
+		factors->priority_qos = prio->qos_prio;
 
-	job_ptr->prio_factors->nice = job_ptr->details->nice;
+	factors->nice = prio->nice;
 }
 
-static uint32_t _get_priority_internal(time_t start_time,
-				       struct job_record *job_ptr)
+/*
+ * Calculate a job's priority and its weighted factors from the inputs
+ * gathered by _get_priority_inputs(). Uses no locks.
+ */
+static void _calc_priority(job_prio_t *prio)
 {
 	double priority		= 0.0;
+	priority_factors_object_t *factors = &prio->factors;
 	priority_factors_object_t pre_factors;
 
-	if (job_ptr->direct_set_prio)
-		return job_ptr->priority;
-
-	if (!job_ptr->details) {
-		error("_get_priority_internal: job %u does not have a "
-		      "details symbol set, can't set priority",
-		      job_ptr->job_id);
-		return 0;
-	}
-	/*
-	 * This means the job is not eligible yet
-	 */
-	if (!job_ptr->details->begin_time
-	    || (job_ptr->details->begin_time > start_time))
-		return 1;
-
 	/* figure out the priority */
-	_get_priority_factors(start_time, job_ptr);
-	memcpy(&pre_factors, job_ptr->prio_factors,
-	       sizeof(priority_factors_object_t));
-
-	job_ptr->prio_factors->priority_age *= (double)weight_age;
-	job_ptr->prio_factors->priority_fs *= (double)weight_fs;
-	job_ptr->prio_factors->priority_js *= (double)weight_js;
-	job_ptr->prio_factors->priority_part *= (double)weight_part;
-	job_ptr->prio_factors->priority_qos *= (double)weight_qos;
-
-	priority = job_ptr->prio_factors->priority_age
-		+ job_ptr->prio_factors->priority_fs
-		+ job_ptr->prio_factors->priority_js
-		+ job_ptr->prio_factors->priority_part
-		+ job_ptr->prio_factors->priority_qos
-		- (double)(job_ptr->prio_factors->nice - NICE_OFFSET);
+	_get_priority_factors(prio);
+	memcpy(&pre_factors, factors, sizeof(priority_factors_object_t));
+
+	factors->priority_age *= (double)weight_age;
+	factors->priority_fs *= (double)weight_fs;
+	factors->priority_js *= (double)weight_js;
+	factors->priority_part *= (double)weight_part;
+	factors->priority_qos *= (double)weight_qos;
+
+	priority = factors->priority_age
+		+ factors->priority_fs
+		+ factors->priority_js
+		+ factors->priority_part
+		+ factors->priority_qos
+		- (double)(factors->nice - NICE_OFFSET);
 
 	/*
 	 * 0 means the job is held; 1 means system hold
@@ -575,30 +637,50 @@ static uint32_t _get_priority_internal(time_t start_time,
 	if (priority_debug) {
 		info("Weighted Age priority is %f * %u = %.2f",
 		     pre_factors.priority_age, weight_age,
-		     job_ptr->prio_factors->priority_age);
+		     factors->priority_age);
 		info("Weighted Fairshare priority is %f * %u = %.2f",
 		     pre_factors.priority_fs, weight_fs,
-		     job_ptr->prio_factors->priority_fs);
+		     factors->priority_fs);
 		info("Weighted JobSize priority is %f * %u = %.2f",
 		     pre_factors.priority_js, weight_js,
-		     job_ptr->prio_factors->priority_js);
+		     factors->priority_js);
 		info("Weighted Partition priority is %f * %u = %.2f",
 		     pre_factors.priority_part, weight_part,
-		     job_ptr->prio_factors->priority_part);
+		     factors->priority_part);
 		info("Weighted QOS priority is %f * %u = %.2f",
 		     pre_factors.priority_qos, weight_qos,
-		     job_ptr->prio_factors->priority_qos);
+		     factors->priority_qos);
 		info("Job %u priority: %.2f + %.2f + %.2f + %.2f + %.2f - %d "
 		     "= %.2f",
-		     job_ptr->job_id, job_ptr->prio_factors->priority_age,
-		     job_ptr->prio_factors->priority_fs,
-		     job_ptr->prio_factors->priority_js,
-		     job_ptr->prio_factors->priority_part,
-		     job_ptr->prio_factors->priority_qos,
-		     (job_ptr->prio_factors->nice - NICE_OFFSET),
+		     prio->job_id, factors->priority_age,
+		     factors->priority_fs,
+		     factors->priority_js,
+		     factors->priority_part,
+		     factors->priority_qos,
+		     (factors->nice - NICE_OFFSET),
 		     priority);
 	}
-	return (uint32_t)priority;
+	prio->priority = (uint32_t)priority;
+}
+
+/*
+ * Calculate a job's priority, recording its factors in factors (usually
+ * job_ptr->prio_factors). The factors are left untouched if the priority
+ * was set directly or the job is not yet eligible.
+ */
+static uint32_t _get_priority_internal(time_t start_time,
+				       struct job_record *job_ptr,
+				       priority_factors_object_t *factors)
+{
+	job_prio_t prio;
+
+	if (!_get_priority_inputs(start_time, job_ptr, &prio))
+		return prio.priority;
+
+	_calc_priority(&prio);
+	memcpy(factors, &prio.factors, sizeof(priority_factors_object_t));
+
+	return prio.priority;
 }
 
 /* based upon the last reset time, compute when the next reset should be */
@@ -901,6 +983,159 @@ static int _apply_new_usage(struct job_record *job_ptr, double decay_factor,
 	return 1;
 }
 
+/* Calculate the priorities of a slice of jobs, see _set_job_priorities() */
+static void *_calc_prio_slice(void *arg)
+{
+	prio_slice_t *slice = (prio_slice_t *) arg;
+	int i;
+
+	for (i = 0; i < slice->prio_cnt; i++) {
+		if (!slice->prio_array[i].fixed)
+			_calc_priority(&slice->prio_array[i]);
+	}
+	return NULL;
+}
+
+/*
+ * Recalculate the priorities of pending jobs. Unless recalc_all is set
+ * only jobs whose age factor is still growing are recalculated, since
+ * their other factors only change with the fair-share tree, the QOS,
+ * the partitions or the configuration (all of which set recalc_all) or
+ * when the job itself is updated (which resets its priority directly).
+ *
+ * The inputs of each job's priority are gathered under the job read lock,
+ * the priorities are calculated without the job locks, split among
+ * prio_threads threads, and then set under a short job write lock.
+ */
+static void _set_job_priorities(time_t start_time, bool recalc_all)
+{
+	struct job_record *job_ptr = NULL;
+	ListIterator itr;
+	job_prio_t *prio_array = NULL;
+	prio_slice_t *slices = NULL;
+	pthread_t *thread_ids = NULL;
+	pthread_attr_t attr;
+	int i, pend_cnt = 0, prio_cnt = 0, prio_size = 0;
+	int thread_cnt = 1, slice_size;
+	long read_usec = 0, calc_usec = 0, write_usec = 0;
+	/* Read lock on jobs, nodes and partitions */
+	slurmctld_lock_t job_read_lock =
+		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
+	/* Write lock on jobs, read lock on nodes and partitions */
+	slurmctld_lock_t job_write_lock =
+		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	DEF_TIMERS;
+
+	START_TIMER;
+	lock_slurmctld(job_read_lock);
+	itr = list_iterator_create(job_list);
+	while ((job_ptr = list_next(itr))) {
+		/*
+		 * This means the job is held, 0, or a system
+		 * hold, 1. Continue also if the job is not
+		 * pending.  There is no reason to set the
+		 * priority if the job isn't pending.
+		 */
+		if ((job_ptr->priority <= 1)
+		    || !IS_JOB_PENDING(job_ptr)
+		    || job_ptr->direct_set_prio)
+			continue;
+		pend_cnt++;
+
+		/* The (weighted) age factor stops growing at max_age */
+		if (!recalc_all && job_ptr->prio_factors
+		    && (job_ptr->prio_factors->priority_age >=
+			(double)weight_age))
+			continue;
+
+		if (prio_cnt >= prio_size) {
+			prio_size = prio_size ? (prio_size * 2) : 1024;
+			xrealloc(prio_array, sizeof(job_prio_t) * prio_size);
+		}
+		if (!_get_priority_inputs(start_time, job_ptr,
+					  &prio_array[prio_cnt]))
+			prio_array[prio_cnt].fixed = true;
+		prio_cnt++;
+	}
+	list_iterator_destroy(itr);
+	unlock_slurmctld(job_read_lock);
+	END_TIMER;
+	read_usec = DELTA_TIMER;
+
+	START_TIMER;
+	/* Not worth starting threads for just a few jobs each */
+	if (prio_threads > 1)
+		thread_cnt = MAX(1, MIN(prio_threads, prio_cnt / 64));
+	if (thread_cnt > 1) {
+		slices = xmalloc(sizeof(prio_slice_t) * thread_cnt);
+		thread_ids = xmalloc(sizeof(pthread_t) * thread_cnt);
+		slice_size = (prio_cnt + thread_cnt - 1) / thread_cnt;
+		slurm_attr_init(&attr);
+		for (i = 0; i < thread_cnt; i++) {
+			slices[i].prio_array = prio_array + (i * slice_size);
+			slices[i].prio_cnt = MIN(slice_size,
+						 prio_cnt - (i * slice_size));
+			if (pthread_create(&thread_ids[i], &attr,
+					   _calc_prio_slice, &slices[i])) {
+				error("pthread_create: %m");
+				/* calculate it here instead */
+				_calc_prio_slice(&slices[i]);
+				thread_ids[i] = 0;
+			}
+		}
+		slurm_attr_destroy(&attr);
+		for (i = 0; i < thread_cnt; i++) {
+			if (thread_ids[i])
+				pthread_join(thread_ids[i], NULL);
+		}
+		xfree(thread_ids);
+		xfree(slices);
+	} else if (prio_cnt) {
+		prio_slice_t slice = { prio_array, prio_cnt };
+		_calc_prio_slice(&slice);
+	}
+	END_TIMER;
+	calc_usec = DELTA_TIMER;
+
+	if (prio_cnt) {
+		START_TIMER;
+		lock_slurmctld(job_write_lock);
+		for (i = 0; i < prio_cnt; i++) {
+			job_ptr = find_job_record(prio_array[i].job_id);
+			/* The job may have started, been held or been
+			 * purged since its priority was calculated */
+			if (!job_ptr || (job_ptr->priority <= 1)
+			    || !IS_JOB_PENDING(job_ptr)
+			    || job_ptr->direct_set_prio)
+				continue;
+			job_ptr->priority = prio_array[i].priority;
+			debug2("priority for job %u is now %u",
+			       job_ptr->job_id, job_ptr->priority);
+			if (prio_array[i].fixed)
+				continue;
+			if (!job_ptr->prio_factors)
+				job_ptr->prio_factors = xmalloc(
+					sizeof(priority_factors_object_t));
+			memcpy(job_ptr->prio_factors,
+			       &prio_array[i].factors,
+			       sizeof(priority_factors_object_t));
+		}
+		last_job_update = time(NULL);
+		unlock_slurmctld(job_write_lock);
+		END_TIMER;
+		write_usec = DELTA_TIMER;
+	}
+	xfree(prio_array);
+
+	if (priority_debug) {
+		info("priority: recalculated %d of %d pending jobs, "
+		     "job read lock usec=%ld, calculation usec=%ld "
+		     "(%d threads), job write lock usec=%ld",
+		     prio_cnt, pend_cnt, read_usec, calc_usec, thread_cnt,
+		     write_usec);
+	}
+}
+
 static void *_decay_thread(void *no_data)
 {
 	struct job_record *job_ptr = NULL;
@@ -915,10 +1150,14 @@ static void *_decay_thread(void *no_data)
 	double decay_hl = (double)slurm_get_priority_decay_hl();
 	double decay_factor = 1;
 	uint16_t reset_period = slurm_get_priority_reset_period();
+	/* assoc_mgr_update_cnt and last_part_update as of the last pass */
+	uint32_t last_assoc_update = 0;
+	time_t last_part_calc = 0;
+	bool recalc_all = true;
 
-	/* Write lock on jobs, read lock on nodes and partitions */
-	slurmctld_lock_t job_write_lock =
-		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	/* Read lock on jobs, nodes and partitions */
+	slurmctld_lock_t job_read_lock =
+		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
 	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -945,6 +1184,7 @@ static void *_decay_thread(void *no_data)
 		time_t now = time(NULL);
 		int run_delta = 0;
 		double real_decay = 0.0;
+		bool new_usage = false, set_prio = false;
 
 		slurm_mutex_lock(&decay_lock);
 		running_decay = 1;
@@ -967,6 +1207,7 @@ static void *_decay_thread(void *no_data)
 				decay_factor = 1;
 
 			reconfig = 0;
+			recalc_all = true;
 		}
 
 		/* this needs to be done right away so as to
@@ -977,6 +1218,7 @@ static void *_decay_thread(void *no_data)
 			break;
 		case PRIORITY_RESET_NOW:	/* do once */
 			_reset_usage();
+			recalc_all = true;
 			reset_period = PRIORITY_RESET_NONE;
 			last_reset = now;
 			break;
@@ -991,6 +1233,7 @@ static void *_decay_thread(void *no_data)
 			}
 			if (now >= next_reset) {
 				_reset_usage();
+				recalc_all = true;
 				last_reset = next_reset;
 				next_reset = _next_reset(reset_period,
 							 last_reset);
@@ -1019,43 +1262,46 @@ static void *_decay_thread(void *no_data)
 			slurm_mutex_unlock(&decay_lock);
 			break;
 		}
-		lock_slurmctld(job_write_lock);
+		/* Only the associations and QOS are modified here */
+		lock_slurmctld(job_read_lock);
 		itr = list_iterator_create(job_list);
 		while ((job_ptr = list_next(itr))) {
 			/* apply new usage */
 			if (!IS_JOB_PENDING(job_ptr) &&
-			    job_ptr->start_time && job_ptr->assoc_ptr) {
-				if (!_apply_new_usage(job_ptr, decay_factor,
-						      last_ran, start_time))
-					continue;
-			}
-
-			/*
-			 * This means the job is held, 0, or a system
-			 * hold, 1. Continue also if the job is not
-			 * pending.  There is no reason to set the
-			 * priority if the job isn't pending.
-			 */
-			if ((job_ptr->priority <= 1)
-			    || !IS_JOB_PENDING(job_ptr))
-				continue;
-
-			job_ptr->priority =
-				_get_priority_internal(start_time, job_ptr);
-			last_job_update = time(NULL);
-			debug2("priority for job %u is now %u",
-			       job_ptr->job_id, job_ptr->priority);
+			    job_ptr->start_time && job_ptr->assoc_ptr &&
+			    _apply_new_usage(job_ptr, decay_factor,
+					     last_ran, start_time))
+				new_usage = true;
 		}
 		list_iterator_destroy(itr);
-		unlock_slurmctld(job_write_lock);
+		unlock_slurmctld(job_read_lock);
+		set_prio = true;
 
 	get_usage:
-		/* now calculate all the normalized usage here */
+		/* Now calculate all the normalized usage here. Decay
+		 * scales the usage of every association and QOS alike,
+		 * leaving the normalized usage unchanged, so this is only
+		 * needed when new usage was added or the associations
+		 * changed. */
 		assoc_mgr_lock(&locks);
-		_set_children_usage_efctv(
-			assoc_mgr_root_assoc->usage->childern_list);
+		if (recalc_all || new_usage
+		    || (last_assoc_update != assoc_mgr_update_cnt)) {
+			_set_children_usage_efctv(
+				assoc_mgr_root_assoc->usage->childern_list);
+			last_assoc_update = assoc_mgr_update_cnt;
+			recalc_all = true;
+		}
 		assoc_mgr_unlock(&locks);
 
+		if (last_part_calc != last_part_update) {
+			last_part_calc = last_part_update;
+			recalc_all = true;
+		}
+		if (set_prio) {
+			_set_job_priorities(start_time, recalc_all);
+			recalc_all = false;
+		}
+
 		last_ran = start_time;
 
 		_write_last_decay_ran(last_ran, last_reset);
@@ -1125,6 +1371,9 @@ static void *_cleanup_thread(void *no_data)
 
 static void _internal_setup(void)
 {
+	char *sched_params, *tmp_ptr;
+	int i;
+
 	if (slurm_get_debug_flags() & DEBUG_FLAG_PRIO)
 		priority_debug = 1;
 	else
@@ -1139,6 +1388,19 @@ static void _internal_setup(void)
 	weight_part = slurm_get_priority_weight_partition();
 	weight_qos = slurm_get_priority_weight_qos();
 
+	prio_threads = 1;
+	sched_params = slurm_get_sched_params();
+	if (sched_params &&
+	    (tmp_ptr = strstr(sched_params, "priority_threads="))) {
+		i = atoi(tmp_ptr + 17);
+		if ((i < 1) || (i > MAX_PRIO_THREADS)) {
+			error("Invalid SchedulerParameters priority_threads: "
+			      "%d", i);
+		} else
+			prio_threads = i;
+	}
+	xfree(sched_params);
+
 	if (priority_debug) {
 		info("priority: Max Age is %u", max_age);
 		info("priority: Weight Age is %u", weight_age);
@@ -1146,6 +1408,7 @@ static void _internal_setup(void)
 		info("priority: Weight JobSize is %u", weight_js);
 		info("priority: Weight Part is %u", weight_part);
 		info("priority: Weight QOS is %u", weight_qos);
+		info("priority: Calculation threads %u", prio_threads);
 	}
 }
 
@@ -1237,7 +1500,13 @@ int fini ( void )
 
 extern uint32_t priority_p_set(uint32_t last_prio, struct job_record *job_ptr)
 {
-	uint32_t priority = _get_priority_internal(time(NULL), job_ptr);
+	uint32_t priority;
+
+	if (!job_ptr->prio_factors)
+		job_ptr->prio_factors =
+			xmalloc(sizeof(priority_factors_object_t));
+	priority = _get_priority_internal(time(NULL), job_ptr,
+					  job_ptr->prio_factors);
 
 	debug2("initial priority for job %u is %u", job_ptr->job_id, priority);
 
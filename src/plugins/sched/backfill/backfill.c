@@ -96,6 +96,7 @@ typedef struct node_space_map {
 	time_t begin_time;
 	time_t end_time;
 	bitstr_t *avail_bitmap;
+	uint16_t *avail_cpus;	/* CPUs free on each node, core_sched only */
 	int next;	/* next record, by time, zero termination */
 } node_space_map_t;
 int backfilled_jobs = 0;
@@ -110,13 +111,19 @@ static uint32_t debug_flags = 0;
 static int backfill_interval = BACKFILL_INTERVAL;
 static int backfill_window = BACKFILL_WINDOW;
 static int max_backfill_job_cnt = 50;
+static bool core_sched = false;	/* plan by CPU count, not whole nodes */
 
 /*********************** local functions *********************/
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
-			     bitstr_t *res_bitmap,
+			     bitstr_t *use_bitmap, uint16_t cpus_per_node,
 			     node_space_map_t *node_space,
 			     int *node_space_recs);
 static int  _attempt_backfill(void);
+static void _filter_avail_cpus(bitstr_t *avail_bitmap,
+			       node_space_map_t *node_space_ptr,
+			       uint16_t cpus_per_node);
+static uint16_t _job_cpus_per_node(struct job_record *job_ptr,
+				   uint32_t node_cnt);
 static bool _job_is_completing(void);
 static void _load_config(void);
 static bool _many_pending_rpcs(void);
@@ -126,9 +133,11 @@ static int  _num_feature_count(struct job_record *job_ptr);
 static void _reset_job_time_limit(struct job_record *job_ptr, time_t now,
 				  node_space_map_t *node_space);
 static int  _start_job(struct job_record *job_ptr, bitstr_t *avail_bitmap);
+static bool _slot_fits(node_space_map_t *node_space_ptr,
+		       bitstr_t *use_bitmap, uint16_t cpus_per_node);
 static bool _test_resv_overlap(node_space_map_t *node_space,
-			       bitstr_t *use_bitmap, uint32_t start_time,
-			       uint32_t end_reserve);
+			       bitstr_t *use_bitmap, uint16_t cpus_per_node,
+			       uint32_t start_time, uint32_t end_reserve);
 static int  _try_sched(struct job_record *job_ptr, bitstr_t **avail_bitmap,
 		       uint32_t min_nodes, uint32_t max_nodes,
 		       uint32_t req_nodes);
@@ -136,7 +145,8 @@ static int  _try_sched(struct job_record *job_ptr, bitstr_t **avail_bitmap,
 /* Log resource allocate table */
 static void _dump_node_space_table(node_space_map_t *node_space_ptr)
 {
-	int i = 0;
+	int i = 0, n;
+	uint32_t cpu_cnt;
 	char begin_buf[32], end_buf[32], *node_list;
 
 	info("=========================================");
@@ -146,8 +156,16 @@ static void _dump_node_space_table(node_space_map_t *node_space_ptr)
 		slurm_make_time_str(&node_space_ptr[i].end_time,
 				    end_buf, sizeof(end_buf));
 		node_list = bitmap2node_name(node_space_ptr[i].avail_bitmap);
-		info("Begin:%s End:%s Nodes:%s",
-		     begin_buf, end_buf, node_list);
+		if (node_space_ptr[i].avail_cpus) {
+			cpu_cnt = 0;
+			for (n = 0; n < node_record_count; n++)
+				cpu_cnt += node_space_ptr[i].avail_cpus[n];
+			info("Begin:%s End:%s Nodes:%s CPUs:%u",
+			     begin_buf, end_buf, node_list, cpu_cnt);
+		} else {
+			info("Begin:%s End:%s Nodes:%s",
+			     begin_buf, end_buf, node_list);
+		}
 		xfree(node_list);
 		if ((i = node_space_ptr[i].next) == 0)
 			break;
@@ -155,6 +173,121 @@ static void _dump_node_space_table(node_space_map_t *node_space_ptr)
 	info("=========================================");
 }
 
+/* Return the number of CPUs configured on the specified node */
+static uint16_t _node_cpus(int node_inx)
+{
+	struct node_record *node_ptr = node_record_table_ptr + node_inx;
+
+	if (slurmctld_conf.fast_schedule)
+		return node_ptr->config_ptr->cpus;
+	return node_ptr->cpus;
+}
+
+/* Return the number of CPUs a job needs on the specified node given its
+ * per-node CPU requirement. Jobs needing whole nodes get every CPU and
+ * unless CPUs are the consumable resource, allocations are made in units
+ * of whole cores. */
+static uint16_t _node_cpus_needed(int node_inx, uint16_t cpus_per_node)
+{
+	struct node_record *node_ptr = node_record_table_ptr + node_inx;
+	uint16_t node_cpus = _node_cpus(node_inx);
+	uint16_t threads;
+
+	if (cpus_per_node >= node_cpus)
+		return node_cpus;
+	if (!(slurmctld_conf.select_type_param & CR_CPU)) {
+		if (slurmctld_conf.fast_schedule)
+			threads = node_ptr->config_ptr->threads;
+		else
+			threads = node_ptr->threads;
+		if (threads > 1) {
+			cpus_per_node = (cpus_per_node + threads - 1) /
+					threads * threads;
+			cpus_per_node = MIN(cpus_per_node, node_cpus);
+		}
+	}
+	return cpus_per_node;
+}
+
+/*
+ * _job_cpus_per_node - Estimate the number of CPUs a job will use on each
+ *	of its allocated nodes for the purpose of building the backfill
+ *	resource map.
+ * IN job_ptr - pending job, with part_ptr set
+ * IN node_cnt - number of nodes the job is expected to span
+ * RET CPUs per node or (uint16_t) NO_VAL if the job needs whole nodes
+ */
+static uint16_t _job_cpus_per_node(struct job_record *job_ptr,
+				   uint32_t node_cnt)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	uint32_t cpus;
+
+	if (!core_sched || (detail_ptr->shared == 0) ||
+	    (job_ptr->part_ptr && (job_ptr->part_ptr->max_share == 0)))
+		return (uint16_t) NO_VAL;
+
+	cpus = MAX(detail_ptr->pn_min_cpus, 1);
+	if (detail_ptr->ntasks_per_node) {
+		cpus = MAX(cpus, detail_ptr->ntasks_per_node *
+				 MAX(detail_ptr->cpus_per_task, 1));
+	}
+	if (node_cnt) {
+		cpus = MAX(cpus, (detail_ptr->min_cpus + node_cnt - 1) /
+				 node_cnt);
+	}
+	if (cpus >= (uint16_t) NO_VAL)
+		return (uint16_t) NO_VAL;
+	return (uint16_t) cpus;
+}
+
+/* Clear from avail_bitmap any node lacking the CPUs needed by a job in
+ * the specified time slot of the resource map */
+static void _filter_avail_cpus(bitstr_t *avail_bitmap,
+			       node_space_map_t *node_space_ptr,
+			       uint16_t cpus_per_node)
+{
+	int n, first, last;
+
+	if (!node_space_ptr->avail_cpus)
+		return;
+	first = bit_ffs(avail_bitmap);
+	if (first < 0)
+		return;
+	last = bit_fls(avail_bitmap);
+	for (n = first; n <= last; n++) {
+		if (!bit_test(avail_bitmap, n))
+			continue;
+		if (node_space_ptr->avail_cpus[n] <
+		    _node_cpus_needed(n, cpus_per_node))
+			bit_clear(avail_bitmap, n);
+	}
+}
+
+/* Return true if the nodes in use_bitmap (using cpus_per_node CPUs each)
+ * are all available in the specified time slot of the resource map */
+static bool _slot_fits(node_space_map_t *node_space_ptr,
+		       bitstr_t *use_bitmap, uint16_t cpus_per_node)
+{
+	int n, first, last;
+
+	if (!node_space_ptr->avail_cpus)
+		return bit_super_set(use_bitmap, node_space_ptr->avail_bitmap);
+
+	first = bit_ffs(use_bitmap);
+	if (first < 0)
+		return true;
+	last = bit_fls(use_bitmap);
+	for (n = first; n <= last; n++) {
+		if (!bit_test(use_bitmap, n))
+			continue;
+		if (node_space_ptr->avail_cpus[n] <
+		    _node_cpus_needed(n, cpus_per_node))
+			return false;
+	}
+	return true;
+}
+
 /*
  * _job_is_completing - Determine if jobs are in the process of completing.
  *	This is a variant of job_is_completing in slurmctld/job_scheduler.c.
@@ -341,6 +474,7 @@ static void _my_sleep(int secs)
 static void _load_config(void)
 {
 	char *sched_params, *tmp_ptr;
+	uint32_t cr_enabled = 0;
 
 	sched_params = slurm_get_sched_params();
 	debug_flags  = slurm_get_debug_flags();
@@ -364,6 +498,16 @@ static void _load_config(void)
 		fatal("Invalid backfill scheduler max_job_bf: %d",
 		      max_backfill_job_cnt);
 	}
+
+	/* With consumable resources, a node is only partly consumed by a
+	 * job reservation. Plan by CPU count unless told otherwise. */
+	if ((select_g_get_info_from_plugin(SELECT_CR_PLUGIN, NULL,
+					   &cr_enabled) == SLURM_SUCCESS) &&
+	    cr_enabled &&
+	    !(sched_params && strstr(sched_params, "bf_whole_node")))
+		core_sched = true;
+	else
+		core_sched = false;
 	xfree(sched_params);
 }
 
@@ -413,38 +557,54 @@ extern void *backfill_agent(void *args)
 	return NULL;
 }
 
-/* Return non-zero to break the backfill loop if change in job, node or
- * partition state or the backfill scheduler needs to be stopped. */
+/* Return non-zero to break the backfill loop if change in partition state
+ * or configuration or the backfill scheduler needs to be stopped.
+ * Job and node state changes do not invalidate the resource map built so
+ * far, so the caller can resume testing the remaining queue, but it must
+ * validate each job record against its job ID before use. */
 static int _yield_locks(void)
 {
 	slurmctld_lock_t all_locks = {
 		READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK };
-	time_t job_update, node_update, part_update;
+	time_t part_update;
 
-	job_update  = last_job_update;
-	node_update = last_node_update;
 	part_update = last_part_update;
 
 	unlock_slurmctld(all_locks);
 	_my_sleep(backfill_interval);
 	lock_slurmctld(all_locks);
 
-	if ((last_job_update  == job_update)  &&
-	    (last_node_update == node_update) &&
-	    (last_part_update == part_update) &&
+	if ((last_part_update == part_update) &&
 	    (! stop_backfill) && (! config_flag))
 		return 0;
 	else
 		return 1;
 }
 
+/* Record statistics for one backfill cycle */
+static void _do_diag_stats(long delta_t, int job_test_count)
+{
+	slurmctld_diag_stats.bf_cycle_counter++;
+	slurmctld_diag_stats.bf_cycle_sum += delta_t;
+	slurmctld_diag_stats.bf_cycle_last = delta_t;
+	if (delta_t > slurmctld_diag_stats.bf_cycle_max)
+		slurmctld_diag_stats.bf_cycle_max = delta_t;
+	slurmctld_diag_stats.bf_depth_sum += job_test_count;
+	slurmctld_diag_stats.bf_last_depth = job_test_count;
+	slurmctld_diag_stats.bf_when_last_cycle = time(NULL);
+	slurmctld_diag_stats.bf_active = 0;
+}
+
 static int _attempt_backfill(void)
 {
+	DEF_TIMERS;
 	bool filter_root = false;
 	List job_queue;
 	job_queue_rec_t *job_queue_rec;
 	slurmdb_qos_rec_t *qos_ptr = NULL;
-	int i, j, node_space_recs;
+	int i, j, n, node_space_recs, job_test_count = 0;
+	uint16_t cpus_per_node;
+	bool yielded = false;
 	struct job_record *job_ptr;
 	struct part_record *part_ptr;
 	uint32_t end_time, end_reserve;
@@ -486,24 +646,57 @@ static int _attempt_backfill(void)
 		return 0;
 	}
 
+	START_TIMER;
+	slurmctld_diag_stats.bf_active = 1;
+	slurmctld_diag_stats.bf_queue_len = list_count(job_queue);
+
 	node_space = xmalloc(sizeof(node_space_map_t) *
 			     (max_backfill_job_cnt + 3));
 	node_space[0].begin_time = sched_start;
 	node_space[0].end_time = sched_start + backfill_window;
 	node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
+	if (core_sched) {
+		node_space[0].avail_cpus = xmalloc(sizeof(uint16_t) *
+						   node_record_count);
+		for (n = 0; n < node_record_count; n++)
+			node_space[0].avail_cpus[n] = _node_cpus(n);
+	}
 	node_space[0].next = 0;
 	node_space_recs = 1;
 	if (debug_flags & DEBUG_FLAG_BACKFILL)
 		_dump_node_space_table(node_space);
 
-	while ((job_queue_rec = (job_queue_rec_t *)
-				list_pop_bottom(job_queue, sort_job_queue2))) {
+	/* The queue is built in priority order, which is then independent
+	 * of the job records, which may be purged while the locks are
+	 * yielded. */
+	while ((job_queue_rec = (job_queue_rec_t *) list_pop(job_queue))) {
+		if ((time(NULL) - sched_start) >= this_sched_timeout) {
+			debug("backfill: loop taking too long, yielding locks");
+			if (_yield_locks()) {
+				debug("backfill: system state changed, "
+				      "breaking out");
+				xfree(job_queue_rec);
+				rc = 1;
+				break;
+			}
+			this_sched_timeout += sched_timeout;
+			yielded = true;
+			now = time(NULL);
+		}
+		/* Partitions are unchanged, else _yield_locks() fails */
+		if (yielded && !job_queue_rec_valid(job_queue_rec)) {
+			/* purged, held or moved while locks were yielded */
+			xfree(job_queue_rec);
+			continue;
+		}
 		job_ptr  = job_queue_rec->job_ptr;
 		part_ptr = job_queue_rec->part_ptr;
 		xfree(job_queue_rec);
+
 		if (!IS_JOB_PENDING(job_ptr))
 			continue;	/* started in other partition */
 		job_ptr->part_ptr = part_ptr;
+		job_test_count++;
 
 		if (debug_flags & DEBUG_FLAG_BACKFILL)
 			info("backfill test for job %u", job_ptr->job_id);
@@ -587,9 +780,12 @@ static int _attempt_backfill(void)
 		else
 			end_time = (time_limit * 60) + now;
 
-		/* Identify usable nodes for this job */
+		/* Identify usable nodes for this job. With core_sched, a node
+		 * is usable if enough of its CPUs remain free in every slot
+		 * of the resource map overlapping the job's run time. */
 		bit_and(avail_bitmap, part_ptr->node_bitmap);
 		bit_and(avail_bitmap, up_node_bitmap);
+		cpus_per_node = _job_cpus_per_node(job_ptr, max_nodes);
 		for (j=0; ; ) {
 			if ((node_space[j].end_time > start_res) &&
 			     node_space[j].next && (later_start == 0))
@@ -599,6 +795,9 @@ static int _attempt_backfill(void)
 			else if (node_space[j].begin_time <= end_time) {
 				bit_and(avail_bitmap,
 					node_space[j].avail_bitmap);
+				_filter_avail_cpus(avail_bitmap,
+						   &node_space[j],
+						   cpus_per_node);
 			} else
 				break;
 			if ((j = node_space[j].next) == 0)
@@ -606,10 +805,8 @@ static int _attempt_backfill(void)
 		}
 
 		if (job_ptr->details->exc_node_bitmap) {
-			bit_not(job_ptr->details->exc_node_bitmap);
-			bit_and(avail_bitmap,
-				job_ptr->details->exc_node_bitmap);
-			bit_not(job_ptr->details->exc_node_bitmap);
+			bit_and_not(avail_bitmap,
+				    job_ptr->details->exc_node_bitmap);
 		}
 
 		/* Test if insufficient nodes remain OR
@@ -633,17 +830,6 @@ static int _attempt_backfill(void)
 		resv_bitmap = bit_copy(avail_bitmap);
 		bit_not(resv_bitmap);
 
-		if ((time(NULL) - sched_start) >= this_sched_timeout) {
-			debug("backfill: loop taking too long, yielding locks");
-			if (_yield_locks()) {
-				debug("backfill: system state changed, "
-				      "breaking out");
-				rc = 1;
-				break;
-			} else {
-				this_sched_timeout += sched_timeout;
-			}
-		}
 		/* this is the time consuming operation */
 		debug2("backfill: entering _try_sched for job %u.",
 		       job_ptr->job_id);
@@ -711,7 +897,9 @@ static int _attempt_backfill(void)
 		}
 
 		end_reserve = job_ptr->start_time + (time_limit * 60);
-		if (_test_resv_overlap(node_space, avail_bitmap,
+		cpus_per_node = _job_cpus_per_node(job_ptr,
+						   bit_set_count(avail_bitmap));
+		if (_test_resv_overlap(node_space, avail_bitmap, cpus_per_node,
 				       job_ptr->start_time, end_reserve)) {
 			/* This job overlaps with an existing reservation for
 			 * job to be backfill scheduled, which the sched
@@ -727,9 +915,9 @@ static int _attempt_backfill(void)
 		qos_ptr = job_ptr->qos_ptr;
 		if (qos_ptr && (qos_ptr->flags & QOS_FLAG_NO_RESERVE))
 			continue;
-		bit_not(avail_bitmap);
 		_add_reservation(job_ptr->start_time, end_reserve,
-				 avail_bitmap, node_space, &node_space_recs);
+				 avail_bitmap, cpus_per_node,
+				 node_space, &node_space_recs);
 		if (debug_flags & DEBUG_FLAG_BACKFILL)
 			_dump_node_space_table(node_space);
 	}
@@ -738,11 +926,19 @@ static int _attempt_backfill(void)
 
 	for (i=0; ; ) {
 		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
+		xfree(node_space[i].avail_cpus);
 		if ((i = node_space[i].next) == 0)
 			break;
 	}
 	xfree(node_space);
 	list_destroy(job_queue);
+	END_TIMER;
+	_do_diag_stats(DELTA_TIMER, job_test_count);
+	if (debug_flags & DEBUG_FLAG_BACKFILL) {
+		info("backfill: tested %d jobs in %ld seconds%s",
+		     job_test_count, (long) difftime(time(NULL), sched_start),
+		     yielded ? " (locks yielded)" : "");
+	}
 	return rc;
 }
 
@@ -775,6 +971,7 @@ static int _start_job(struct job_record *job_ptr, bitstr_t *resv_bitmap)
 		else if (job_ptr->details->prolog_running == 0)
 			launch_job(job_ptr);
 		backfilled_jobs++;
+		slurmctld_diag_stats.bf_backfilled_jobs++;
 		if (debug_flags & DEBUG_FLAG_BACKFILL) {
 			info("backfill: Jobs backfilled since boot: %d",
 			     backfilled_jobs);
@@ -808,12 +1005,14 @@ static void _reset_job_time_limit(struct job_record *job_ptr, time_t now,
 {
 	int32_t j, resv_delay;
 	uint32_t orig_time_limit = job_ptr->time_limit;
+	uint16_t cpus_per_node;
 
+	cpus_per_node = _job_cpus_per_node(job_ptr, job_ptr->node_cnt);
 	for (j=0; ; ) {
 		if ((node_space[j].begin_time != now) &&
 		    (node_space[j].begin_time < job_ptr->end_time) &&
-		    (!bit_super_set(job_ptr->node_bitmap,
-				    node_space[j].avail_bitmap))) {
+		    (!_slot_fits(&node_space[j], job_ptr->node_bitmap,
+				 cpus_per_node))) {
 			/* Job overlaps pending job's resource reservation */
 			resv_delay = difftime(node_space[j].begin_time, now);
 			resv_delay /= 60;	/* seconds to minutes */
@@ -849,9 +1048,58 @@ static bool _more_work (time_t last_backfill_time)
 	return rc;
 }
 
-/* Create a reservation for a job in the future */
+/* Copy a node_space record's resource availability into another record */
+static void _copy_node_space(node_space_map_t *dest, node_space_map_t *src)
+{
+	dest->avail_bitmap = bit_copy(src->avail_bitmap);
+	if (src->avail_cpus) {
+		dest->avail_cpus = xmalloc(sizeof(uint16_t) *
+					   node_record_count);
+		memcpy(dest->avail_cpus, src->avail_cpus,
+		       sizeof(uint16_t) * node_record_count);
+	} else
+		dest->avail_cpus = NULL;
+}
+
+/* Remove the resources of a job reservation from one node_space record.
+ * Without per-node CPU counts, the job's nodes are removed entirely. */
+static void _reserve_node_space(node_space_map_t *node_space_ptr,
+				bitstr_t *use_bitmap, uint16_t cpus_per_node)
+{
+	int n, first, last;
+	uint16_t cpus;
+
+	if (!node_space_ptr->avail_cpus) {
+		bit_and_not(node_space_ptr->avail_bitmap, use_bitmap);
+		return;
+	}
+
+	first = bit_ffs(use_bitmap);
+	if (first < 0)
+		return;
+	last = bit_fls(use_bitmap);
+	for (n = first; n <= last; n++) {
+		if (!bit_test(use_bitmap, n))
+			continue;
+		cpus = _node_cpus_needed(n, cpus_per_node);
+		if (node_space_ptr->avail_cpus[n] > cpus)
+			node_space_ptr->avail_cpus[n] -= cpus;
+		else
+			node_space_ptr->avail_cpus[n] = 0;
+		if (node_space_ptr->avail_cpus[n] == 0)
+			bit_clear(node_space_ptr->avail_bitmap, n);
+	}
+}
+
+/*
+ * Create a reservation for a job in the future
+ * IN start_time, end_reserve - time span of the reservation
+ * IN use_bitmap - nodes to be used by the job
+ * IN cpus_per_node - CPUs used on each node or NO_VAL for whole nodes
+ * IN/OUT node_space, node_space_recs - resource map to update
+ */
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
-			     bitstr_t *res_bitmap,
+			     bitstr_t *use_bitmap, uint16_t cpus_per_node,
 			     node_space_map_t *node_space,
 			     int *node_space_recs)
 {
@@ -865,8 +1113,7 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			node_space[i].begin_time = start_time;
 			node_space[i].end_time = node_space[j].end_time;
 			node_space[j].end_time = start_time;
-			node_space[i].avail_bitmap =
-				bit_copy(node_space[j].avail_bitmap);
+			_copy_node_space(&node_space[i], &node_space[j]);
 			node_space[i].next = node_space[j].next;
 			node_space[j].next = i;
 			(*node_space_recs)++;
@@ -885,8 +1132,8 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 				node_space[i].end_time = node_space[j].
 							 end_time;
 				node_space[j].end_time = end_reserve;
-				node_space[i].avail_bitmap =
-					bit_copy(node_space[j].avail_bitmap);
+				_copy_node_space(&node_space[i],
+						 &node_space[j]);
 				node_space[i].next = node_space[j].next;
 				node_space[j].next = i;
 				(*node_space_recs)++;
@@ -899,8 +1146,10 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 
 	for (j=0; ; ) {
 		if ((node_space[j].begin_time >= start_time) &&
-		    (node_space[j].end_time <= end_reserve))
-			bit_and(node_space[j].avail_bitmap, res_bitmap);
+		    (node_space[j].end_time <= end_reserve)) {
+			_reserve_node_space(&node_space[j], use_bitmap,
+					    cpus_per_node);
+		}
 		if ((node_space[j].begin_time >= end_reserve) ||
 		    ((j = node_space[j].next) == 0))
 			break;
@@ -912,12 +1161,13 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
  *	reservation that the backfill scheduler has made for a job to be
  *	started in the future.
  * IN use_bitmap - nodes to be allocated
+ * IN cpus_per_node - CPUs to be allocated on each node or NO_VAL for all
  * IN start_time - start time of job
  * IN end_reserve - end time of job
  */
 static bool _test_resv_overlap(node_space_map_t *node_space,
-			       bitstr_t *use_bitmap, uint32_t start_time,
-			       uint32_t end_reserve)
+			       bitstr_t *use_bitmap, uint16_t cpus_per_node,
+			       uint32_t start_time, uint32_t end_reserve)
 {
 	bool overlap = false;
 	int j;
@@ -925,7 +1175,7 @@ static bool _test_resv_overlap(node_space_map_t *node_space,
 	for (j=0; ; ) {
 		if ((node_space[j].end_time   > start_time) &&
 		    (node_space[j].begin_time < end_reserve) &&
-		    (!bit_super_set(use_bitmap, node_space[j].avail_bitmap))) {
+		    (!_slot_fits(&node_space[j], use_bitmap, cpus_per_node))) {
 			overlap = true;
 			break;
 		}
@@ -182,6 +182,7 @@ host_fini:	if (rc) {
 		xfree(job_ptr->partition);
 		job_ptr->partition = xstrdup(part_name_ptr);
 		job_ptr->part_ptr = part_ptr;
+		add_job_to_queue(job_ptr);
 		last_job_update = time(NULL);
 		update_accounting = true;
 	}
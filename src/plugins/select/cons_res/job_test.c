@@ -832,23 +832,23 @@ clear_bit:	/* This node is not usable by this job */
 /* given an "avail" node_bitmap, return a corresponding "avail" core_bitmap */
 bitstr_t *_make_core_bitmap(bitstr_t *node_map)
 {
-	uint32_t n, c, nodes, size;
+	uint32_t c, nodes, size;
 	uint32_t coff;
+	int n;
 
 	nodes = bit_size(node_map);
 	size = cr_get_coremap_offset(nodes);
-	bitstr_t *core_map = bit_alloc(size);
+	/* usually few nodes are available to a job on a large system */
+	bitstr_t *core_map = bit_alloc_sparse(size);
 	if (!core_map)
 		return NULL;
 
-	nodes = bit_size(node_map);
-	for (n = 0, c = 0; n < nodes; n++) {
-		if (bit_test(node_map, n)) {
-			coff = cr_get_coremap_offset(n+1);
-			while (c < coff) {
-				bit_set(core_map, c++);
-			}
-		}
+	for (n = bit_ffs(node_map); n >= 0;
+	     n = ((n + 1) < nodes) ? bit_ffs_from_bit(node_map, n + 1) : -1) {
+		c = cr_get_coremap_offset(n);
+		coff = cr_get_coremap_offset(n+1);
+		if (coff > c)
+			bit_nset(core_map, c, coff - 1);
 	}
 	return core_map;
 }
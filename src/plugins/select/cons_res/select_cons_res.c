@@ -1622,8 +1622,8 @@ top:	orig_map = bit_copy(save_bitmap);
 				    (mode != PREEMPT_MODE_CHECKPOINT) &&
 				    (mode != PREEMPT_MODE_CANCEL))
 					continue;
-				if (bit_overlap(bitmap,
-						tmp_job_ptr->node_bitmap) == 0)
+				if (!bit_overlap_any(bitmap,
+						     tmp_job_ptr->node_bitmap))
 					continue;
 				if (tmp_job_ptr->details->usable_nodes == 0)
 					continue;
@@ -1784,8 +1784,8 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 			fatal ("memory allocation failure");
 		while ((tmp_job_ptr = (struct job_record *)
 			list_next(preemptee_iterator))) {
-			if (bit_overlap(bitmap,
-					tmp_job_ptr->node_bitmap) == 0)
+			if (!bit_overlap_any(bitmap,
+					     tmp_job_ptr->node_bitmap))
 				continue;
 			list_append(*preemptee_job_list, tmp_job_ptr);
 		}
@@ -2453,8 +2453,8 @@ top:	if ((rc != SLURM_SUCCESS) && preemptee_candidates &&
 				preemptee_candidates);
 			while ((tmp_job_ptr = (struct job_record *)
 				list_next(preemptee_iterator))) {
-				if (bit_overlap(bitmap,
-						tmp_job_ptr->node_bitmap) == 0)
+				if (!bit_overlap_any(bitmap,
+						     tmp_job_ptr->node_bitmap))
 					continue;
 				if (tmp_job_ptr->details->usable_nodes == 0)
 					continue;
@@ -2600,7 +2600,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 		preemptee_iterator =list_iterator_create(preemptee_candidates);
 		while ((tmp_job_ptr = (struct job_record *)
 			list_next(preemptee_iterator))) {
-			if (bit_overlap(bitmap, tmp_job_ptr->node_bitmap) == 0)
+			if (!bit_overlap_any(bitmap, tmp_job_ptr->node_bitmap))
 				continue;
 
 			list_append(*preemptee_job_list, tmp_job_ptr);
@@ -168,6 +168,7 @@
 #define LONG_OPT_WAIT_ALL_NODES  0x150
 #define LONG_OPT_EXPORT          0x151
 #define LONG_OPT_REQ_SWITCH      0x152
+#define LONG_OPT_JOB_COUNT       0x153
 
 /*---- global variables, defined in opt.h ----*/
 opt_t opt;
@@ -314,6 +315,7 @@ static void _opt_default()
 	opt.job_name = NULL;
 	opt.jobid    = NO_VAL;
 	opt.jobid_set = false;
+	opt.job_count = 1;
 	opt.dependency = NULL;
 	opt.account  = NULL;
 	opt.comment  = NULL;
@@ -713,6 +715,7 @@ static struct option long_options[] = {
 	{"hint",          required_argument, 0, LONG_OPT_HINT},
 	{"ioload-image",  required_argument, 0, LONG_OPT_RAMDISK_IMAGE},
 	{"jobid",         required_argument, 0, LONG_OPT_JOBID},
+	{"job-count",     required_argument, 0, LONG_OPT_JOB_COUNT},
 	{"linux-image",   required_argument, 0, LONG_OPT_LINUX_IMAGE},
 	{"mail-type",     required_argument, 0, LONG_OPT_MAIL_TYPE},
 	{"mail-user",     required_argument, 0, LONG_OPT_MAIL_USER},
@@ -1405,6 +1408,13 @@ static void _set_options(int argc, char **argv)
 			opt.jobid = _get_int(optarg, "jobid");
 			opt.jobid_set = true;
 			break;
+		case LONG_OPT_JOB_COUNT:
+			opt.job_count = _get_int(optarg, "job-count");
+			if (opt.job_count < 1) {
+				error("invalid job-count value %s", optarg);
+				exit(error_exit);
+			}
+			break;
 		case LONG_OPT_UID:
 			if (opt.euid != (uid_t) -1) {
 				error("duplicate --uid option");
@@ -2126,6 +2136,11 @@ static bool _opt_verify(void)
 		verified = false;
 	}
 
+	if ((opt.job_count > 1) && opt.jobid_set) {
+		error("--job-count can not be used with --jobid");
+		verified = false;
+	}
+
 	_fullpath(&opt.efname, opt.cwd);
 	_fullpath(&opt.ifname, opt.cwd);
 	_fullpath(&opt.ofname, opt.cwd);
@@ -2675,6 +2690,7 @@ static void _opt_list(void)
 	}
 	info("jobid             : %u %s", opt.jobid,
 		opt.jobid_set ? "(set)" : "(default)");
+	info("job count         : %u", opt.job_count);
 	info("partition         : %s",
 		opt.partition == NULL ? "default" : opt.partition);
 	info("job name          : `%s'", opt.job_name);
@@ -2773,7 +2789,8 @@ static void _usage(void)
 "              [--input file] [--output file] [--error file]\n"
 "              [--time-min=minutes] [--licenses=names] [--clusters=cluster_names]\n"
 "              [--workdir=directory] [--share] [-m dist] [-J jobname]\n"
-"              [--jobid=id] [--verbose] [--gid=group] [--uid=user] [-W sec] \n"
+"              [--jobid=id] [--job-count=n] [--verbose] [--gid=group]\n"
+"              [--uid=user] [-W sec]\n"
 "              [--contiguous] [--mincpus=n] [--mem=MB] [--tmp=MB] [-C list]\n"
 "              [--account=name] [--dependency=type:jobid] [--comment=name]\n"
 #ifdef HAVE_BG		/* Blue gene specific options */
@@ -2818,6 +2835,7 @@ static void _help(void)
 "  -i, --input=in              file for batch script's standard input\n"
 "  -I, --immediate             exit if resources are not immediately available\n"
 "      --jobid=id              run under already allocated job\n"
+"      --job-count=n           submit n identical jobs in one request\n"
 "  -J, --job-name=jobname      name of job\n"
 "  -k, --no-kill               do not kill job on node failure\n"
 "  -L, --licenses=names        required license, comma separated\n"
@@ -68,6 +68,7 @@ static void  _env_merge_filter(job_desc_msg_t *desc);
 static int   _fill_job_desc_from_opts(job_desc_msg_t *desc);
 static int   _check_cluster_specific_settings(job_desc_msg_t *desc);
 static void *_get_script_buffer(const char *filename, int *size);
+static void  _print_job_id(uint32_t job_id);
 static char *_script_wrap(char *command_string);
 static void  _set_exit_code(void);
 static void  _set_prio_process_env(void);
@@ -75,16 +76,20 @@ static int   _set_rlimit_env(void);
 static void  _set_spank_env(void);
 static void  _set_submit_dir_env(void);
 static int   _set_umask_env(void);
+static int   _submit_job(job_desc_msg_t *desc, submit_response_msg_t **resp,
+			 submit_multi_response_msg_t **multi_resp);
 
 int main(int argc, char *argv[])
 {
 	log_options_t logopt = LOG_OPTS_STDERR_ONLY;
 	job_desc_msg_t desc;
-	submit_response_msg_t *resp;
+	submit_response_msg_t *resp = NULL;
+	submit_multi_response_msg_t *multi_resp = NULL;
 	char *script_name;
 	void *script_body;
 	int script_size = 0;
-	int retries = 0;
+	int retries = 0, rc = 0;
+	uint32_t i;
 
 	log_init(xbasename(argv[0]), logopt, 0, NULL);
 
@@ -156,7 +161,7 @@ int main(int argc, char *argv[])
 	if (_check_cluster_specific_settings(&desc) != SLURM_SUCCESS)
 		exit(error_exit);
 
-	while (slurm_submit_batch_job(&desc, &resp) < 0) {
+	while (_submit_job(&desc, &resp, &multi_resp) < 0) {
 		static char *msg;
 
 		if (errno == ESLURM_ERROR_ON_DESC_TO_RECORD_COPY)
@@ -183,14 +188,42 @@ int main(int argc, char *argv[])
 		sleep (++retries);
         }
 
-	printf("Submitted batch job %u", resp->job_id);
+	if (multi_resp) {
+		for (i = 0; i < multi_resp->job_cnt; i++)
+			_print_job_id(multi_resp->job_id[i]);
+		if (multi_resp->job_cnt < opt.job_count) {
+			error("Only %u of %u batch jobs submitted: %s",
+			      multi_resp->job_cnt, opt.job_count,
+			      slurm_strerror(multi_resp->error_code));
+			rc = error_exit;
+		}
+		slurm_free_submit_multi_response_msg(multi_resp);
+	} else {
+		_print_job_id(resp->job_id);
+		slurm_free_submit_response_response_msg(resp);
+	}
+
+	xfree(desc.script);
+	return rc;
+}
+
+/* Submit the job, or opt.job_count copies of it in one RPC */
+static int _submit_job(job_desc_msg_t *desc, submit_response_msg_t **resp,
+		       submit_multi_response_msg_t **multi_resp)
+{
+	if (opt.job_count > 1) {
+		return slurm_submit_batch_job_multi(desc, opt.job_count,
+						    multi_resp);
+	}
+	return slurm_submit_batch_job(desc, resp);
+}
+
+static void _print_job_id(uint32_t job_id)
+{
+	printf("Submitted batch job %u", job_id);
 	if (working_cluster_rec)
 		printf(" on cluster %s", working_cluster_rec->name);
 	printf("\n");
-
-	xfree(desc.script);
-	slurm_free_submit_response_response_msg(resp);
-	return 0;
 }
 
 /* Propagate select user environment variables to the job */
@@ -46,6 +46,7 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "slurm/slurm_errno.h"
@@ -63,17 +64,22 @@
 
 #define MAX_RETRIES     10
 #define MAX_THREADS      8	/* These can be huge messages, so
-				 * only run MAX_THREADS at one time */
+				 * only run MAX_THREADS per block at one time */
 typedef struct thd {
 	pthread_t thread;	/* thread ID */
 	slurm_msg_t msg;	/* message to send */
-	int rc;			/* highest return codes from RPC */
 	char *nodelist;
+	bcast_block_t *block;	/* block being transmitted */
 } thd_t;
 
 static pthread_mutex_t agent_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  agent_cnt_cond  = PTHREAD_COND_INITIALIZER;
-static int agent_cnt = 0;
+static int agent_cnt = 0;	/* RPC threads running for all blocks */
+static int agent_rc = 0;	/* highest return code from RPCs */
+
+/* Nodes to which each thread sends a block, preserved across calls */
+static int threads_used = 0;
+static char *thread_nodelist[MAX_THREADS];
 
 static void *_agent_thread(void *args);
 
@@ -106,75 +112,77 @@ static void *_agent_thread(void *args)
 		rc = MAX(rc, msg_rc);
 	}
 
-	thread_ptr->rc = rc;
 	list_iterator_destroy(itr);
 	if (ret_list)
 		list_destroy(ret_list);
 	slurm_mutex_lock(&agent_cnt_mutex);
+	agent_rc = MAX(agent_rc, rc);
 	agent_cnt--;
+	if (--thread_ptr->block->agent_cnt == 0)
+		thread_ptr->block->active = false;
 	pthread_cond_broadcast(&agent_cnt_cond);
 	slurm_mutex_unlock(&agent_cnt_mutex);
+	xfree(thread_ptr);
 	return NULL;
 }
 
-/* Issue the RPC to transfer the file's data */
-extern void send_rpc(file_bcast_msg_t *bcast_msg,
-		     job_sbcast_cred_msg_t *sbcast_cred)
+/* Divide the nodes between the threads sending each block */
+static void _init_threads(job_sbcast_cred_msg_t *sbcast_cred)
 {
-	/* Preserve some data structures across calls for better performance */
-	static int threads_used = 0;
-	static thd_t thread_info[MAX_THREADS];
-
-	int i, fanout, rc = SLURM_SUCCESS;
-	int retries = 0;
-	pthread_attr_t attr;
-
-	if (threads_used == 0) {
-		hostlist_t hl;
-		hostlist_t new_hl;
-		int *span = NULL;
-		char *name = NULL;
+	hostlist_t hl;
+	hostlist_t new_hl;
+	int *span = NULL;
+	char *name = NULL;
+	int i, fanout;
 
-		if (params.fanout)
-			fanout = MIN(MAX_THREADS, params.fanout);
-		else
-			fanout = MAX_THREADS;
+	if (params.fanout)
+		fanout = MIN(MAX_THREADS, params.fanout);
+	else
+		fanout = MAX_THREADS;
 
-		span = set_span(sbcast_cred->node_cnt, fanout);
+	span = set_span(sbcast_cred->node_cnt, fanout);
 
-		hl = hostlist_create(sbcast_cred->node_list);
+	hl = hostlist_create(sbcast_cred->node_list);
 
-		i = 0;
-		while (i < sbcast_cred->node_cnt) {
-			int j = 0;
+	i = 0;
+	while (i < sbcast_cred->node_cnt) {
+		int j = 0;
+		name = hostlist_shift(hl);
+		if(!name) {
+			debug3("no more nodes to send to");
+			break;
+		}
+		new_hl = hostlist_create(name);
+		free(name);
+		i++;
+		for(j = 0; j < span[threads_used]; j++) {
 			name = hostlist_shift(hl);
-			if(!name) {
-				debug3("no more nodes to send to");
+			if(!name)
 				break;
-			}
-			new_hl = hostlist_create(name);
+			hostlist_push(new_hl, name);
 			free(name);
 			i++;
-			for(j = 0; j < span[threads_used]; j++) {
-				name = hostlist_shift(hl);
-				if(!name)
-					break;
-				hostlist_push(new_hl, name);
-				free(name);
-				i++;
-			}
-			thread_info[threads_used].nodelist = 
-				hostlist_ranged_string_xmalloc(new_hl);
-			hostlist_destroy(new_hl);
-			slurm_msg_t_init(&thread_info[threads_used].msg);
-			thread_info[threads_used].msg.msg_type =
-				REQUEST_FILE_BCAST;
-			threads_used++;
 		}
-		xfree(span);
-		hostlist_destroy(hl);
-		debug("using %d threads", threads_used);
+		thread_nodelist[threads_used] =
+			hostlist_ranged_string_xmalloc(new_hl);
+		hostlist_destroy(new_hl);
+		threads_used++;
 	}
+	xfree(span);
+	hostlist_destroy(hl);
+	debug("using %d threads", threads_used);
+}
+
+/* Start the RPC to transfer a block of the file's data */
+extern void send_rpc_start(bcast_block_t *block,
+			   job_sbcast_cred_msg_t *sbcast_cred)
+{
+	int i, retries = 0;
+	pthread_attr_t attr;
+	thd_t *thread_ptr;
+
+	if (threads_used == 0)
+		_init_threads(sbcast_cred);
 
 	slurm_attr_init(&attr);
 	if (pthread_attr_setstacksize(&attr, 3 * 1024*1024))
@@ -183,31 +191,90 @@ extern void send_rpc(file_bcast_msg_t *bcast_msg,
 			PTHREAD_CREATE_DETACHED))
 		error("pthread_attr_setdetachstate error %m");
 
+	slurm_mutex_lock(&agent_cnt_mutex);
+	block->active = (threads_used > 0);
+	block->agent_cnt = threads_used;
+	agent_cnt += threads_used;
+	slurm_mutex_unlock(&agent_cnt_mutex);
+
 	for (i=0; i<threads_used; i++) {
-		thread_info[i].msg.data = bcast_msg;
-		slurm_mutex_lock(&agent_cnt_mutex);
-		agent_cnt++;
-		slurm_mutex_unlock(&agent_cnt_mutex);
+		thread_ptr = xmalloc(sizeof(thd_t));
+		slurm_msg_t_init(&thread_ptr->msg);
+		thread_ptr->msg.msg_type = REQUEST_FILE_BCAST;
+		thread_ptr->msg.data = &block->msg;
+		thread_ptr->nodelist = thread_nodelist[i];
+		thread_ptr->block = block;
 
-		while (pthread_create(&thread_info[i].thread,
+		while (pthread_create(&thread_ptr->thread,
 				      &attr, _agent_thread,
-				      (void *) &thread_info[i])) {
+				      (void *) thread_ptr)) {
 			error("pthread_create error %m");
 			if (++retries > MAX_RETRIES)
 				fatal("Can't create pthread");
 			sleep(1);	/* sleep and retry */
 		}
 	}
+	pthread_attr_destroy(&attr);
+}
+
+/* Wait until one of the blocks is not being transmitted and return it */
+extern bcast_block_t *send_rpc_idle(bcast_block_t *blocks, int block_cnt)
+{
+	bcast_block_t *block = NULL;
+	int i, rc;
+
+	slurm_mutex_lock(&agent_cnt_mutex);
+	while (agent_rc == 0) {
+		for (i=0; i<block_cnt; i++) {
+			if (!blocks[i].active) {
+				block = &blocks[i];
+				break;
+			}
+		}
+		if (block)
+			break;
+		pthread_cond_wait(&agent_cnt_cond, &agent_cnt_mutex);
+	}
+	rc = agent_rc;
+	slurm_mutex_unlock(&agent_cnt_mutex);
+
+	if (rc)
+		exit(1);
+	return block;
+}
+
+/* Wait until all blocks have been transmitted */
+extern void send_rpc_wait(void)
+{
+	int rc;
 
-	/* wait until pthreads complete */
 	slurm_mutex_lock(&agent_cnt_mutex);
 	while (agent_cnt)
 		pthread_cond_wait(&agent_cnt_cond, &agent_cnt_mutex);
+	rc = agent_rc;
 	slurm_mutex_unlock(&agent_cnt_mutex);
-	pthread_attr_destroy(&attr);
 
-	for (i=0; i<threads_used; i++)
-		 rc = MAX(rc, thread_info[i].rc);
+	if (rc)
+		exit(1);
+}
+
+/* Issue the RPC to transfer the file's data */
+extern void send_rpc(file_bcast_msg_t *bcast_msg,
+		     job_sbcast_cred_msg_t *sbcast_cred)
+{
+	bcast_block_t block;
+	int rc;
+
+	memset(&block, 0, sizeof(bcast_block_t));
+	memcpy(&block.msg, bcast_msg, sizeof(file_bcast_msg_t));
+	send_rpc_start(&block, sbcast_cred);
+
+	/* wait until pthreads complete */
+	slurm_mutex_lock(&agent_cnt_mutex);
+	while (block.active)
+		pthread_cond_wait(&agent_cnt_cond, &agent_cnt_mutex);
+	rc = agent_rc;
+	slurm_mutex_unlock(&agent_cnt_mutex);
 
 	if (rc)
 		exit(1);
@@ -53,6 +53,7 @@
 
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "src/common/xstring.h"
@@ -67,6 +68,7 @@
 
 /* FUNCTIONS */
 static void     _help( void );
+static uint16_t _map_compress( char *buf );
 static uint32_t _map_size( char *buf );
 static void     _print_options( void );
 static void     _usage( void );
@@ -80,7 +82,7 @@ extern void parse_command_line(int argc, char *argv[])
 	int opt_char;
 	int option_index;
 	static struct option long_options[] = {
-		{"compress",  no_argument,       0, 'C'},
+		{"compress",  optional_argument, 0, 'C'},
 		{"fanout",    required_argument, 0, 'F'},
 		{"force",     no_argument,       0, 'f'},
 		{"preserve",  no_argument,       0, 'p'},
@@ -88,13 +90,14 @@ extern void parse_command_line(int argc, char *argv[])
 		{"timeout",   required_argument, 0, 't'},
 		{"verbose",   no_argument,       0, 'v'},
 		{"version",   no_argument,       0, 'V'},
+		{"window",    required_argument, 0, 'w'},
 		{"help",      no_argument,       0, OPT_LONG_HELP},
 		{"usage",     no_argument,       0, OPT_LONG_USAGE},
 		{NULL,        0,                 0, 0}
 	};
 
-	if (getenv("SBCAST_COMPRESS"))
-		params.compress = true;
+	if ( ( env_val = getenv("SBCAST_COMPRESS") ) )
+		params.compress = _map_compress(env_val);
 	if ( ( env_val = getenv("SBCAST_FANOUT") ) )
 		params.fanout = atoi(env_val);
 	if (getenv("SBCAST_FORCE"))
@@ -105,9 +108,11 @@ extern void parse_command_line(int argc, char *argv[])
 		params.block_size = _map_size(env_val);
 	if ( ( env_val = getenv("SBCAST_TIMEOUT") ) )
 		params.timeout = (atoi(env_val) * 1000);
+	if ( ( env_val = getenv("SBCAST_WINDOW") ) )
+		params.window = atoi(env_val);
 
 	optind = 0;
-	while((opt_char = getopt_long(argc, argv, "CfF:ps:t:vV",
+	while((opt_char = getopt_long(argc, argv, "C::fF:ps:t:vVw:",
 			long_options, &option_index)) != -1) {
 		switch (opt_char) {
 		case (int)'?':
@@ -116,7 +121,7 @@ extern void parse_command_line(int argc, char *argv[])
 			exit(1);
 			break;
 		case (int)'C':
-			params.compress = true;
+			params.compress = _map_compress(optarg);
 			break;
 		case (int)'f':
 			params.force = true;
@@ -139,6 +144,9 @@ extern void parse_command_line(int argc, char *argv[])
 		case (int) 'V':
 			print_slurm_version();
 			exit(0);
+		case (int) 'w':
+			params.window = atoi(optarg);
+			break;
 		case (int) OPT_LONG_HELP:
 			_help();
 			exit(0);
@@ -158,6 +166,14 @@ extern void parse_command_line(int argc, char *argv[])
 	params.src_fname = xstrdup(argv[optind]);
 	params.dst_fname = xstrdup(argv[optind+1]);
 
+#ifndef HAVE_ZLIB
+	if (params.compress == BCAST_COMPRESS_ZLIB) {
+		fprintf(stderr, "zlib compression not supported by this "
+			"build, file sent uncompressed\n");
+		params.compress = BCAST_COMPRESS_NONE;
+	}
+#endif
+
 	if (params.verbose)
 		_print_options();
 #ifdef HAVE_BG
@@ -166,6 +182,19 @@ extern void parse_command_line(int argc, char *argv[])
 #endif
 }
 
+/* map compression codec name to BCAST_COMPRESS_*, no name means zlib */
+static uint16_t _map_compress( char *buf )
+{
+	if ((buf == NULL) || (buf[0] == '\0') ||
+	    !strcasecmp(buf, "zlib"))
+		return BCAST_COMPRESS_ZLIB;
+	if (!strcasecmp(buf, "none"))
+		return BCAST_COMPRESS_NONE;
+
+	fprintf(stderr, "compression type %s is invalid\n", buf);
+	exit(1);
+}
+
 /* map size in string to number, interpret suffix of "k" or "m" */
 static uint32_t _map_size( char *buf )
 {
@@ -196,12 +225,14 @@ static void _print_options( void )
 {
 	info("-----------------------------");
 	info("block_size = %u", params.block_size);
-	info("compress   = %s", params.compress ? "true" : "false");
+	info("compress   = %s", (params.compress == BCAST_COMPRESS_ZLIB) ?
+			       "zlib" : "none");
 	info("force      = %s", params.force ? "true" : "false");
 	info("fanout     = %d", params.fanout);
 	info("preserve   = %s", params.preserve ? "true" : "false");
 	info("timeout    = %d", params.timeout);
 	info("verbose    = %d", params.verbose);
+	info("window     = %d", params.window);
 	info("source     = %s", params.src_fname);
 	info("dest       = %s", params.dst_fname);
 	info("-----------------------------");
@@ -210,14 +241,15 @@ static void _print_options( void )
 
 static void _usage( void )
 {
-	printf("Usage: sbcast [-CfFpvV] SOURCE DEST\n");
+	printf("Usage: sbcast [-CfFpvVw] SOURCE DEST\n");
 }
 
 static void _help( void )
 {
 	printf ("\
 Usage: sbcast [OPTIONS] SOURCE DEST\n\
-  -C, --compress      compress the file being transmitted\n\
+  -C, --compress[=lib] compress the file being transmitted,\n\
+                      lib may be \"zlib\" (default) or \"none\"\n\
   -f, --force         replace destination file as required\n\
   -F, --fanout=num    specify message fanout\n\
   -p, --preserve      preserve modes and times of source file\n\
@@ -225,6 +257,7 @@ Usage: sbcast [OPTIONS] SOURCE DEST\n\
   -t, --timeout=secs  specify message timeout (seconds)\n\
   -v, --verbose       provide detailed event logging\n\
   -V, --version       print version information and exit\n\
+  -w, --window=num    count of blocks being transmitted at once\n\
 \nHelp options:\n\
   --help              show this help message\n\
   --usage             display brief usage message\n");
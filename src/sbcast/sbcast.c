@@ -50,6 +50,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+
 #include "slurm/slurm_errno.h"
 #include "src/common/forward.h"
 #include "src/common/hostlist.h"
@@ -57,6 +61,7 @@
 #include "src/common/slurm_cred.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/sbcast/sbcast.h"
@@ -67,6 +72,11 @@ struct sbcast_parameters params;	/* program parameters */
 struct stat f_stat;			/* source file stats */
 job_sbcast_cred_msg_t *sbcast_cred;	/* job alloc info and sbcast cred */
 
+/* transfer statistics, reported with --verbose */
+static uint64_t data_bytes = 0;		/* bytes of file data read */
+static uint64_t sent_bytes = 0;		/* bytes of block data sent */
+static long compress_usec = 0;		/* time spent compressing */
+
 static void _bcast_file(void);
 static void _get_job_info(void);
 
@@ -157,6 +167,10 @@ static ssize_t _get_block(char *buffer, size_t buf_size)
 			      params.src_fname, strerror(errno));
 			exit(1);
 		}
+#ifdef POSIX_FADV_SEQUENTIAL
+		/* read ahead while earlier blocks are transmitted */
+		(void) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 	}
 
 	while (buf_size) {
@@ -179,28 +193,91 @@ static ssize_t _get_block(char *buffer, size_t buf_size)
 	return buf_used;
 }
 
+/* Compress the data read into a block. The data is sent as read if no
+ * codec was requested or if compression does not make it smaller, so the
+ * codec is chosen for each message. */
+static void _compress_block(bcast_block_t *block, uint32_t data_len)
+{
+	block->msg.compress	= BCAST_COMPRESS_NONE;
+	block->msg.uncomp_len	= data_len;
+	block->msg.block	= block->data;
+	block->msg.block_len	= data_len;
+
+#ifdef HAVE_ZLIB
+	if ((params.compress == BCAST_COMPRESS_ZLIB) && data_len) {
+		uLongf comp_len = block->comp_size;
+		int rc;
+		DEF_TIMERS;
+
+		START_TIMER;
+		rc = compress2((Bytef *) block->comp_data, &comp_len,
+			       (Bytef *) block->data, data_len, Z_BEST_SPEED);
+		END_TIMER;
+		compress_usec += DELTA_TIMER;
+		if (rc != Z_OK) {
+			debug("block %u, zlib compress error %d",
+			      block->msg.block_no, rc);
+		} else if (comp_len < data_len) {
+			block->msg.compress  = BCAST_COMPRESS_ZLIB;
+			block->msg.block     = block->comp_data;
+			block->msg.block_len = comp_len;
+		}
+	}
+#endif
+
+	data_bytes += data_len;
+	sent_bytes += block->msg.block_len;
+}
+
+/* Log the effective throughput of the transfer, used to pick the block
+ * size, window and codec best suited to a file */
+static void _log_stats(long usec)
+{
+	double secs = (double) MAX(usec, 1) / 1000000.0;
+
+	verbose("-----------------------------");
+	verbose("file bytes = %"PRIu64, data_bytes);
+	verbose("sent bytes = %"PRIu64" (%.1f%%)", sent_bytes,
+		data_bytes ? (100.0 * sent_bytes / data_bytes) : 100.0);
+	verbose("compress   = %ld usec", compress_usec);
+	verbose("elapsed    = %ld usec", usec);
+	verbose("throughput = %.2f MB/s (%.2f MB/s sent)",
+		(double) data_bytes / secs / (1024 * 1024),
+		(double) sent_bytes / secs / (1024 * 1024));
+}
+
 /* read and broadcast the file */
 static void _bcast_file(void)
 {
-	int buf_size;
+	int buf_size, window, i;
 	ssize_t size_read = 0;
+	uint32_t data_len;
 	file_bcast_msg_t bcast_msg;
-	char *buffer;
+	bcast_block_t *blocks, *block;
+	DEF_TIMERS;
 
-	if (params.block_size)
-		buf_size = MIN(params.block_size, f_stat.st_size);
-	else
+	if (params.block_size) {
+		buf_size = MIN(params.block_size, BCAST_MAX_BLOCK_SIZE);
+		buf_size = MIN(buf_size, f_stat.st_size);
+	} else
 		buf_size = MIN((512 * 1024), f_stat.st_size);
 
+	if (params.window > 0)
+		window = params.window;
+	else
+		window = DEFAULT_WINDOW;
+
 	bcast_msg.fname		= params.dst_fname;
 	bcast_msg.block_no	= 1;
+	bcast_msg.block_offset	= 0;
 	bcast_msg.last_block	= 0;
 	bcast_msg.force		= params.force;
 	bcast_msg.modes		= f_stat.st_mode;
 	bcast_msg.uid		= f_stat.st_uid;
 	bcast_msg.gid		= f_stat.st_gid;
-	buffer			= xmalloc(buf_size);
-	bcast_msg.block		= buffer;
+	bcast_msg.compress	= BCAST_COMPRESS_NONE;
+	bcast_msg.uncomp_len	= 0;
+	bcast_msg.block		= NULL;
 	bcast_msg.block_len	= 0;
 	bcast_msg.cred          = sbcast_cred->sbcast_cred;
 
@@ -212,19 +289,54 @@ static void _bcast_file(void)
 		bcast_msg.mtime     = 0;
 	}
 
+	/* Each block being transmitted needs its own buffer */
+	blocks = xmalloc(sizeof(bcast_block_t) * window);
+	for (i = 0; i < window; i++) {
+		blocks[i].msg = bcast_msg;
+		blocks[i].data = xmalloc(buf_size);
+#ifdef HAVE_ZLIB
+		if (params.compress == BCAST_COMPRESS_ZLIB) {
+			blocks[i].comp_size = compressBound(buf_size);
+			blocks[i].comp_data = xmalloc(blocks[i].comp_size);
+		}
+#endif
+	}
+
+	START_TIMER;
+
+	/* The first block creates the file and the last block sets its
+	 * modes and times, so each is sent alone. Up to "window" other
+	 * blocks are transmitted at once and written at their offset. */
 	while (1) {
-		bcast_msg.block_len = _get_block(buffer, buf_size);
-		debug("block %d, size %u", bcast_msg.block_no,
-		      bcast_msg.block_len);
-		size_read += bcast_msg.block_len;
+		if (bcast_msg.block_no == 1)
+			block = &blocks[0];
+		else
+			block = send_rpc_idle(blocks, window);
+		block->msg.block_no	= bcast_msg.block_no;
+		block->msg.block_offset	= size_read;
+		data_len = _get_block(block->data, buf_size);
+		_compress_block(block, data_len);
+		debug("block %u, size %u, sent %u", block->msg.block_no,
+		      data_len, block->msg.block_len);
+		size_read += data_len;
 		if (size_read >= f_stat.st_size)
-			bcast_msg.last_block = 1;
+			block->msg.last_block = 1;
 
-		send_rpc(&bcast_msg, sbcast_cred);
-		if (bcast_msg.last_block)
+		if ((block->msg.block_no == 1) || block->msg.last_block) {
+			send_rpc_wait();
+			send_rpc(&block->msg, sbcast_cred);
+		} else
+			send_rpc_start(block, sbcast_cred);
+		if (block->msg.last_block)
 			break;	/* end of file */
 		bcast_msg.block_no++;
 	}
+	END_TIMER;
+	_log_stats(DELTA_TIMER);
 
-	xfree(buffer);
+	for (i = 0; i < window; i++) {
+		xfree(blocks[i].data);
+		xfree(blocks[i].comp_data);
+	}
+	xfree(blocks);
 }
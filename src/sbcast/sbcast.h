@@ -50,20 +50,49 @@
 
 struct sbcast_parameters {
 	uint32_t block_size;
-	bool compress;
+	uint16_t compress;	/* BCAST_COMPRESS_* codec to use */
 	int  fanout;
 	bool force;
 	bool preserve;
 	int  timeout;
 	int  verbose;
+	int  window;
 	char *src_fname;
 	char *dst_fname;
 };
 
+/* Default count of blocks being transmitted at once */
+#define DEFAULT_WINDOW	4
+
+/* A block of the file and the state of its transmission */
+typedef struct bcast_block {
+	file_bcast_msg_t msg;	/* message to send, including its data */
+	char *data;		/* file data read into this block */
+	char *comp_data;	/* data after compression, if any */
+	uint32_t comp_size;	/* size of comp_data buffer */
+	bool active;		/* set while the RPCs are in progress */
+	int agent_cnt;		/* count of RPC threads still running */
+} bcast_block_t;
+
 extern struct sbcast_parameters params;
 
 extern void parse_command_line(int argc, char *argv[]);
+
+/* Issue the RPC to transfer a block of the file's data and wait for all
+ * nodes to respond */
 extern void send_rpc(file_bcast_msg_t *bcast_msg,
 		     job_sbcast_cred_msg_t *sbcast_cred);
 
+/* Start the RPC to transfer a block of the file's data and return
+ * without waiting for a response. The block must not be modified until
+ * it is returned by send_rpc_idle() or send_rpc_wait() returns. */
+extern void send_rpc_start(bcast_block_t *block,
+			   job_sbcast_cred_msg_t *sbcast_cred);
+
+/* Wait until one of the blocks is not being transmitted and return it */
+extern bcast_block_t *send_rpc_idle(bcast_block_t *blocks, int block_cnt);
+
+/* Wait until all blocks have been transmitted */
+extern void send_rpc_wait(void);
+
 #endif
@@ -169,7 +169,17 @@ _load_job_records (void)
 {
 	int error_code;
 
-	error_code = slurm_load_jobs ((time_t) NULL, &job_buffer_ptr, 1);
+	/* Jobs of one user or name are found through the controller's
+	 * job indexes, only load those */
+	if ((opt.job_cnt == 0) && (opt.user_name || opt.job_name)) {
+		error_code = slurm_load_job_user(&job_buffer_ptr,
+						 opt.user_name ?
+						 (uint32_t) opt.user_id :
+						 NO_VAL,
+						 opt.job_name, 1);
+	} else
+		error_code = slurm_load_jobs ((time_t) NULL, &job_buffer_ptr,
+					      1);
 
 	if (error_code) {
 		slurm_perror ("slurm_load_jobs error");
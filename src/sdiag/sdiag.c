@@ -0,0 +1,381 @@
+/*****************************************************************************\
+ *  sdiag.c - Report slurmctld performance statistics
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://www.schedmd.com/slurmdocs/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if HAVE_GETOPT_H
+#  include <getopt.h>
+#else
+#  include "src/common/getopt.h"
+#endif
+
+#if HAVE_INTTYPES_H
+#  include <inttypes.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include "src/common/log.h"
+#include "src/common/parse_time.h"
+#include "src/common/proc_args.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/uid.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* getopt_long options, integers but not characters */
+#define OPT_LONG_HELP  0x100
+#define OPT_LONG_USAGE 0x101
+
+static bool reset_stats = false;
+static bool sort_by_time = false;
+
+static void _help(void);
+static void _parse_command_line(int argc, char *argv[]);
+static void _print_lock_table(char *title, uint32_t size, char **name,
+			      uint32_t *cnt, uint32_t *contended,
+			      uint64_t *wait, uint32_t *wait_max,
+			      uint64_t *hold, uint32_t *hold_max, bool sort);
+static void _print_rpc_table(char *title, uint32_t size, uint32_t *id_name,
+			     uint32_t *cnt, uint64_t *time, uint32_t *time_max,
+			     uint32_t *limited, bool by_user);
+static void _print_stats(stats_info_response_msg_t *stats);
+static void _usage(void);
+
+int main(int argc, char *argv[])
+{
+	log_options_t opts = LOG_OPTS_STDERR_ONLY;
+	stats_info_request_msg_t req;
+	stats_info_response_msg_t *stats = NULL;
+
+	log_init(xbasename(argv[0]), opts, SYSLOG_FACILITY_USER, NULL);
+	_parse_command_line(argc, argv);
+
+	if (reset_stats) {
+		req.command_id = STAT_COMMAND_RESET;
+		if (slurm_reset_statistics(&req) != SLURM_SUCCESS) {
+			slurm_perror("slurm_reset_statistics");
+			exit(1);
+		}
+		printf("Reset scheduling statistics\n");
+		exit(0);
+	}
+
+	req.command_id = STAT_COMMAND_GET;
+	if ((slurm_get_statistics(&stats, &req) != SLURM_SUCCESS) ||
+	    (stats == NULL)) {
+		slurm_perror("slurm_get_statistics");
+		exit(1);
+	}
+	_print_stats(stats);
+	slurm_free_stats_response_msg(stats);
+
+	exit(0);
+}
+
+static void _parse_command_line(int argc, char *argv[])
+{
+	int opt_char;
+	int option_index;
+	static struct option long_options[] = {
+		{"reset",        no_argument, 0, 'r'},
+		{"sort-by-time", no_argument, 0, 't'},
+		{"version",      no_argument, 0, 'V'},
+		{"help",         no_argument, 0, OPT_LONG_HELP},
+		{"usage",        no_argument, 0, OPT_LONG_USAGE},
+		{NULL,           0,           0, 0}
+	};
+
+	while ((opt_char = getopt_long(argc, argv, "rtV",
+				       long_options, &option_index)) != -1) {
+		switch (opt_char) {
+		case (int)'?':
+			fprintf(stderr, "Try \"sdiag --help\" "
+				"for more information\n");
+			exit(1);
+		case (int)'r':
+			reset_stats = true;
+			break;
+		case (int)'t':
+			sort_by_time = true;
+			break;
+		case (int)'V':
+			print_slurm_version();
+			exit(0);
+		case OPT_LONG_HELP:
+			_help();
+			exit(0);
+		case OPT_LONG_USAGE:
+			_usage();
+			exit(0);
+		}
+	}
+
+	if (optind < argc) {
+		error("Unrecognized option: %s", argv[optind]);
+		_usage();
+		exit(1);
+	}
+}
+
+/* Return the mean of sum over cnt, zero if cnt is zero */
+static uint64_t _mean(uint64_t sum, uint32_t cnt)
+{
+	if (cnt == 0)
+		return 0;
+	return sum / cnt;
+}
+
+static void _print_stats(stats_info_response_msg_t *stats)
+{
+	uint32_t *type_id;
+	char time_str[32];
+	uint32_t i;
+
+	printf("*******************************************************\n");
+	slurm_make_time_str(&stats->req_time, time_str, sizeof(time_str));
+	printf("sdiag output at %s\n", time_str);
+	slurm_make_time_str(&stats->req_time_start, time_str,
+			    sizeof(time_str));
+	printf("Data since      %s\n", time_str);
+	printf("*******************************************************\n");
+
+	printf("Server thread count:  %u\n", stats->server_thread_count);
+	printf("Agent queue size:     %u\n", stats->agent_queue_size);
+	printf("Agent thread count:   %u\n", stats->agent_count);
+	printf("DBD Agent queue size: %u\n", stats->dbd_agent_queue_size);
+
+	printf("\nMain schedule statistics (microseconds):\n");
+	printf("\tLast cycle:   %u\n", stats->schedule_cycle_last);
+	printf("\tMax cycle:    %u\n", stats->schedule_cycle_max);
+	printf("\tTotal cycles: %u\n", stats->schedule_cycle_counter);
+	printf("\tMean cycle:   %"PRIu64"\n",
+	       _mean(stats->schedule_cycle_sum,
+		     stats->schedule_cycle_counter));
+	printf("\tMean depth cycle:  %"PRIu64"\n",
+	       _mean(stats->schedule_cycle_depth,
+		     stats->schedule_cycle_counter));
+	printf("\tLast queue length: %u\n", stats->schedule_queue_len);
+
+	printf("\nBackfilling stats%s\n",
+	       stats->bf_active ? " (WARNING: data obtained"
+				  " in the middle of backfilling execution)"
+				: "");
+	printf("\tTotal backfilled jobs (since last reset): %u\n",
+	       stats->bf_backfilled_jobs);
+	printf("\tTotal cycles: %u\n", stats->bf_cycle_counter);
+	if (stats->bf_when_last_cycle) {
+		slurm_make_time_str(&stats->bf_when_last_cycle, time_str,
+				    sizeof(time_str));
+		printf("\tLast cycle when: %s\n", time_str);
+	}
+	printf("\tLast cycle: %u\n", stats->bf_cycle_last);
+	printf("\tMax cycle:  %u\n", stats->bf_cycle_max);
+	printf("\tMean cycle: %"PRIu64"\n",
+	       _mean(stats->bf_cycle_sum, stats->bf_cycle_counter));
+	printf("\tLast depth cycle: %u\n", stats->bf_last_depth);
+	printf("\tMean depth cycle: %"PRIu64"\n",
+	       _mean(stats->bf_depth_sum, stats->bf_cycle_counter));
+	printf("\tLast queue length: %u\n", stats->bf_queue_len);
+
+	printf("\nState save statistics (microseconds):\n");
+	printf("\tLast save:   %u\n", stats->state_save_last);
+	printf("\tMax save:    %u\n", stats->state_save_max);
+	printf("\tTotal saves: %u\n", stats->state_save_counter);
+	printf("\tMean save:   %"PRIu64"\n",
+	       _mean(stats->state_save_sum, stats->state_save_counter));
+
+	printf("\nRPC queue statistics (microseconds):\n");
+	printf("\tWorker threads:         %u\n", stats->rpc_queue_workers);
+	printf("\tUnreceived connections: %u\n",
+	       stats->rpc_queue_conn_depth);
+	for (i = 0; i < stats->rpc_queue_size; i++) {
+		printf("\t%-8s count:%-8u depth:%-6u max_depth:%-6u "
+		       "ave_wait:%-6"PRIu64" max_wait:%-8u "
+		       "ave_time:%-6"PRIu64" max_time:%u\n",
+		       stats->rpc_queue_name[i], stats->rpc_queue_cnt[i],
+		       stats->rpc_queue_depth[i],
+		       stats->rpc_queue_depth_max[i],
+		       _mean(stats->rpc_queue_wait[i], stats->rpc_queue_cnt[i]),
+		       stats->rpc_queue_wait_max[i],
+		       _mean(stats->rpc_queue_run[i], stats->rpc_queue_cnt[i]),
+		       stats->rpc_queue_run_max[i]);
+	}
+
+	_print_lock_table("\nLock statistics by lock type (microseconds)",
+			  stats->lock_type_size, stats->lock_type_name,
+			  stats->lock_type_cnt, stats->lock_type_contended,
+			  stats->lock_type_wait, stats->lock_type_wait_max,
+			  stats->lock_type_hold, stats->lock_type_hold_max,
+			  false);
+	_print_lock_table("\nLock statistics by function (microseconds)",
+			  stats->lock_caller_size, stats->lock_caller_name,
+			  stats->lock_caller_cnt, NULL,
+			  stats->lock_caller_wait, stats->lock_caller_wait_max,
+			  stats->lock_caller_hold, stats->lock_caller_hold_max,
+			  true);
+
+	type_id = xmalloc(sizeof(uint32_t) * stats->rpc_type_size);
+	for (i = 0; i < stats->rpc_type_size; i++)
+		type_id[i] = stats->rpc_type_id[i];
+	_print_rpc_table("\nRemote Procedure Call statistics by message type",
+			 stats->rpc_type_size, type_id, stats->rpc_type_cnt,
+			 stats->rpc_type_time, stats->rpc_type_time_max,
+			 stats->rpc_type_limited, false);
+	xfree(type_id);
+
+	_print_rpc_table("\nRemote Procedure Call statistics by user",
+			 stats->rpc_user_size, stats->rpc_user_id,
+			 stats->rpc_user_cnt, stats->rpc_user_time,
+			 stats->rpc_user_time_max, stats->rpc_user_limited,
+			 true);
+}
+
+/* Print one table of lock statistics. If sort is set, records are sorted by
+ * decreasing count or by decreasing total hold time if --sort-by-time.
+ * Locks which were never acquired are not printed. */
+static void _print_lock_table(char *title, uint32_t size, char **name,
+			      uint32_t *cnt, uint32_t *contended,
+			      uint64_t *wait, uint32_t *wait_max,
+			      uint64_t *hold, uint32_t *hold_max, bool sort)
+{
+	uint32_t *order, i, j, tmp;
+
+	order = xmalloc(sizeof(uint32_t) * size);
+	for (i = 0; i < size; i++)
+		order[i] = i;
+	for (i = 1; sort && (i < size); i++) {
+		tmp = order[i];
+		for (j = i; j > 0; j--) {
+			if (sort_by_time ? (hold[order[j-1]] >= hold[tmp]) :
+					   (cnt[order[j-1]] >= cnt[tmp]))
+				break;
+			order[j] = order[j-1];
+		}
+		order[j] = tmp;
+	}
+
+	printf("%s:\n", title);
+	for (i = 0; i < size; i++) {
+		j = order[i];
+		if (cnt[j] == 0)
+			continue;
+		printf("\t%-40s count:%-8u ", name[j], cnt[j]);
+		if (contended)
+			printf("contended:%-8u ", contended[j]);
+		printf("ave_wait:%-6"PRIu64" max_wait:%-8u "
+		       "ave_hold:%-6"PRIu64" max_hold:%u\n",
+		       _mean(wait[j], cnt[j]), wait_max[j],
+		       _mean(hold[j], cnt[j]), hold_max[j]);
+	}
+	xfree(order);
+}
+
+/* Print one table of RPC statistics, sorted by decreasing count or by
+ * decreasing total time if --sort-by-time */
+static void _print_rpc_table(char *title, uint32_t size, uint32_t *id_name,
+			     uint32_t *cnt, uint64_t *time, uint32_t *time_max,
+			     uint32_t *limited, bool by_user)
+{
+	uint32_t *order, i, j, tmp;
+	char *name;
+
+	order = xmalloc(sizeof(uint32_t) * size);
+	for (i = 0; i < size; i++)
+		order[i] = i;
+	for (i = 1; i < size; i++) {	/* insertion sort, few records */
+		tmp = order[i];
+		for (j = i; j > 0; j--) {
+			if (sort_by_time ? (time[order[j-1]] >= time[tmp]) :
+					   (cnt[order[j-1]] >= cnt[tmp]))
+				break;
+			order[j] = order[j-1];
+		}
+		order[j] = tmp;
+	}
+
+	printf("%s:\n", title);
+	for (i = 0; i < size; i++) {
+		j = order[i];
+		if (by_user) {
+			name = uid_to_string((uid_t) id_name[j]);
+			printf("\t%-40s(%8u) count:%-6u "
+			       "ave_time:%-6"PRIu64" max_time:%-6u "
+			       "total_time:%-8"PRIu64" limited:%u\n",
+			       name, id_name[j], cnt[j],
+			       _mean(time[j], cnt[j]), time_max[j], time[j],
+			       limited[j]);
+			xfree(name);
+		} else {
+			printf("\t%-40s(%5u) count:%-6u "
+			       "ave_time:%-6"PRIu64" max_time:%-6u "
+			       "total_time:%-8"PRIu64" limited:%u\n",
+			       rpc_num2string(id_name[j]), id_name[j], cnt[j],
+			       _mean(time[j], cnt[j]), time_max[j], time[j],
+			       limited[j]);
+		}
+	}
+	xfree(order);
+}
+
+static void _usage(void)
+{
+	printf("Usage: sdiag [-r] [-t] [-V] [--help] [--usage]\n");
+}
+
+static void _help(void)
+{
+	printf("\
+Usage: sdiag [OPTIONS]\n\
+  -r, --reset                     reset statistics, root or SlurmUser only\n\
+  -t, --sort-by-time              sort RPCs and locks by time, not count\n\
+  -V, --version                   output version information and exit\n\
+\nHelp options:\n\
+  --help                          show this help message\n\
+  --usage                         display a brief summary of sdiag options\n");
+}
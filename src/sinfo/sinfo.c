@@ -220,10 +220,11 @@ _query_server(partition_info_msg_t ** part_pptr,
 	static block_info_msg_t *old_bg_ptr = NULL, *new_bg_ptr;
 
 	int error_code;
-	uint16_t show_flags = 0;
+	uint16_t show_flags = 0, node_flags;
 
 	if (params.all_flag)
 		show_flags |= SHOW_ALL;
+	node_flags = show_flags;
 
 	if (old_part_ptr) {
 		if (clear_old)
@@ -248,11 +249,15 @@ _query_server(partition_info_msg_t ** part_pptr,
 	old_part_ptr = new_part_ptr;
 	*part_pptr = new_part_ptr;
 
+	/* Transfer only changed nodes when polling */
+	if (params.iterate)
+		node_flags |= SHOW_DELTA;
+
 	if (old_node_ptr) {
 		if (clear_old)
 			old_node_ptr->last_update = 0;
 		error_code = slurm_load_node(old_node_ptr->last_update,
-					     &new_node_ptr, show_flags);
+					     &new_node_ptr, node_flags);
 		if (error_code == SLURM_SUCCESS)
 			slurm_free_node_info_msg(old_node_ptr);
 		else if (slurm_get_errno() == SLURM_NO_CHANGE_IN_DATA) {
@@ -261,7 +266,7 @@ _query_server(partition_info_msg_t ** part_pptr,
 		}
 	} else {
 		error_code = slurm_load_node((time_t) NULL, &new_node_ptr,
-					     show_flags);
+					     node_flags);
 	}
 
 	if (error_code) {
@@ -1355,6 +1355,19 @@ extern int get_agent_count(void)
 	return agent_cnt;
 }
 
+/* get_agent_queue_size - count of RPC requests queued for retry */
+extern int get_agent_queue_size(void)
+{
+	int cnt = 0;
+
+	slurm_mutex_lock(&retry_mutex);
+	if (retry_list)
+		cnt = list_count(retry_list);
+	slurm_mutex_unlock(&retry_mutex);
+
+	return cnt;
+}
+
 static void _purge_agent_args(agent_arg_t *agent_arg_ptr)
 {
 	if (agent_arg_ptr == NULL)
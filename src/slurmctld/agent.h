@@ -98,6 +98,9 @@ extern void agent_purge (void);
 /* get_agent_count - find out how many active agents we have */
 extern int get_agent_count(void);
 
+/* get_agent_queue_size - count of RPC requests queued for retry */
+extern int get_agent_queue_size(void);
+
 /*
  * mail_job_info - Send e-mail notice of job state change
  * IN job_ptr - job identification
@@ -0,0 +1,582 @@
+/*****************************************************************************\
+ *  batch_store.c - content addressed, reference counted storage of batch
+ *	job scripts and environments
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://www.schedmd.com/slurmdocs/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef WITH_PTHREADS
+#  include <pthread.h>
+#endif				/* WITH_PTHREADS */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/common/fnv_hash.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/timers.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/batch_store.h"
+#include "src/slurmctld/state_save.h"
+
+#define STORE_DIR_NAME	"/batch_store"
+#define STORE_DIR_CNT	100	/* number of hash.# subdirectories */
+#define STORE_HASH_SIZE	16384	/* records hash table size */
+
+typedef struct store_rec {
+	char     *key;		/* file name, see batch_store_add() */
+	uint32_t  ref_cnt;	/* jobs referencing this data */
+	char     *data;		/* contents not yet written to a file */
+	uint32_t  size;		/* size of data */
+	uint32_t  fail_seq;	/* flush_seq of last failed write */
+	uint32_t  gen;		/* distinguishes records of the same key */
+	struct store_rec *next;	/* next record in this hash chain */
+} store_rec_t;
+
+static pthread_mutex_t store_mutex = PTHREAD_MUTEX_INITIALIZER;
+static store_rec_t **store_hash = NULL;
+static List unlink_list = NULL;	/* keys of files to remove */
+static bool store_synced = false;	/* unreferenced files removed */
+static uint32_t flush_seq = 0;		/* count of batch_store_flush() */
+static uint32_t rec_gen = 0;		/* count of records created */
+static int last_write_rc = SLURM_SUCCESS; /* result of the last flush */
+
+/* Hash of a key used for both the hash table and subdirectory index */
+static uint32_t _key_inx(const char *key)
+{
+	return (uint32_t) fnv_hash64(key, strlen(key));
+}
+
+/* Return the xmalloc'ed name of the file or temporary file holding
+ * the data for a key, or of the store's top directory if key is NULL */
+static char *_key_path(const char *key, bool tmp)
+{
+	char *path = slurm_get_state_save_location();
+
+	xstrcat(path, STORE_DIR_NAME);
+	if (key) {
+		xstrfmtcat(path, "/hash.%u/%s%s",
+			   _key_inx(key) % STORE_DIR_CNT, key,
+			   tmp ? ".tmp" : "");
+	}
+	return path;
+}
+
+/* Find the record for a key. Call with store_mutex locked. */
+static store_rec_t *_find_rec(const char *key)
+{
+	store_rec_t *rec;
+
+	if (store_hash == NULL)
+		return NULL;
+	rec = store_hash[_key_inx(key) % STORE_HASH_SIZE];
+	while (rec && strcmp(rec->key, key))
+		rec = rec->next;
+	return rec;
+}
+
+static int _find_key(void *x, void *key)
+{
+	return !strcmp((char *) x, (char *) key);
+}
+
+/* Create the record for a key, cancelling any queued removal of its file.
+ * Call with store_mutex locked. */
+static store_rec_t *_create_rec(const char *key)
+{
+	store_rec_t *rec;
+	uint32_t inx;
+
+	if (store_hash == NULL) {
+		store_hash = xmalloc(sizeof(store_rec_t *) * STORE_HASH_SIZE);
+		unlink_list = list_create(slurm_destroy_char);
+	} else
+		(void) list_delete_all(unlink_list, _find_key, (void *) key);
+	inx = _key_inx(key) % STORE_HASH_SIZE;
+	rec = xmalloc(sizeof(store_rec_t));
+	rec->key = xstrdup(key);
+	rec->gen = ++rec_gen;
+	rec->next = store_hash[inx];
+	store_hash[inx] = rec;
+	return rec;
+}
+
+/* Remove a record and queue removal of its file.
+ * Call with store_mutex locked. */
+static void _delete_rec(store_rec_t *rec)
+{
+	store_rec_t **rec_pptr;
+
+	rec_pptr = &store_hash[_key_inx(rec->key) % STORE_HASH_SIZE];
+	while (*rec_pptr != rec)
+		rec_pptr = &(*rec_pptr)->next;
+	*rec_pptr = rec->next;
+
+	list_append(unlink_list, rec->key);	/* list now owns key */
+	xfree(rec->data);
+	xfree(rec);
+}
+
+/* Create a directory if it does not already exist */
+static int _make_dir(char *dir_name)
+{
+	if ((mkdir(dir_name, 0700) < 0) && (errno != EEXIST)) {
+		error("mkdir(%s) error %m", dir_name);
+		return SLURM_ERROR;
+	}
+	return SLURM_SUCCESS;
+}
+
+/* Write data to a temporary file, then rename it to the key's file name */
+static int _write_file(char *key, char *data, uint32_t size)
+{
+	char *file_name, *tmp_name, *dir_name;
+	int fd, amount;
+	uint32_t pos = 0;
+
+	tmp_name = _key_path(key, true);
+	fd = creat(tmp_name, 0600);
+	if ((fd < 0) && (errno == ENOENT)) {
+		/* create the store and hash directories as needed */
+		dir_name = _key_path(NULL, false);
+		(void) _make_dir(dir_name);
+		xstrfmtcat(dir_name, "/hash.%u", _key_inx(key) % STORE_DIR_CNT);
+		(void) _make_dir(dir_name);
+		xfree(dir_name);
+		fd = creat(tmp_name, 0600);
+	}
+	if (fd < 0) {
+		error("Error creating file %s, %m", tmp_name);
+		xfree(tmp_name);
+		return ESLURM_WRITING_TO_FILE;
+	}
+
+	while (pos < size) {
+		amount = write(fd, &data[pos], size - pos);
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+			error("Error writing file %s, %m", tmp_name);
+			close(fd);
+			(void) unlink(tmp_name);
+			xfree(tmp_name);
+			return ESLURM_WRITING_TO_FILE;
+		}
+		pos += amount;
+	}
+	close(fd);
+
+	file_name = _key_path(key, false);
+	if (rename(tmp_name, file_name) < 0) {
+		error("Error renaming file %s to %s, %m", tmp_name, file_name);
+		(void) unlink(tmp_name);
+		xfree(file_name);
+		xfree(tmp_name);
+		return ESLURM_WRITING_TO_FILE;
+	}
+	xfree(file_name);
+	xfree(tmp_name);
+	return SLURM_SUCCESS;
+}
+
+/* Read the contents of a file, RET NULL on error */
+static char *_read_file(char *file_name, uint32_t *size)
+{
+	struct stat stat_buf;
+	char *data;
+	int fd, amount;
+	uint32_t pos = 0;
+
+	fd = open(file_name, O_RDONLY);
+	if (fd < 0) {
+		error("Error opening file %s, %m", file_name);
+		return NULL;
+	}
+	if (fstat(fd, &stat_buf) < 0) {
+		error("Error reading file %s, %m", file_name);
+		close(fd);
+		return NULL;
+	}
+
+	data = xmalloc(stat_buf.st_size + 1);	/* leave string terminated */
+	while (pos < stat_buf.st_size) {
+		amount = read(fd, &data[pos], stat_buf.st_size - pos);
+		if ((amount < 0) && (errno == EINTR))
+			continue;
+		if (amount <= 0) {
+			error("Error reading file %s, %m", file_name);
+			close(fd);
+			xfree(data);
+			return NULL;
+		}
+		pos += amount;
+	}
+	close(fd);
+	*size = pos;
+	return data;
+}
+
+extern char *batch_store_add(char *type, uid_t uid, char *data,
+			     uint32_t size)
+{
+	store_rec_t *rec;
+	char *key;
+
+	key = xstrdup_printf("%s.%u.%016"PRIx64".%x", type, (uint32_t) uid,
+			     fnv_hash64(data, size), size);
+	slurm_mutex_lock(&store_mutex);
+	rec = _find_rec(key);
+	if (rec == NULL) {
+		rec = _create_rec(key);
+		rec->data = xmalloc(size);
+		memcpy(rec->data, data, size);
+		rec->size = size;
+		schedule_batch_store_save();
+	}
+	rec->ref_cnt++;
+	slurm_mutex_unlock(&store_mutex);
+
+	return key;
+}
+
+extern char *batch_store_import(char *type, uid_t uid, char *file_name)
+{
+	char *data, *key;
+	uint32_t size;
+
+	data = _read_file(file_name, &size);
+	if (data == NULL)
+		return NULL;
+	key = batch_store_add(type, uid, data, size);
+	xfree(data);
+	return key;
+}
+
+extern void batch_store_release(char *key)
+{
+	store_rec_t *rec;
+
+	slurm_mutex_lock(&store_mutex);
+	rec = _find_rec(key);
+	if (rec == NULL) {
+		/* Before the first sync no references are counted, files of
+		 * jobs purged while loading state are removed as orphans */
+		if (store_synced)
+			error("batch_store_release: no record for %s", key);
+	} else if (--rec->ref_cnt == 0) {
+		_delete_rec(rec);
+		schedule_batch_store_save();
+	}
+	slurm_mutex_unlock(&store_mutex);
+}
+
+extern char *batch_store_read(char *key, uint32_t *size)
+{
+	store_rec_t *rec;
+	char *data = NULL, *file_name;
+
+	*size = 0;
+	slurm_mutex_lock(&store_mutex);
+	rec = _find_rec(key);
+	if (rec && rec->data) {
+		data = xmalloc(rec->size + 1);	/* leave string terminated */
+		memcpy(data, rec->data, rec->size);
+		*size = rec->size;
+	}
+	slurm_mutex_unlock(&store_mutex);
+	if (data)
+		return data;
+
+	file_name = _key_path(key, false);
+	data = _read_file(file_name, size);
+	xfree(file_name);
+	return data;
+}
+
+extern bool batch_store_exists(char *key)
+{
+	store_rec_t *rec;
+	struct stat stat_buf;
+	char *file_name;
+	bool found = false;
+
+	slurm_mutex_lock(&store_mutex);
+	rec = _find_rec(key);
+	if (rec && rec->data)
+		found = true;
+	slurm_mutex_unlock(&store_mutex);
+	if (found)
+		return found;
+
+	file_name = _key_path(key, false);
+	if (stat(file_name, &stat_buf) == 0)
+		found = true;
+	xfree(file_name);
+	return found;
+}
+
+extern int batch_store_flush(void)
+{
+	store_rec_t *rec;
+	List old_list = NULL;
+	char *key, *file_name, *data;
+	uint32_t i, size, gen, write_cnt = 0;
+	int rc = SLURM_SUCCESS, write_rc;
+	DEF_TIMERS;
+
+	START_TIMER;
+	/* Remove files first, data of the same key might have been added
+	 * again after its file was queued for removal */
+	slurm_mutex_lock(&store_mutex);
+	if (unlink_list && list_count(unlink_list)) {
+		old_list = unlink_list;
+		unlink_list = list_create(slurm_destroy_char);
+	}
+	slurm_mutex_unlock(&store_mutex);
+	if (old_list) {
+		while ((key = list_pop(old_list))) {
+			file_name = _key_path(key, false);
+			(void) unlink(file_name);
+			xfree(file_name);
+			xfree(key);
+		}
+		list_destroy(old_list);
+	}
+
+	/* Write data without holding the store_mutex, so the data is copied.
+	 * The in-memory data is released after its file is written, unless
+	 * the record was removed (and maybe created again) in the meantime.
+	 * Records which could not be written keep their data and are skipped
+	 * until the next flush. */
+	flush_seq++;
+	for (i = 0; i < STORE_HASH_SIZE; ) {
+		slurm_mutex_lock(&store_mutex);
+		if (store_hash == NULL) {
+			slurm_mutex_unlock(&store_mutex);
+			break;
+		}
+		rec = store_hash[i];
+		while (rec && ((rec->data == NULL) ||
+			       (rec->fail_seq == flush_seq)))
+			rec = rec->next;
+		if (rec == NULL) {
+			slurm_mutex_unlock(&store_mutex);
+			i++;
+			continue;
+		}
+		key  = xstrdup(rec->key);
+		gen  = rec->gen;
+		size = rec->size;
+		data = xmalloc(size);
+		memcpy(data, rec->data, size);
+		slurm_mutex_unlock(&store_mutex);
+
+		write_rc = _write_file(key, data, size);
+
+		slurm_mutex_lock(&store_mutex);
+		if ((rec = _find_rec(key)) && (rec->gen == gen) && rec->data) {
+			if (write_rc == SLURM_SUCCESS)
+				xfree(rec->data);
+			else
+				rec->fail_seq = flush_seq;
+		}
+		slurm_mutex_unlock(&store_mutex);
+		if (write_rc == SLURM_SUCCESS)
+			write_cnt++;
+		else
+			rc = write_rc;
+		xfree(data);
+		xfree(key);
+	}
+	END_TIMER2("batch_store_flush");
+	if (write_cnt)
+		debug2("batch_store_flush: wrote %u files %s",
+		       write_cnt, TIME_STR);
+	slurm_mutex_lock(&store_mutex);
+	last_write_rc = rc;
+	slurm_mutex_unlock(&store_mutex);
+	if (rc != SLURM_SUCCESS)
+		schedule_batch_store_save();
+	return rc;
+}
+
+extern int batch_store_write_status(void)
+{
+	int rc;
+
+	slurm_mutex_lock(&store_mutex);
+	rc = last_write_rc;
+	slurm_mutex_unlock(&store_mutex);
+	return rc;
+}
+
+extern void batch_store_sync_start(void)
+{
+	store_rec_t *rec;
+	uint32_t i;
+
+	slurm_mutex_lock(&store_mutex);
+	for (i = 0; store_hash && (i < STORE_HASH_SIZE); i++) {
+		for (rec = store_hash[i]; rec; rec = rec->next)
+			rec->ref_cnt = 0;
+	}
+	slurm_mutex_unlock(&store_mutex);
+}
+
+extern void batch_store_ref(char *key)
+{
+	store_rec_t *rec;
+
+	slurm_mutex_lock(&store_mutex);
+	rec = _find_rec(key);
+	if (rec == NULL)
+		rec = _create_rec(key);
+	rec->ref_cnt++;
+	slurm_mutex_unlock(&store_mutex);
+}
+
+/* Remove files in the store which no record references */
+static void _remove_orphan_files(void)
+{
+	DIR *top_dir, *hash_dir;
+	struct dirent *top_ent, *hash_ent;
+	char *top_name, *dir_name, *file_name;
+	int len, orphan_cnt = 0;
+	bool orphan;
+
+	top_name = _key_path(NULL, false);
+	top_dir = opendir(top_name);
+	if (top_dir == NULL) {	/* nothing stored yet */
+		xfree(top_name);
+		return;
+	}
+	while ((top_ent = readdir(top_dir))) {
+		if (strncmp(top_ent->d_name, "hash.", 5))
+			continue;
+		dir_name = xstrdup_printf("%s/%s", top_name, top_ent->d_name);
+		hash_dir = opendir(dir_name);
+		if (hash_dir == NULL) {
+			error("opendir(%s): %m", dir_name);
+			xfree(dir_name);
+			continue;
+		}
+		while ((hash_ent = readdir(hash_dir))) {
+			if (hash_ent->d_name[0] == '.')
+				continue;
+			len = strlen(hash_ent->d_name);
+			if ((len > 4) &&
+			    !strcmp(hash_ent->d_name + len - 4, ".tmp")) {
+				orphan = true;	/* incomplete write */
+			} else {
+				slurm_mutex_lock(&store_mutex);
+				orphan = (_find_rec(hash_ent->d_name) == NULL);
+				slurm_mutex_unlock(&store_mutex);
+			}
+			if (!orphan)
+				continue;
+			file_name = xstrdup_printf("%s/%s", dir_name,
+						   hash_ent->d_name);
+			(void) unlink(file_name);
+			xfree(file_name);
+			orphan_cnt++;
+		}
+		closedir(hash_dir);
+		xfree(dir_name);
+	}
+	closedir(top_dir);
+	xfree(top_name);
+	if (orphan_cnt)
+		info("Purged %d unreferenced batch script files", orphan_cnt);
+}
+
+extern void batch_store_sync_end(void)
+{
+	store_rec_t *rec, *next_rec;
+	uint32_t i, del_cnt = 0;
+
+	slurm_mutex_lock(&store_mutex);
+	for (i = 0; store_hash && (i < STORE_HASH_SIZE); i++) {
+		for (rec = store_hash[i]; rec; rec = next_rec) {
+			next_rec = rec->next;
+			if (rec->ref_cnt)
+				continue;
+			_delete_rec(rec);
+			del_cnt++;
+		}
+	}
+	slurm_mutex_unlock(&store_mutex);
+	if (del_cnt)
+		schedule_batch_store_save();
+
+	if (!store_synced) {
+		_remove_orphan_files();
+		store_synced = true;
+	}
+}
+
+extern void batch_store_fini(void)
+{
+	store_rec_t *rec, *next_rec;
+	uint32_t i;
+
+	slurm_mutex_lock(&store_mutex);
+	for (i = 0; store_hash && (i < STORE_HASH_SIZE); i++) {
+		for (rec = store_hash[i]; rec; rec = next_rec) {
+			next_rec = rec->next;
+			xfree(rec->key);
+			xfree(rec->data);
+			xfree(rec);
+		}
+	}
+	xfree(store_hash);
+	if (unlink_list) {
+		list_destroy(unlink_list);
+		unlink_list = NULL;
+	}
+	slurm_mutex_unlock(&store_mutex);
+}
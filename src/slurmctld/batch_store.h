@@ -0,0 +1,132 @@
+/*****************************************************************************\
+ *  batch_store.h - content addressed, reference counted storage of batch
+ *	job scripts and environments
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://www.schedmd.com/slurmdocs/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_BATCH_STORE_H
+#define _HAVE_BATCH_STORE_H
+
+#include <inttypes.h>
+#include <sys/types.h>
+
+#include "src/common/macros.h"
+
+/*
+ * Batch job scripts and environments are stored in files named by the
+ * owning user and a hash of their contents, spread over the subdirectories
+ * StateSaveLocation/batch_store/hash.<0-99>. Jobs with identical data share
+ * one file, which is removed when the last job referencing it is purged.
+ *
+ * Data added is kept in memory until written by the slurmctld state save
+ * thread, so no file system operations happen while the job locks are held.
+ * The job state is written only after the data its jobs reference.
+ */
+
+/*
+ * batch_store_add - add a reference to the stored copy of some data,
+ *	storing the data if not already present
+ * IN type - type of data, "script" or "env"
+ * IN uid - user owning the data, only identical data of the same user
+ *	is shared
+ * IN data - data to store, copied as needed
+ * IN size - size of data in bytes
+ * RET key identifying the data, xfree() when no longer needed
+ */
+extern char *batch_store_add(char *type, uid_t uid, char *data,
+			     uint32_t size);
+
+/*
+ * batch_store_import - add the contents of a file to the store, used to
+ *	convert the job.<id> directories of older versions
+ * IN type, uid - as for batch_store_add()
+ * IN file_name - file to read
+ * RET key identifying the data, xfree() when no longer needed,
+ *	or NULL if the file could not be read
+ */
+extern char *batch_store_import(char *type, uid_t uid, char *file_name);
+
+/*
+ * batch_store_release - remove a reference to stored data and remove the
+ *	data once no references remain
+ * IN key - as returned by batch_store_add()
+ */
+extern void batch_store_release(char *key);
+
+/*
+ * batch_store_read - return a copy of stored data
+ * IN key - as returned by batch_store_add()
+ * OUT size - size of data in bytes
+ * RET data, xfree() when no longer needed, or NULL on error
+ */
+extern char *batch_store_read(char *key, uint32_t *size);
+
+/*
+ * batch_store_exists - test if stored data exists
+ * IN key - as returned by batch_store_add()
+ * RET true if the data can be read
+ */
+extern bool batch_store_exists(char *key);
+
+/*
+ * batch_store_flush - write data added to the store and remove the files
+ *	of data no longer referenced. Called by the state save thread, and
+ *	by dump_all_job_state() before it writes the job state.
+ * RET SLURM_SUCCESS or an error code if some data could not be written,
+ *	such data is kept in memory and another flush is scheduled
+ */
+extern int batch_store_flush(void);
+
+/*
+ * batch_store_write_status - return the result of the last
+ *	batch_store_flush(), used to reject new batch jobs while data can
+ *	not be written
+ */
+extern int batch_store_write_status(void);
+
+/*
+ * Rebuild the reference counts from the job records: call
+ * batch_store_sync_start(), then batch_store_ref() for each key referenced,
+ * then batch_store_sync_end(). The first sync also removes files which no
+ * job references.
+ * NOTE: Lock job records before entry
+ */
+extern void batch_store_sync_start(void);
+extern void batch_store_ref(char *key);
+extern void batch_store_sync_end(void);
+
+/* Free all memory used by the store (data not yet written is lost) */
+extern void batch_store_fini(void);
+
+#endif	/* !_HAVE_BATCH_STORE_H */
@@ -87,6 +87,7 @@
 
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/batch_store.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/job_submit.h"
@@ -153,6 +154,7 @@ log_options_t sched_log_opts = SCHEDLOG_OPTS_INITIALIZER;
 
 /* Global variables */
 slurmctld_config_t slurmctld_config;
+diag_stats_t slurmctld_diag_stats;
 int bg_recover = DEFAULT_RECOVER;
 char *slurmctld_cluster_name = NULL; /* name of cluster */
 void *acct_db_conn = NULL;
@@ -168,6 +170,7 @@ static int	debug_level = 0;
 static char	*debug_logfile = NULL;
 static bool     dump_core = false;
 static uint32_t max_server_threads = MAX_SERVER_THREADS;
+static uint32_t rpc_worker_cnt = RPC_WORKER_THREADS;
 static int	new_nice = 0;
 static char	node_name[MAX_SLURM_NAME];
 static int	recover   = DEFAULT_RECOVER;
@@ -175,6 +178,17 @@ static pthread_cond_t server_thread_cond = PTHREAD_COND_INITIALIZER;
 static pid_t	slurmctld_pid;
 static char    *slurm_conf_filename;
 static int      primary = 1 ;
+
+/* RPC worker pool. Accepted connections wait in rpc_conn_queue to be
+ * received, then in rpc_msg_queue by priority class to be processed. */
+static pthread_mutex_t rpc_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  rpc_queue_cond  = PTHREAD_COND_INITIALIZER;
+static List rpc_conn_queue = NULL;
+static List rpc_msg_queue[RPC_PRIO_CNT];
+static bool rpc_pool_shutdown = false;
+static uint32_t rpc_conn_depth = 0;
+static rpc_queue_stats_t rpc_queue_stats[RPC_PRIO_CNT];
+static char *rpc_prio_name[RPC_PRIO_CNT] = { "high", "normal", "low" };
 /*
  * Static list of signals to block in this process
  * *Must be zero-terminated*
@@ -201,7 +215,8 @@ static void         _remove_qos(slurmdb_qos_rec_t *rec);
 static void         _update_assoc(slurmdb_association_rec_t *rec);
 static void         _update_qos(slurmdb_qos_rec_t *rec);
 inline static int   _report_locks_set(void);
-static void *       _service_connection(void *arg);
+static void *       _rpc_worker(void *no_data);
+static void         _service_connection(void *arg);
 static int          _shutdown_backup_controller(int wait_time);
 static void *       _slurmctld_background(void *no_data);
 static void *       _slurmctld_rpc_mgr(void *no_data);
@@ -215,6 +230,10 @@ static bool         _wait_for_server_thread(void);
 
 typedef struct connection_arg {
 	int newsockfd;
+	slurm_msg_t *msg;	/* NULL until message received */
+	int msg_rc;		/* errno from slurm_receive_msg() */
+	rpc_prio_t prio;
+	struct timeval queue_time;
 } connection_arg_t;
 
 /* main - slurmctld main function, start various threads and process RPCs */
@@ -229,6 +248,7 @@ int main(int argc, char *argv[])
 	assoc_init_args_t assoc_init_arg;
 	pthread_t assoc_cache_thread;
 	slurm_trigger_callbacks_t callbacks;
+	DEF_TIMERS;
 
 	/*
 	 * Establish initial configuration
@@ -371,6 +391,7 @@ int main(int argc, char *argv[])
 	callbacks.dbd_resumed = trigger_primary_dbd_res_op;
 	callbacks.db_fail     = trigger_primary_db_fail;
 	callbacks.db_resumed  = trigger_primary_db_res_op;
+	START_TIMER;
 	acct_db_conn = acct_storage_g_get_connection(&callbacks, 0, false,
 						     slurmctld_cluster_name);
 	if (assoc_mgr_init(acct_db_conn, &assoc_init_arg, errno)) {
@@ -397,6 +418,8 @@ int main(int argc, char *argv[])
 	   way.  If we get an error we can't do anything about it.
 	*/
 	load_assoc_usage(slurmctld_conf.state_save_location);
+	END_TIMER2("association state recovery");
+	info("Association state recovered in %s", TIME_STR);
 
 	/* This thread is looking for when we get correct data from
 	   the database so we can update the assoc_ptr's in the jobs
@@ -467,9 +490,12 @@ int main(int argc, char *argv[])
 			trigger_primary_ctld_res_ctrl();
 			/* Now recover the remaining state information */
 			lock_slurmctld(config_write_lock);
+			START_TIMER;
 			if (switch_restore(slurmctld_conf.state_save_location,
 					   recover ? true : false))
 				fatal(" failed to initialize switch plugin" );
+			END_TIMER2("switch_restore");
+			info("Switch state recovered in %s", TIME_STR);
 			if ((error_code = read_slurm_conf(recover, false))) {
 				fatal("read_slurm_conf reading %s: %s",
 					slurmctld_conf.slurm_conf,
@@ -645,6 +671,7 @@ int main(int argc, char *argv[])
 
 	/* Purge our local data structures */
 	job_fini();
+	batch_store_fini();
 	part_fini();	/* part_fini() must preceed node_fini() */
 	node_fini();
 	purge_front_end_state();
@@ -735,6 +762,7 @@ static void  _init_config(void)
 	slurmctld_config.server_thread_count = 0;
 	slurmctld_config.shutdown_time  = (time_t) 0;
 	slurmctld_config.thread_id_main = pthread_self();
+	slurmctld_diag_stats.time_start = slurmctld_config.boot_time;
 #ifdef WITH_PTHREADS
 	pthread_mutex_init(&slurmctld_config.thread_count_lock, NULL);
 	slurmctld_config.thread_id_main    = (pthread_t) 0;
@@ -849,7 +877,8 @@ static void _sig_handler(int signal)
 {
 }
 
-/* _slurmctld_rpc_mgr - Read incoming RPCs and create pthread for each */
+/* _slurmctld_rpc_mgr - Read incoming RPCs and queue them for a pool of
+ *	worker threads */
 static void *_slurmctld_rpc_mgr(void *no_data)
 {
 	slurm_fd_t newsockfd;
@@ -858,9 +887,8 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	slurm_addr_t cli_addr, srv_addr;
 	uint16_t port;
 	char ip[32];
-	pthread_t thread_id_rpc_req;
+	pthread_t *thread_id_rpc_req;
 	pthread_attr_t thread_attr_rpc_req;
-	int no_thread;
 	int fd_next = 0, i, nports;
 	fd_set rfds;
 	connection_arg_t *conn_arg = NULL;
@@ -874,11 +902,28 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	(void) pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
 	debug3("_slurmctld_rpc_mgr pid = %u", getpid());
 
-	/* threads to process individual RPC's are detached */
+	/* start the pool of threads to process individual RPCs */
+	slurm_mutex_lock(&rpc_queue_mutex);
+	rpc_pool_shutdown = false;
+	rpc_conn_queue = list_create(NULL);
+	if (rpc_conn_queue == NULL)
+		fatal("list_create: malloc failure");
+	for (i = 0; i < RPC_PRIO_CNT; i++) {
+		rpc_msg_queue[i] = list_create(NULL);
+		if (rpc_msg_queue[i] == NULL)
+			fatal("list_create: malloc failure");
+	}
+	slurm_mutex_unlock(&rpc_queue_mutex);
+	rpc_worker_cnt = MIN(RPC_WORKER_THREADS, max_server_threads);
+	rpc_worker_cnt = MAX(rpc_worker_cnt, 1);
+	thread_id_rpc_req = xmalloc(sizeof(pthread_t) * rpc_worker_cnt);
 	slurm_attr_init(&thread_attr_rpc_req);
-	if (pthread_attr_setdetachstate
-	    (&thread_attr_rpc_req, PTHREAD_CREATE_DETACHED))
-		fatal("pthread_attr_setdetachstate %m");
+	for (i = 0; i < rpc_worker_cnt; i++) {
+		if (pthread_create(&thread_id_rpc_req[i], &thread_attr_rpc_req,
+				   _rpc_worker, NULL))
+			fatal("pthread_create: %m");
+	}
+	debug2("slurmctld RPC worker pool of %u threads", rpc_worker_cnt);
 
 	/* set node_addr to bind to (NULL means any) */
 	if (slurmctld_conf.backup_controller && slurmctld_conf.backup_addr &&
@@ -957,23 +1002,30 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		}
 		conn_arg = xmalloc(sizeof(connection_arg_t));
 		conn_arg->newsockfd = newsockfd;
-		if (slurmctld_config.shutdown_time)
-			no_thread = 1;
-		else if (pthread_create(&thread_id_rpc_req,
-					&thread_attr_rpc_req,
-					_service_connection,
-					(void *) conn_arg)) {
-			error("pthread_create: %m");
-			no_thread = 1;
-		} else
-			no_thread = 0;
-
-		if (no_thread) {
-			_service_connection((void *) conn_arg);
-		}
+		slurm_mutex_lock(&rpc_queue_mutex);
+		list_enqueue(rpc_conn_queue, conn_arg);
+		rpc_conn_depth++;
+		pthread_cond_signal(&rpc_queue_cond);
+		slurm_mutex_unlock(&rpc_queue_mutex);
 	}
 
 	debug3("_slurmctld_rpc_mgr shutting down");
+	/* workers drain the queues before exiting */
+	slurm_mutex_lock(&rpc_queue_mutex);
+	rpc_pool_shutdown = true;
+	pthread_cond_broadcast(&rpc_queue_cond);
+	slurm_mutex_unlock(&rpc_queue_mutex);
+	for (i = 0; i < rpc_worker_cnt; i++)
+		pthread_join(thread_id_rpc_req[i], NULL);
+	xfree(thread_id_rpc_req);
+	slurm_mutex_lock(&rpc_queue_mutex);
+	list_destroy(rpc_conn_queue);
+	rpc_conn_queue = NULL;
+	for (i = 0; i < RPC_PRIO_CNT; i++) {
+		list_destroy(rpc_msg_queue[i]);
+		rpc_msg_queue[i] = NULL;
+	}
+	slurm_mutex_unlock(&rpc_queue_mutex);
 	slurm_attr_destroy(&thread_attr_rpc_req);
 	for (i=0; i<nports; i++)
 		(void) slurm_shutdown_msg_engine(sockfd[i]);
@@ -983,38 +1035,150 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	return NULL;
 }
 
+/* Identify the priority class of an RPC. Messages which release resources
+ * or report node state are serviced ahead of submissions and updates, which
+ * are serviced ahead of information queries. */
+extern rpc_prio_t rpc_msg_prio(slurm_msg_type_t msg_type)
+{
+	switch (msg_type) {
+	case MESSAGE_NODE_REGISTRATION_STATUS:
+	case MESSAGE_EPILOG_COMPLETE:
+	case REQUEST_COMPLETE_BATCH_SCRIPT:
+	case REQUEST_COMPLETE_JOB_ALLOCATION:
+	case REQUEST_STEP_COMPLETE:
+	case REQUEST_CONTROL:
+	case REQUEST_PING:
+	case REQUEST_RECONFIGURE:
+	case REQUEST_SHUTDOWN:
+	case REQUEST_SHUTDOWN_IMMEDIATE:
+	case REQUEST_TAKEOVER:
+	case ACCOUNTING_UPDATE_MSG:
+	case ACCOUNTING_FIRST_REG:
+		return RPC_PRIO_HIGH;
+	case REQUEST_BUILD_INFO:
+	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_INFO_SINGLE:
+	case REQUEST_JOB_USER_INFO:
+	case REQUEST_JOB_STEP_INFO:
+	case REQUEST_NODE_INFO:
+	case REQUEST_PARTITION_INFO:
+	case REQUEST_BLOCK_INFO:
+	case REQUEST_TRIGGER_GET:
+	case REQUEST_SHARE_INFO:
+	case REQUEST_RESERVATION_INFO:
+	case REQUEST_PRIORITY_FACTORS:
+	case REQUEST_TOPO_INFO:
+	case REQUEST_FRONT_END_INFO:
+	case REQUEST_STATS_INFO:
+		return RPC_PRIO_LOW;
+	default:
+		return RPC_PRIO_NORMAL;
+	}
+}
+
+/* Return true if the oldest record in a message queue has waited longer
+ * than RPC_QUEUE_AGE_LIMIT. Call with rpc_queue_mutex locked. */
+static bool _rpc_queue_aged(List msg_queue, struct timeval *now)
+{
+	connection_arg_t *conn = (connection_arg_t *) list_peek(msg_queue);
+
+	if (conn == NULL)
+		return false;
+	return (slurm_diff_tv_usec(&conn->queue_time, now) >
+		RPC_QUEUE_AGE_LIMIT);
+}
+
+/* Select the next connection or message for a worker thread.
+ * Call with rpc_queue_mutex locked.
+ * RET work to do or NULL if the queues are empty */
+static connection_arg_t *_rpc_queue_next(void)
+{
+	connection_arg_t *conn;
+	struct timeval now;
+	uint32_t msg_depth = 0;
+	int i;
+
+	if ((conn = list_dequeue(rpc_msg_queue[RPC_PRIO_HIGH])))
+		return conn;
+
+	gettimeofday(&now, NULL);
+	for (i = RPC_PRIO_NORMAL; i < RPC_PRIO_CNT; i++) {
+		if (_rpc_queue_aged(rpc_msg_queue[i], &now))
+			return list_dequeue(rpc_msg_queue[i]);
+		msg_depth += rpc_queue_stats[i].depth;
+	}
+
+	/* Receive new messages to find any of high priority, unless there
+	 * are already more messages waiting than worker threads */
+	if ((msg_depth < rpc_worker_cnt) &&
+	    (conn = list_dequeue(rpc_conn_queue)))
+		return conn;
+
+	for (i = RPC_PRIO_NORMAL; i < RPC_PRIO_CNT; i++) {
+		if ((conn = list_dequeue(rpc_msg_queue[i])))
+			return conn;
+	}
+	return list_dequeue(rpc_conn_queue);
+}
+
 /*
- * _service_connection - service the RPC
- * IN/OUT arg - really just the connection's file descriptor, freed
- *	upon completion
- * RET - NULL
+ * _receive_connection - read the message from an accepted connection and
+ *	queue it for processing by priority
+ * IN/OUT conn - connection to receive from, freed on error
  */
-static void *_service_connection(void *arg)
+static void _receive_connection(connection_arg_t *conn)
 {
-	connection_arg_t *conn = (connection_arg_t *) arg;
-	void *return_code = NULL;
-	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+	rpc_queue_stats_t *stats;
 
-	slurm_msg_t_init(msg);
+	conn->msg = xmalloc(sizeof(slurm_msg_t));
+	slurm_msg_t_init(conn->msg);
 	/*
 	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
 	 * possibility for slurmctld_req() to close accepted connection.
 	 */
-	if(slurm_receive_msg(conn->newsockfd, msg, 0) != 0) {
+	if (slurm_receive_msg(conn->newsockfd, conn->msg, 0) != 0) {
 		error("slurm_receive_msg: %m");
 		/* close should only be called when the socket implementation
 		 * is being used the following call will be a no-op in a
 		 * message/mongo implementation */
 		/* close the new socket */
 		slurm_close_accepted_conn(conn->newsockfd);
-		goto cleanup;
+		slurm_free_msg(conn->msg);
+		xfree(conn);
+		_free_server_thread();
+		return;
 	}
+	conn->msg_rc = errno;
+	conn->prio = rpc_msg_prio(conn->msg->msg_type);
+
+	slurm_mutex_lock(&rpc_queue_mutex);
+	gettimeofday(&conn->queue_time, NULL);
+	list_enqueue(rpc_msg_queue[conn->prio], conn);
+	stats = &rpc_queue_stats[conn->prio];
+	stats->depth++;
+	if (stats->depth > stats->depth_max)
+		stats->depth_max = stats->depth;
+	pthread_cond_signal(&rpc_queue_cond);
+	slurm_mutex_unlock(&rpc_queue_mutex);
+}
 
-	if(errno != SLURM_SUCCESS) {
-		if (errno == SLURM_PROTOCOL_VERSION_ERROR) {
+/*
+ * _service_connection - service the RPC
+ * IN/OUT arg - connection with its received message, freed
+ *	upon completion
+ */
+static void _service_connection(void *arg)
+{
+	connection_arg_t *conn = (connection_arg_t *) arg;
+	slurm_msg_t *msg = conn->msg;
+
+	if (conn->msg_rc != SLURM_SUCCESS) {
+		if (conn->msg_rc == SLURM_PROTOCOL_VERSION_ERROR) {
 			slurm_send_rc_msg(msg, SLURM_PROTOCOL_VERSION_ERROR);
-		} else
-			info("_service_connection/slurm_receive_msg %m");
+		} else {
+			info("_service_connection/slurm_receive_msg %s",
+			     slurm_strerror(conn->msg_rc));
+		}
 	} else {
 		/* process the request */
 		slurmctld_req(msg);
@@ -1023,11 +1187,120 @@ static void *_service_connection(void *arg)
 	    && slurm_close_accepted_conn(conn->newsockfd) < 0)
 		error ("close(%d): %m",  conn->newsockfd);
 
-cleanup:
 	slurm_free_msg(msg);
 	xfree(arg);
 	_free_server_thread();
-	return return_code;
+}
+
+/* _rpc_worker - thread which receives and services queued RPCs until the
+ *	RPC manager shuts down and the queues are empty */
+static void *_rpc_worker(void *no_data)
+{
+	connection_arg_t *conn;
+	rpc_queue_stats_t *stats;
+	struct timeval start, end;
+	uint32_t delta;
+
+	while (1) {
+		slurm_mutex_lock(&rpc_queue_mutex);
+		while ((conn = _rpc_queue_next()) == NULL) {
+			if (rpc_pool_shutdown) {
+				slurm_mutex_unlock(&rpc_queue_mutex);
+				return NULL;
+			}
+			pthread_cond_wait(&rpc_queue_cond, &rpc_queue_mutex);
+		}
+		if (conn->msg == NULL) {
+			rpc_conn_depth--;
+			slurm_mutex_unlock(&rpc_queue_mutex);
+			_receive_connection(conn);
+			continue;
+		}
+		stats = &rpc_queue_stats[conn->prio];
+		stats->depth--;
+		gettimeofday(&start, NULL);
+		delta = slurm_diff_tv_usec(&conn->queue_time, &start);
+		stats->wait_usec += delta;
+		if (delta > stats->wait_max_usec)
+			stats->wait_max_usec = delta;
+		slurm_mutex_unlock(&rpc_queue_mutex);
+
+		_service_connection(conn);
+
+		gettimeofday(&end, NULL);
+		delta = slurm_diff_tv_usec(&start, &end);
+		slurm_mutex_lock(&rpc_queue_mutex);
+		stats->count++;
+		stats->run_usec += delta;
+		if (delta > stats->run_max_usec)
+			stats->run_max_usec = delta;
+		slurm_mutex_unlock(&rpc_queue_mutex);
+	}
+	return NULL;
+}
+
+/*
+ * get_rpc_queue_stats - Get a copy of the RPC queue statistics
+ * OUT stats - statistics for each rpc_prio_t, RPC_PRIO_CNT records
+ * OUT conn_depth - connections accepted but not yet received
+ * OUT worker_cnt - RPC worker threads
+ */
+extern void get_rpc_queue_stats(rpc_queue_stats_t *stats,
+				uint32_t *conn_depth, uint32_t *worker_cnt)
+{
+	slurm_mutex_lock(&rpc_queue_mutex);
+	memcpy(stats, rpc_queue_stats, sizeof(rpc_queue_stats));
+	*conn_depth = rpc_conn_depth;
+	*worker_cnt = rpc_worker_cnt;
+	slurm_mutex_unlock(&rpc_queue_mutex);
+}
+
+/* reset_rpc_queue_stats - Clear RPC queue statistics, other than the
+ *	current queue depths */
+extern void reset_rpc_queue_stats(void)
+{
+	int i;
+
+	slurm_mutex_lock(&rpc_queue_mutex);
+	for (i = 0; i < RPC_PRIO_CNT; i++) {
+		rpc_queue_stats[i].count = 0;
+		rpc_queue_stats[i].depth_max = rpc_queue_stats[i].depth;
+		rpc_queue_stats[i].wait_usec = 0;
+		rpc_queue_stats[i].wait_max_usec = 0;
+		rpc_queue_stats[i].run_usec = 0;
+		rpc_queue_stats[i].run_max_usec = 0;
+	}
+	slurm_mutex_unlock(&rpc_queue_mutex);
+}
+
+/* rpc_prio_string - Return the name of an RPC priority class, e.g. "high" */
+extern char *rpc_prio_string(rpc_prio_t prio)
+{
+	if (prio >= RPC_PRIO_CNT)
+		return "unknown";
+	return rpc_prio_name[prio];
+}
+
+/* log_rpc_queue_stats - Log RPC queue statistics */
+extern void log_rpc_queue_stats(void)
+{
+	rpc_queue_stats_t stats[RPC_PRIO_CNT];
+	uint32_t conn_depth, worker_cnt;
+	int i;
+
+	get_rpc_queue_stats(stats, &conn_depth, &worker_cnt);
+	info("RPC queue statistics: workers:%u unreceived:%u",
+	     worker_cnt, conn_depth);
+	for (i = 0; i < RPC_PRIO_CNT; i++) {
+		if (stats[i].count == 0)
+			continue;
+		info("  %-6s cnt:%u depth:%u depth_max:%u wait_avg:%"PRIu64" "
+		     "wait_max:%u run_avg:%"PRIu64" run_max:%u (usec)",
+		     rpc_prio_name[i], stats[i].count, stats[i].depth,
+		     stats[i].depth_max, stats[i].wait_usec / stats[i].count,
+		     stats[i].wait_max_usec, stats[i].run_usec / stats[i].count,
+		     stats[i].run_max_usec);
+	}
 }
 
 /* Increment slurmctld_config.server_thread_count and don't return
@@ -1275,6 +1548,7 @@ static void *_slurmctld_background(void *no_data)
 	static time_t last_node_acct;
 	static time_t last_ctld_bu_ping;
 	static time_t last_uid_update;
+	static time_t last_lock_stats;
 	static bool ping_msg_sent = false;
 	time_t now;
 	int no_resp_msg_interval, ping_interval, purge_job_interval;
@@ -1310,7 +1584,7 @@ static void *_slurmctld_background(void *no_data)
 	last_purge_job_time = last_trigger = last_health_check_time = now;
 	last_timelimit_time = last_assert_primary_time = now;
 	last_no_resp_msg_time = last_resv_time = last_ctld_bu_ping = now;
-	last_uid_update = now;
+	last_uid_update = last_lock_stats = now;
 
 	if ((slurmctld_conf.min_job_age > 0) &&
 	    (slurmctld_conf.min_job_age < PURGE_JOB_INTERVAL)) {
@@ -1361,6 +1635,9 @@ static void *_slurmctld_background(void *no_data)
 			if (slurmctld_config.server_thread_count)
 				info("shutdown server_thread_count=%d",
 					slurmctld_config.server_thread_count);
+			log_lock_stats();
+			log_rpc_queue_stats();
+			assoc_mgr_log_lookup_stats();
 			if (_report_locks_set() == 0) {
 				info("Saving all slurm state");
 				save_all_state();
@@ -1532,6 +1809,15 @@ static void *_slurmctld_background(void *no_data)
 			assoc_mgr_set_missing_uids();
 		}
 
+		if ((slurmctld_conf.slurmctld_debug > 3) &&
+		    (difftime(now, last_lock_stats) >= PERIODIC_LOCK_STATS)) {
+			now = time(NULL);
+			last_lock_stats = now;
+			log_lock_stats();
+			log_rpc_queue_stats();
+			assoc_mgr_log_lookup_stats();
+		}
+
 		END_TIMER2("_slurmctld_background");
 	}
 
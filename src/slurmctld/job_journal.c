@@ -0,0 +1,113 @@
+/*****************************************************************************\
+ *  job_journal.c - job state journal records, see dump_all_job_state()
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://www.schedmd.com/slurmdocs/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "src/common/fnv_hash.h"
+#include "src/slurmctld/job_journal.h"
+
+static void _pack_delete_rec(Buf journal, uint32_t job_id_sequence,
+			     uint32_t job_id)
+{
+	pack32((uint32_t) (sizeof(uint16_t) + sizeof(uint32_t) * 2),
+	       journal);
+	pack16((uint16_t) JOB_JOURNAL_DELETE, journal);
+	pack32(job_id_sequence, journal);
+	pack32(job_id, journal);
+}
+
+extern void job_journal_rec_begin(Buf buffer, job_state_rec_t *rec,
+				  uint32_t job_id)
+{
+	rec->job_id = job_id;
+	pack32((uint32_t) 0, buffer);
+	rec->offset = get_buf_offset(buffer);
+}
+
+extern void job_journal_rec_end(Buf buffer, job_state_rec_t *rec)
+{
+	uint32_t end_offset = get_buf_offset(buffer);
+
+	rec->size = end_offset - rec->offset;
+	set_buf_offset(buffer, rec->offset - sizeof(uint32_t));
+	pack32(rec->size, buffer);
+	set_buf_offset(buffer, end_offset);
+	rec->hash = fnv_hash64(get_buf_data(buffer) + rec->offset, rec->size);
+}
+
+extern void job_journal_pack(Buf journal, Buf buffer,
+			     job_state_rec_t *recs, uint32_t rec_cnt,
+			     job_state_rec_t *old_recs, uint32_t old_cnt,
+			     uint32_t job_id_sequence,
+			     uint32_t *upd_cnt, uint32_t *del_cnt)
+{
+	job_state_rec_t *old_rec;
+	uint32_t i, j, rec_offset, tmp_offset;
+
+	*upd_cnt = 0;
+	*del_cnt = 0;
+	for (i = 0, j = 0; i < rec_cnt; i++) {
+		/* Records of removed jobs, both arrays are sorted */
+		while ((j < old_cnt) && (old_recs[j].job_id < recs[i].job_id)) {
+			_pack_delete_rec(journal, job_id_sequence,
+					 old_recs[j++].job_id);
+			(*del_cnt)++;
+		}
+		old_rec = NULL;
+		if ((j < old_cnt) && (old_recs[j].job_id == recs[i].job_id))
+			old_rec = &old_recs[j++];
+		if (old_rec && (old_rec->hash == recs[i].hash))
+			continue;
+
+		rec_offset = get_buf_offset(journal);
+		pack32((uint32_t) 0, journal);
+		pack16((uint16_t) JOB_JOURNAL_UPDATE, journal);
+		pack32(job_id_sequence, journal);
+		packmem_array(get_buf_data(buffer) + recs[i].offset,
+			      recs[i].size, journal);
+		tmp_offset = get_buf_offset(journal);
+		set_buf_offset(journal, rec_offset);
+		pack32(tmp_offset - rec_offset - sizeof(uint32_t), journal);
+		set_buf_offset(journal, tmp_offset);
+		(*upd_cnt)++;
+	}
+	for ( ; j < old_cnt; j++) {
+		_pack_delete_rec(journal, job_id_sequence, old_recs[j].job_id);
+		(*del_cnt)++;
+	}
+}
@@ -0,0 +1,91 @@
+/*****************************************************************************\
+ *  job_journal.h - job state journal records, see dump_all_job_state()
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://www.schedmd.com/slurmdocs/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_JOB_JOURNAL_H
+#define _HAVE_JOB_JOURNAL_H
+
+#include <inttypes.h>
+
+#include "src/common/pack.h"
+
+/* Records of the job state journal */
+#define JOB_JOURNAL_UPDATE	1
+#define JOB_JOURNAL_DELETE	2
+
+/* Hash of a job's saved state, used to append only changed jobs to the
+ * job state journal */
+typedef struct job_state_rec {
+	uint32_t job_id;
+	uint32_t offset;	/* location of record in the packed job_state,
+				 * excluding its size field */
+	uint32_t size;
+	uint64_t hash;
+} job_state_rec_t;
+
+/*
+ * job_journal_rec_begin - start a size prefixed job record in buffer
+ * IN buffer - packed job_state
+ * OUT rec - set to the job ID and location of the record
+ * IN job_id - ID of the job whose state follows
+ */
+extern void job_journal_rec_begin(Buf buffer, job_state_rec_t *rec,
+				  uint32_t job_id);
+
+/*
+ * job_journal_rec_end - finish a job record started by
+ *	job_journal_rec_begin(), setting its size prefix
+ * IN buffer - packed job_state
+ * IN/OUT rec - set to the size and hash of the record
+ */
+extern void job_journal_rec_end(Buf buffer, job_state_rec_t *rec);
+
+/*
+ * job_journal_pack - pack journal records of the jobs which changed or
+ *	were removed between two saves of the job state
+ * IN journal - buffer to append the journal records to
+ * IN buffer - job state packed with job_journal_rec_begin/end()
+ * IN recs, rec_cnt - records of the jobs in buffer, sorted by job_id
+ * IN old_recs, old_cnt - records of the previous save, sorted by job_id
+ * IN job_id_sequence - job ID sequence saved with each record
+ * OUT upd_cnt, del_cnt - count of changed and removed jobs
+ */
+extern void job_journal_pack(Buf journal, Buf buffer,
+			     job_state_rec_t *recs, uint32_t rec_cnt,
+			     job_state_rec_t *old_recs, uint32_t old_cnt,
+			     uint32_t job_id_sequence,
+			     uint32_t *upd_cnt, uint32_t *del_cnt);
+
+#endif /* !_HAVE_JOB_JOURNAL_H */
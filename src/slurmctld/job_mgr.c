@@ -78,7 +78,9 @@
 
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/batch_store.h"
 #include "src/slurmctld/front_end.h"
+#include "src/slurmctld/job_journal.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/job_submit.h"
 #include "src/slurmctld/licenses.h"
@@ -98,14 +100,42 @@
 #define STEP_FLAG 0xbbbb
 #define TOP_PRIORITY 0xffff0000	/* large, but leave headroom for higher */
 
+/* The job ID hash table starts with JOB_HASH_MIN_SIZE entries and doubles
+ * in size once it holds more jobs than entries. The chains of the old table
+ * are moved JOB_HASH_MOVE_CNT at a time as jobs are added or removed, so no
+ * single operation pays for rehashing every job. */
+#define JOB_HASH_MIN_SIZE	1024
+#define JOB_HASH_MOVE_CNT	64
 #define JOB_HASH_INX(_job_id)	(_job_id % hash_table_size)
+#define JOB_HASH_OLD_INX(_job_id) (_job_id % hash_table_size_old)
+
+/* Jobs are also indexed by user ID and by name, see pack_user_jobs() */
+#define JOB_USER_HASH_SIZE	1024
+#define JOB_USER_HASH_INX(_user_id) (_user_id % JOB_USER_HASH_SIZE)
+#define JOB_NAME_HASH_SIZE	4096
+
+/* Number of pre-packed REQUEST_JOB_INFO responses retained, one for each
+ * protocol_version and show_flags combination recently requested */
+#define JOB_PACK_CACHE_CNT	4
+/* Seconds for which removed jobs are remembered to answer SHOW_DELTA
+ * requests, older requests get a full response */
+#define JOB_PACK_DELTA_TIME	600
 
 /* Change JOB_STATE_VERSION value when changing the state save format */
-#define JOB_STATE_VERSION      "VER011"
+#define JOB_STATE_VERSION      "VER013"
 #define JOB_2_3_STATE_VERSION  "VER011"		/* SLURM version 2.3 */
 #define JOB_2_2_STATE_VERSION  "VER010"		/* SLURM version 2.2 */
 #define JOB_2_1_STATE_VERSION  "VER009"		/* SLURM version 2.1 */
 
+/* Rewrite the job_state file once the journal exceeds its size, but let
+ * the journal grow to at least this many bytes */
+#define JOB_JOURNAL_MIN_SIZE	(4 * 1024 * 1024)
+
+/* Job records of a job_state file are unpacked by up to JOB_LOAD_THREADS
+ * threads, each handling at least JOB_LOAD_MIN_RECS records */
+#define JOB_LOAD_THREADS	8
+#define JOB_LOAD_MIN_RECS	1000
+
 #define JOB_CKPT_VERSION      "JOB_CKPT_002"
 #define JOB_2_2_CKPT_VERSION  "JOB_CKPT_002"	/* SLURM version 2.2 */
 #define JOB_2_1_CKPT_VERSION  "JOB_CKPT_001"	/* SLURM version 2.1 */
@@ -117,20 +147,105 @@ time_t last_job_update;		/* time of last update to job records */
 /* Local variables */
 static uint32_t highest_prio = 0;
 static uint32_t lowest_prio  = TOP_PRIORITY;
-static int      hash_table_size = 0;
+static uint32_t hash_table_size = 0;
+static uint32_t hash_table_size_old = 0;
 static int      job_count = 0;		/* job's in the system */
+static uint32_t job_hash_cnt = 0;	/* jobs in job_hash and job_hash_old */
+static uint32_t job_hash_move_inx = 0;	/* next job_hash_old chain to move */
 static uint32_t job_id_sequence = 0;	/* first job_id to assign new job */
 static struct   job_record **job_hash = NULL;
+static struct   job_record **job_hash_old = NULL; /* moving to job_hash */
+static struct   job_record **job_name_hash = NULL;
+static struct   job_record **job_user_hash = NULL;
 static bool     wiki_sched = false;
 static bool     wiki2_sched = false;
 static bool     wiki_sched_test = false;
 
+/* Pre-packed job records for REQUEST_JOB_INFO, shared by all users. The
+ * records needed to filter the response for each user are kept alongside
+ * so that a response can be built from the cache without the job lock. */
+typedef struct job_pack_rec {
+	uint32_t job_id;
+	time_t change_time;		/* time packed job last changed */
+	uint32_t offset;		/* offset of packed job in buffer */
+	uint32_t size;			/* size of packed job */
+	uint32_t user_id;
+	char *account;
+	struct part_record *part_ptr;
+	time_t purge_time;		/* end_time if job can be purged */
+} job_pack_rec_t;
+
+typedef struct job_pack_cache {
+	uint16_t protocol_version;
+	uint16_t show_flags;
+	time_t build_time;		/* zero if slot unused */
+	time_t expire_time;		/* pending job begin time changes
+					 * packed start time, zero if none */
+	time_t last_job_update;		/* values at build_time */
+	time_t last_part_update;
+	time_t last_used;
+	Buf buffer;
+	job_pack_rec_t *recs;
+	uint32_t rec_cnt;
+	time_t delta_start;		/* changes known since this time */
+	uint32_t *del_job_id;		/* jobs removed, oldest first */
+	time_t *del_time;
+	uint32_t del_cnt;
+} job_pack_cache_t;
+
+static pthread_mutex_t job_pack_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static job_pack_cache_t job_pack_cache[JOB_PACK_CACHE_CNT];
+
+/* Hash of each job's saved state, sorted by job_id */
+static job_state_rec_t *job_state_recs = NULL;
+static uint32_t job_state_rec_cnt = 0;
+static time_t   job_state_time = 0;	/* time of last job_state file,
+					 * zero if journal can't be used */
+static uint32_t job_state_size = 0;	/* size of last job_state file */
+static uint32_t job_journal_size = 0;	/* current size of journal */
+
+/* Location of a job record in a job_state file and its recovery status */
+typedef struct job_load_rec {
+	uint32_t offset;
+	uint32_t size;
+	bool     defer;		/* load after the parallel phase */
+	int      rc;
+} job_load_rec_t;
+
+/* Records of a job_state file loaded by one _load_job_thread() */
+typedef struct job_load_args {
+	char *data;
+	uint32_t data_size;
+	job_load_rec_t *recs;
+	uint32_t first_rec;
+	uint32_t last_rec;
+} job_load_args_t;
+
+/* Serializes the parts of _load_job_state() which update shared state
+ * while job records are loaded by several threads */
+static pthread_mutex_t job_load_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool job_load_parallel = false;
+
 /* Local functions */
 static void _add_job_hash(struct job_record *job_ptr);
+static void _add_job_index(struct job_record *job_ptr);
+static void _job_pack_cache_build(job_pack_cache_t *cache, time_t now);
+static void _job_pack_cache_clear(job_pack_cache_t *cache);
+static void _job_pack_cache_copy(job_pack_cache_t *cache, char **buffer_ptr,
+				 int *buffer_size, uid_t uid, time_t now,
+				 time_t resp_time, bool delta,
+				 time_t update_time);
+static job_pack_cache_t *_job_pack_cache_find(uint16_t show_flags,
+					      uint16_t protocol_version,
+					      time_t now, bool valid_only);
+static job_pack_cache_t *_job_pack_cache_snapshot(uint16_t show_flags,
+						  uint16_t protocol_version,
+						  time_t now,
+						  time_t update_time);
 static int  _checkpoint_job_record (struct job_record *job_ptr,
 				    char *image_dir);
-static int  _copy_job_desc_to_file(job_desc_msg_t * job_desc,
-				   uint32_t job_id);
+static int  _copy_job_desc_to_store(job_desc_msg_t * job_desc,
+				    struct job_record *job_ptr);
 static int  _copy_job_desc_to_job_record(job_desc_msg_t * job_desc,
 					 struct job_record **job_ptr,
 					 bitstr_t ** exc_bitmap,
@@ -148,6 +263,12 @@ static void _dump_job_details(struct job_details *detail_ptr,
 static void _dump_job_state(struct job_record *dump_job_ptr, Buf buffer);
 static int  _find_batch_dir(void *x, void *key);
 static void _get_batch_job_dir_ids(List batch_dirs);
+static bool _hide_job(struct job_record *job_ptr, uint16_t show_flags,
+		      uid_t uid, time_t min_age);
+static bool _import_job_files(struct job_record *job_ptr, List batch_dirs);
+static void _job_hash_grow(void);
+static void _job_hash_move(uint32_t chain_cnt);
+static uint32_t _job_name_hash_inx(char *name);
 static void _job_timed_out(struct job_record *job_ptr);
 static int  _job_create(job_desc_msg_t * job_specs, int allocate, int will_run,
 			struct job_record **job_rec_ptr, uid_t submit_uid);
@@ -156,11 +277,17 @@ static int  _list_find_job_id(void *job_entry, void *key);
 static int  _list_find_job_old(void *job_entry, void *key);
 static int  _load_job_details(struct job_record *job_ptr, Buf buffer,
 			      uint16_t protocol_version);
+static int  _load_job_records(Buf buffer, int *job_cnt);
+static void _job_load_lock(void);
+static void _job_load_unlock(void);
 static int  _load_job_state(Buf buffer,	uint16_t protocol_version);
 static uint32_t _max_switch_wait(uint32_t input_wait);
 static void _notify_srun_missing_step(struct job_record *job_ptr, int node_inx,
 				      time_t now, time_t node_boot_time);
 static int  _open_job_state_file(char **state_file);
+static int  _read_job_journal(time_t state_time, bool job_id_only);
+static int  _reset_job_journal(time_t state_time);
+static int  _write_state_buf(int fd, char *data, int nwrite, char *file);
 static void _pack_job_for_ckpt (struct job_record *job_ptr, Buf buffer);
 static void _pack_default_job_details(struct job_record *job_ptr,
 				      Buf buffer,
@@ -170,12 +297,14 @@ static void _pack_pending_job_details(struct job_details *detail_ptr,
 				      uint16_t protocol_version);
 static int  _purge_job_record(uint32_t job_id);
 static void _purge_missing_jobs(int node_inx, time_t now);
-static void _read_data_array_from_file(char *file_name, char ***data,
-				       uint32_t * size,
- 				       struct job_record *job_ptr);
-static void _read_data_from_file(char *file_name, char **data);
+static char *_pack_data_array(char **data, uint32_t size,
+			      uint32_t *buf_size);
+static void _read_data_array_from_store(char ***data, uint32_t * size,
+					struct job_record *job_ptr);
 static char *_read_job_ckpt_file(char *ckpt_file, int *size_ptr);
 static void _remove_defunct_batch_dirs(List batch_dirs);
+static void _remove_job_hash(struct job_record *job_entry);
+static void _remove_job_index(struct job_record *job_ptr);
 static int  _reset_detail_bitmaps(struct job_record *job_ptr);
 static void _reset_step_bitmaps(struct job_record *job_ptr);
 static int  _resume_job_nodes(struct job_record *job_ptr, bool indf_susp);
@@ -191,9 +320,6 @@ static int  _validate_job_create_req(job_desc_msg_t * job_desc);
 static int  _validate_job_desc(job_desc_msg_t * job_desc_msg, int allocate,
 			       uid_t submit_uid, struct part_record *part_ptr);
 static void _validate_job_files(List batch_dirs);
-static int  _write_data_to_file(char *file_name, char *data);
-static int  _write_data_array_to_file(char *file_name, char **data,
-				      uint32_t size);
 static void _xmit_new_end_time(struct job_record *job_ptr);
 
 
@@ -257,8 +383,14 @@ void delete_job_details(struct job_record *job_entry)
 		return;
 
 	xassert (job_entry->details->magic == DETAILS_MAGIC);
-	if (IS_JOB_FINISHED(job_entry))
-		_delete_job_desc_files(job_entry->job_id);
+	if (job_entry->details->env_key) {
+		batch_store_release(job_entry->details->env_key);
+		xfree(job_entry->details->env_key);
+	}
+	if (job_entry->details->script_key) {
+		batch_store_release(job_entry->details->script_key);
+		xfree(job_entry->details->script_key);
+	}
 
 	for (i=0; i<job_entry->details->argc; i++)
 		xfree(job_entry->details->argv[i]);
@@ -290,7 +422,8 @@ void delete_job_details(struct job_record *job_entry)
 	xfree(job_entry->details);	/* Must be last */
 }
 
-/* _delete_job_desc_files - delete job descriptor related files */
+/* _delete_job_desc_files - delete the job.<id> directory holding the job
+ *	script and environment files written by older versions of slurmctld */
 static void _delete_job_desc_files(uint32_t job_id)
 {
 	char *dir_name, job_dir[20], *file_name;
@@ -398,10 +531,135 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
 }
 
 
+/* Write a buffer to a file descriptor, RET 0 or errno */
+static int _write_state_buf(int fd, char *data, int nwrite, char *file)
+{
+	int pos = 0, amount;
+
+	while (nwrite > 0) {
+		amount = write(fd, &data[pos], nwrite);
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+			error("Error writing file %s, %m", file);
+			return errno;
+		}
+		nwrite -= amount;
+		pos    += amount;
+	}
+	return 0;
+}
+
+static int _job_state_rec_cmp(const void *a, const void *b)
+{
+	uint32_t job_id_a = ((job_state_rec_t *) a)->job_id;
+	uint32_t job_id_b = ((job_state_rec_t *) b)->job_id;
+
+	if (job_id_a < job_id_b)
+		return -1;
+	return (job_id_a > job_id_b);
+}
+
+/*
+ * _reset_job_journal - start an empty job state journal for a newly
+ *	written job_state file
+ * IN state_time - time in the header of the job_state file
+ * RET 0 or error code
+ */
+static int _reset_job_journal(time_t state_time)
+{
+	char *reg_file, *new_file;
+	int error_code = 0, log_fd;
+	Buf buffer = init_buf(BUF_SIZE);
+
+	packstr(JOB_STATE_VERSION, buffer);
+	pack_time(state_time, buffer);
+
+	reg_file = xstrdup(slurmctld_conf.state_save_location);
+	xstrcat(reg_file, "/job_state.journal");
+	new_file = xstrdup(slurmctld_conf.state_save_location);
+	xstrcat(new_file, "/job_state.journal.new");
+
+	log_fd = creat(new_file, 0600);
+	if (log_fd < 0) {
+		error("Can't save state, create file %s error %m",
+		      new_file);
+		error_code = errno;
+	} else {
+		error_code = _write_state_buf(log_fd, get_buf_data(buffer),
+					      get_buf_offset(buffer), new_file);
+		if (fsync_and_close(log_fd, "job journal") && !error_code)
+			error_code = errno;
+	}
+	if (error_code)
+		(void) unlink(new_file);
+	else if (rename(new_file, reg_file)) {
+		error("Can't rename %s to %s: %m", new_file, reg_file);
+		error_code = errno;
+	} else
+		job_journal_size = get_buf_offset(buffer);
+
+	xfree(reg_file);
+	xfree(new_file);
+	free_buf(buffer);
+	return error_code;
+}
+
+/*
+ * _append_job_journal - append records of changed and removed jobs to the
+ *	job state journal
+ * IN buffer - job state as written to a job_state file
+ * IN recs - location and hash of each job in buffer, sorted by job_id
+ * RET 0 or error code
+ */
+static int _append_job_journal(Buf buffer, job_state_rec_t *recs,
+			       uint32_t rec_cnt)
+{
+	Buf journal = init_buf(BUF_SIZE);
+	uint32_t job_cnt, del_cnt;
+	char *reg_file;
+	int error_code = 0, log_fd;
+
+	job_journal_pack(journal, buffer, recs, rec_cnt, job_state_recs,
+			 job_state_rec_cnt, job_id_sequence,
+			 &job_cnt, &del_cnt);
+
+	if (get_buf_offset(journal) == 0) {
+		free_buf(journal);
+		return 0;
+	}
+
+	reg_file = xstrdup(slurmctld_conf.state_save_location);
+	xstrcat(reg_file, "/job_state.journal");
+	log_fd = open(reg_file, O_WRONLY | O_APPEND);
+	if (log_fd < 0) {
+		error("Can't save state, open file %s error %m", reg_file);
+		error_code = errno;
+	} else {
+		error_code = _write_state_buf(log_fd, get_buf_data(journal),
+					      get_buf_offset(journal),
+					      reg_file);
+		if (fsync_and_close(log_fd, "job journal") && !error_code)
+			error_code = errno;
+	}
+	if (error_code == 0) {
+		job_journal_size += get_buf_offset(journal);
+		debug3("Appended %u changed and %u removed jobs to %s",
+		       job_cnt, del_cnt, reg_file);
+	}
+	xfree(reg_file);
+	free_buf(journal);
+	return error_code;
+}
+
 /*
  * dump_all_job_state - save the state of all jobs to file for checkpoint
  *	Changes here should be reflected in load_last_job_id() and
  *	load_all_job_state().
+ *	Only jobs whose state changed since the previous save are appended
+ *	to the job_state.journal file. The complete job_state file is
+ *	rewritten and the journal emptied once the journal grows larger than
+ *	the job_state file.
  * RET 0 or error code */
 int dump_all_job_state(void)
 {
@@ -417,9 +675,14 @@ int dump_all_job_state(void)
 	struct job_record *job_ptr;
 	Buf buffer = init_buf(high_buffer_size);
 	time_t min_age = 0, now = time(NULL);
+	job_state_rec_t *recs;
+	uint32_t rec_cnt = 0, i;
 	DEF_TIMERS;
 
 	START_TIMER;
+	/* The journal is matched to its job_state file by this time */
+	if (now <= job_state_time)
+		now = job_state_time + 1;
 	/* write header: version, time */
 	packstr(JOB_STATE_VERSION, buffer);
 	pack_time(now, buffer);
@@ -439,14 +702,22 @@ int dump_all_job_state(void)
 
 	/* write individual job records */
 	lock_slurmctld(job_read_lock);
+	i = MAX(list_count(job_list), 1);
+	recs = xmalloc(sizeof(job_state_rec_t) * i);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 		if ((min_age > 0) && (job_ptr->end_time < min_age) &&
 		    (! IS_JOB_COMPLETING(job_ptr)) && IS_JOB_FINISHED(job_ptr))
 			continue;	/* job ready for purging, don't dump */
+		if (rec_cnt >= i)
+			break;
 
+		/* Each record is preceded by its size */
+		job_journal_rec_begin(buffer, &recs[rec_cnt], job_ptr->job_id);
 		_dump_job_state(job_ptr, buffer);
+		job_journal_rec_end(buffer, &recs[rec_cnt]);
+		rec_cnt++;
 	}
 	list_iterator_destroy(job_iterator);
 
@@ -459,6 +730,26 @@ int dump_all_job_state(void)
 	xstrcat(new_file, "/job_state.new");
 	unlock_slurmctld(job_read_lock);
 
+	qsort(recs, rec_cnt, sizeof(job_state_rec_t), _job_state_rec_cmp);
+	high_buffer_size = MAX(get_buf_offset(buffer), high_buffer_size);
+
+	/* Write the scripts and environments of the jobs just packed before
+	 * the state which references them, and keep the old state if they
+	 * can not be written */
+	error_code = batch_store_flush();
+	lock_state_files();
+	if (error_code) {
+		error("Can't save job state, batch scripts not written");
+		schedule_job_save();
+		goto fini;
+	}
+	if (job_state_time &&
+	    (job_journal_size < MAX(job_state_size, JOB_JOURNAL_MIN_SIZE)) &&
+	    (_append_job_journal(buffer, recs, rec_cnt) == 0)) {
+		/* job_state file is unchanged */
+		goto fini;
+	}
+
 	if (stat(reg_file, &stat_buf) == 0) {
 		static time_t last_mtime = (time_t) 0;
 		int delta_t = difftime(stat_buf.st_mtime, last_mtime);
@@ -474,27 +765,17 @@ int dump_all_job_state(void)
 		last_mtime = time(NULL);
 	}
 
-	lock_state_files();
+	job_state_time = 0;
 	log_fd = creat(new_file, 0600);
 	if (log_fd < 0) {
 		error("Can't save state, create file %s error %m",
 		      new_file);
 		error_code = errno;
 	} else {
-		int pos = 0, nwrite = get_buf_offset(buffer), amount, rc;
-		char *data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(log_fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				error_code = errno;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
-
+		int rc;
+		error_code = _write_state_buf(log_fd, get_buf_data(buffer),
+					      get_buf_offset(buffer),
+					      new_file);
 		rc = fsync_and_close(log_fd, "job");
 		if (rc && !error_code)
 			error_code = rc;
@@ -511,12 +792,25 @@ int dump_all_job_state(void)
 			debug4("unable to create link for %s -> %s: %m",
 			       new_file, reg_file);
 		(void) unlink(new_file);
+		/* A stale journal is ignored since its time won't match */
+		if (_reset_job_journal(now) == 0) {
+			job_state_time = now;
+			job_state_size = get_buf_offset(buffer);
+		}
+	}
+
+fini:	if (error_code == 0) {
+		xfree(job_state_recs);
+		job_state_recs = recs;
+		job_state_rec_cnt = rec_cnt;
+		recs = NULL;
 	}
 	xfree(old_file);
 	xfree(reg_file);
 	xfree(new_file);
 	unlock_state_files();
 
+	xfree(recs);
 	free_buf(buffer);
 	END_TIMER2("dump_all_job_state");
 	return error_code;
@@ -551,9 +845,275 @@ static int _open_job_state_file(char **state_file)
 	return state_fd;
 }
 
+/*
+ * _read_job_journal - apply the records of the job state journal written
+ *	after the job_state file was saved
+ * IN state_time - time in the header of the job_state file
+ * IN job_id_only - only recover job_id_sequence
+ * RET count of records applied
+ */
+static int _read_job_journal(time_t state_time, bool job_id_only)
+{
+	int data_allocated, data_read = 0, state_fd, rec_cnt = 0;
+	uint32_t data_size = 0, rec_size, rec_end, ver_str_len, job_id, seq;
+	uint16_t rec_type;
+	char *data = NULL, *state_file, *ver_str = NULL;
+	struct job_record *job_ptr;
+	time_t buf_time;
+	Buf buffer;
+
+	state_file = slurm_get_state_save_location();
+	xstrcat(state_file, "/job_state.journal");
+	lock_state_files();
+	state_fd = open(state_file, O_RDONLY);
+	if (state_fd >= 0) {
+		data_allocated = BUF_SIZE;
+		data = xmalloc(data_allocated);
+		while (1) {
+			data_read = read(state_fd, &data[data_size],
+					 BUF_SIZE);
+			if (data_read < 0) {
+				if (errno == EINTR)
+					continue;
+				else {
+					error("Read error on %s: %m",
+					      state_file);
+					break;
+				}
+			} else if (data_read == 0)	/* eof */
+				break;
+			data_size      += data_read;
+			data_allocated += data_read;
+			xrealloc(data, data_allocated);
+		}
+		close(state_fd);
+	}
+	unlock_state_files();
+	if (state_fd < 0) {
+		xfree(state_file);
+		return 0;
+	}
+
+	buffer = create_buf(data, data_size);
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	safe_unpack_time(&buf_time, buffer);
+	if ((ver_str == NULL) || strcmp(ver_str, JOB_STATE_VERSION) ||
+	    (buf_time != state_time)) {
+		debug("Ignoring stale job state journal %s", state_file);
+		goto fini;
+	}
+
+	while (remaining_buf(buffer) >= sizeof(uint32_t)) {
+		safe_unpack32(&rec_size, buffer);
+		if (rec_size > remaining_buf(buffer))
+			break;		/* record not completely written */
+		rec_end = get_buf_offset(buffer) + rec_size;
+		safe_unpack16(&rec_type, buffer);
+		safe_unpack32(&seq, buffer);
+		job_id_sequence = MAX(seq, job_id_sequence);
+		if (job_id_only) {
+			set_buf_offset(buffer, rec_end);
+			continue;
+		}
+		if (rec_type == JOB_JOURNAL_DELETE) {
+			safe_unpack32(&job_id, buffer);
+			(void) _purge_job_record(job_id);
+		} else if (rec_type == JOB_JOURNAL_UPDATE) {
+			/* The job ID follows the association ID */
+			safe_unpack32(&job_id, buffer);
+			safe_unpack32(&job_id, buffer);
+			set_buf_offset(buffer, get_buf_offset(buffer) -
+					       sizeof(uint32_t) * 2);
+			job_ptr = find_job_record(job_id);
+			/* Replace the job's record. Batch store references
+			 * are only counted by the sync after loading state,
+			 * so releasing the old record's keys removes no
+			 * script or environment. */
+			if (job_ptr)
+				(void) _purge_job_record(job_id);
+			if (_load_job_state(buffer, SLURM_PROTOCOL_VERSION) !=
+			    SLURM_SUCCESS)
+				goto unpack_error;
+		}
+		if (get_buf_offset(buffer) != rec_end)
+			goto unpack_error;
+		rec_cnt++;
+	}
+	goto fini;
+
+unpack_error:
+	error("Incomplete job state journal %s", state_file);
+fini:	xfree(ver_str);
+	xfree(state_file);
+	free_buf(buffer);
+	return rec_cnt;
+}
+
+static void *_load_job_thread(void *arg)
+{
+	job_load_args_t *args = (job_load_args_t *) arg;
+	job_load_rec_t *rec;
+	Buf buffer;
+	uint32_t i;
+
+	/* The data is shared, each thread only uses its own offset */
+	buffer = create_buf(args->data, args->data_size);
+	for (i = args->first_rec; i < args->last_rec; i++) {
+		rec = &args->recs[i];
+		if (rec->defer)
+			continue;
+		set_buf_offset(buffer, rec->offset);
+		rec->rc = _load_job_state(buffer, SLURM_PROTOCOL_VERSION);
+		if ((rec->rc == SLURM_SUCCESS) &&
+		    (get_buf_offset(buffer) != (rec->offset + rec->size)))
+			rec->rc = SLURM_FAILURE;
+	}
+	(void) xfer_buf_data(buffer);
+	return NULL;
+}
+
+/* Lock shared state updated by _load_job_state() while loading job records
+ * in parallel */
+static void _job_load_lock(void)
+{
+	if (job_load_parallel)
+		slurm_mutex_lock(&job_load_mutex);
+}
+
+static void _job_load_unlock(void)
+{
+	if (job_load_parallel)
+		slurm_mutex_unlock(&job_load_mutex);
+}
+
+/* Return the job ID of a job record in a job_state file, zero if invalid */
+static uint32_t _job_load_rec_id(Buf buffer, job_load_rec_t *rec)
+{
+	uint32_t job_id = 0;
+
+	/* The job ID follows the association ID */
+	if (rec->size >= (sizeof(uint32_t) * 2)) {
+		set_buf_offset(buffer, rec->offset + sizeof(uint32_t));
+		(void) unpack32(&job_id, buffer);
+	}
+	return job_id;
+}
+
+/*
+ * _load_job_records - load the job records of a job_state file, each of
+ *	which is preceded by its size. With many records, the records are
+ *	divided between several threads. All job records are created first
+ *	so the job table is not modified while the threads run.
+ * IN buffer - job_state file, positioned at the first job record
+ * OUT job_cnt - count of jobs recovered
+ * RET 0 or error code if the last record is incomplete
+ */
+static int _load_job_records(Buf buffer, int *job_cnt)
+{
+	job_load_rec_t *recs = NULL;
+	job_load_args_t *args;
+	pthread_t *threads;
+	pthread_attr_t attr;
+	uint32_t rec_cnt = 0, rec_alloc = 0, rec_size, job_id, i;
+	int error_code = SLURM_SUCCESS, thread_cnt;
+	long cpu_cnt;
+	struct job_record *job_ptr;
+	DEF_TIMERS;
+
+	START_TIMER;
+	while (remaining_buf(buffer) > 0) {
+		if ((remaining_buf(buffer) < sizeof(uint32_t)) ||
+		    unpack32(&rec_size, buffer) ||
+		    (rec_size > remaining_buf(buffer))) {
+			/* Load the complete records */
+			error_code = SLURM_FAILURE;
+			break;
+		}
+		if (rec_cnt >= rec_alloc) {
+			rec_alloc += 1024;
+			xrealloc(recs, sizeof(job_load_rec_t) * rec_alloc);
+		}
+		recs[rec_cnt].offset = get_buf_offset(buffer);
+		recs[rec_cnt].size   = rec_size;
+		rec_cnt++;
+		set_buf_offset(buffer, get_buf_offset(buffer) + rec_size);
+	}
+
+	/* Create the job records in file order. Records with duplicate job
+	 * IDs or which can not be created are loaded afterwards. */
+	thread_cnt = MIN(JOB_LOAD_THREADS, rec_cnt / JOB_LOAD_MIN_RECS);
+	cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpu_cnt > 0)
+		thread_cnt = MIN(thread_cnt, cpu_cnt);
+	for (i = 0; i < rec_cnt; i++) {
+		if (thread_cnt < 2) {
+			recs[i].defer = true;
+			continue;
+		}
+		job_id = _job_load_rec_id(buffer, &recs[i]);
+		if ((job_id == 0) || find_job_record(job_id) ||
+		    ((job_ptr = create_job_record(&recs[i].rc)) == NULL)) {
+			recs[i].defer = true;
+			continue;
+		}
+		job_ptr->job_id = job_id;
+		_add_job_hash(job_ptr);
+	}
+
+	if (thread_cnt >= 2) {
+		args    = xmalloc(sizeof(job_load_args_t) * thread_cnt);
+		threads = xmalloc(sizeof(pthread_t) * thread_cnt);
+		job_load_parallel = true;
+		for (i = 0; i < thread_cnt; i++) {
+			args[i].data      = get_buf_data(buffer);
+			args[i].data_size = size_buf(buffer);
+			args[i].recs      = recs;
+			args[i].first_rec = (rec_cnt * i) / thread_cnt;
+			args[i].last_rec  = (rec_cnt * (i + 1)) / thread_cnt;
+			slurm_attr_init(&attr);
+			if (pthread_create(&threads[i], &attr,
+					   _load_job_thread, &args[i])) {
+				error("pthread_create error %m");
+				threads[i] = 0;
+				(void) _load_job_thread(&args[i]);
+			}
+			slurm_attr_destroy(&attr);
+		}
+		for (i = 0; i < thread_cnt; i++) {
+			if (threads[i])
+				pthread_join(threads[i], NULL);
+		}
+		job_load_parallel = false;
+		xfree(args);
+		xfree(threads);
+	}
+
+	for (i = 0; i < rec_cnt; i++) {
+		if (recs[i].defer) {
+			set_buf_offset(buffer, recs[i].offset);
+			recs[i].rc = _load_job_state(buffer,
+						     SLURM_PROTOCOL_VERSION);
+		} else if (recs[i].rc != SLURM_SUCCESS) {
+			/* Not purged by _load_job_state() in parallel */
+			error("Incomplete job record");
+			_purge_job_record(_job_load_rec_id(buffer, &recs[i]));
+		}
+		if (recs[i].rc == SLURM_SUCCESS)
+			(*job_cnt)++;
+	}
+	set_buf_offset(buffer, size_buf(buffer));
+	xfree(recs);
+	END_TIMER2("_load_job_records");
+	debug("Loaded %u job records using %d threads in %s",
+	      rec_cnt, MAX(thread_cnt, 1), TIME_STR);
+	return error_code;
+}
+
 /*
  * load_all_job_state - load the job state from file, recover from last
  *	checkpoint. Execute this after loading the configuration file data.
+ *	The job_state file is followed by the records of the job state
+ *	journal written after it.
  *	Changes here should be reflected in load_last_job_id().
  * RET 0 or error code
  */
@@ -561,7 +1121,7 @@ extern int load_all_job_state(void)
 {
 	int data_allocated, data_read = 0, error_code = SLURM_SUCCESS;
 	uint32_t data_size = 0;
-	int state_fd, job_cnt = 0;
+	int state_fd, job_cnt = 0, i;
 	char *data = NULL, *state_file;
 	Buf buffer;
 	time_t buf_time;
@@ -611,6 +1171,8 @@ extern int load_all_job_state(void)
 	if (ver_str) {
 		if (!strcmp(ver_str, JOB_STATE_VERSION)) {
 			protocol_version = SLURM_PROTOCOL_VERSION;
+		} else if (!strcmp(ver_str, JOB_2_3_STATE_VERSION)) {
+			protocol_version = SLURM_2_3_PROTOCOL_VERSION;
 		} else if (!strcmp(ver_str, JOB_2_2_STATE_VERSION)) {
 			protocol_version = SLURM_2_2_PROTOCOL_VERSION;
 		} else if (!strcmp(ver_str, JOB_2_1_STATE_VERSION)) {
@@ -633,15 +1195,28 @@ extern int load_all_job_state(void)
 	job_id_sequence = MAX(saved_job_id, job_id_sequence);
 	debug3("Job id in job_state header is %u", saved_job_id);
 
+	if (protocol_version == SLURM_PROTOCOL_VERSION) {
+		error_code = _load_job_records(buffer, &job_cnt);
+		if (error_code != SLURM_SUCCESS)
+			goto unpack_error;
+	}
 	while (remaining_buf(buffer) > 0) {
 		error_code = _load_job_state(buffer, protocol_version);
 		if (error_code != SLURM_SUCCESS)
 			goto unpack_error;
 		job_cnt++;
 	}
+	free_buf(buffer);
+
+	if (protocol_version == SLURM_PROTOCOL_VERSION) {
+		i = _read_job_journal(buf_time, false);
+		if (i) {
+			info("Recovered %d job state journal records", i);
+			job_cnt = list_count(job_list);
+		}
+	}
 	debug3("Set job_id_sequence to %u", job_id_sequence);
 
-	free_buf(buffer);
 	info("Recovered information about %d jobs", job_cnt);
 	return error_code;
 
@@ -724,6 +1299,7 @@ extern int load_last_job_id( void )
 	/* Ignore the state for individual jobs stored here */
 
 	free_buf(buffer);
+	(void) _read_job_journal(buf_time, true);
 	return error_code;
 
 unpack_error:
@@ -1033,8 +1609,11 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 			 * haven't been since all information will be
 			 * put in when the job is finished.
 			 */
-			if ((error_code = load_step_state(job_ptr, buffer,
-							  protocol_version)))
+			_job_load_lock();
+			error_code = load_step_state(job_ptr, buffer,
+						     protocol_version);
+			_job_load_unlock();
+			if (error_code)
 				goto unpack_error;
 			safe_unpack16(&step_flag, buffer);
 		}
@@ -1344,12 +1923,14 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 		goto unpack_error;
 	}
 
+	_job_load_lock();
 	if (priority > 1) {
 		highest_prio = MAX(highest_prio, priority);
 		lowest_prio  = MIN(lowest_prio,  priority);
 	}
 	if (job_id_sequence <= job_id)
 		job_id_sequence = job_id + 1;
+	_job_load_unlock();
 
 	xfree(job_ptr->account);
 	job_ptr->account = account;
@@ -1456,6 +2037,8 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	job_ptr->wait4switch     = wait4switch;
 
 	memset(&assoc_rec, 0, sizeof(slurmdb_association_rec_t));
+	_job_load_lock();
+	_add_job_index(job_ptr);
 
 	/*
 	 * For speed and accurracy we will first see if we once had an
@@ -1526,6 +2109,7 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 		}
 		job_ptr->qos_id = qos_rec.id;
 	}
+	_job_load_unlock();
 	build_node_details(job_ptr);	/* set node_addr */
 	return SLURM_SUCCESS;
 
@@ -1552,7 +2136,8 @@ unpack_error:
 	xfree(wckey);
 	select_g_select_jobinfo_free(select_jobinfo);
 	checkpoint_free_jobinfo(check_job);
-	if (job_ptr) {
+	/* With parallel loading, _load_job_records() purges the job */
+	if (job_ptr && !job_load_parallel) {
 		if (job_ptr->job_id == 0)
 			job_ptr->job_id = NO_VAL;
 		_purge_job_record(job_ptr->job_id);
@@ -1611,6 +2196,8 @@ void _dump_job_details(struct job_details *detail_ptr, Buf buffer)
 	packstr(detail_ptr->work_dir,  buffer);
 	packstr(detail_ptr->ckpt_dir,  buffer);
 	packstr(detail_ptr->restart_dir, buffer);
+	packstr(detail_ptr->env_key, buffer);
+	packstr(detail_ptr->script_key, buffer);
 
 	pack_multi_core_data(detail_ptr->mc_ptr, buffer,
 			     SLURM_PROTOCOL_VERSION);
@@ -1626,6 +2213,7 @@ static int _load_job_details(struct job_record *job_ptr, Buf buffer,
 	char *cpu_bind, *dependency = NULL, *orig_dependency = NULL, *mem_bind;
 	char *err = NULL, *in = NULL, *out = NULL, *work_dir = NULL;
 	char *ckpt_dir = NULL, *restart_dir = NULL;
+	char *env_key = NULL, *script_key = NULL;
 	char **argv = (char **) NULL, **env_sup = (char **) NULL;
 	uint32_t min_nodes, max_nodes;
 	uint32_t min_cpus = 1, max_cpus = NO_VAL;
@@ -1684,6 +2272,10 @@ static int _load_job_details(struct job_record *job_ptr, Buf buffer,
 		safe_unpackstr_xmalloc(&work_dir, &name_len, buffer);
 		safe_unpackstr_xmalloc(&ckpt_dir, &name_len, buffer);
 		safe_unpackstr_xmalloc(&restart_dir, &name_len, buffer);
+		if (protocol_version >= SLURM_2_4_PROTOCOL_VERSION) {
+			safe_unpackstr_xmalloc(&env_key, &name_len, buffer);
+			safe_unpackstr_xmalloc(&script_key, &name_len, buffer);
+		}
 
 		if (unpack_multi_core_data(&mc_ptr, buffer, protocol_version))
 			goto unpack_error;
@@ -1824,6 +2416,10 @@ static int _load_job_details(struct job_record *job_ptr, Buf buffer,
 	xfree(job_ptr->details->work_dir);
 	xfree(job_ptr->details->ckpt_dir);
 	xfree(job_ptr->details->restart_dir);
+	/* batch store references are counted by sync_job_files() once all
+	 * state is loaded */
+	xfree(job_ptr->details->env_key);
+	xfree(job_ptr->details->script_key);
 
 	/* now put the details into the job record */
 	job_ptr->details->acctg_freq = acctg_freq;
@@ -1868,6 +2464,8 @@ static int _load_job_details(struct job_record *job_ptr, Buf buffer,
 	job_ptr->details->work_dir = work_dir;
 	job_ptr->details->ckpt_dir = ckpt_dir;
 	job_ptr->details->restart_dir = restart_dir;
+	job_ptr->details->env_key = env_key;
+	job_ptr->details->script_key = script_key;
 
 	return SLURM_SUCCESS;
 
@@ -1892,6 +2490,8 @@ unpack_error:
 	xfree(work_dir);
 	xfree(ckpt_dir);
 	xfree(restart_dir);
+	xfree(env_key);
+	xfree(script_key);
 	return SLURM_FAILURE;
 }
 
@@ -1904,9 +2504,149 @@ void _add_job_hash(struct job_record *job_ptr)
 {
 	int inx;
 
+	if (job_hash_old)
+		_job_hash_move(JOB_HASH_MOVE_CNT);
+	else if (job_hash_cnt >= hash_table_size)
+		_job_hash_grow();
+
 	inx = JOB_HASH_INX(job_ptr->job_id);
 	job_ptr->job_next = job_hash[inx];
 	job_hash[inx] = job_ptr;
+	job_hash_cnt++;
+}
+
+/* _remove_job_hash - remove a job record from the job hash table
+ * IN job_entry - pointer to job record
+ * Globals: hash table updated
+ */
+static void _remove_job_hash(struct job_record *job_entry)
+{
+	struct job_record *job_ptr, **job_pptr;
+
+	job_pptr = &job_hash[JOB_HASH_INX(job_entry->job_id)];
+	while (((job_ptr = *job_pptr) != NULL) && (job_ptr != job_entry))
+		job_pptr = &job_ptr->job_next;
+	if ((job_ptr == NULL) && job_hash_old) {
+		job_pptr = &job_hash_old[JOB_HASH_OLD_INX(job_entry->job_id)];
+		while (((job_ptr = *job_pptr) != NULL) &&
+		       (job_ptr != job_entry))
+			job_pptr = &job_ptr->job_next;
+	}
+	if (job_ptr == NULL)
+		fatal("job hash error");
+	*job_pptr = job_entry->job_next;
+	job_entry->job_next = NULL;
+	job_hash_cnt--;
+
+	if (job_hash_old)
+		_job_hash_move(JOB_HASH_MOVE_CNT);
+}
+
+/* Double the size of the job hash table. The records are moved into the
+ * new table by subsequent calls to _job_hash_move(). */
+static void _job_hash_grow(void)
+{
+	if (job_hash_old)	/* finish moving the previous table */
+		_job_hash_move(hash_table_size_old);
+
+	job_hash_old = job_hash;
+	hash_table_size_old = hash_table_size;
+	job_hash_move_inx = 0;
+	hash_table_size *= 2;
+	job_hash = xmalloc(hash_table_size * sizeof(struct job_record *));
+	debug("Job hash table size increased to %u", hash_table_size);
+}
+
+/* Move up to chain_cnt chains of the old job hash table into the current
+ * one, the old table is freed once empty */
+static void _job_hash_move(uint32_t chain_cnt)
+{
+	struct job_record *job_ptr, *next_ptr;
+	int inx;
+
+	while (job_hash_old && chain_cnt--) {
+		job_ptr = job_hash_old[job_hash_move_inx];
+		job_hash_old[job_hash_move_inx] = NULL;
+		while (job_ptr) {
+			next_ptr = job_ptr->job_next;
+			inx = JOB_HASH_INX(job_ptr->job_id);
+			job_ptr->job_next = job_hash[inx];
+			job_hash[inx] = job_ptr;
+			job_ptr = next_ptr;
+		}
+		if (++job_hash_move_inx >= hash_table_size_old) {
+			xfree(job_hash_old);
+			hash_table_size_old = 0;
+			job_hash_move_inx = 0;
+		}
+	}
+}
+
+static uint32_t _job_name_hash_inx(char *name)
+{
+	uint32_t hash = 5381;
+
+	while (*name)
+		hash = (hash * 33) ^ (unsigned char) *name++;
+	return hash % JOB_NAME_HASH_SIZE;
+}
+
+/* _add_job_index - add a job record to the user and name indexes, must be
+ *	called again whenever the job's name changes
+ * IN job_ptr - pointer to job record, user_id and name must be set
+ */
+static void _add_job_index(struct job_record *job_ptr)
+{
+	struct job_record **head;
+
+	_remove_job_index(job_ptr);
+	if (job_user_hash == NULL) {
+		job_user_hash = xmalloc(JOB_USER_HASH_SIZE *
+					sizeof(struct job_record *));
+		job_name_hash = xmalloc(JOB_NAME_HASH_SIZE *
+					sizeof(struct job_record *));
+	}
+
+	head = &job_user_hash[JOB_USER_HASH_INX(job_ptr->user_id)];
+	job_ptr->job_next_user = *head;
+	if (*head)
+		(*head)->job_pprev_user = &job_ptr->job_next_user;
+	*head = job_ptr;
+	job_ptr->job_pprev_user = head;
+
+	if (job_ptr->name == NULL)
+		return;
+	head = &job_name_hash[_job_name_hash_inx(job_ptr->name)];
+	job_ptr->job_next_name = *head;
+	if (*head)
+		(*head)->job_pprev_name = &job_ptr->job_next_name;
+	*head = job_ptr;
+	job_ptr->job_pprev_name = head;
+}
+
+/* _remove_job_index - remove a job record from the user and name indexes
+ * IN job_ptr - pointer to job record
+ */
+static void _remove_job_index(struct job_record *job_ptr)
+{
+	if (job_ptr->job_pprev_user) {
+		*job_ptr->job_pprev_user = job_ptr->job_next_user;
+		if (job_ptr->job_next_user) {
+			job_ptr->job_next_user->job_pprev_user =
+				job_ptr->job_pprev_user;
+		}
+		job_ptr->job_next_user  = NULL;
+		job_ptr->job_pprev_user = NULL;
+	}
+	if (job_ptr->job_pprev_name) {
+		*job_ptr->job_pprev_name = job_ptr->job_next_name;
+		if (job_ptr->job_next_name) {
+			job_ptr->job_next_name->job_pprev_name =
+				job_ptr->job_pprev_name;
+		}
+		job_ptr->job_next_name  = NULL;
+		job_ptr->job_pprev_name = NULL;
+	}
 }
 
 /*
@@ -1927,6 +2667,15 @@ struct job_record *find_job_record(uint32_t job_id)
 		job_ptr = job_ptr->job_next;
 	}
 
+	if (job_hash_old) {	/* not yet moved to job_hash */
+		job_ptr = job_hash_old[JOB_HASH_OLD_INX(job_id)];
+		while (job_ptr) {
+			if (job_ptr->job_id == job_id)
+				return job_ptr;
+			job_ptr = job_ptr->job_next;
+		}
+	}
+
 	return NULL;
 }
 
@@ -2013,6 +2762,7 @@ extern int kill_job_by_part_name(char *part_name)
 				} else {
 					FREE_NULL_LIST(job_ptr->part_ptr_list);
 				}
+				add_job_to_queue(job_ptr);
 			}
 		}
 
@@ -2173,6 +2923,7 @@ extern int kill_job_by_front_end_name(char *node_name)
 				job_ptr->job_state = JOB_PENDING;
 				if (job_ptr->node_cnt)
 					job_ptr->job_state |= JOB_COMPLETING;
+				add_job_to_queue(job_ptr);
 				job_ptr->details->submit_time = now;
 
 				/* restart from periodic checkpoint */
@@ -2406,6 +3157,7 @@ extern int kill_running_job_by_node_name(char *node_name)
 				job_ptr->job_state = JOB_PENDING;
 				if (job_ptr->node_cnt)
 					job_ptr->job_state |= JOB_COMPLETING;
+				add_job_to_queue(job_ptr);
 				job_ptr->details->submit_time = now;
 
 				/* restart from periodic checkpoint */
@@ -2706,22 +3458,16 @@ int init_job_conf(void)
 }
 
 /*
- * rehash_jobs - Create or rebuild the job hash table.
+ * rehash_jobs - Create the job hash table. It grows as needed afterwards,
+ *	so MaxJobCount may be changed freely.
  * NOTE: run lock_slurmctld before entry: Read config, write job
  */
 extern void rehash_jobs(void)
 {
 	if (job_hash == NULL) {
-		hash_table_size = slurmctld_conf.max_job_cnt;
+		hash_table_size = JOB_HASH_MIN_SIZE;
 		job_hash = (struct job_record **)
 			xmalloc(hash_table_size * sizeof(struct job_record *));
-	} else if (hash_table_size < (slurmctld_conf.max_job_cnt / 2)) {
-		/* If the MaxJobCount grows by too much, the hash table will
-		 * be ineffective without rebuilding. We don't presently bother
-		 * to rebuild the hash table, but cut MaxJobCount back as
-		 * needed. */
-		error ("MaxJobCount reset too high, restart slurmctld");
-		slurmctld_conf.max_job_cnt = hash_table_size;
 	}
 }
 
@@ -2758,6 +3504,9 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 	*job_pptr = job_ptr;
 	time_t now = time(NULL);
 
+	if (job_ptr)
+		add_job_to_queue(job_ptr);
+
 	if (error_code) {
 		if (job_ptr && (immediate || will_run)) {
 			/* this should never really happen here */
@@ -3212,6 +3961,7 @@ extern int job_complete(uint32_t job_id, uid_t uid, bool requeue,
 		job_ptr->batch_flag++;	/* only one retry */
 		job_ptr->restart_cnt++;
 		job_ptr->job_state = JOB_PENDING | job_comp_flag;
+		add_job_to_queue(job_ptr);
 		/* Since the job completion logger removes the job submit
 		 * information, we need to add it again. */
 		acct_policy_add_job_submit(job_ptr);
@@ -3996,11 +4746,9 @@ static int _job_create(job_desc_msg_t * job_desc, int allocate, int will_run,
 
 	if (job_desc->script
 	    &&  (!will_run)) {	/* don't bother with copy if just a test */
-		if ((error_code = _copy_job_desc_to_file(job_desc,
-							 job_ptr->job_id))) {
-			error_code = ESLURM_WRITING_TO_FILE;
+		if ((error_code = _copy_job_desc_to_store(job_desc,
+							  job_ptr)))
 			goto cleanup_fail;
-		}
 		job_ptr->batch_flag = 1;
 	} else
 		job_ptr->batch_flag = 0;
@@ -4101,130 +4849,67 @@ static int _validate_job_create_req(job_desc_msg_t * job_desc)
 	return SLURM_SUCCESS;
 }
 
-/* _copy_job_desc_to_file - copy the job script and environment from the RPC
- *	structure into a file */
+/* _copy_job_desc_to_store - record the job script and environment from the
+ *	RPC structure in the batch store. Identical scripts and environments
+ *	are shared between jobs and the files are written later by the
+ *	state save thread, so this does no file I/O.
+ * RET 0 or ESLURM_WRITING_TO_FILE if the store's last write failed */
 static int
-_copy_job_desc_to_file(job_desc_msg_t * job_desc, uint32_t job_id)
+_copy_job_desc_to_store(job_desc_msg_t * job_desc, struct job_record *job_ptr)
 {
-	int error_code = 0;
-	char *dir_name, job_dir[20], *file_name;
+	struct job_details *detail_ptr = job_ptr->details;
+	char *env_buf;
+	uint32_t env_size;
 	DEF_TIMERS;
 
-	START_TIMER;
-	/* Create state_save_location directory */
-	dir_name = slurm_get_state_save_location();
-
-	/* Create job_id specific directory */
-	sprintf(job_dir, "/job.%u", job_id);
-	xstrcat(dir_name, job_dir);
-	if (mkdir(dir_name, 0700)) {
-		error("mkdir(%s) error %m", dir_name);
-		xfree(dir_name);
+	if (batch_store_write_status() != SLURM_SUCCESS)
 		return ESLURM_WRITING_TO_FILE;
-	}
 
-	/* Create environment file, and write data to it */
-	file_name = xstrdup(dir_name);
-	xstrcat(file_name, "/environment");
-	error_code = _write_data_array_to_file(file_name,
-					       job_desc->environment,
-					       job_desc->env_size);
-	xfree(file_name);
-
-	if (error_code == 0) {
-		/* Create script file */
-		file_name = xstrdup(dir_name);
-		xstrcat(file_name, "/script");
-		error_code = _write_data_to_file(file_name, job_desc->script);
-		xfree(file_name);
-	}
-
-	xfree(dir_name);
-	END_TIMER2("_copy_job_desc_to_file");
-	return error_code;
+	START_TIMER;
+	env_buf = _pack_data_array(job_desc->environment, job_desc->env_size,
+				   &env_size);
+	xfree(detail_ptr->env_key);
+	detail_ptr->env_key = batch_store_add("env", job_ptr->user_id,
+					      env_buf, env_size);
+	xfree(env_buf);
+
+	xfree(detail_ptr->script_key);
+	detail_ptr->script_key = batch_store_add("script", job_ptr->user_id,
+						 job_desc->script,
+						 strlen(job_desc->script) + 1);
+	END_TIMER2("_copy_job_desc_to_store");
+	return SLURM_SUCCESS;
 }
 
 /*
- * Create file with specified name and write the supplied data array to it
- * IN file_name - file to create and write to
+ * Serialize an array of strings into a single buffer: a uint32_t element
+ *	count followed by each string including its terminating NUL
  * IN data - array of pointers to strings (e.g. env)
  * IN size - number of elements in data
+ * OUT buf_size - size of the returned buffer
+ * RET buffer, must be xfreed when no longer needed
  */
-static int
-_write_data_array_to_file(char *file_name, char **data, uint32_t size)
+static char *_pack_data_array(char **data, uint32_t size, uint32_t *buf_size)
 {
-	int fd, i, pos, nwrite, amount;
-
-	fd = creat(file_name, 0600);
-	if (fd < 0) {
-		error("Error creating file %s, %m", file_name);
-		return ESLURM_WRITING_TO_FILE;
-	}
-
-	amount = write(fd, &size, sizeof(uint32_t));
-	if (amount < sizeof(uint32_t)) {
-		error("Error writing file %s, %m", file_name);
-		close(fd);
-		return ESLURM_WRITING_TO_FILE;
-	}
+	char *buffer;
+	uint32_t i, len, pos;
 
 	if (data == NULL)
-		return SLURM_SUCCESS;
-
+		size = 0;
+	pos = sizeof(uint32_t);
+	for (i = 0; i < size; i++)
+		pos += strlen(data[i]) + 1;
+	buffer = xmalloc(pos);
+	memcpy(buffer, &size, sizeof(uint32_t));
+
+	pos = sizeof(uint32_t);
 	for (i = 0; i < size; i++) {
-		nwrite = strlen(data[i]) + 1;
-		pos = 0;
-		while (nwrite > 0) {
-			amount = write(fd, &data[i][pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m",
-				      file_name);
-				close(fd);
-				return ESLURM_WRITING_TO_FILE;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
-	}
-
-	close(fd);
-	return SLURM_SUCCESS;
-}
-
-/*
- * Create file with specified name and write the supplied data array to it
- * IN file_name - file to create and write to
- * IN data - pointer to string
- */
-static int _write_data_to_file(char *file_name, char *data)
-{
-	int fd, pos, nwrite, amount;
-
-	if (data == NULL) {
-		(void) unlink(file_name);
-		return SLURM_SUCCESS;
+		len = strlen(data[i]) + 1;
+		memcpy(&buffer[pos], data[i], len);
+		pos += len;
 	}
-
-	fd = creat(file_name, 0700);
-	if (fd < 0) {
-		error("Error creating file %s, %m", file_name);
-		return ESLURM_WRITING_TO_FILE;
-	}
-
-	nwrite = strlen(data) + 1;
-	pos = 0;
-	while (nwrite > 0) {
-		amount = write(fd, &data[pos], nwrite);
-		if ((amount < 0) && (errno != EINTR)) {
-			error("Error writing file %s, %m", file_name);
-			close(fd);
-			return ESLURM_WRITING_TO_FILE;
-		}
-		nwrite -= amount;
-		pos    += amount;
-	}
-	close(fd);
-	return SLURM_SUCCESS;
+	*buf_size = pos;
+	return buffer;
 }
 
 /*
@@ -4236,15 +4921,9 @@ static int _write_data_to_file(char *file_name, char *data)
  */
 char **get_job_env(struct job_record *job_ptr, uint32_t * env_size)
 {
-	char job_dir[30], *file_name, **environment = NULL;
-
-	file_name = slurm_get_state_save_location();
-	sprintf(job_dir, "/job.%d/environment", job_ptr->job_id);
-	xstrcat(file_name, job_dir);
-
-	_read_data_array_from_file(file_name, &environment, env_size, job_ptr);
+	char **environment = NULL;
 
-	xfree(file_name);
+	_read_data_array_from_store(&environment, env_size, job_ptr);
 	return environment;
 }
 
@@ -4256,24 +4935,20 @@ char **get_job_env(struct job_record *job_ptr, uint32_t * env_size)
 char *get_job_script(struct job_record *job_ptr)
 {
 	char *script = NULL;
+	uint32_t size;
 
-	if (job_ptr->batch_flag) {
-		char *file_name = slurm_get_state_save_location();
-		char job_dir[30];
-
-		sprintf(job_dir, "/job.%d/script", job_ptr->job_id);
-		xstrcat(file_name, job_dir);
-
-		_read_data_from_file(file_name, &script);
+	if (!job_ptr->batch_flag)
+		return NULL;
 
-		xfree(file_name);
-	}
+	if (job_ptr->details && job_ptr->details->script_key)
+		script = batch_store_read(job_ptr->details->script_key, &size);
+	else
+		error("No script recorded for batch job %u", job_ptr->job_id);
 	return script;
 }
 
 /*
- * Read a collection of strings from a file
- * IN file_name - file to read from
+ * Read a job's environment from the batch store
  * OUT data - pointer to array of pointers to strings (e.g. env),
  *	must be xfreed when no longer needed
  * OUT size - number of elements in data
@@ -4281,59 +4956,43 @@ char *get_job_script(struct job_record *job_ptr)
  * NOTE: The output format of this must be identical with _xduparray2()
  */
 static void
-_read_data_array_from_file(char *file_name, char ***data, uint32_t * size,
-			   struct job_record *job_ptr)
+_read_data_array_from_store(char ***data, uint32_t * size,
+			    struct job_record *job_ptr)
 {
-	int fd, pos, buf_size, amount, i, j;
+	int pos, buf_size, i, j;
 	char *buffer, **array_ptr;
-	uint32_t rec_cnt;
+	uint32_t rec_cnt, data_size;
 
-	xassert(file_name);
 	xassert(data);
 	xassert(size);
 	*data = NULL;
 	*size = 0;
 
-	fd = open(file_name, 0);
-	if (fd < 0) {
-		error("Error opening file %s, %m", file_name);
+	if (!job_ptr->details || !job_ptr->details->env_key) {
+		error("No environment recorded for job %u", job_ptr->job_id);
 		return;
 	}
-
-	amount = read(fd, &rec_cnt, sizeof(uint32_t));
-	if (amount < sizeof(uint32_t)) {
-		if (amount != 0)	/* incomplete write */
-			error("Error reading file %s, %m", file_name);
-		else
-			verbose("File %s has zero size", file_name);
-		close(fd);
+	buffer = batch_store_read(job_ptr->details->env_key, &data_size);
+	if (buffer == NULL)
+		return;
+	if (data_size < sizeof(uint32_t)) {
+		error("Bad environment %s for job %u",
+		      job_ptr->details->env_key, job_ptr->job_id);
+		xfree(buffer);
 		return;
 	}
 
+	memcpy(&rec_cnt, buffer, sizeof(uint32_t));
 	if (rec_cnt == 0) {
-		*data = NULL;
-		*size = 0;
+		xfree(buffer);
 		return;
 	}
 
-	pos = 0;
-	buf_size = BUF_SIZE;
-	buffer = xmalloc(buf_size);
-	while (1) {
-		amount = read(fd, &buffer[pos], BUF_SIZE);
-		if (amount < 0) {
-			error("Error reading file %s, %m", file_name);
-			xfree(buffer);
-			close(fd);
-			return;
-		}
-		pos += amount;
-		if (amount < BUF_SIZE)	/* end of file */
-			break;
-		buf_size += amount;
-		xrealloc(buffer, buf_size);
-	}
-	close(fd);
+	/* Drop the record count so the strings start at the beginning of
+	 * the buffer, which is freed through the first array element */
+	buf_size = data_size - sizeof(uint32_t);
+	memmove(buffer, buffer + sizeof(uint32_t), buf_size);
+	pos = buf_size;
 
 	/* Allocate extra space for supplemental environment variables
 	 * as set by Moab */
@@ -4350,7 +5009,8 @@ _read_data_array_from_file(char *file_name, char ***data, uint32_t * size,
 		array_ptr[i] = &buffer[pos];
 		pos += strlen(&buffer[pos]) + 1;
 		if ((pos > buf_size) && ((i + 1) < rec_cnt)) {
-			error("Bad environment file %s", file_name);
+			error("Bad environment %s for job %u",
+			      job_ptr->details->env_key, job_ptr->job_id);
 			rec_cnt = i;
 			break;
 		}
@@ -4398,50 +5058,6 @@ _read_data_array_from_file(char *file_name, char ***data, uint32_t * size,
 	return;
 }
 
-/*
- * Read a string from a file
- * IN file_name - file to read from
- * OUT data - pointer to  string
- *	must be xfreed when no longer needed
- */
-void _read_data_from_file(char *file_name, char **data)
-{
-	int fd, pos, buf_size, amount;
-	char *buffer;
-
-	xassert(file_name);
-	xassert(data);
-	*data = NULL;
-
-	fd = open(file_name, 0);
-	if (fd < 0) {
-		error("Error opening file %s, %m", file_name);
-		return;
-	}
-
-	pos = 0;
-	buf_size = BUF_SIZE;
-	buffer = xmalloc(buf_size);
-	while (1) {
-		amount = read(fd, &buffer[pos], BUF_SIZE);
-		if (amount < 0) {
-			error("Error reading file %s, %m", file_name);
-			xfree(buffer);
-			close(fd);
-			return;
-		}
-		if (amount < BUF_SIZE)	/* end of file */
-			break;
-		pos += amount;
-		buf_size += amount;
-		xrealloc(buffer, buf_size);
-	}
-
-	*data = buffer;
-	close(fd);
-	return;
-}
-
 /* Given a job request, return a multi_core_data struct.
  * Returns NULL if no values set in the job/step request */
 static multi_core_data_t *
@@ -4557,6 +5173,7 @@ _copy_job_desc_to_job_record(job_desc_msg_t * job_desc,
 	_add_job_hash(job_ptr);
 
 	job_ptr->user_id    = (uid_t) job_desc->user_id;
+	_add_job_index(job_ptr);
 	job_ptr->group_id   = (gid_t) job_desc->group_id;
 	job_ptr->job_state  = JOB_PENDING;
 	job_ptr->time_limit = job_desc->time_limit;
@@ -5205,23 +5822,18 @@ static int _validate_job_desc(job_desc_msg_t * job_desc_msg, int allocate,
 static void _list_delete_job(void *job_entry)
 {
 	struct job_record *job_ptr = (struct job_record *) job_entry;
-	struct job_record **job_pptr;
 	int i;
 
 	xassert(job_entry);
 	xassert (job_ptr->magic == JOB_MAGIC);
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
 
-	/* Remove the record from the hash table */
-	job_pptr = &job_hash[JOB_HASH_INX(job_ptr->job_id)];
-	while ((job_pptr != NULL) &&
-	       ((job_ptr = *job_pptr) != (struct job_record *) job_entry)) {
-		job_pptr = &job_ptr->job_next;
-	}
-	if (job_pptr == NULL)
-		fatal("job hash error");
-	*job_pptr = job_ptr->job_next;
+	/* Remove the record from the hash table and indexes */
+	_remove_job_hash(job_ptr);
+	_remove_job_index(job_ptr);
 
+	notify_job_dependents(job_ptr);	/* dependency is gone */
+	xfree(job_ptr->dependent_ids);
 	delete_job_details(job_ptr);
 	xfree(job_ptr->account);
 	xfree(job_ptr->alloc_node);
@@ -5318,6 +5930,413 @@ static int _list_find_job_old(void *job_entry, void *key)
 }
 
 
+/* Free the contents of a job pack cache slot */
+static void _job_pack_cache_clear(job_pack_cache_t *cache)
+{
+	int i;
+
+	if (cache->buffer)
+		free_buf(cache->buffer);
+	for (i = 0; i < cache->rec_cnt; i++)
+		xfree(cache->recs[i].account);
+	xfree(cache->recs);
+	xfree(cache->del_job_id);
+	xfree(cache->del_time);
+	memset(cache, 0, sizeof(job_pack_cache_t));
+}
+
+/* Test if a job pack cache slot reflects the current job and partition
+ * state. A slot built in the same second as the latest update may have
+ * missed later updates made in that second, so it is never valid. */
+static bool _job_pack_cache_valid(job_pack_cache_t *cache, time_t now)
+{
+	if (cache->build_time == 0)
+		return false;
+	/* Read without the job lock. An update in progress has not yet
+	 * changed last_job_update and this response predates it. */
+	if ((cache->last_job_update != last_job_update) ||
+	    (cache->last_job_update >= cache->build_time))
+		return false;
+	if ((cache->last_part_update != last_part_update) ||
+	    (cache->last_part_update >= cache->build_time))
+		return false;
+	if (cache->expire_time && (now >= cache->expire_time))
+		return false;
+	return true;
+}
+
+/*
+ * Find the job pack cache slot for a request.
+ * IN valid_only - if set return NULL unless the slot is current, otherwise
+ *	return the matching slot or the least recently used one for reuse
+ * Call with job_pack_cache_mutex locked.
+ */
+static job_pack_cache_t *_job_pack_cache_find(uint16_t show_flags,
+					      uint16_t protocol_version,
+					      time_t now, bool valid_only)
+{
+	job_pack_cache_t *cache, *lru_cache = NULL;
+	int i;
+
+	for (i = 0; i < JOB_PACK_CACHE_CNT; i++) {
+		cache = &job_pack_cache[i];
+		if (cache->build_time &&
+		    (cache->show_flags == show_flags) &&
+		    (cache->protocol_version == protocol_version)) {
+			if (valid_only && !_job_pack_cache_valid(cache, now))
+				return NULL;
+			cache->last_used = now;
+			return cache;
+		}
+		if ((lru_cache == NULL) ||
+		    (cache->last_used < lru_cache->last_used))
+			lru_cache = cache;
+	}
+	if (valid_only)
+		return NULL;
+
+	_job_pack_cache_clear(lru_cache);
+	lru_cache->show_flags = show_flags;
+	lru_cache->protocol_version = protocol_version;
+	lru_cache->last_used = now;
+	return lru_cache;
+}
+
+/*
+ * Find a job pack cache slot for a request which may be answered with
+ * records packed before the latest job changes, as they were when the
+ * slot was built. The slot's partition pointers must still be valid and
+ * the client must not already have newer data.
+ * Call with job_pack_cache_mutex locked plus partition read lock.
+ */
+static job_pack_cache_t *_job_pack_cache_snapshot(uint16_t show_flags,
+						  uint16_t protocol_version,
+						  time_t now,
+						  time_t update_time)
+{
+	job_pack_cache_t *cache;
+	int i;
+
+	for (i = 0; i < JOB_PACK_CACHE_CNT; i++) {
+		cache = &job_pack_cache[i];
+		if ((cache->build_time == 0) ||
+		    (cache->show_flags != show_flags) ||
+		    (cache->protocol_version != protocol_version))
+			continue;
+		if ((cache->last_part_update != last_part_update) ||
+		    (update_time >= cache->build_time))
+			return NULL;
+		cache->last_used = now;
+		return cache;
+	}
+	return NULL;
+}
+
+static int _job_pack_rec_cmp(const void *a, const void *b)
+{
+	uint32_t job_id_a = ((job_pack_rec_t *) a)->job_id;
+	uint32_t job_id_b = ((job_pack_rec_t *) b)->job_id;
+
+	if (job_id_a < job_id_b)
+		return -1;
+	return (job_id_a > job_id_b);
+}
+
+/* Record the removal of a job for SHOW_DELTA requests and forget removals
+ * older than JOB_PACK_DELTA_TIME */
+static void _job_pack_cache_del(job_pack_cache_t *cache, uint32_t job_id,
+				time_t now)
+{
+	time_t cutoff = now - JOB_PACK_DELTA_TIME;
+	uint32_t i;
+
+	if (job_id) {
+		xrealloc(cache->del_job_id,
+			 sizeof(uint32_t) * (cache->del_cnt + 1));
+		xrealloc(cache->del_time, sizeof(time_t) * (cache->del_cnt + 1));
+		cache->del_job_id[cache->del_cnt] = job_id;
+		cache->del_time[cache->del_cnt++] = now;
+	}
+
+	for (i = 0; i < cache->del_cnt; i++) {
+		if (cache->del_time[i] >= cutoff)
+			break;
+	}
+	if (i == 0)
+		return;
+	cache->del_cnt -= i;
+	memmove(cache->del_job_id, cache->del_job_id + i,
+		sizeof(uint32_t) * cache->del_cnt);
+	memmove(cache->del_time, cache->del_time + i,
+		sizeof(time_t) * cache->del_cnt);
+	cache->delta_start = MAX(cache->delta_start, cutoff);
+}
+
+/*
+ * Pack every job record into a cache slot without user filtering. Records
+ * identical to those of the previous build keep their change time, jobs no
+ * longer present are recorded as removed.
+ * Call with job_pack_cache_mutex locked plus job and partition read locks.
+ */
+static void _job_pack_cache_build(job_pack_cache_t *cache, time_t now)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+	job_pack_rec_t *rec, *old_rec, *old_recs = cache->recs;
+	Buf old_buffer = cache->buffer;
+	uint32_t old_cnt = cache->rec_cnt, offset;
+	bool *old_found;
+	time_t begin_time;
+	int rec_size;
+	DEF_TIMERS;
+
+	START_TIMER;
+	if (old_cnt)
+		qsort(old_recs, old_cnt, sizeof(job_pack_rec_t),
+		      _job_pack_rec_cmp);
+	old_found = xmalloc(sizeof(bool) * MAX(old_cnt, 1));
+	if (old_buffer)
+		cache->buffer = init_buf(size_buf(old_buffer));
+	else
+		cache->buffer = init_buf(BUF_SIZE);
+	rec_size = list_count(job_list);
+	cache->recs = xmalloc(sizeof(job_pack_rec_t) * MAX(rec_size, 1));
+	cache->rec_cnt = 0;
+	cache->expire_time = 0;
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		xassert (job_ptr->magic == JOB_MAGIC);
+		if (cache->rec_cnt >= rec_size)
+			break;
+
+		offset = get_buf_offset(cache->buffer);
+		pack_job(job_ptr, cache->show_flags, cache->buffer,
+			 cache->protocol_version, (uid_t) 0);
+		rec = &cache->recs[cache->rec_cnt++];
+		rec->job_id   = job_ptr->job_id;
+		rec->offset   = offset;
+		rec->size     = get_buf_offset(cache->buffer) - offset;
+		rec->user_id  = job_ptr->user_id;
+		rec->account  = xstrdup(job_ptr->account);
+		rec->part_ptr = job_ptr->part_ptr;
+		if (!IS_JOB_COMPLETING(job_ptr) && IS_JOB_FINISHED(job_ptr))
+			rec->purge_time = job_ptr->end_time;
+		else
+			rec->purge_time = 0;
+
+		rec->change_time = now;
+		old_rec = NULL;
+		if (old_cnt) {
+			old_rec = bsearch(rec, old_recs, old_cnt,
+					  sizeof(job_pack_rec_t),
+					  _job_pack_rec_cmp);
+		}
+		if (old_rec) {
+			old_found[old_rec - old_recs] = true;
+			if ((old_rec->size == rec->size) &&
+			    !memcmp(get_buf_data(old_buffer) + old_rec->offset,
+				    get_buf_data(cache->buffer) + rec->offset,
+				    rec->size))
+				rec->change_time = old_rec->change_time;
+		}
+
+		/* pack_job() reports the begin time as the expected start
+		 * time of a pending job until the begin time is reached */
+		if (job_ptr->details && (job_ptr->start_time == 0)) {
+			begin_time = job_ptr->details->begin_time;
+			if ((begin_time > now) &&
+			    ((cache->expire_time == 0) ||
+			     (begin_time < cache->expire_time)))
+				cache->expire_time = begin_time;
+		}
+	}
+	list_iterator_destroy(job_iterator);
+
+	for (offset = 0; offset < old_cnt; offset++) {
+		if (!old_found[offset])
+			_job_pack_cache_del(cache, old_recs[offset].job_id, now);
+		xfree(old_recs[offset].account);
+	}
+	_job_pack_cache_del(cache, 0, now);
+	xfree(old_found);
+	xfree(old_recs);
+	if (old_buffer)
+		free_buf(old_buffer);
+	if (cache->delta_start == 0)
+		cache->delta_start = now;
+
+	cache->build_time = now;
+	cache->last_job_update = last_job_update;
+	cache->last_part_update = last_part_update;
+	END_TIMER2("_job_pack_cache_build");
+	debug3("_job_pack_cache_build: packed %u jobs, size=%u %s",
+	       cache->rec_cnt, get_buf_offset(cache->buffer), TIME_STR);
+}
+
+/*
+ * Build a REQUEST_JOB_INFO response from a job pack cache slot, filtering
+ * the records visible to the requesting user.
+ * IN resp_time - time the response describes, the slot's build time if it
+ *	is a snapshot predating the latest job changes
+ * IN delta - if set build a RESPONSE_JOB_INFO_DELTA message with records
+ *	changed since update_time, otherwise a RESPONSE_JOB_INFO message
+ * Call with job_pack_cache_mutex locked plus config and partition read
+ * locks. The job lock is not needed.
+ */
+static void _job_pack_cache_copy(job_pack_cache_t *cache, char **buffer_ptr,
+				 int *buffer_size, uid_t uid, time_t now,
+				 time_t resp_time, bool delta,
+				 time_t update_time)
+{
+	job_pack_rec_t *rec;
+	uint32_t jobs_packed = 0, count_offset, tmp_offset;
+	uint32_t *del_job_id = NULL, del_cnt = 0;
+	time_t min_age = 0;
+	bool private_data, is_operator, full = true;
+	Buf buffer;
+	int i;
+
+	if (slurmctld_conf.min_job_age > 0)
+		min_age = now  - slurmctld_conf.min_job_age;
+	private_data = (slurmctld_conf.private_data & PRIVATE_DATA_JOBS);
+	is_operator = validate_operator(uid);
+
+	buffer = init_buf(get_buf_offset(cache->buffer) + 64);
+	if (delta) {
+		/* Partition changes alter which jobs the user may see */
+		if (update_time && (update_time >= cache->delta_start) &&
+		    (update_time > last_part_update))
+			full = false;
+		pack_time(resp_time, buffer);
+		pack16((uint16_t) full, buffer);
+		pack32((uint32_t) 0, buffer);	/* node_scaling */
+		count_offset = get_buf_offset(buffer);
+		pack32(jobs_packed, buffer);
+	} else {
+		/* write message body header : size and time */
+		/* put in a place holder job record count of 0 for now */
+		count_offset = get_buf_offset(buffer);
+		pack32(jobs_packed, buffer);
+		pack_time(resp_time, buffer);
+	}
+
+	for (i = 0; i < cache->rec_cnt; i++) {
+		rec = &cache->recs[i];
+		if (!full && (rec->change_time < update_time)) {
+			/* unchanged, but may have aged out of the list */
+			if ((min_age > 0) && rec->purge_time &&
+			    (rec->purge_time < min_age) &&
+			    (rec->purge_time >= (update_time -
+						 slurmctld_conf.min_job_age))) {
+				xrealloc(del_job_id,
+					 sizeof(uint32_t) * (del_cnt + 1));
+				del_job_id[del_cnt++] = rec->job_id;
+			}
+			continue;
+		}
+
+		if ((((cache->show_flags & SHOW_ALL) == 0) && (uid != 0) &&
+		     rec->part_ptr &&
+		     ((rec->part_ptr->flags & PART_FLAG_HIDDEN) ||
+		      (validate_group(rec->part_ptr, uid) == 0))) ||
+		    (private_data && (rec->user_id != uid) && !is_operator &&
+		     !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
+						   rec->account)) ||
+		    ((min_age > 0) && rec->purge_time &&
+		     (rec->purge_time < min_age))) {
+			/* not visible to this user or ready for purging */
+			if (!full) {
+				xrealloc(del_job_id,
+					 sizeof(uint32_t) * (del_cnt + 1));
+				del_job_id[del_cnt++] = rec->job_id;
+			}
+			continue;
+		}
+
+		if (delta) {
+			pack32(rec->job_id, buffer);
+			packmem(get_buf_data(cache->buffer) + rec->offset,
+				rec->size, buffer);
+		} else {
+			packmem_array(get_buf_data(cache->buffer) + rec->offset,
+				      rec->size, buffer);
+		}
+		jobs_packed++;
+	}
+
+	if (delta) {
+		for (i = 0; !full && (i < cache->del_cnt); i++) {
+			if (cache->del_time[i] < update_time)
+				continue;
+			xrealloc(del_job_id, sizeof(uint32_t) * (del_cnt + 1));
+			del_job_id[del_cnt++] = cache->del_job_id[i];
+		}
+		pack32_array(del_job_id, del_cnt, buffer);
+		xfree(del_job_id);
+	}
+
+	/* put the real record count in the message body header */
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, count_offset);
+	pack32(jobs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
+/*
+ * pack_all_jobs_cached - dump all job information for all jobs from the
+ *	pre-packed cache if it is current, see pack_all_jobs()
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN update_time - with SHOW_DELTA, pack only jobs changed since this time
+ * IN snapshot - if set and the cache is not current, send the records as
+ *	they were when the cache was built, stamped with that time
+ * RET SLURM_SUCCESS or SLURM_ERROR if the cache can not be used, in which
+ *	case pack_all_jobs() must be called with the job lock
+ * NOTE: Call with config and partition read locks, the job lock is not needed
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ */
+extern int pack_all_jobs_cached(char **buffer_ptr, int *buffer_size,
+				uint16_t show_flags, uid_t uid,
+				uint16_t protocol_version, time_t update_time,
+				bool snapshot)
+{
+	job_pack_cache_t *cache;
+	time_t now = time(NULL);
+	bool delta = (show_flags & SHOW_DELTA);
+	int rc = SLURM_ERROR;
+
+	buffer_ptr[0] = NULL;
+	*buffer_size = 0;
+	if (show_flags & SHOW_DETAIL)
+		return rc;	/* batch script depends upon uid */
+
+	show_flags &= (~SHOW_DELTA);
+	slurm_mutex_lock(&job_pack_cache_mutex);
+	cache = _job_pack_cache_find(show_flags, protocol_version, now, true);
+	if (cache) {
+		_job_pack_cache_copy(cache, buffer_ptr, buffer_size, uid, now,
+				     now, delta, update_time);
+		rc = SLURM_SUCCESS;
+	} else if (snapshot &&
+		   (cache = _job_pack_cache_snapshot(show_flags,
+						     protocol_version, now,
+						     update_time))) {
+		_job_pack_cache_copy(cache, buffer_ptr, buffer_size, uid, now,
+				     cache->build_time, delta, update_time);
+		debug3("pack_all_jobs_cached: sent job records as of %ld",
+		       (long) cache->build_time);
+		rc = SLURM_SUCCESS;
+	}
+	slurm_mutex_unlock(&job_pack_cache_mutex);
+	return rc;
+}
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -5325,6 +6344,8 @@ static int _list_find_job_old(void *job_entry, void *key)
  * OUT buffer_size - set to size of the buffer in bytes
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
+ * IN update_time - with SHOW_DELTA, pack only jobs changed since this time
+ *	as a RESPONSE_JOB_INFO_DELTA message (SHOW_DETAIL must not be set)
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -5332,10 +6353,11 @@ static int _list_find_job_old(void *job_entry, void *key)
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid,
-			  uint16_t protocol_version)
+			  uint16_t protocol_version, time_t update_time)
 {
 	ListIterator job_iterator;
 	struct job_record *job_ptr;
+	job_pack_cache_t *cache;
 	uint32_t jobs_packed = 0, tmp_offset;
 	Buf buffer;
 	time_t min_age = 0, now = time(NULL);
@@ -5343,6 +6365,22 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
+	if ((show_flags & SHOW_DETAIL) == 0) {
+		/* Responses without the batch script are the same for all
+		 * users once filtered, pack them once for reuse */
+		bool delta = (show_flags & SHOW_DELTA);
+		show_flags &= (~SHOW_DELTA);
+		slurm_mutex_lock(&job_pack_cache_mutex);
+		cache = _job_pack_cache_find(show_flags, protocol_version,
+					     now, false);
+		if (!_job_pack_cache_valid(cache, now))
+			_job_pack_cache_build(cache, now);
+		_job_pack_cache_copy(cache, buffer_ptr, buffer_size, uid, now,
+				     now, delta, update_time);
+		slurm_mutex_unlock(&job_pack_cache_mutex);
+		return;
+	}
+
 	buffer = init_buf(BUF_SIZE);
 
 	/* write message body header : size and time */
@@ -5359,21 +6397,9 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 
-		if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
-		    (job_ptr->part_ptr) &&
-		    (job_ptr->part_ptr->flags & PART_FLAG_HIDDEN))
-			continue;
-
-		if ((slurmctld_conf.private_data & PRIVATE_DATA_JOBS) &&
-		    (job_ptr->user_id != uid) && !validate_operator(uid) &&
-		    !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
-						  job_ptr->account))
+		if (_hide_job(job_ptr, show_flags, uid, min_age))
 			continue;
 
-		if ((min_age > 0) && (job_ptr->end_time < min_age) &&
-		    (! IS_JOB_COMPLETING(job_ptr)) && IS_JOB_FINISHED(job_ptr))
-			continue;	/* job ready for purging, don't dump */
-
 		pack_job(job_ptr, show_flags, buffer, protocol_version, uid);
 		jobs_packed++;
 	}
@@ -5406,34 +6432,22 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 			uint32_t job_id, uint16_t show_flags, uid_t uid,
 			uint16_t protocol_version)
 {
-	ListIterator job_iterator;
 	struct job_record *job_ptr;
-	uint32_t jobs_packed = 0;
 	Buf buffer;
 
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
-		if (job_ptr->job_id != job_id)
-			continue;
-
-		if ((slurmctld_conf.private_data & PRIVATE_DATA_JOBS) &&
-		    (job_ptr->user_id != uid) && !validate_operator(uid) &&
-		    !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
-						  job_ptr->account))
-			break;
-
-		jobs_packed++;
-		break;
-	}
-	list_iterator_destroy(job_iterator);
-	if (jobs_packed == 0)
+	job_ptr = find_job_record(job_id);
+	if ((job_ptr == NULL) ||
+	    ((slurmctld_conf.private_data & PRIVATE_DATA_JOBS) &&
+	     (job_ptr->user_id != uid) && !validate_operator(uid) &&
+	     !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
+					   job_ptr->account)))
 		return ESLURM_INVALID_JOB_ID;
 
 	buffer = init_buf(BUF_SIZE);
-	pack32(jobs_packed, buffer);
+	pack32((uint32_t) 1, buffer);
 	pack_time(time(NULL), buffer);
 	pack_job(job_ptr, show_flags, buffer, protocol_version, uid);
 
@@ -5442,6 +6456,103 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * pack_user_jobs - dump information for the jobs of one user and/or with
+ *	one name in machine independent form (for network transmission),
+ *	found through the job user and name indexes
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN user_id - ID of user whose jobs are wanted, NO_VAL for any user
+ * IN job_name - name of jobs wanted, NULL for any name
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ */
+extern void pack_user_jobs(char **buffer_ptr, int *buffer_size,
+			   uint32_t user_id, char *job_name,
+			   uint16_t show_flags, uid_t uid,
+			   uint16_t protocol_version)
+{
+	ListIterator job_iterator = NULL;
+	struct job_record *job_ptr = NULL;
+	uint32_t jobs_packed = 0, tmp_offset;
+	Buf buffer;
+	time_t min_age = 0, now = time(NULL);
+
+	buffer = init_buf(BUF_SIZE);
+	pack32(jobs_packed, buffer);
+	pack_time(now, buffer);
+
+	if (slurmctld_conf.min_job_age > 0)
+		min_age = now  - slurmctld_conf.min_job_age;
+
+	if (user_id != NO_VAL) {
+		if (job_user_hash)
+			job_ptr = job_user_hash[JOB_USER_HASH_INX(user_id)];
+	} else if (job_name) {
+		if (job_name_hash)
+			job_ptr = job_name_hash[_job_name_hash_inx(job_name)];
+	} else {
+		job_iterator = list_iterator_create(job_list);
+		job_ptr = (struct job_record *) list_next(job_iterator);
+	}
+
+	part_filter_set(uid);
+	while (job_ptr) {
+		xassert (job_ptr->magic == JOB_MAGIC);
+		if (((user_id == NO_VAL) || (job_ptr->user_id == user_id)) &&
+		    ((job_name == NULL) ||
+		     (job_ptr->name && !strcmp(job_ptr->name, job_name))) &&
+		    !_hide_job(job_ptr, show_flags, uid, min_age)) {
+			pack_job(job_ptr, show_flags, buffer,
+				 protocol_version, uid);
+			jobs_packed++;
+		}
+
+		if (user_id != NO_VAL)
+			job_ptr = job_ptr->job_next_user;
+		else if (job_name)
+			job_ptr = job_ptr->job_next_name;
+		else
+			job_ptr = (struct job_record *) list_next(job_iterator);
+	}
+	part_filter_clear();
+	if (job_iterator)
+		list_iterator_destroy(job_iterator);
+
+	/* put the real record count in the message body header */
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(jobs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
+/* Return true if a job should not be included in a job information response
+ * to a user because of its partition, PrivateData or age */
+static bool _hide_job(struct job_record *job_ptr, uint16_t show_flags,
+		      uid_t uid, time_t min_age)
+{
+	if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
+	    (job_ptr->part_ptr) &&
+	    (job_ptr->part_ptr->flags & PART_FLAG_HIDDEN))
+		return true;
+
+	if ((slurmctld_conf.private_data & PRIVATE_DATA_JOBS) &&
+	    (job_ptr->user_id != uid) && !validate_operator(uid) &&
+	    !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
+					  job_ptr->account))
+		return true;
+
+	if ((min_age > 0) && (job_ptr->end_time < min_age) &&
+	    (! IS_JOB_COMPLETING(job_ptr)) && IS_JOB_FINISHED(job_ptr))
+		return true;	/* job ready for purging, don't dump */
+
+	return false;
+}
+
 /*
  * pack_job - dump all configuration information about a specific job in
  *	machine independent form (for network transmission)
@@ -6393,8 +7504,8 @@ static bool _top_priority(struct job_record *job_ptr)
 				top = false;
 				break;
 			}
-			if (bit_overlap(job_ptr->part_ptr->node_bitmap,
-					job_ptr2->part_ptr->node_bitmap) == 0)
+			if (!bit_overlap_any(job_ptr->part_ptr->node_bitmap,
+					     job_ptr2->part_ptr->node_bitmap))
 				continue;   /* no node overlap in partitions */
 			if ((job_ptr2->part_ptr->priority >
 			     job_ptr ->part_ptr->priority) ||
@@ -6737,6 +7848,7 @@ int update_job(job_desc_msg_t * job_specs, uid_t uid)
 			FREE_NULL_LIST(job_ptr->part_ptr_list);
 			job_ptr->part_ptr_list = part_ptr_list;
 			part_ptr_list = NULL;	/* nothing to free */
+			add_job_to_queue(job_ptr);
 			info("update_job: setting partition to %s for "
 			     "job_id %u", job_specs->partition,
 			     job_specs->job_id);
@@ -7450,8 +8562,10 @@ int update_job(job_desc_msg_t * job_specs, uid_t uid)
 			error_code = ESLURM_DISABLED;
 			goto fini;
 		} else {
+			xfree(job_ptr->name);
 			job_ptr->name = job_specs->name;
 			job_specs->name = NULL;
+			_add_job_index(job_ptr);
 
 			info("sched: update_job: setting name to %s for "
 			     "job_id %u", job_ptr->name, job_specs->job_id);
@@ -8366,8 +9480,9 @@ job_alloc_info(uint32_t uid, uint32_t job_id, struct job_record **job_pptr)
 
 /*
  * Synchronize the batch job in the system with their files.
- * All pending batch jobs must have script and environment files
- * No other jobs should have such files
+ * All pending batch jobs must have script and environment in the batch store,
+ * jobs still using a job.<id> directory from older versions are converted.
+ * Data not referenced by any job is removed from the batch store.
  * NOTE: READ lock_slurmctld config before entry
  */
 int sync_job_files(void)
@@ -8383,7 +9498,7 @@ int sync_job_files(void)
 }
 
 /* Append to the batch_dirs list the job_id's associated with
- *	every batch job directory in existence
+ *	every job.<id> batch directory written by older versions
  * NOTE: READ lock_slurmctld config before entry
  */
 static void _get_batch_job_dir_ids(List batch_dirs)
@@ -8417,26 +9532,80 @@ static void _get_batch_job_dir_ids(List batch_dirs)
 	closedir(f_dir);
 }
 
-/* All pending batch jobs must have a batch_dir entry,
- *	otherwise we flag it as FAILED and don't schedule
- * If the batch_dir entry exists for a PENDING or RUNNING batch job,
- *	remove it the list (of directories to be deleted) */
+/* Convert the job.<id> directory of a job into batch store records.
+ *	The directory is removed from batch_dirs and so kept until the next
+ *	sync, by which time the job state recording the new keys is saved.
+ * RET true if the job's script and environment were recovered */
+static bool _import_job_files(struct job_record *job_ptr, List batch_dirs)
+{
+	char *dir_name, *file_name, job_dir[20];
+	struct job_details *detail_ptr = job_ptr->details;
+
+	if (list_find_first(batch_dirs, _find_batch_dir,
+			    &(job_ptr->job_id)) == NULL)
+		return false;
+
+	dir_name = slurm_get_state_save_location();
+	sprintf(job_dir, "/job.%u", job_ptr->job_id);
+	xstrcat(dir_name, job_dir);
+
+	file_name = xstrdup_printf("%s/environment", dir_name);
+	detail_ptr->env_key = batch_store_import("env", job_ptr->user_id,
+						 file_name);
+	xfree(file_name);
+	file_name = xstrdup_printf("%s/script", dir_name);
+	detail_ptr->script_key = batch_store_import("script",
+						    job_ptr->user_id,
+						    file_name);
+	xfree(file_name);
+	xfree(dir_name);
+
+	if (!detail_ptr->env_key || !detail_ptr->script_key)
+		return false;
+	debug("Converted batch directory of job %u", job_ptr->job_id);
+	list_delete_all(batch_dirs, _find_batch_dir, &(job_ptr->job_id));
+	return true;
+}
+
+/* All pending batch jobs must have their script and environment in the
+ *	batch store, otherwise we flag it as FAILED and don't schedule.
+ * If a job.<id> batch_dir entry exists for a PENDING or RUNNING batch job
+ *	without batch store records, convert it and remove it from the list
+ *	(of directories to be deleted).
+ * Rebuild the batch store reference counts from every job with details. */
 static void _validate_job_files(List batch_dirs)
 {
 	ListIterator job_iterator;
 	struct job_record *job_ptr;
-	int del_cnt;
+	struct job_details *detail_ptr;
+	bool found;
 
+	batch_store_sync_start();
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		detail_ptr = job_ptr->details;
+		if (!detail_ptr)
+			continue;
+		if (detail_ptr->env_key)
+			batch_store_ref(detail_ptr->env_key);
+		if (detail_ptr->script_key)
+			batch_store_ref(detail_ptr->script_key);
 		if (!job_ptr->batch_flag)
 			continue;
 		if (IS_JOB_FINISHED(job_ptr))
 			continue;
-		/* Want to keep this job's files */
-		del_cnt = list_delete_all(batch_dirs, _find_batch_dir,
-					  &(job_ptr->job_id));
-		if ((del_cnt == 0) && IS_JOB_PENDING(job_ptr)) {
+
+		if (!detail_ptr->env_key && !detail_ptr->script_key) {
+			found = _import_job_files(job_ptr, batch_dirs);
+		} else if (IS_JOB_PENDING(job_ptr)) {
+			found = (detail_ptr->env_key &&
+				 detail_ptr->script_key &&
+				 batch_store_exists(detail_ptr->env_key) &&
+				 batch_store_exists(detail_ptr->script_key));
+		} else
+			found = true;
+
+		if (!found && IS_JOB_PENDING(job_ptr)) {
 			error("Script for job %u lost, state set to FAILED",
 			      job_ptr->job_id);
 			job_ptr->job_state = JOB_FAILED;
@@ -8448,6 +9617,7 @@ static void _validate_job_files(List batch_dirs)
 		}
 	}
 	list_iterator_destroy(job_iterator);
+	batch_store_sync_end();
 }
 
 /* List matching function, see common/list.h */
@@ -8667,11 +9837,24 @@ extern bool job_epilog_complete(uint32_t job_id, char *node_name,
 /* job_fini - free all memory associated with job records */
 void job_fini (void)
 {
+	int i;
+
+	slurm_mutex_lock(&job_pack_cache_mutex);
+	for (i = 0; i < JOB_PACK_CACHE_CNT; i++)
+		_job_pack_cache_clear(&job_pack_cache[i]);
+	slurm_mutex_unlock(&job_pack_cache_mutex);
+	xfree(job_state_recs);
+	job_state_rec_cnt = 0;
+	job_state_time = 0;
+	free_job_queue();
 	if (job_list) {
 		list_destroy(job_list);
 		job_list = NULL;
 	}
 	xfree(job_hash);
+	xfree(job_hash_old);
+	xfree(job_name_hash);
+	xfree(job_user_hash);
 }
 
 /* log the completion of the specified job */
@@ -8683,6 +9866,7 @@ extern void job_completion_logger(struct job_record  *job_ptr, bool requeue)
 	xassert(job_ptr);
 
 	acct_policy_remove_job_submit(job_ptr);
+	notify_job_dependents(job_ptr);
 
 	if (!IS_JOB_RESIZING(job_ptr)) {
 		/* Remove configuring state just to make sure it isn't there
@@ -9266,6 +10450,7 @@ extern int job_requeue (uid_t uid, uint32_t job_id, slurm_fd_t conn_fd,
 	job_ptr->job_state = JOB_PENDING;
 	if (job_ptr->node_cnt)
 		job_ptr->job_state |= JOB_COMPLETING;
+	add_job_to_queue(job_ptr);
 
 	job_ptr->details->submit_time = now;
 	job_ptr->pre_sus_time = (time_t) 0;
@@ -90,6 +90,28 @@ static int	_valid_node_feature(char *feature);
 
 static int	save_last_part_update = 0;
 
+/* Entry in the persistent queue of pending jobs */
+typedef struct job_queue_ent {
+	job_queue_rec_t rec;
+	uint32_t order;		/* order of insertion, breaks priority ties */
+	uint32_t priority;	/* job priority when last sorted */
+	uint32_t resv_id;	/* job reservation when last sorted */
+	void *qos_ptr;		/* job QOS when last sorted */
+	uint32_t queue_seq;	/* job_queue_seq of the job when added */
+} job_queue_ent_t;
+
+/* Persistent queue of (job, partition) pairs for all pending jobs, kept
+ * in priority order so the scheduler need not walk job_list. Protected by
+ * the job write lock. */
+static job_queue_ent_t *job_queue_array = NULL;
+static int		job_queue_cnt = 0;
+static int		job_queue_size = 0;
+static bool		job_queue_built = false;
+static bool		job_queue_sorted = false;
+static uint32_t		job_queue_order = 0;
+static uint32_t		job_queue_seq = 0;
+static time_t		job_queue_part_update = 0;
+
 /*
  * _build_user_job_list - build list of jobs for a given user
  *			  and an optional job name
@@ -130,18 +152,185 @@ static void _job_queue_append(List job_queue, struct job_record *job_ptr,
 	job_queue_rec_t *job_queue_rec;
 
 	job_queue_rec = xmalloc(sizeof(job_queue_rec_t));
+	job_queue_rec->job_id   = job_ptr->job_id;
 	job_queue_rec->job_ptr  = job_ptr;
 	job_queue_rec->part_ptr = part_ptr;
 	list_append(job_queue, job_queue_rec);
 }
 
+/* list_find_first() function matching a partition record */
+static int _find_part_ptr(void *x, void *key)
+{
+	return (x == key);
+}
+
 static void _job_queue_rec_del(void *x)
 {
 	xfree(x);
 }
 
+/* Append an entry for a job and one of its partitions to the persistent
+ * queue of pending jobs */
+static void _job_queue_ent_add(struct job_record *job_ptr,
+			       struct part_record *part_ptr)
+{
+	job_queue_ent_t *ent;
+
+	if (job_queue_cnt >= job_queue_size) {
+		job_queue_size = MAX(1024, job_queue_size * 2);
+		xrealloc(job_queue_array,
+			 sizeof(job_queue_ent_t) * job_queue_size);
+	}
+	ent = &job_queue_array[job_queue_cnt++];
+	ent->rec.job_id   = job_ptr->job_id;
+	ent->rec.job_ptr  = job_ptr;
+	ent->rec.part_ptr = part_ptr;
+	ent->order     = job_queue_order++;
+	ent->priority  = job_ptr->priority;
+	ent->resv_id   = job_ptr->resv_id;
+	ent->qos_ptr   = job_ptr->qos_ptr;
+	ent->queue_seq = job_ptr->job_queue_seq;
+}
+
+/* qsort() comparison of job_queue_ent_t, decreasing priority order per
+ * sort_job_queue2() with ties broken by order of insertion */
+static int _job_queue_ent_cmp(const void *x, const void *y)
+{
+	job_queue_ent_t *ent1 = (job_queue_ent_t *) x;
+	job_queue_ent_t *ent2 = (job_queue_ent_t *) y;
+	int rc;
+
+	rc = sort_job_queue2(&ent1->rec, &ent2->rec);
+	if (rc)
+		return rc;
+	if (ent1->order < ent2->order)
+		return -1;
+	if (ent1->order > ent2->order)
+		return 1;
+	return 0;
+}
+
+/*
+ * add_job_to_queue - add a pending job to the persistent queue of pending
+ *	jobs, one entry for each partition it may use. Call whenever a job
+ *	becomes pending or its partitions change, any prior entries for the
+ *	job are then discarded.
+ * IN job_ptr - pointer to job, ignored if not pending
+ */
+extern void add_job_to_queue(struct job_record *job_ptr)
+{
+	ListIterator part_iterator;
+	struct part_record *part_ptr;
+
+	if (!IS_JOB_PENDING(job_ptr))
+		return;
+
+	/* Entries with an older sequence number are purged when the
+	 * queue is next built, zero is never used */
+	if (++job_queue_seq == 0)
+		job_queue_seq++;
+	job_ptr->job_queue_seq = job_queue_seq;
+	job_queue_sorted = false;
+
+	if (job_ptr->part_ptr_list) {
+		part_iterator = list_iterator_create(job_ptr->part_ptr_list);
+		if (part_iterator == NULL)
+			fatal("list_iterator_create malloc failure");
+		while ((part_ptr = (struct part_record *)
+				list_next(part_iterator))) {
+			_job_queue_ent_add(job_ptr, part_ptr);
+		}
+		list_iterator_destroy(part_iterator);
+	} else {
+		if (job_ptr->part_ptr == NULL) {
+			part_ptr = find_part_record(job_ptr->partition);
+			if (part_ptr == NULL) {
+				error("Could not find partition %s "
+				      "for job %u", job_ptr->partition,
+				      job_ptr->job_id);
+				return;
+			}
+			job_ptr->part_ptr = part_ptr;
+			error("partition pointer reset for job %u, "
+			      "part %s", job_ptr->job_id,
+			      job_ptr->partition);
+		}
+		_job_queue_ent_add(job_ptr, job_ptr->part_ptr);
+	}
+}
+
+/*
+ * rebuild_job_queue - rebuild the persistent queue of pending jobs from
+ *	job_list. Call after job or partition records are recreated.
+ */
+extern void rebuild_job_queue(void)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+
+	job_queue_cnt = 0;
+	job_queue_built = true;
+	job_queue_sorted = false;
+	if (job_list == NULL)
+		return;
+
+	job_iterator = list_iterator_create(job_list);
+	if (job_iterator == NULL)
+		fatal("list_iterator_create memory allocation failure");
+	while ((job_ptr = (struct job_record *) list_next(job_iterator)))
+		add_job_to_queue(job_ptr);
+	list_iterator_destroy(job_iterator);
+}
+
+/* free_job_queue - free the persistent queue of pending jobs */
+extern void free_job_queue(void)
+{
+	xfree(job_queue_array);
+	job_queue_cnt = job_queue_size = 0;
+	job_queue_built = false;
+}
+
+/* Remove entries of jobs which are purged, no longer pending or were added
+ * again from the persistent queue. Note if its order may have changed. */
+static void _purge_job_queue(void)
+{
+	job_queue_ent_t *ent;
+	struct job_record *job_ptr;
+	int i, j;
+
+	if (job_queue_part_update != last_part_update) {
+		/* partition priorities may have changed */
+		job_queue_part_update = last_part_update;
+		job_queue_sorted = false;
+	}
+
+	for (i = 0, j = 0; i < job_queue_cnt; i++) {
+		ent = &job_queue_array[i];
+		/* Validate the job pointer before using it */
+		job_ptr = find_job_record(ent->rec.job_id);
+		if ((job_ptr != ent->rec.job_ptr) ||
+		    (job_ptr->job_queue_seq != ent->queue_seq) ||
+		    !IS_JOB_PENDING(job_ptr))
+			continue;
+		if ((ent->priority != job_ptr->priority) ||
+		    (ent->resv_id  != job_ptr->resv_id)  ||
+		    (ent->qos_ptr  != job_ptr->qos_ptr)) {
+			ent->priority = job_ptr->priority;
+			ent->resv_id  = job_ptr->resv_id;
+			ent->qos_ptr  = job_ptr->qos_ptr;
+			job_queue_sorted = false;
+		}
+		if (i != j)
+			job_queue_array[j] = *ent;
+		j++;
+	}
+	job_queue_cnt = j;
+}
+
 /*
- * build_job_queue - build (non-priority ordered) list of pending jobs
+ * build_job_queue - build list of pending jobs which may be started, in
+ *	decreasing priority order (see sort_job_queue2), from the persistent
+ *	queue of pending jobs
  * IN clear_start - if set then clear the start_time for pending jobs
  * RET the job queue
  * NOTE: the caller must call list_destroy() on RET value to free memory
@@ -149,26 +338,35 @@ static void _job_queue_rec_del(void *x)
 extern List build_job_queue(bool clear_start)
 {
 	List job_queue;
-	ListIterator job_iterator, part_iterator;
+	job_queue_ent_t *ent;
 	struct job_record *job_ptr = NULL;
-	struct part_record *part_ptr;
-	bool job_is_pending;
 	bool job_indepen = false;
+	int i;
 
 	job_queue = list_create(_job_queue_rec_del);
 	if (job_queue == NULL)
 		fatal("list_create memory allocation failure");
-	job_iterator = list_iterator_create(job_list);
-	if (job_iterator == NULL)
-		fatal("list_iterator_create memory allocation failure");
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+
+	if (!job_queue_built)
+		rebuild_job_queue();
+	_purge_job_queue();
+	if (!job_queue_sorted) {
+		qsort(job_queue_array, job_queue_cnt, sizeof(job_queue_ent_t),
+		      _job_queue_ent_cmp);
+		job_queue_sorted = true;
+	}
+
+	/* Jobs which can run in several partitions have several entries
+	 * and are tested once for each */
+	for (i = 0; i < job_queue_cnt; i++) {
+		ent = &job_queue_array[i];
+		job_ptr = ent->rec.job_ptr;
 		xassert (job_ptr->magic == JOB_MAGIC);
-		job_is_pending = IS_JOB_PENDING(job_ptr);
-		if (!job_is_pending || IS_JOB_COMPLETING(job_ptr))
+		if (IS_JOB_COMPLETING(job_ptr))
 			continue;
 		/* ensure dependency shows current values behind a hold */
 		job_indepen = job_independent(job_ptr, 0);
-		if (job_is_pending && clear_start)
+		if (clear_start)
 			job_ptr->start_time = (time_t) 0;
 		if (job_ptr->priority == 0)	{ /* held */
 			if ((job_ptr->state_reason != WAIT_HELD) &&
@@ -193,39 +391,39 @@ extern List build_job_queue(bool clear_start)
 
 		if (!job_indepen)	/* can not run now */
 			continue;
-		if (job_ptr->part_ptr_list) {
-			part_iterator = list_iterator_create(job_ptr->
-							     part_ptr_list);
-			if (part_iterator == NULL)
-				fatal("list_iterator_create malloc failure");
-			while ((part_ptr = (struct part_record *)
-					list_next(part_iterator))) {
-				_job_queue_append(job_queue, job_ptr, part_ptr);
-			}
-			list_iterator_destroy(part_iterator);
-		} else {
-			if (job_ptr->part_ptr == NULL) {
-				part_ptr = find_part_record(job_ptr->partition);
-				if (part_ptr == NULL) {
-					error("Could not find partition %s "
-					      "for job %u", job_ptr->partition,
-					      job_ptr->job_id);
-					continue;
-				}
-				job_ptr->part_ptr = part_ptr;
-				error("partition pointer reset for job %u, "
-				      "part %s", job_ptr->job_id,
-				      job_ptr->partition);
-			}
-			_job_queue_append(job_queue, job_ptr,
-					  job_ptr->part_ptr);
-		}
+		_job_queue_append(job_queue, job_ptr, ent->rec.part_ptr);
 	}
-	list_iterator_destroy(job_iterator);
 
 	return job_queue;
 }
 
+/*
+ * job_queue_rec_valid - determine if a record of a queue from
+ *	build_job_queue() is still valid after the job and partition locks
+ *	were released, applying the same tests as build_job_queue()
+ * IN job_queue_rec - record to validate
+ * RET true if the job still exists, may start and may use the partition
+ * NOTE: a removed partition is not detected, the caller must check that
+ *	last_part_update is unchanged
+ */
+extern bool job_queue_rec_valid(job_queue_rec_t *job_queue_rec)
+{
+	struct job_record *job_ptr = job_queue_rec->job_ptr;
+	struct part_record *part_ptr = job_queue_rec->part_ptr;
+
+	if ((find_job_record(job_queue_rec->job_id) != job_ptr) ||
+	    !IS_JOB_PENDING(job_ptr) || IS_JOB_COMPLETING(job_ptr) ||
+	    (job_ptr->priority == 0))
+		return false;
+	if (job_ptr->part_ptr_list) {
+		if (!list_find_first(job_ptr->part_ptr_list, _find_part_ptr,
+				     part_ptr))
+			return false;
+	} else if (job_ptr->part_ptr != part_ptr)
+		return false;
+	return job_independent(job_ptr, 0);
+}
+
 /*
  * job_is_completing - Determine if jobs are in the process of completing.
  * RET - True of any job is in the process of completing AND
@@ -313,6 +511,17 @@ static bool _failed_partition(struct part_record *part_ptr,
 	return false;
 }
 
+/* Record statistics for one schedule() pass, call with job write lock */
+static void _do_diag_stats(long delta_t, uint32_t job_depth)
+{
+	if (delta_t > slurmctld_diag_stats.schedule_cycle_max)
+		slurmctld_diag_stats.schedule_cycle_max = delta_t;
+	slurmctld_diag_stats.schedule_cycle_sum += delta_t;
+	slurmctld_diag_stats.schedule_cycle_last = delta_t;
+	slurmctld_diag_stats.schedule_cycle_depth += job_depth;
+	slurmctld_diag_stats.schedule_cycle_counter++;
+}
+
 /*
  * schedule - attempt to schedule all pending jobs
  *	pending jobs for each partition will be scheduled in priority
@@ -321,10 +530,9 @@ static bool _failed_partition(struct part_record *part_ptr,
  *		  queue on every job submit (0 means to use the system default,
  *		  SchedulerParameters for default_queue_depth)
  * RET count of jobs scheduled
- * Note: We re-build the queue every time. Jobs can not only be added
- *	or removed from the queue, but have their priority or partition
- *	changed with the update_job RPC. In general nodes will be in priority
- *	order (by submit time), so the sorting should be pretty fast.
+ * Note: The queue of pending jobs is persistent and only re-sorted when a
+ *	job's priority, reservation, QOS or partitions change, so the walk
+ *	of job_list and sort are avoided on each pass.
  */
 extern int schedule(uint32_t job_limit)
 {
@@ -424,7 +632,8 @@ extern int schedule(uint32_t job_limit)
 
 	debug("sched: Running job scheduler");
 	job_queue = build_job_queue(false);
-	while ((job_queue_rec = list_pop_bottom(job_queue, sort_job_queue2))) {
+	slurmctld_diag_stats.schedule_queue_len = list_count(job_queue);
+	while ((job_queue_rec = list_pop(job_queue))) {
 		job_ptr  = job_queue_rec->job_ptr;
 		part_ptr = job_queue_rec->part_ptr;
 		xfree(job_queue_rec);
@@ -483,8 +692,8 @@ extern int schedule(uint32_t job_limit)
 			       job_ptr->partition);
 			continue;
 		}
-		if (bit_overlap(avail_node_bitmap,
-				job_ptr->part_ptr->node_bitmap) == 0) {
+		if (bit_overlap_any(avail_node_bitmap,
+				    job_ptr->part_ptr->node_bitmap) == 0) {
 			/* All nodes DRAIN, DOWN, or
 			 * reserved for jobs in higher priority partition */
 			job_ptr->state_reason = WAIT_RESOURCES;
@@ -635,8 +844,9 @@ extern int schedule(uint32_t job_limit)
 	avail_node_bitmap = save_avail_node_bitmap;
 	xfree(failed_parts);
 	list_destroy(job_queue);
-	unlock_slurmctld(job_write_lock);
 	END_TIMER2("schedule");
+	_do_diag_stats(DELTA_TIMER, job_depth);
+	unlock_slurmctld(job_write_lock);
 	return job_cnt;
 }
 
@@ -849,17 +1059,52 @@ extern void print_job_dependency(struct job_record *job_ptr)
 	list_iterator_destroy(depend_iter);
 }
 
+/* Record that dep_job_ptr has a job depending upon it, so that job's
+ * dependencies are retested when dep_job_ptr changes state */
+static void _add_job_dependent(struct job_record *dep_job_ptr,
+			       uint32_t job_id)
+{
+	if (dep_job_ptr->dependent_cnt &&
+	    (dep_job_ptr->dependent_ids[dep_job_ptr->dependent_cnt - 1] ==
+	     job_id))
+		return;		/* several dependencies upon the same job */
+	xrealloc(dep_job_ptr->dependent_ids,
+		 sizeof(uint32_t) * (dep_job_ptr->dependent_cnt + 1));
+	dep_job_ptr->dependent_ids[dep_job_ptr->dependent_cnt++] = job_id;
+}
+
+/*
+ * notify_job_dependents - flag the jobs with a dependency upon this one to
+ *	have their dependencies retested. Call when the job starts, ends or
+ *	is purged.
+ * IN job_ptr - job which changed state
+ */
+extern void notify_job_dependents(struct job_record *job_ptr)
+{
+	struct job_record *dep_job_ptr;
+	int i;
+
+	for (i = 0; i < job_ptr->dependent_cnt; i++) {
+		dep_job_ptr = find_job_record(job_ptr->dependent_ids[i]);
+		if (dep_job_ptr && dep_job_ptr->details)
+			dep_job_ptr->details->depend_blocked = false;
+	}
+}
+
 /*
  * Determine if a job's dependencies are met
  * RET: 0 = no dependencies
  *      1 = dependencies remain
  *      2 = failure (job completion code not per dependency), delete the job
+ * NOTE: A job with dependencies remaining is not retested until a job it
+ *	depends upon starts, ends or is purged (see notify_job_dependents)
  */
 extern int test_job_dependency(struct job_record *job_ptr)
 {
 	ListIterator depend_iter, job_iterator;
 	struct depend_spec *dep_ptr;
 	bool failure = false, depends = false, expands = false;
+	bool singleton = false;
  	List job_queue = NULL;
  	bool run_now;
 	int count = 0;
@@ -868,6 +1113,8 @@ extern int test_job_dependency(struct job_record *job_ptr)
 	if ((job_ptr->details == NULL) ||
 	    (job_ptr->details->depend_list == NULL))
 		return 0;
+	if (job_ptr->details->depend_blocked)
+		return 1;
 
 	count = list_count(job_ptr->details->depend_list);
 	depend_iter = list_iterator_create(job_ptr->details->depend_list);
@@ -902,10 +1149,12 @@ extern int test_job_dependency(struct job_record *job_ptr)
 			/* job can run now, delete dependency */
  			if (run_now)
  				list_delete_item(depend_iter);
- 			else
+ 			else {
 				depends = true;
- 		} else if ((dep_ptr->job_ptr->magic != JOB_MAGIC) ||
-			   (dep_ptr->job_ptr->job_id != dep_ptr->job_id)) {
+				singleton = true;
+			}
+ 		} else if (find_job_record(dep_ptr->job_id) !=
+			   dep_ptr->job_ptr) {
 			/* job is gone, dependency lifted */
 			list_delete_item(depend_iter);
 			clear_dep = true;
@@ -976,8 +1225,13 @@ extern int test_job_dependency(struct job_record *job_ptr)
 
 	if (failure)
 		return 2;
-	if (depends)
+	if (depends) {
+		/* Singleton and expand dependencies are not satisfied by a
+		 * state change of one specific job, keep testing them */
+		if (!singleton && !expands)
+			job_ptr->details->depend_blocked = true;
 		return 1;
+	}
 	return 0;
 }
 
@@ -996,6 +1250,7 @@ extern int update_job_dependency(struct job_record *job_ptr, char *new_depend)
 	uint32_t job_id = 0;
 	char *tok = new_depend, *sep_ptr, *sep_ptr2;
 	List new_depend_list = NULL;
+	ListIterator depend_iter;
 	struct depend_spec *dep_ptr;
 	struct job_record *dep_job_ptr;
 	char dep_buf[32];
@@ -1006,6 +1261,7 @@ extern int update_job_dependency(struct job_record *job_ptr, char *new_depend)
 
 	/* Clear dependencies on NULL, "0", or empty dependency input */
 	job_ptr->details->expanding_jobid = 0;
+	job_ptr->details->depend_blocked = false;
 	if ((new_depend == NULL) || (new_depend[0] == '\0') ||
 	    ((new_depend[0] == '0') && (new_depend[1] == '\0'))) {
 		xfree(job_ptr->details->dependency);
@@ -1154,6 +1410,16 @@ extern int update_job_dependency(struct job_record *job_ptr, char *new_depend)
 		if (job_ptr->details->depend_list)
 			list_destroy(job_ptr->details->depend_list);
 		job_ptr->details->depend_list = new_depend_list;
+		depend_iter = list_iterator_create(new_depend_list);
+		if (depend_iter == NULL)
+			fatal("list_iterator_create malloc failure");
+		while ((dep_ptr = (struct depend_spec *)
+				  list_next(depend_iter))) {
+			if (dep_ptr->job_ptr)	/* not singleton */
+				_add_job_dependent(dep_ptr->job_ptr,
+						   job_ptr->job_id);
+		}
+		list_iterator_destroy(depend_iter);
 #if _DEBUG
 		print_job_dependency(job_ptr);
 #endif
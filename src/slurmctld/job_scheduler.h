@@ -45,10 +45,20 @@
 #include "src/slurmctld/slurmctld.h"
 
 typedef struct job_queue_rec {
+	uint32_t job_id;	/* to validate job_ptr after locks released */
 	struct job_record *job_ptr;
 	struct part_record *part_ptr;
 } job_queue_rec_t;
 
+/*
+ * add_job_to_queue - add a pending job to the persistent queue of pending
+ *	jobs, one entry for each partition it may use. Call whenever a job
+ *	becomes pending or its partitions change, any prior entries for the
+ *	job are then discarded.
+ * IN job_ptr - pointer to job, ignored if not pending
+ */
+extern void add_job_to_queue(struct job_record *job_ptr);
+
 /*
  * build_feature_list - Translate a job's feature string into a feature_list
  * IN  details->features
@@ -58,13 +68,26 @@ typedef struct job_queue_rec {
 extern int build_feature_list(struct job_record *job_ptr);
 
 /*
- * build_job_queue - build (non-priority ordered) list of pending jobs
+ * build_job_queue - build list of pending jobs which may be started, in
+ *	decreasing priority order (see sort_job_queue2), from the persistent
+ *	queue of pending jobs
  * IN clear_start - if set then clear the start_time for pending jobs
  * RET the job queue
  * NOTE: the caller must call list_destroy() on RET value to free memory
  */
 extern List build_job_queue(bool clear_start);
 
+/*
+ * job_queue_rec_valid - determine if a record of a queue from
+ *	build_job_queue() is still valid after the job and partition locks
+ *	were released, applying the same tests as build_job_queue()
+ * IN job_queue_rec - record to validate
+ * RET true if the job still exists, may start and may use the partition
+ * NOTE: a removed partition is not detected, the caller must check that
+ *	last_part_update is unchanged
+ */
+extern bool job_queue_rec_valid(job_queue_rec_t *job_queue_rec);
+
 /*
  * epilog_slurmctld - execute the prolog_slurmctld for a job that has just
  *	terminated.
@@ -105,6 +128,14 @@ extern void launch_job(struct job_record *job_ptr);
 extern int make_batch_job_cred(batch_job_launch_msg_t *launch_msg_ptr,
 			       struct job_record *job_ptr);
 
+/*
+ * notify_job_dependents - flag the jobs with a dependency upon this one to
+ *	have their dependencies retested. Call when the job starts, ends or
+ *	is purged.
+ * IN job_ptr - job which changed state
+ */
+extern void notify_job_dependents(struct job_record *job_ptr);
+
 /* Print a job's dependency information based upon job_ptr->depend_list */
 extern void print_job_dependency(struct job_record *job_ptr);
 
@@ -116,10 +147,19 @@ extern void print_job_dependency(struct job_record *job_ptr);
  */
 extern int prolog_slurmctld(struct job_record *job_ptr);
 
+/* free_job_queue - free the persistent queue of pending jobs */
+extern void free_job_queue(void);
+
 /* If a job can run in multiple partitions, make sure that the one 
  * actually used is first in the string. Needed for job state save/restore */
 extern void rebuild_job_part_list(struct job_record *job_ptr);
 
+/*
+ * rebuild_job_queue - rebuild the persistent queue of pending jobs from
+ *	job_list. Call after job or partition records are recreated.
+ */
+extern void rebuild_job_queue(void);
+
 /*
  * schedule - attempt to schedule all pending jobs
  *	pending jobs for each partition will be scheduled in priority
@@ -128,10 +168,9 @@ extern void rebuild_job_part_list(struct job_record *job_ptr);
  *		  queue on every job submit (0 means to use the system default,
  *		  SchedulerParameters for default_queue_depth)
  * RET count of jobs scheduled
- * Note: We re-build the queue every time. Jobs can not only be added
- *	or removed from the queue, but have their priority or partition
- *	changed with the update_job RPC. In general nodes will be in priority
- *	order (by submit time), so the sorting should be pretty fast.
+ * Note: The queue of pending jobs is persistent and only re-sorted when a
+ *	job's priority, reservation, QOS or partitions change, so the walk
+ *	of job_list and sort are avoided on each pass.
  */
 extern int schedule(uint32_t job_limit);
 
@@ -156,6 +195,8 @@ extern int sort_job_queue2(void *x, void *y);
  * RET: 0 = no dependencies
  *      1 = dependencies remain
  *      2 = failure (job completion code not per dependency), delete the job
+ * NOTE: A job with dependencies remaining is not retested until a job it
+ *	depends upon starts, ends or is purged (see notify_job_dependents)
  */
 extern int test_job_dependency(struct job_record *job_ptr);
 
@@ -47,34 +47,209 @@
 
 #include <errno.h>
 #include <string.h>
+#include <sys/time.h>
 #include <sys/types.h>
 
+#include "src/common/log.h"
+#include "src/common/parse_time.h"
+#include "src/common/timers.h"
+#include "src/common/xmalloc.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/slurmctld.h"
 
-static pthread_mutex_t locks_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t locks_cond = PTHREAD_COND_INITIALIZER;
+/* Maximum depth of nested lock_slurmctld() calls tracked per thread */
+#define LOCK_NEST_MAX	4
+
+/* Locks held by the current thread, for per-caller hold times. Entries are
+ * matched to unlock_slurmctld() calls by lock levels rather than by nesting
+ * order, since locks need not be released in the reverse order of
+ * acquisition. */
+typedef struct {
+	int depth;		/* entries in use */
+	int untracked;		/* locks held beyond LOCK_NEST_MAX */
+	const char *caller[LOCK_NEST_MAX];
+	slurmctld_lock_t levels[LOCK_NEST_MAX];
+	struct timeval acquired[LOCK_NEST_MAX];
+} lock_thread_rec_t;
+
+/* Each data type has its own mutex and condition variable so that
+ * releasing one lock does not wake threads waiting for a different one */
+static pthread_mutex_t locks_mutex[ENTITY_COUNT] = {
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER };
+static pthread_cond_t locks_cond[ENTITY_COUNT] = {
+	PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
 static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static slurmctld_lock_flags_t slurmctld_locks;
 static int kill_thread = 0;
 
+/* Lock statistics. Per data type values are protected by that data type's
+ * locks_mutex, per caller values by stats_mutex. */
+static lock_stats_t type_stats[ENTITY_COUNT][2];  /* [type][read/write] */
+static struct timeval read_start[ENTITY_COUNT], write_start[ENTITY_COUNT];
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static lock_caller_stats_t caller_stats[LOCK_STATS_CALLERS];
+static int caller_cnt = 0;
+static time_t stats_start_time = 0;
+static pthread_key_t  thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+
+static char *lock_type_name[ENTITY_COUNT] = {
+	"config", "job", "node", "partition" };
+
 static bool _wr_rdlock(lock_datatype_t datatype, bool wait_lock);
 static void _wr_rdunlock(lock_datatype_t datatype);
 static bool _wr_wrlock(lock_datatype_t datatype, bool wait_lock);
 static void _wr_wrunlock(lock_datatype_t datatype);
 
+static void _add_wait(lock_stats_t *stats, uint32_t usec)
+{
+	stats->wait_usec += usec;
+	if (usec > stats->wait_max_usec)
+		stats->wait_max_usec = usec;
+}
+
+static void _add_hold(lock_stats_t *stats, uint32_t usec)
+{
+	stats->hold_usec += usec;
+	if (usec > stats->hold_max_usec)
+		stats->hold_max_usec = usec;
+}
+
+static void _free_thread_rec(void *thread_rec)
+{
+	xfree(thread_rec);
+}
+
+static void _make_thread_key(void)
+{
+	if (pthread_key_create(&thread_key, _free_thread_rec))
+		error("pthread_key_create: %m");
+}
+
+static lock_thread_rec_t *_get_thread_rec(void)
+{
+	lock_thread_rec_t *thread_rec;
+
+	pthread_once(&thread_key_once, _make_thread_key);
+	thread_rec = (lock_thread_rec_t *) pthread_getspecific(thread_key);
+	if (thread_rec == NULL) {
+		thread_rec = xmalloc(sizeof(lock_thread_rec_t));
+		pthread_setspecific(thread_key, thread_rec);
+	}
+	return thread_rec;
+}
+
+/* Find the statistics record for a caller. Callers beyond the table size
+ * are accumulated in the last record. Call with stats_mutex locked. */
+static lock_caller_stats_t *_find_caller(const char *caller)
+{
+	int i;
+
+	for (i = 0; i < caller_cnt; i++) {
+		if ((caller_stats[i].caller == caller) ||
+		    !strcmp(caller_stats[i].caller, caller))
+			return &caller_stats[i];
+	}
+	if (caller_cnt < (LOCK_STATS_CALLERS - 1)) {
+		caller_stats[caller_cnt].caller = caller;
+		return &caller_stats[caller_cnt++];
+	}
+	i = LOCK_STATS_CALLERS - 1;
+	caller_stats[i].caller = "other";
+	caller_cnt = LOCK_STATS_CALLERS;
+	return &caller_stats[i];
+}
+
+static bool _same_levels(slurmctld_lock_t *a, slurmctld_lock_t *b)
+{
+	return ((a->config    == b->config) &&
+		(a->job       == b->job)    &&
+		(a->node      == b->node)   &&
+		(a->partition == b->partition));
+}
+
+/* Record that the current thread acquired its locks */
+static void _lock_acquired(slurmctld_lock_t *lock_levels, const char *caller,
+			   struct timeval *start)
+{
+	lock_thread_rec_t *thread_rec = _get_thread_rec();
+	lock_caller_stats_t *caller_ptr;
+	struct timeval now;
+	int depth;
+
+	gettimeofday(&now, NULL);
+	if (thread_rec->depth < LOCK_NEST_MAX) {
+		depth = thread_rec->depth++;
+		thread_rec->caller[depth] = caller;
+		thread_rec->levels[depth] = *lock_levels;
+		thread_rec->acquired[depth] = now;
+	} else
+		thread_rec->untracked++;
+
+	slurm_mutex_lock(&stats_mutex);
+	caller_ptr = _find_caller(caller);
+	caller_ptr->stats.count++;
+	_add_wait(&caller_ptr->stats, slurm_diff_tv_usec(start, &now));
+	slurm_mutex_unlock(&stats_mutex);
+}
+
+/* Record that the current thread released locks with the given levels.
+ * If several held entries have those levels, the most recent is used. */
+static void _lock_released(slurmctld_lock_t *lock_levels)
+{
+	lock_thread_rec_t *thread_rec = _get_thread_rec();
+	lock_caller_stats_t *caller_ptr;
+	struct timeval now;
+	uint32_t hold_usec;
+	const char *caller;
+	int i;
+
+	for (i = thread_rec->depth - 1; i >= 0; i--) {
+		if (_same_levels(&thread_rec->levels[i], lock_levels))
+			break;
+	}
+	if (i < 0) {
+		if (thread_rec->untracked > 0)
+			thread_rec->untracked--;
+		return;
+	}
+
+	gettimeofday(&now, NULL);
+	caller = thread_rec->caller[i];
+	hold_usec = slurm_diff_tv_usec(&thread_rec->acquired[i], &now);
+	for (thread_rec->depth--; i < thread_rec->depth; i++) {
+		thread_rec->caller[i]   = thread_rec->caller[i + 1];
+		thread_rec->levels[i]   = thread_rec->levels[i + 1];
+		thread_rec->acquired[i] = thread_rec->acquired[i + 1];
+	}
+
+	slurm_mutex_lock(&stats_mutex);
+	caller_ptr = _find_caller(caller);
+	_add_hold(&caller_ptr->stats, hold_usec);
+	slurm_mutex_unlock(&stats_mutex);
+}
+
 /* init_locks - create locks used for slurmctld data structure access
  *	control */
 void init_locks(void)
 {
 	/* just clear all semaphores */
 	memset((void *) &slurmctld_locks, 0, sizeof(slurmctld_locks));
+	if (stats_start_time == 0)
+		stats_start_time = time(NULL);
 }
 
 /* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld(slurmctld_lock_t lock_levels)
+extern void lock_slurmctld_func(slurmctld_lock_t lock_levels,
+				const char *caller)
 {
+	struct timeval start;
+
+	gettimeofday(&start, NULL);
+
 	if (lock_levels.config == READ_LOCK)
 		(void) _wr_rdlock(CONFIG_LOCK, true);
 	else if (lock_levels.config == WRITE_LOCK)
@@ -94,13 +269,19 @@ extern void lock_slurmctld(slurmctld_lock_t lock_levels)
 		(void) _wr_rdlock(PART_LOCK, true);
 	else if (lock_levels.partition == WRITE_LOCK)
 		(void) _wr_wrlock(PART_LOCK, true);
+
+	_lock_acquired(&lock_levels, caller, &start);
 }
 
 /* try_lock_slurmctld - equivalent to lock_slurmctld() except 
  * RET 0 on success or -1 if the locks are currently not available */
-extern int try_lock_slurmctld (slurmctld_lock_t lock_levels)
+extern int try_lock_slurmctld_func(slurmctld_lock_t lock_levels,
+				   const char *caller)
 {
 	bool success = true;
+	struct timeval start;
+
+	gettimeofday(&start, NULL);
 
 	if (lock_levels.config == READ_LOCK)
 		success = _wr_rdlock(CONFIG_LOCK, false);
@@ -157,6 +338,7 @@ extern int try_lock_slurmctld (slurmctld_lock_t lock_levels)
 		return -1;
 	}
 
+	_lock_acquired(&lock_levels, caller, &start);
 	return 0;
 }
 
@@ -164,6 +346,8 @@ extern int try_lock_slurmctld (slurmctld_lock_t lock_levels)
  *	defined order */
 extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 {
+	_lock_released(&lock_levels);
+
 	if (lock_levels.partition == READ_LOCK)
 		_wr_rdunlock(PART_LOCK);
 	else if (lock_levels.partition == WRITE_LOCK)
@@ -188,9 +372,10 @@ extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 /* _wr_rdlock - Issue a read lock on the specified data type */
 static bool _wr_rdlock(lock_datatype_t datatype, bool wait_lock)
 {
-	bool success = true;
+	bool success = true, waited = false;
+	struct timeval start, now = {0, 0};
 
-	slurm_mutex_lock(&locks_mutex);
+	slurm_mutex_lock(&locks_mutex[datatype]);
 	while (1) {
 		if ((slurmctld_locks.entity[write_wait_lock(datatype)] == 0) &&
 		    (slurmctld_locks.entity[write_lock(datatype)] == 0)) {
@@ -200,30 +385,57 @@ static bool _wr_rdlock(lock_datatype_t datatype, bool wait_lock)
 			success = false;
 			break;
 		} else {	/* wait for state change and retry */
-			pthread_cond_wait(&locks_cond, &locks_mutex);
+			if (!waited) {
+				gettimeofday(&start, NULL);
+				waited = true;
+			}
+			pthread_cond_wait(&locks_cond[datatype],
+					  &locks_mutex[datatype]);
 			if (kill_thread)
 				pthread_exit(NULL);
 		}
 	}
-	slurm_mutex_unlock(&locks_mutex);
+	if (success) {
+		lock_stats_t *stats = &type_stats[datatype][0];
+		stats->count++;
+		if (waited || (slurmctld_locks.entity[read_lock(datatype)]
+			       == 1))
+			gettimeofday(&now, NULL);
+		if (waited) {
+			stats->contended++;
+			_add_wait(stats, slurm_diff_tv_usec(&start, &now));
+		}
+		if (slurmctld_locks.entity[read_lock(datatype)] == 1)
+			read_start[datatype] = now;
+	}
+	slurm_mutex_unlock(&locks_mutex[datatype]);
 	return success;
 }
 
 /* _wr_rdunlock - Issue a read unlock on the specified data type */
 static void _wr_rdunlock(lock_datatype_t datatype)
 {
-	slurm_mutex_lock(&locks_mutex);
+	struct timeval now;
+
+	slurm_mutex_lock(&locks_mutex[datatype]);
 	slurmctld_locks.entity[read_lock(datatype)]--;
-	pthread_cond_broadcast(&locks_cond);
-	slurm_mutex_unlock(&locks_mutex);
+	if (slurmctld_locks.entity[read_lock(datatype)] == 0) {
+		/* Read hold time is the time any reader held the lock */
+		gettimeofday(&now, NULL);
+		_add_hold(&type_stats[datatype][0],
+			  slurm_diff_tv_usec(&read_start[datatype], &now));
+	}
+	pthread_cond_broadcast(&locks_cond[datatype]);
+	slurm_mutex_unlock(&locks_mutex[datatype]);
 }
 
 /* _wr_wrlock - Issue a write lock on the specified data type */
 static bool _wr_wrlock(lock_datatype_t datatype, bool wait_lock)
 {
-	bool success = true;
+	bool success = true, waited = false;
+	struct timeval start;
 
-	slurm_mutex_lock(&locks_mutex);
+	slurm_mutex_lock(&locks_mutex[datatype]);
 	slurmctld_locks.entity[write_wait_lock(datatype)]++;
 
 	while (1) {
@@ -237,38 +449,166 @@ static bool _wr_wrlock(lock_datatype_t datatype, bool wait_lock)
 			success = false;
 			break;
 		} else {	/* wait for state change and retry */
-			pthread_cond_wait(&locks_cond, &locks_mutex);
+			if (!waited) {
+				gettimeofday(&start, NULL);
+				waited = true;
+			}
+			pthread_cond_wait(&locks_cond[datatype],
+					  &locks_mutex[datatype]);
 			if (kill_thread)
 				pthread_exit(NULL);
 		}
 	}
-	slurm_mutex_unlock(&locks_mutex);
+	if (success) {
+		lock_stats_t *stats = &type_stats[datatype][1];
+		gettimeofday(&write_start[datatype], NULL);
+		stats->count++;
+		if (waited) {
+			stats->contended++;
+			_add_wait(stats,
+				  slurm_diff_tv_usec(&start,
+						     &write_start[datatype]));
+		}
+	}
+	slurm_mutex_unlock(&locks_mutex[datatype]);
 	return success;
 }
 
 /* _wr_wrunlock - Issue a write unlock on the specified data type */
 static void _wr_wrunlock(lock_datatype_t datatype)
 {
-	slurm_mutex_lock(&locks_mutex);
+	struct timeval now;
+
+	slurm_mutex_lock(&locks_mutex[datatype]);
 	slurmctld_locks.entity[write_lock(datatype)]--;
-	pthread_cond_broadcast(&locks_cond);
-	slurm_mutex_unlock(&locks_mutex);
+	gettimeofday(&now, NULL);
+	_add_hold(&type_stats[datatype][1],
+		  slurm_diff_tv_usec(&write_start[datatype], &now));
+	pthread_cond_broadcast(&locks_cond[datatype]);
+	slurm_mutex_unlock(&locks_mutex[datatype]);
 }
 
 /* get_lock_values - Get the current value of all locks
  * OUT lock_flags - a copy of the current lock values */
 void get_lock_values(slurmctld_lock_flags_t * lock_flags)
 {
+	int i;
+
 	xassert(lock_flags);
-	memcpy((void *) lock_flags, (void *) &slurmctld_locks,
-	       sizeof(slurmctld_locks));
+	for (i = 0; i < ENTITY_COUNT; i++) {
+		slurm_mutex_lock(&locks_mutex[i]);
+		lock_flags->entity[read_lock(i)] =
+			slurmctld_locks.entity[read_lock(i)];
+		lock_flags->entity[write_lock(i)] =
+			slurmctld_locks.entity[write_lock(i)];
+		lock_flags->entity[write_wait_lock(i)] =
+			slurmctld_locks.entity[write_wait_lock(i)];
+		slurm_mutex_unlock(&locks_mutex[i]);
+	}
+}
+
+/* get_lock_stats - Get a copy of the lock statistics
+ * OUT lock_stats - read and write statistics for each lock type, indexed
+ *	by (lock_datatype_t * 2 + 0) for read, (lock_datatype_t * 2 + 1)
+ *	for write. Must have space for ENTITY_COUNT * 2 records.
+ * OUT caller_stats_ptr - copy of per caller statistics, xfree to release
+ * OUT caller_stats_cnt - count of records in caller_stats_ptr
+ * RET time at which statistics collection started */
+extern time_t get_lock_stats(lock_stats_t *lock_stats,
+			     lock_caller_stats_t **caller_stats_ptr,
+			     int *caller_stats_cnt)
+{
+	int i;
+	time_t start_time;
+
+	for (i = 0; i < ENTITY_COUNT; i++) {
+		slurm_mutex_lock(&locks_mutex[i]);
+		lock_stats[i * 2]     = type_stats[i][0];
+		lock_stats[i * 2 + 1] = type_stats[i][1];
+		slurm_mutex_unlock(&locks_mutex[i]);
+	}
+
+	slurm_mutex_lock(&stats_mutex);
+	start_time = stats_start_time;
+	*caller_stats_cnt = caller_cnt;
+	*caller_stats_ptr = xmalloc(sizeof(lock_caller_stats_t) *
+				    MAX(caller_cnt, 1));
+	memcpy(*caller_stats_ptr, caller_stats,
+	       sizeof(lock_caller_stats_t) * caller_cnt);
+	slurm_mutex_unlock(&stats_mutex);
+
+	return start_time;
+}
+
+/* reset_lock_stats - Clear lock statistics */
+extern void reset_lock_stats(void)
+{
+	int i;
+
+	for (i = 0; i < ENTITY_COUNT; i++) {
+		slurm_mutex_lock(&locks_mutex[i]);
+		memset(type_stats[i], 0, sizeof(type_stats[i]));
+		slurm_mutex_unlock(&locks_mutex[i]);
+	}
+
+	slurm_mutex_lock(&stats_mutex);
+	for (i = 0; i < caller_cnt; i++)
+		memset(&caller_stats[i].stats, 0, sizeof(lock_stats_t));
+	stats_start_time = time(NULL);
+	slurm_mutex_unlock(&stats_mutex);
+}
+
+/* lock_datatype_string - Return the name of a data type, e.g. "job" */
+extern char *lock_datatype_string(lock_datatype_t datatype)
+{
+	if (datatype >= ENTITY_COUNT)
+		return "unknown";
+	return lock_type_name[datatype];
+}
+
+static void _log_lock_stats(char *name, lock_stats_t *stats)
+{
+	if (stats->count == 0)
+		return;
+	info("  %-28s cnt:%u contended:%u wait_avg:%"PRIu64" "
+	     "wait_max:%u hold_avg:%"PRIu64" hold_max:%u (usec)",
+	     name, stats->count, stats->contended,
+	     stats->wait_usec / stats->count, stats->wait_max_usec,
+	     stats->hold_usec / stats->count, stats->hold_max_usec);
+}
+
+/* log_lock_stats - Log lock statistics accumulated since startup or the
+ *	last call to reset_lock_stats() */
+extern void log_lock_stats(void)
+{
+	lock_stats_t lock_stats[ENTITY_COUNT * 2];
+	lock_caller_stats_t *callers = NULL;
+	int caller_count, i;
+	char name[64], time_str[32];
+	time_t start_time;
+
+	start_time = get_lock_stats(lock_stats, &callers, &caller_count);
+	slurm_make_time_str(&start_time, time_str, sizeof(time_str));
+	info("Lock statistics since %s:", time_str);
+	for (i = 0; i < ENTITY_COUNT; i++) {
+		snprintf(name, sizeof(name), "%s_read", lock_type_name[i]);
+		_log_lock_stats(name, &lock_stats[i * 2]);
+		snprintf(name, sizeof(name), "%s_write", lock_type_name[i]);
+		_log_lock_stats(name, &lock_stats[i * 2 + 1]);
+	}
+	for (i = 0; i < caller_count; i++)
+		_log_lock_stats((char *) callers[i].caller, &callers[i].stats);
+	xfree(callers);
 }
 
 /* kill_locked_threads - Kill all threads waiting on semaphores */
 extern void kill_locked_threads(void)
 {
+	int i;
+
 	kill_thread = 1;
-	pthread_cond_broadcast(&locks_cond);
+	for (i = 0; i < ENTITY_COUNT; i++)
+		pthread_cond_broadcast(&locks_cond[i]);
 }
 
 /* un/lock semaphore used for saving state of slurmctld */
@@ -87,6 +87,9 @@
 #ifndef _SLURMCTLD_LOCKS_H
 #define _SLURMCTLD_LOCKS_H
 
+#include <inttypes.h>
+#include <time.h>
+
 /* levels of locking required for each data structure */
 typedef enum {
 	NO_LOCK,
@@ -125,6 +128,46 @@ typedef struct {
 }	slurmctld_lock_flags_t;
 
 
+/* Lock usage statistics. Times are in microseconds. For read locks,
+ * hold time is the time during which any reader held the lock. */
+typedef struct {
+	uint32_t count;		/* locks acquired */
+	uint32_t contended;	/* locks which had to wait */
+	uint64_t wait_usec;	/* total time waiting for lock */
+	uint32_t wait_max_usec;
+	uint64_t hold_usec;	/* total time lock held */
+	uint32_t hold_max_usec;
+}	lock_stats_t;
+
+/* Maximum number of distinct lock_slurmctld() callers tracked */
+#define LOCK_STATS_CALLERS	128
+
+typedef struct {
+	const char *caller;	/* function calling lock_slurmctld() */
+	lock_stats_t stats;
+}	lock_caller_stats_t;
+
+/* get_lock_stats - Get a copy of the lock statistics
+ * OUT lock_stats - read and write statistics for each lock type, indexed
+ *	by (lock_datatype_t * 2 + 0) for read, (lock_datatype_t * 2 + 1)
+ *	for write. Must have space for ENTITY_COUNT * 2 records.
+ * OUT caller_stats_ptr - copy of per caller statistics, xfree to release
+ * OUT caller_stats_cnt - count of records in caller_stats_ptr
+ * RET time at which statistics collection started */
+extern time_t get_lock_stats(lock_stats_t *lock_stats,
+			     lock_caller_stats_t **caller_stats_ptr,
+			     int *caller_stats_cnt);
+
+/* lock_datatype_string - Return the name of a data type, e.g. "job" */
+extern char *lock_datatype_string(lock_datatype_t datatype);
+
+/* log_lock_stats - Log lock statistics accumulated since startup or the
+ *	last call to reset_lock_stats() */
+extern void log_lock_stats(void);
+
+/* reset_lock_stats - Clear lock statistics */
+extern void reset_lock_stats(void);
+
 /* get_lock_values - Get the current value of all locks
  * OUT lock_flags - a copy of the current lock values */
 extern void get_lock_values (slurmctld_lock_flags_t *lock_flags);
@@ -136,12 +179,19 @@ extern void init_locks ( void );
 /* kill_locked_threads - Kill all threads waiting on semaphores */
 extern void kill_locked_threads ( void );
 
-/* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld (slurmctld_lock_t lock_levels);
+/* lock_slurmctld - Issue the required lock requests in a well defined order
+ * The calling function is recorded for lock statistics */
+#define lock_slurmctld(lock_levels) \
+	lock_slurmctld_func(lock_levels, __func__)
+extern void lock_slurmctld_func (slurmctld_lock_t lock_levels,
+				 const char *caller);
 
 /* try_lock_slurmctld - equivalent to lock_slurmctld() except 
  * RET 0 on success or -1 if the locks are currently not available */
-extern int try_lock_slurmctld (slurmctld_lock_t lock_levels);
+#define try_lock_slurmctld(lock_levels) \
+	try_lock_slurmctld_func(lock_levels, __func__)
+extern int try_lock_slurmctld_func (slurmctld_lock_t lock_levels,
+				    const char *caller);
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
@@ -55,6 +55,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include "src/common/fnv_hash.h"
 #include "src/common/gres.h"
 #include "src/common/hostlist.h"
 #include "src/common/macros.h"
@@ -93,6 +94,14 @@ bitstr_t *power_node_bitmap = NULL;	/* bitmap of powered down nodes */
 bitstr_t *share_node_bitmap = NULL;  	/* bitmap of sharable nodes */
 bitstr_t *up_node_bitmap    = NULL;  	/* bitmap of non-down nodes */
 
+/* Hash and change time of each packed node record for SHOW_DELTA requests,
+ * indexed like node_record_table_ptr */
+static uint64_t *node_pack_hash = NULL;
+static time_t   *node_pack_time = NULL;
+static int       node_pack_cnt = 0;
+static uint16_t  node_pack_version = 0;
+static time_t    node_pack_start = 0;	/* changes known since this time */
+
 static void 	_dump_node_state (struct node_record *dump_node_ptr,
 				  Buf buffer);
 static front_end_record_t * _front_end_reg(
@@ -103,6 +112,9 @@ static bool	_node_is_hidden(struct node_record *node_ptr);
 static int	_open_node_state_file(char **state_file);
 static void 	_pack_node (struct node_record *dump_node_ptr, Buf buffer,
 			    uint16_t protocol_version);
+static void	_pack_all_node_delta(Buf buffer, uint16_t show_flags,
+				     uid_t uid, uint16_t protocol_version,
+				     time_t update_time);
 static void	_sync_bitmaps(struct node_record *node_ptr, int job_count);
 static void	_update_config_ptr(bitstr_t *bitmap,
 				struct config_record *config_ptr);
@@ -561,6 +573,100 @@ static bool _node_is_hidden(struct node_record *node_ptr)
 	return true;
 }
 
+/* Return true if a node's record is packed without its name for this user */
+static bool _node_pack_hidden(struct node_record *node_ptr,
+			      uint16_t show_flags, uid_t uid)
+{
+	if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
+	    (_node_is_hidden(node_ptr)))
+		return true;
+	if (IS_NODE_FUTURE(node_ptr))
+		return true;
+	if ((node_ptr->name == NULL) || (node_ptr->name[0] == '\0'))
+		return true;
+	return false;
+}
+
+/*
+ * Pack a RESPONSE_NODE_INFO_DELTA message body with the records of nodes
+ *	changed since update_time, identified by node table index. Every
+ *	record is packed to detect changes, only changed ones are sent.
+ * NOTE: WRITE lock_slurmctld node before entry
+ */
+static void _pack_all_node_delta(Buf buffer, uint16_t show_flags,
+				 uid_t uid, uint16_t protocol_version,
+				 time_t update_time)
+{
+	struct node_record *node_ptr = node_record_table_ptr;
+	uint32_t nodes_packed = 0, count_offset, tmp_offset, node_scaling;
+	uint64_t hash;
+	time_t now = time(NULL);
+	bool full = true;
+	char *orig_name;
+	Buf rec_buf;
+	int inx;
+
+	if ((node_pack_cnt != node_record_count) ||
+	    (node_pack_version != protocol_version)) {
+		xfree(node_pack_hash);
+		xfree(node_pack_time);
+		node_pack_cnt = node_record_count;
+		node_pack_version = protocol_version;
+		node_pack_hash = xmalloc(sizeof(uint64_t) *
+					 MAX(node_pack_cnt, 1));
+		node_pack_time = xmalloc(sizeof(time_t) *
+					 MAX(node_pack_cnt, 1));
+		node_pack_start = now;
+	}
+	/* Partition changes alter which nodes the user may see */
+	if (update_time && (update_time >= node_pack_start) &&
+	    (update_time > last_part_update))
+		full = false;
+
+	pack_time(now, buffer);
+	pack16((uint16_t) full, buffer);
+	select_g_alter_node_cnt(SELECT_GET_NODE_SCALING, &node_scaling);
+	pack32(node_scaling, buffer);
+	count_offset = get_buf_offset(buffer);
+	pack32(nodes_packed, buffer);
+
+	rec_buf = init_buf(BUF_SIZE);
+	for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
+		xassert (node_ptr->magic == NODE_MAGIC);
+		xassert (node_ptr->config_ptr->magic == CONFIG_MAGIC);
+
+		set_buf_offset(rec_buf, 0);
+		_pack_node(node_ptr, rec_buf, protocol_version);
+		hash = fnv_hash64(get_buf_data(rec_buf),
+				  get_buf_offset(rec_buf));
+		if ((node_pack_time[inx] == 0) || (node_pack_hash[inx] != hash)) {
+			node_pack_hash[inx] = hash;
+			node_pack_time[inx] = now;
+		}
+		if (!full && (node_pack_time[inx] < update_time))
+			continue;
+
+		if (_node_pack_hidden(node_ptr, show_flags, uid)) {
+			orig_name = node_ptr->name;
+			node_ptr->name = NULL;
+			set_buf_offset(rec_buf, 0);
+			_pack_node(node_ptr, rec_buf, protocol_version);
+			node_ptr->name = orig_name;
+		}
+		pack32((uint32_t) inx, buffer);
+		packmem(get_buf_data(rec_buf), get_buf_offset(rec_buf),
+			buffer);
+		nodes_packed++;
+	}
+	free_buf(rec_buf);
+	pack32_array(NULL, 0, buffer);	/* nodes are never removed */
+
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, count_offset);
+	pack32(nodes_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+}
+
 /*
  * pack_all_node - dump all configuration and node information for all nodes
  *	in machine independent form (for network transmission)
@@ -569,6 +675,8 @@ static bool _node_is_hidden(struct node_record *node_ptr)
  * IN show_flags - node filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN protocol_version - slurm protocol version of client
+ * IN update_time - with SHOW_DELTA, pack only nodes changed since this time
+ *	as a RESPONSE_NODE_INFO_DELTA message
  * global: node_record_table_ptr - pointer to global node table
  * NOTE: the caller must xfree the buffer at *buffer_ptr
  * NOTE: change slurm_load_node() in api/node_info.c when data format changes
@@ -576,7 +684,7 @@ static bool _node_is_hidden(struct node_record *node_ptr)
  */
 extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
-			   uint16_t protocol_version)
+			   uint16_t protocol_version, time_t update_time)
 {
 	int inx;
 	uint32_t nodes_packed, tmp_offset, node_scaling;
@@ -591,6 +699,16 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	buffer = init_buf (BUF_SIZE*16);
 	nodes_packed = 0;
 
+	if (show_flags & SHOW_DELTA) {
+		part_filter_set(uid);
+		_pack_all_node_delta(buffer, show_flags & (~SHOW_DELTA), uid,
+				     protocol_version, update_time);
+		part_filter_clear();
+		*buffer_size = get_buf_offset(buffer);
+		buffer_ptr[0] = xfer_buf_data(buffer);
+		return;
+	}
+
 	if (protocol_version >= SLURM_2_1_PROTOCOL_VERSION) {
 		/* write header: count and time */
 		pack32(nodes_packed, buffer);
@@ -611,16 +729,7 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			 * the node index pointers. So pack a node
 			 * with a name of NULL and let the caller deal
 			 * with it. */
-			hidden = false;
-			if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
-			    (_node_is_hidden(node_ptr)))
-				hidden = true;
-			else if (IS_NODE_FUTURE(node_ptr))
-				hidden = true;
-			else if ((node_ptr->name == NULL) ||
-				 (node_ptr->name[0] == '\0'))
-				hidden = true;
-
+			hidden = _node_pack_hidden(node_ptr, show_flags, uid);
 			if (hidden) {
 				char *orig_name = node_ptr->name;
 				node_ptr->name = NULL;
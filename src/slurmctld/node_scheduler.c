@@ -751,9 +751,9 @@ _pick_best_nodes(struct node_set *node_set_ptr, int node_set_size,
 						   share_node_bitmap)) {
 					return ESLURM_NODES_BUSY;
 				}
-				if (bit_overlap(job_ptr->details->
-						req_node_bitmap,
-						cg_node_bitmap)) {
+				if (bit_overlap_any(job_ptr->details->
+						    req_node_bitmap,
+						    cg_node_bitmap)) {
 					return ESLURM_NODES_BUSY;
 				}
 			} else {
@@ -764,8 +764,8 @@ _pick_best_nodes(struct node_set *node_set_ptr, int node_set_size,
 				}
 				/* Note: IDLE nodes are not COMPLETING */
 			}
-		} else if (bit_overlap(job_ptr->details->req_node_bitmap,
-				       cg_node_bitmap)) {
+		} else if (bit_overlap_any(job_ptr->details->req_node_bitmap,
+					   cg_node_bitmap)) {
 			return ESLURM_NODES_BUSY;
 		}
 
@@ -838,20 +838,16 @@ _pick_best_nodes(struct node_set *node_set_ptr, int node_set_size,
 				if (shared) {
 					bit_and(node_set_ptr[i].my_bitmap,
 						share_node_bitmap);
-					bit_not(cg_node_bitmap);
-					bit_and(node_set_ptr[i].my_bitmap,
-						cg_node_bitmap);
-					bit_not(cg_node_bitmap);
+					bit_and_not(node_set_ptr[i].my_bitmap,
+						    cg_node_bitmap);
 				} else {
 					bit_and(node_set_ptr[i].my_bitmap,
 						idle_node_bitmap);
 					/* IDLE nodes are not COMPLETING */
 				}
 			} else {
-				bit_not(cg_node_bitmap);
-				bit_and(node_set_ptr[i].my_bitmap,
-					cg_node_bitmap);
-				bit_not(cg_node_bitmap);
+				bit_and_not(node_set_ptr[i].my_bitmap,
+					    cg_node_bitmap);
 			}
 			if (avail_bitmap) {
 				bit_or(avail_bitmap,
@@ -1381,6 +1377,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 	configuring = IS_JOB_CONFIGURING(job_ptr);
 
 	job_ptr->job_state = JOB_RUNNING;
+	notify_job_dependents(job_ptr);
 	if (configuring
 	    || bit_overlap(job_ptr->node_bitmap, power_node_bitmap))
 		job_ptr->job_state |= JOB_CONFIGURING;
@@ -1675,9 +1672,8 @@ static int _build_node_list(struct job_record *job_ptr,
 	node_set_ptr[node_set_inx+1].my_bitmap = NULL;
 	if (detail_ptr->exc_node_bitmap) {
 		if (usable_node_mask) {
-			bit_not(detail_ptr->exc_node_bitmap);
-			bit_and(usable_node_mask, detail_ptr->exc_node_bitmap);
-			bit_not(detail_ptr->exc_node_bitmap);
+			bit_and_not(usable_node_mask,
+				    detail_ptr->exc_node_bitmap);
 		} else {
 			usable_node_mask =
 				bit_copy(detail_ptr->exc_node_bitmap);
@@ -70,6 +70,7 @@
 #include "src/common/slurm_priority.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_topology.h"
+#include "src/common/slurmdbd_defs.h"
 #include "src/common/switch.h"
 #include "src/common/xstring.h"
 
@@ -89,10 +90,50 @@
 
 #include "src/plugins/select/bluegene/bg_enums.h"
 
+/* RPC statistics by message type or by user, see _rpc_stats_add() */
+typedef struct rpc_stats {
+	uint32_t  size;		/* records in use */
+	uint32_t  alloc;	/* records allocated */
+	uint32_t *id;		/* message type or user ID */
+	uint32_t *cnt;
+	uint64_t *time;		/* total processing time in usec */
+	uint32_t *time_max;
+	uint32_t *limited;	/* RPCs rejected by the rate limiter */
+} rpc_stats_t;
+
+static pthread_mutex_t rpc_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rpc_stats_t rpc_type_stats, rpc_user_stats;
+
+/* Per user token bucket for RPC rate limiting, see _rpc_rate_limited() */
+#define RPC_BUCKET_HASH_SIZE 256
+typedef struct rpc_bucket {
+	uint32_t uid;
+	double   tokens;		/* RPCs the user may issue now */
+	struct timeval refill_time;	/* time tokens were last added */
+	struct rpc_bucket *next;
+} rpc_bucket_t;
+
+static pthread_mutex_t rpc_limit_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rpc_bucket_t *rpc_bucket_hash[RPC_BUCKET_HASH_SIZE];
+static time_t   rpc_limit_update = 0;	/* time of config last read */
+static uint32_t rpc_rate_limit = 0;	/* RPCs per second per user, 0=none */
+static uint32_t rpc_rate_burst = 0;	/* token bucket size */
+
+static char **      _copy_str_array(char **array, uint32_t cnt);
 static void         _fill_ctld_conf(slurm_ctl_conf_t * build_ptr);
+static void         _fill_lock_stats(stats_info_response_msg_t *stats);
+static void         _fill_rpc_queue_stats(stats_info_response_msg_t *stats);
+static void         _fill_stats_info(stats_info_response_msg_t *stats);
 static void         _kill_job_on_msg_fail(uint32_t job_id);
 static int 	    _launch_batch_step(job_desc_msg_t *job_desc_msg,
 				       uid_t uid, uint32_t *step_id);
+static void         _load_rpc_limit_config(void);
+static void         _reset_stats_info(void);
+static bool         _rpc_rate_limited(slurm_msg_t *msg, uid_t uid);
+static void         _rpc_stats_add(rpc_stats_t *stats, uint32_t id,
+				   long delta_t, bool limited);
+static void         _rpc_stats_record(slurm_msg_t *msg, uid_t uid,
+				      long delta_t, bool limited);
 static int          _make_step_cred(struct step_record *step_rec,
 				    slurm_cred_t **slurm_cred);
 
@@ -110,8 +151,10 @@ inline static void  _slurm_rpc_dump_conf(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_front_end(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_jobs(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_job_single(slurm_msg_t * msg);
+inline static void  _slurm_rpc_dump_job_user(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_nodes(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_partitions(slurm_msg_t * msg);
+inline static void  _slurm_rpc_dump_stats(slurm_msg_t * msg);
 inline static void  _slurm_rpc_end_time(slurm_msg_t * msg);
 inline static void  _slurm_rpc_epilog_complete(slurm_msg_t * msg);
 inline static void  _slurm_rpc_get_shares(slurm_msg_t *msg);
@@ -146,6 +189,7 @@ inline static void  _slurm_rpc_step_complete(slurm_msg_t * msg);
 inline static void  _slurm_rpc_step_layout(slurm_msg_t * msg);
 inline static void  _slurm_rpc_step_update(slurm_msg_t * msg);
 inline static void  _slurm_rpc_submit_batch_job(slurm_msg_t * msg);
+inline static void  _slurm_rpc_submit_batch_job_multi(slurm_msg_t * msg);
 inline static void  _slurm_rpc_suspend(slurm_msg_t * msg);
 inline static void  _slurm_rpc_trigger_clear(slurm_msg_t * msg);
 inline static void  _slurm_rpc_trigger_get(slurm_msg_t * msg);
@@ -167,14 +211,26 @@ inline static void  _update_cred_key(void);
  */
 void slurmctld_req (slurm_msg_t * msg)
 {
+	DEF_TIMERS;
+	uid_t uid;
+
 	/* Just to validate the cred */
-	(void) g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
 	if (g_slurm_auth_errno(msg->auth_cred) != SLURM_SUCCESS) {
 		error("Bad authentication: %s",
 		      g_slurm_auth_errstr(g_slurm_auth_errno(msg->auth_cred)));
 		return;
 	}
 
+	START_TIMER;
+	if (_rpc_rate_limited(msg, uid)) {
+		slurm_send_rc_msg(msg, ESLURM_RPC_RATE_LIMITED);
+		slurm_free_msg_data(msg->msg_type, msg->data);
+		END_TIMER;
+		_rpc_stats_record(msg, uid, DELTA_TIMER, true);
+		return;
+	}
+
 	switch (msg->msg_type) {
 	case REQUEST_RESOURCE_ALLOCATION:
 		_slurm_rpc_allocate_resources(msg);
@@ -192,6 +248,10 @@ void slurmctld_req (slurm_msg_t * msg)
 		_slurm_rpc_dump_job_single(msg);
 		slurm_free_job_id_msg(msg->data);
 		break;
+	case REQUEST_JOB_USER_INFO:
+		_slurm_rpc_dump_job_user(msg);
+		slurm_free_job_user_id_msg(msg->data);
+		break;
 	case REQUEST_SHARE_INFO:
 		_slurm_rpc_get_shares(msg);
 		slurm_free_shares_request_msg(msg->data);
@@ -288,6 +348,10 @@ void slurmctld_req (slurm_msg_t * msg)
 		_slurm_rpc_submit_batch_job(msg);
 		slurm_free_job_desc_msg(msg->data);
 		break;
+	case REQUEST_SUBMIT_BATCH_JOB_MULTI:
+		_slurm_rpc_submit_batch_job_multi(msg);
+		slurm_free_job_desc_multi_msg(msg->data);
+		break;
 	case REQUEST_UPDATE_FRONT_END:
 		_slurm_rpc_update_front_end(msg);
 		slurm_free_update_front_end_msg(msg->data);
@@ -426,11 +490,157 @@ void slurmctld_req (slurm_msg_t * msg)
 		_slurm_rpc_dump_spank(msg);
 		slurm_free_spank_env_request_msg(msg->data);
 		break;
+	case REQUEST_STATS_INFO:
+		_slurm_rpc_dump_stats(msg);
+		slurm_free_stats_info_request_msg(msg->data);
+		break;
 	default:
 		error("invalid RPC msg_type=%d", msg->msg_type);
 		slurm_send_rc_msg(msg, EINVAL);
 		break;
 	}
+	END_TIMER;
+	_rpc_stats_record(msg, uid, DELTA_TIMER, false);
+}
+
+/* Read the RPC rate limit options from SchedulerParameters.
+ * Call with rpc_limit_mutex locked. */
+static void _load_rpc_limit_config(void)
+{
+	char *sched_params, *tmp_ptr;
+	int i;
+
+	rpc_rate_limit = 0;
+	rpc_rate_burst = 0;
+	sched_params = slurm_get_sched_params();
+	if (sched_params &&
+	    (tmp_ptr = strstr(sched_params, "rpc_rate_limit="))) {
+		i = atoi(tmp_ptr + 15);
+		if (i < 0) {
+			error("Invalid SchedulerParameters rpc_rate_limit: %d",
+			      i);
+		} else
+			rpc_rate_limit = i;
+	}
+	if (sched_params &&
+	    (tmp_ptr = strstr(sched_params, "rpc_rate_burst="))) {
+		i = atoi(tmp_ptr + 15);
+		if (i < 1) {
+			error("Invalid SchedulerParameters rpc_rate_burst: %d",
+			      i);
+		} else
+			rpc_rate_burst = i;
+	}
+	if (rpc_rate_burst == 0)
+		rpc_rate_burst = MAX(rpc_rate_limit, 1);
+	xfree(sched_params);
+}
+
+/* Return true if the user has exceeded their RPC rate limit, otherwise
+ * take one token from the user's bucket. High priority RPCs (node state,
+ * job and step completion) and those of root or SlurmUser are not limited,
+ * nor is anything unless SchedulerParameters sets rpc_rate_limit. */
+static bool _rpc_rate_limited(slurm_msg_t *msg, uid_t uid)
+{
+	rpc_bucket_t *bucket;
+	struct timeval now;
+	double delta_t;
+	bool limited = false;
+
+	if ((rpc_msg_prio(msg->msg_type) == RPC_PRIO_HIGH) ||
+	    validate_slurm_user(uid))
+		return false;
+
+	slurm_mutex_lock(&rpc_limit_mutex);
+	if (rpc_limit_update != slurmctld_conf.last_update) {
+		rpc_limit_update = slurmctld_conf.last_update;
+		_load_rpc_limit_config();
+	}
+	if (rpc_rate_limit == 0) {
+		slurm_mutex_unlock(&rpc_limit_mutex);
+		return false;
+	}
+
+	gettimeofday(&now, NULL);
+	bucket = rpc_bucket_hash[uid % RPC_BUCKET_HASH_SIZE];
+	while (bucket && (bucket->uid != uid))
+		bucket = bucket->next;
+	if (bucket == NULL) {
+		bucket = xmalloc(sizeof(rpc_bucket_t));
+		bucket->uid = uid;
+		bucket->tokens = rpc_rate_burst;
+		bucket->refill_time = now;
+		bucket->next = rpc_bucket_hash[uid % RPC_BUCKET_HASH_SIZE];
+		rpc_bucket_hash[uid % RPC_BUCKET_HASH_SIZE] = bucket;
+	} else {
+		delta_t  = now.tv_sec - bucket->refill_time.tv_sec;
+		delta_t += (now.tv_usec - bucket->refill_time.tv_usec) /
+			   1000000.0;
+		if (delta_t > 0) {
+			bucket->tokens += delta_t * rpc_rate_limit;
+			bucket->refill_time = now;
+		}
+		if (bucket->tokens > rpc_rate_burst)
+			bucket->tokens = rpc_rate_burst;
+	}
+	if (bucket->tokens >= 1.0)
+		bucket->tokens -= 1.0;
+	else
+		limited = true;
+	slurm_mutex_unlock(&rpc_limit_mutex);
+
+	if (limited) {
+		debug("RPC rate limit exceeded by uid=%u, %s rejected",
+		      (uint32_t) uid, rpc_num2string(msg->msg_type));
+	}
+	return limited;
+}
+
+/* Record one RPC's processing time by message type and by user */
+static void _rpc_stats_record(slurm_msg_t *msg, uid_t uid, long delta_t,
+			      bool limited)
+{
+	slurm_mutex_lock(&rpc_stats_mutex);
+	_rpc_stats_add(&rpc_type_stats, msg->msg_type, delta_t, limited);
+	_rpc_stats_add(&rpc_user_stats, uid, delta_t, limited);
+	slurm_mutex_unlock(&rpc_stats_mutex);
+}
+
+/* Add one RPC's processing time to its statistics record, creating the
+ * record if needed. Call with rpc_stats_mutex locked. */
+static void _rpc_stats_add(rpc_stats_t *stats, uint32_t id, long delta_t,
+			   bool limited)
+{
+	uint32_t i;
+
+	for (i = 0; i < stats->size; i++) {
+		if (stats->id[i] == id)
+			break;
+	}
+	if (i == stats->size) {
+		if (stats->size == stats->alloc) {
+			stats->alloc = MAX(stats->alloc * 2, 64);
+			xrealloc(stats->id, sizeof(uint32_t) * stats->alloc);
+			xrealloc(stats->cnt, sizeof(uint32_t) * stats->alloc);
+			xrealloc(stats->time, sizeof(uint64_t) * stats->alloc);
+			xrealloc(stats->time_max,
+				 sizeof(uint32_t) * stats->alloc);
+			xrealloc(stats->limited,
+				 sizeof(uint32_t) * stats->alloc);
+		}
+		stats->id[i] = id;
+		stats->cnt[i] = 0;
+		stats->time[i] = 0;
+		stats->time_max[i] = 0;
+		stats->limited[i] = 0;
+		stats->size++;
+	}
+	stats->cnt[i]++;
+	stats->time[i] += delta_t;
+	if (delta_t > stats->time_max[i])
+		stats->time_max[i] = delta_t;
+	if (limited)
+		stats->limited[i]++;
 }
 
 /*
@@ -932,22 +1142,50 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 	/* Locks: Read config job, write node (for hiding) */
 	slurmctld_lock_t job_read_lock = {
 		READ_LOCK, READ_LOCK, NO_LOCK, WRITE_LOCK };
+	/* Locks: Read config part (for hiding cached jobs) */
+	slurmctld_lock_t cache_read_lock = {
+		READ_LOCK, NO_LOCK, NO_LOCK, READ_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	uint16_t show_flags = job_info_request_msg->show_flags;
+	int rc;
 
 	START_TIMER;
 	debug3("Processing RPC: REQUEST_JOB_INFO from uid=%d", uid);
-	lock_slurmctld(job_read_lock);
+	/* Detailed job records are not pre-packed, send them all */
+	if (show_flags & SHOW_DETAIL)
+		show_flags &= (~SHOW_DELTA);
+	lock_slurmctld(cache_read_lock);
+	rc = pack_all_jobs_cached(&dump, &dump_size, show_flags, uid,
+				  msg->protocol_version,
+				  job_info_request_msg->last_update, false);
+	unlock_slurmctld(cache_read_lock);
+	if ((rc != SLURM_SUCCESS) && try_lock_slurmctld(job_read_lock)) {
+		/* A writer holds or awaits the job lock. Rather than wait,
+		 * send the jobs as last packed, the client's next request
+		 * picks up the changes made since then. */
+		lock_slurmctld(cache_read_lock);
+		rc = pack_all_jobs_cached(&dump, &dump_size, show_flags, uid,
+					  msg->protocol_version,
+					  job_info_request_msg->last_update,
+					  true);
+		unlock_slurmctld(cache_read_lock);
+		if (rc != SLURM_SUCCESS)
+			lock_slurmctld(job_read_lock);
+	}
 
 	if ((job_info_request_msg->last_update - 1) >= last_job_update) {
-		unlock_slurmctld(job_read_lock);
+		if (rc != SLURM_SUCCESS)
+			unlock_slurmctld(job_read_lock);
+		xfree(dump);
 		debug3("_slurm_rpc_dump_jobs, no change");
 		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
 	} else {
-		pack_all_jobs(&dump, &dump_size,
-			      job_info_request_msg->show_flags,
-			      g_slurm_auth_get_uid(msg->auth_cred, NULL),
-			      msg->protocol_version);
-		unlock_slurmctld(job_read_lock);
+		if (rc != SLURM_SUCCESS) {
+			pack_all_jobs(&dump, &dump_size, show_flags, uid,
+				      msg->protocol_version,
+				      job_info_request_msg->last_update);
+			unlock_slurmctld(job_read_lock);
+		}
 		END_TIMER2("_slurm_rpc_dump_jobs");
 /* 		info("_slurm_rpc_dump_jobs, size=%d %s", */
 /* 		     dump_size, TIME_STR); */
@@ -957,7 +1195,10 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 		response_msg.flags = msg->flags;
 		response_msg.protocol_version = msg->protocol_version;
 		response_msg.address = msg->address;
-		response_msg.msg_type = RESPONSE_JOB_INFO;
+		if (show_flags & SHOW_DELTA)
+			response_msg.msg_type = RESPONSE_JOB_INFO_DELTA;
+		else
+			response_msg.msg_type = RESPONSE_JOB_INFO;
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 
@@ -1008,6 +1249,40 @@ static void _slurm_rpc_dump_job_single(slurm_msg_t * msg)
 	xfree(dump);
 }
 
+/* _slurm_rpc_dump_job_user - process RPC for the state information of the
+ *	jobs of one user and/or with one name */
+static void _slurm_rpc_dump_job_user(slurm_msg_t * msg)
+{
+	DEF_TIMERS;
+	char *dump = NULL;
+	int dump_size;
+	slurm_msg_t response_msg;
+	job_user_id_msg_t *job_user_msg = (job_user_id_msg_t *) msg->data;
+	/* Locks: Read config job, write node (for hiding) */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, NO_LOCK, WRITE_LOCK };
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+
+	START_TIMER;
+	debug3("Processing RPC: REQUEST_JOB_USER_INFO from uid=%d", uid);
+	lock_slurmctld(job_read_lock);
+	pack_user_jobs(&dump, &dump_size, job_user_msg->user_id,
+		       job_user_msg->job_name, job_user_msg->show_flags, uid,
+		       msg->protocol_version);
+	unlock_slurmctld(job_read_lock);
+	END_TIMER2("_slurm_rpc_dump_job_user");
+
+	slurm_msg_t_init(&response_msg);
+	response_msg.flags = msg->flags;
+	response_msg.protocol_version = msg->protocol_version;
+	response_msg.address = msg->address;
+	response_msg.msg_type = RESPONSE_JOB_INFO;
+	response_msg.data = dump;
+	response_msg.data_size = dump_size;
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	xfree(dump);
+}
+
 static void  _slurm_rpc_get_shares(slurm_msg_t *msg)
 {
 	DEF_TIMERS;
@@ -1181,7 +1456,8 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	} else {
 
 		pack_all_node(&dump, &dump_size, node_req_msg->show_flags,
-			      uid, msg->protocol_version);
+			      uid, msg->protocol_version,
+			      node_req_msg->last_update);
 		unlock_slurmctld(node_write_lock);
 		END_TIMER2("_slurm_rpc_dump_nodes");
 		debug3("_slurm_rpc_dump_nodes, size=%d %s",
@@ -1192,7 +1468,10 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 		response_msg.flags = msg->flags;
 		response_msg.protocol_version = msg->protocol_version;
 		response_msg.address = msg->address;
-		response_msg.msg_type = RESPONSE_NODE_INFO;
+		if (node_req_msg->show_flags & SHOW_DELTA)
+			response_msg.msg_type = RESPONSE_NODE_INFO_DELTA;
+		else
+			response_msg.msg_type = RESPONSE_NODE_INFO;
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 
@@ -2640,6 +2919,159 @@ static void _slurm_rpc_submit_batch_job(slurm_msg_t * msg)
 	}
 }
 
+/* Return an xmalloc'ed copy of an array of cnt strings */
+static char **_copy_str_array(char **array, uint32_t cnt)
+{
+	char **copy;
+	uint32_t i;
+
+	if (array == NULL)
+		return NULL;
+	copy = xmalloc(sizeof(char *) * (cnt + 1));
+	for (i = 0; i < cnt; i++)
+		copy[i] = xstrdup(array[i]);
+	return copy;
+}
+
+/* _slurm_rpc_submit_batch_job_multi - process RPC to submit job_cnt
+ *	identical batch jobs. All jobs are created under one acquisition of
+ *	the job write lock and submission stops at the first job which can
+ *	not be created. The response lists the IDs of the jobs created. */
+static void _slurm_rpc_submit_batch_job_multi(slurm_msg_t * msg)
+{
+	int error_code = SLURM_SUCCESS;
+	DEF_TIMERS;
+	uint32_t i;
+	struct job_record *job_ptr = NULL;
+	slurm_msg_t response_msg;
+	submit_multi_response_msg_t submit_msg;
+	job_desc_multi_msg_t *multi_msg = (job_desc_multi_msg_t *) msg->data;
+	job_desc_msg_t *job_desc_msg = multi_msg->job_desc;
+	char **argv, **spank_job_env;
+	uint32_t argc, spank_job_env_size;
+	/* Locks: Write job, read node, read partition */
+	slurmctld_lock_t job_write_lock = {
+		NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+
+	START_TIMER;
+	debug2("Processing RPC: REQUEST_SUBMIT_BATCH_JOB_MULTI from uid=%d",
+	       uid);
+
+	/* do RPC call */
+	if ( (uid != job_desc_msg->user_id) && (!validate_slurm_user(uid)) ) {
+		/* NOTE: User root can submit a batch job for any other user */
+		error_code = ESLURM_USER_ID_MISSING;
+		error("Security violation, SUBMIT_JOB_MULTI from uid=%d", uid);
+	}
+	if ((job_desc_msg->alloc_node == NULL) ||
+	    (job_desc_msg->alloc_node[0] == '\0')) {
+		error_code = ESLURM_INVALID_NODE_NAME;
+		error("REQUEST_SUBMIT_BATCH_JOB_MULTI lacks alloc_node from "
+		      "uid=%d", uid);
+	}
+	if (job_desc_msg->job_id != SLURM_BATCH_SCRIPT) {
+		/* Each job needs its own job ID */
+		error_code = ESLURM_INVALID_JOB_ID;
+	}
+	if (multi_msg->job_cnt == 0)
+		error_code = SLURM_ERROR;
+	else if (multi_msg->job_cnt > SUBMIT_MULTI_MAX_JOBS) {
+		/* Bounds the time the job write lock is held */
+		error_code = ESLURM_INVALID_JOB_COUNT;
+		error("REQUEST_SUBMIT_BATCH_JOB_MULTI for %u jobs from uid=%d",
+		      multi_msg->job_cnt, uid);
+	}
+	if (error_code != SLURM_SUCCESS) {
+		info("_slurm_rpc_submit_batch_job_multi: %s",
+		     slurm_strerror(error_code));
+		slurm_send_rc_msg(msg, error_code);
+		return;
+	}
+	dump_job_desc(job_desc_msg);
+
+	/* job_allocate() moves argv and spank_job_env into the job record,
+	 * so give each job but the last its own copy */
+	argc = job_desc_msg->argc;
+	argv = job_desc_msg->argv;
+	spank_job_env_size = job_desc_msg->spank_job_env_size;
+	spank_job_env = job_desc_msg->spank_job_env;
+
+	memset(&submit_msg, 0, sizeof(submit_multi_response_msg_t));
+	submit_msg.job_id = xmalloc(sizeof(uint32_t) * multi_msg->job_cnt);
+	lock_slurmctld(job_write_lock);
+	for (i = 0; i < multi_msg->job_cnt; i++) {
+		if (i < (multi_msg->job_cnt - 1)) {
+			job_desc_msg->argv = _copy_str_array(argv, argc);
+			job_desc_msg->spank_job_env = _copy_str_array(
+				spank_job_env, spank_job_env_size);
+		} else {
+			job_desc_msg->argv = argv;
+			job_desc_msg->spank_job_env = spank_job_env;
+			argv = NULL;
+			spank_job_env = NULL;
+		}
+		job_desc_msg->argc = argc;
+		job_desc_msg->spank_job_env_size = spank_job_env_size;
+
+		job_ptr = NULL;
+		error_code = job_allocate(job_desc_msg,
+					  job_desc_msg->immediate,
+					  false, NULL, 0, uid, &job_ptr);
+		if ((error_code != SLURM_SUCCESS) &&
+		    (error_code != ESLURM_JOB_HELD) &&
+		    (error_code != ESLURM_NODE_NOT_AVAIL) &&
+		    (error_code != ESLURM_QOS_THRES) &&
+		    (error_code != ESLURM_RESERVATION_NOT_USABLE) &&
+		    (error_code != ESLURM_REQUESTED_PART_CONFIG_UNAVAILABLE))
+			break;
+		submit_msg.job_id[submit_msg.job_cnt++] = job_ptr->job_id;
+	}
+	unlock_slurmctld(job_write_lock);
+	END_TIMER2("_slurm_rpc_submit_batch_job_multi");
+
+	/* Free the arrays job_allocate() did not take. If the loop stopped
+	 * early, the copies in job_desc_msg are freed with the message. */
+	if (argv) {
+		for (i = 0; i < argc; i++)
+			xfree(argv[i]);
+		xfree(argv);
+	}
+	if (spank_job_env) {
+		for (i = 0; i < spank_job_env_size; i++)
+			xfree(spank_job_env[i]);
+		xfree(spank_job_env);
+	}
+
+	/* return result */
+	if (submit_msg.job_cnt == 0) {
+		info("_slurm_rpc_submit_batch_job_multi: %s",
+		     slurm_strerror(error_code));
+		slurm_send_rc_msg(msg, error_code);
+	} else {
+		if (submit_msg.job_cnt < multi_msg->job_cnt) {
+			info("_slurm_rpc_submit_batch_job_multi: %u of %u "
+			     "jobs submitted: %s", submit_msg.job_cnt,
+			     multi_msg->job_cnt, slurm_strerror(error_code));
+		}
+		info("_slurm_rpc_submit_batch_job_multi JobId=%u-%u Count=%u "
+		     "%s", submit_msg.job_id[0],
+		     submit_msg.job_id[submit_msg.job_cnt - 1],
+		     submit_msg.job_cnt, TIME_STR);
+		submit_msg.error_code = error_code;
+		slurm_msg_t_init(&response_msg);
+		response_msg.flags = msg->flags;
+		response_msg.protocol_version = msg->protocol_version;
+		response_msg.msg_type = RESPONSE_SUBMIT_BATCH_JOB_MULTI;
+		response_msg.data = &submit_msg;
+		slurm_send_node_msg(msg->conn_fd, &response_msg);
+		schedule(0);		/* has own locks */
+		schedule_job_save();	/* has own locks */
+		schedule_node_save();	/* has own locks */
+	}
+	xfree(submit_msg.job_id);
+}
+
 /* _slurm_rpc_update_job - process RPC to update the configuration of a
  *	job (e.g. priority) */
 static void _slurm_rpc_update_job(slurm_msg_t * msg)
@@ -3509,7 +3941,7 @@ xduparray(uint16_t size, char ** array)
 }
 
 /* Like xduparray(), but performs one xmalloc().  The output format of this
- * must be identical to _read_data_array_from_file() */
+ * must be identical to _read_data_array_from_store() */
 static char **
 _xduparray2(uint16_t size, char ** array)
 {
@@ -4138,3 +4570,255 @@ inline static void _slurm_rpc_dump_spank(slurm_msg_t * msg)
 	slurm_send_node_msg(msg->conn_fd, &response_msg);
 	slurm_free_spank_env_responce_msg(spank_resp_msg);
 }
+
+/* Copy the slurmctld lock statistics into a stats response message */
+static void _fill_lock_stats(stats_info_response_msg_t *stats)
+{
+	lock_stats_t lock_stats[ENTITY_COUNT * 2], *lock_ptr;
+	lock_caller_stats_t *callers = NULL;
+	int caller_cnt, i;
+
+	(void) get_lock_stats(lock_stats, &callers, &caller_cnt);
+
+	stats->lock_type_size = ENTITY_COUNT * 2;
+	stats->lock_type_name = xmalloc(sizeof(char *) * ENTITY_COUNT * 2);
+	stats->lock_type_cnt = xmalloc(sizeof(uint32_t) * ENTITY_COUNT * 2);
+	stats->lock_type_contended =
+		xmalloc(sizeof(uint32_t) * ENTITY_COUNT * 2);
+	stats->lock_type_wait = xmalloc(sizeof(uint64_t) * ENTITY_COUNT * 2);
+	stats->lock_type_wait_max =
+		xmalloc(sizeof(uint32_t) * ENTITY_COUNT * 2);
+	stats->lock_type_hold = xmalloc(sizeof(uint64_t) * ENTITY_COUNT * 2);
+	stats->lock_type_hold_max =
+		xmalloc(sizeof(uint32_t) * ENTITY_COUNT * 2);
+	for (i = 0; i < (ENTITY_COUNT * 2); i++) {
+		lock_ptr = &lock_stats[i];
+		stats->lock_type_name[i] = xstrdup_printf("%s_%s",
+				lock_datatype_string(i / 2),
+				(i % 2) ? "write" : "read");
+		stats->lock_type_cnt[i] = lock_ptr->count;
+		stats->lock_type_contended[i] = lock_ptr->contended;
+		stats->lock_type_wait[i] = lock_ptr->wait_usec;
+		stats->lock_type_wait_max[i] = lock_ptr->wait_max_usec;
+		stats->lock_type_hold[i] = lock_ptr->hold_usec;
+		stats->lock_type_hold_max[i] = lock_ptr->hold_max_usec;
+	}
+
+	stats->lock_caller_size = caller_cnt;
+	stats->lock_caller_name = xmalloc(sizeof(char *) * caller_cnt);
+	stats->lock_caller_cnt = xmalloc(sizeof(uint32_t) * caller_cnt);
+	stats->lock_caller_wait = xmalloc(sizeof(uint64_t) * caller_cnt);
+	stats->lock_caller_wait_max = xmalloc(sizeof(uint32_t) * caller_cnt);
+	stats->lock_caller_hold = xmalloc(sizeof(uint64_t) * caller_cnt);
+	stats->lock_caller_hold_max = xmalloc(sizeof(uint32_t) * caller_cnt);
+	for (i = 0; i < caller_cnt; i++) {
+		lock_ptr = &callers[i].stats;
+		stats->lock_caller_name[i] = xstrdup(callers[i].caller);
+		stats->lock_caller_cnt[i] = lock_ptr->count;
+		stats->lock_caller_wait[i] = lock_ptr->wait_usec;
+		stats->lock_caller_wait_max[i] = lock_ptr->wait_max_usec;
+		stats->lock_caller_hold[i] = lock_ptr->hold_usec;
+		stats->lock_caller_hold_max[i] = lock_ptr->hold_max_usec;
+	}
+	xfree(callers);
+}
+
+/* Copy the RPC queue statistics into a stats response message */
+static void _fill_rpc_queue_stats(stats_info_response_msg_t *stats)
+{
+	rpc_queue_stats_t queue_stats[RPC_PRIO_CNT];
+	int i;
+
+	get_rpc_queue_stats(queue_stats, &stats->rpc_queue_conn_depth,
+			    &stats->rpc_queue_workers);
+
+	stats->rpc_queue_size = RPC_PRIO_CNT;
+	stats->rpc_queue_name = xmalloc(sizeof(char *) * RPC_PRIO_CNT);
+	stats->rpc_queue_cnt = xmalloc(sizeof(uint32_t) * RPC_PRIO_CNT);
+	stats->rpc_queue_depth = xmalloc(sizeof(uint32_t) * RPC_PRIO_CNT);
+	stats->rpc_queue_depth_max = xmalloc(sizeof(uint32_t) * RPC_PRIO_CNT);
+	stats->rpc_queue_wait = xmalloc(sizeof(uint64_t) * RPC_PRIO_CNT);
+	stats->rpc_queue_wait_max = xmalloc(sizeof(uint32_t) * RPC_PRIO_CNT);
+	stats->rpc_queue_run = xmalloc(sizeof(uint64_t) * RPC_PRIO_CNT);
+	stats->rpc_queue_run_max = xmalloc(sizeof(uint32_t) * RPC_PRIO_CNT);
+	for (i = 0; i < RPC_PRIO_CNT; i++) {
+		stats->rpc_queue_name[i] = xstrdup(rpc_prio_string(i));
+		stats->rpc_queue_cnt[i] = queue_stats[i].count;
+		stats->rpc_queue_depth[i] = queue_stats[i].depth;
+		stats->rpc_queue_depth_max[i] = queue_stats[i].depth_max;
+		stats->rpc_queue_wait[i] = queue_stats[i].wait_usec;
+		stats->rpc_queue_wait_max[i] = queue_stats[i].wait_max_usec;
+		stats->rpc_queue_run[i] = queue_stats[i].run_usec;
+		stats->rpc_queue_run_max[i] = queue_stats[i].run_max_usec;
+	}
+}
+
+/* Fill in the slurmctld statistics response, the arrays must be freed
+ * by the caller */
+static void _fill_stats_info(stats_info_response_msg_t *stats)
+{
+	uint32_t i, size;
+
+	memset(stats, 0, sizeof(stats_info_response_msg_t));
+	stats->req_time = time(NULL);
+	stats->req_time_start = slurmctld_diag_stats.time_start;
+
+	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
+	stats->server_thread_count = slurmctld_config.server_thread_count;
+	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
+	stats->agent_queue_size = get_agent_queue_size();
+	stats->agent_count = get_agent_count();
+	stats->dbd_agent_queue_size = slurmdbd_agent_queue_count();
+
+	stats->schedule_cycle_counter =
+		slurmctld_diag_stats.schedule_cycle_counter;
+	stats->schedule_cycle_last = slurmctld_diag_stats.schedule_cycle_last;
+	stats->schedule_cycle_max = slurmctld_diag_stats.schedule_cycle_max;
+	stats->schedule_cycle_sum = slurmctld_diag_stats.schedule_cycle_sum;
+	stats->schedule_cycle_depth =
+		slurmctld_diag_stats.schedule_cycle_depth;
+	stats->schedule_queue_len = slurmctld_diag_stats.schedule_queue_len;
+
+	stats->bf_cycle_counter = slurmctld_diag_stats.bf_cycle_counter;
+	stats->bf_cycle_last = slurmctld_diag_stats.bf_cycle_last;
+	stats->bf_cycle_max = slurmctld_diag_stats.bf_cycle_max;
+	stats->bf_cycle_sum = slurmctld_diag_stats.bf_cycle_sum;
+	stats->bf_depth_sum = slurmctld_diag_stats.bf_depth_sum;
+	stats->bf_last_depth = slurmctld_diag_stats.bf_last_depth;
+	stats->bf_queue_len = slurmctld_diag_stats.bf_queue_len;
+	stats->bf_backfilled_jobs = slurmctld_diag_stats.bf_backfilled_jobs;
+	stats->bf_when_last_cycle = slurmctld_diag_stats.bf_when_last_cycle;
+	stats->bf_active = slurmctld_diag_stats.bf_active;
+
+	stats->state_save_counter = slurmctld_diag_stats.state_save_counter;
+	stats->state_save_last = slurmctld_diag_stats.state_save_last;
+	stats->state_save_max = slurmctld_diag_stats.state_save_max;
+	stats->state_save_sum = slurmctld_diag_stats.state_save_sum;
+
+	slurm_mutex_lock(&rpc_stats_mutex);
+	size = rpc_type_stats.size;
+	stats->rpc_type_size = size;
+	stats->rpc_type_id = xmalloc(sizeof(uint16_t) * size);
+	for (i = 0; i < size; i++)
+		stats->rpc_type_id[i] = rpc_type_stats.id[i];
+	stats->rpc_type_cnt = xmalloc(sizeof(uint32_t) * size);
+	memcpy(stats->rpc_type_cnt, rpc_type_stats.cnt,
+	       sizeof(uint32_t) * size);
+	stats->rpc_type_time = xmalloc(sizeof(uint64_t) * size);
+	memcpy(stats->rpc_type_time, rpc_type_stats.time,
+	       sizeof(uint64_t) * size);
+	stats->rpc_type_time_max = xmalloc(sizeof(uint32_t) * size);
+	memcpy(stats->rpc_type_time_max, rpc_type_stats.time_max,
+	       sizeof(uint32_t) * size);
+	stats->rpc_type_limited = xmalloc(sizeof(uint32_t) * size);
+	memcpy(stats->rpc_type_limited, rpc_type_stats.limited,
+	       sizeof(uint32_t) * size);
+
+	size = rpc_user_stats.size;
+	stats->rpc_user_size = size;
+	stats->rpc_user_id = xmalloc(sizeof(uint32_t) * size);
+	memcpy(stats->rpc_user_id, rpc_user_stats.id,
+	       sizeof(uint32_t) * size);
+	stats->rpc_user_cnt = xmalloc(sizeof(uint32_t) * size);
+	memcpy(stats->rpc_user_cnt, rpc_user_stats.cnt,
+	       sizeof(uint32_t) * size);
+	stats->rpc_user_time = xmalloc(sizeof(uint64_t) * size);
+	memcpy(stats->rpc_user_time, rpc_user_stats.time,
+	       sizeof(uint64_t) * size);
+	stats->rpc_user_time_max = xmalloc(sizeof(uint32_t) * size);
+	memcpy(stats->rpc_user_time_max, rpc_user_stats.time_max,
+	       sizeof(uint32_t) * size);
+	stats->rpc_user_limited = xmalloc(sizeof(uint32_t) * size);
+	memcpy(stats->rpc_user_limited, rpc_user_stats.limited,
+	       sizeof(uint32_t) * size);
+	slurm_mutex_unlock(&rpc_stats_mutex);
+
+	_fill_lock_stats(stats);
+	_fill_rpc_queue_stats(stats);
+}
+
+/* Clear the slurmctld statistics, the RPC records are retained for reuse.
+ * bf_active is left unchanged, it reflects a backfill cycle in progress. */
+static void _reset_stats_info(void)
+{
+	/* Locks: Write job, held by the writers of these statistics */
+	slurmctld_lock_t job_write_lock = {
+		NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
+
+	lock_slurmctld(job_write_lock);
+	slurmctld_diag_stats.time_start = time(NULL);
+
+	slurmctld_diag_stats.schedule_cycle_counter = 0;
+	slurmctld_diag_stats.schedule_cycle_last = 0;
+	slurmctld_diag_stats.schedule_cycle_max = 0;
+	slurmctld_diag_stats.schedule_cycle_sum = 0;
+	slurmctld_diag_stats.schedule_cycle_depth = 0;
+	slurmctld_diag_stats.schedule_queue_len = 0;
+
+	slurmctld_diag_stats.bf_cycle_counter = 0;
+	slurmctld_diag_stats.bf_cycle_last = 0;
+	slurmctld_diag_stats.bf_cycle_max = 0;
+	slurmctld_diag_stats.bf_cycle_sum = 0;
+	slurmctld_diag_stats.bf_depth_sum = 0;
+	slurmctld_diag_stats.bf_last_depth = 0;
+	slurmctld_diag_stats.bf_queue_len = 0;
+	slurmctld_diag_stats.bf_backfilled_jobs = 0;
+	slurmctld_diag_stats.bf_when_last_cycle = 0;
+	unlock_slurmctld(job_write_lock);
+
+	reset_state_save_stats();
+	reset_lock_stats();
+	reset_rpc_queue_stats();
+
+	slurm_mutex_lock(&rpc_stats_mutex);
+	rpc_type_stats.size = 0;
+	rpc_user_stats.size = 0;
+	slurm_mutex_unlock(&rpc_stats_mutex);
+}
+
+/* _slurm_rpc_dump_stats - process RPC for slurmctld statistics, any user
+ *	may get them but only a super user may reset them */
+inline static void _slurm_rpc_dump_stats(slurm_msg_t * msg)
+{
+	stats_info_request_msg_t *request_msg;
+	stats_info_response_msg_t resp;
+	slurm_msg_t response_msg;
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+
+	request_msg = (stats_info_request_msg_t *) msg->data;
+	debug2("Processing RPC: REQUEST_STATS_INFO (command: %u) from uid=%d",
+	       request_msg->command_id, uid);
+
+	if (request_msg->command_id == STAT_COMMAND_RESET) {
+		if (!validate_super_user(uid)) {
+			error("Security violation, REQUEST_STATS_INFO reset "
+			      "from uid=%d", uid);
+			slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
+			return;
+		}
+		_reset_stats_info();
+		info("slurmctld statistics reset by uid=%d", uid);
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		return;
+	}
+
+	_fill_stats_info(&resp);
+	slurm_msg_t_init(&response_msg);
+	response_msg.flags = msg->flags;
+	response_msg.protocol_version = msg->protocol_version;
+	response_msg.address  = msg->address;
+	response_msg.msg_type = RESPONSE_STATS_INFO;
+	response_msg.data     = &resp;
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+
+	xfree(resp.rpc_type_id);
+	xfree(resp.rpc_type_cnt);
+	xfree(resp.rpc_type_time);
+	xfree(resp.rpc_type_time_max);
+	xfree(resp.rpc_type_limited);
+	xfree(resp.rpc_user_id);
+	xfree(resp.rpc_user_cnt);
+	xfree(resp.rpc_user_time);
+	xfree(resp.rpc_user_time_max);
+	xfree(resp.rpc_user_limited);
+}
@@ -70,6 +70,7 @@
 #include "src/common/slurm_topology.h"
 #include "src/common/slurm_rlimits_info.h"
 #include "src/common/switch.h"
+#include "src/common/timers.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/acct_policy.h"
@@ -90,11 +91,16 @@
 #include "src/slurmctld/srun_comm.h"
 #include "src/slurmctld/trigger_mgr.h"
 
+/* Start of the current read_slurm_conf() phase, see _phase_end() */
+static struct timeval phase_tv;
+static bool phase_log = false;
+
 static void _acct_restore_active_jobs(void);
 static int  _build_bitmaps(void);
 static void _build_bitmaps_pre_select(void);
 static void _gres_reconfig(bool reconfig);
 static int  _init_all_slurm_conf(void);
+static void _phase_end(char *phase);
 static int  _preserve_select_type_param(slurm_ctl_conf_t * ctl_conf_ptr,
 					uint16_t old_select_type_p);
 static int  _preserve_plugins(slurm_ctl_conf_t * ctl_conf_ptr,
@@ -698,6 +704,8 @@ int read_slurm_conf(int recover, bool reconfig)
 
 	/* initialization */
 	START_TIMER;
+	phase_tv  = tv1;
+	phase_log = !reconfig;
 
 	if (reconfig) {
 		/* in order to re-use job state information,
@@ -775,6 +783,8 @@ int read_slurm_conf(int recover, bool reconfig)
 	rehash_jobs();
 	set_slurmd_addr();
 
+	_phase_end("configuration");
+
 	if (reconfig) {		/* Preserve state from memory */
 		if (old_node_table_ptr) {
 			info("restoring original state of nodes");
@@ -798,14 +808,19 @@ int read_slurm_conf(int recover, bool reconfig)
 	} else if (recover == 1) {	/* Load job & node state files */
 		(void) load_all_node_state(true);
 		(void) load_all_front_end_state(true);
+		_phase_end("node state");
 		load_job_ret = load_all_job_state();
 		sync_job_priorities();
+		_phase_end("job state");
 	} else if (recover > 1) {	/* Load node, part & job state files */
 		(void) load_all_node_state(false);
 		(void) load_all_front_end_state(false);
+		_phase_end("node state");
 		(void) load_all_part_state();
+		_phase_end("partition state");
 		load_job_ret = load_all_job_state();
 		sync_job_priorities();
+		_phase_end("job state");
 	}
 
 	sync_front_end_state();
@@ -820,11 +835,14 @@ int read_slurm_conf(int recover, bool reconfig)
 		      "Clean start required.");
 	}
 	xfree(state_save_dir);
+	_phase_end("select plugin state");
 	_gres_reconfig(reconfig);
 	reset_job_bitmaps();		/* must follow select_g_job_init() */
+	_phase_end("job bitmaps");
 
 	(void) _sync_nodes_to_jobs();
 	(void) sync_job_files();
+	_phase_end("job files");
 	_purge_old_node_state(old_node_table_ptr, old_node_record_count);
 	_purge_old_part_state(old_part_list, old_def_part_name);
 
@@ -841,6 +859,8 @@ int read_slurm_conf(int recover, bool reconfig)
 	/* NOTE: Run restore_node_features before _restore_job_dependencies */
 	restore_node_features(recover);
 	_restore_job_dependencies();
+	rebuild_job_queue();	/* partition records may be new */
+	_phase_end("job dependencies");
 #ifdef 	HAVE_ELAN
 	_validate_node_proc_count();
 #endif
@@ -856,6 +876,7 @@ int read_slurm_conf(int recover, bool reconfig)
 			(void) slurm_sched_reconfig();
 		}
 	}
+	_phase_end("reservation and trigger state");
 
 	/* sort config_list by weight for scheduling */
 	list_sort(config_list, &list_compare_config);
@@ -893,10 +914,30 @@ int read_slurm_conf(int recover, bool reconfig)
 	select_g_reconfigure();
 
 	slurmctld_conf.last_update = time(NULL);
+	_phase_end("plugin reconfiguration");
 	END_TIMER2("read_slurm_conf");
+	if (phase_log)
+		info("read_slurm_conf: completed in %s", TIME_STR);
 	return error_code;
 }
 
+/* Log the time used by a phase of read_slurm_conf() at slurmctld startup,
+ * where the time to recover state matters most, and start the next phase */
+static void _phase_end(char *phase)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	if (phase_log) {
+		info("read_slurm_conf: %s took usec=%ld",
+		     phase, slurm_diff_tv(&phase_tv, &now));
+	} else {
+		debug2("read_slurm_conf: %s took usec=%ld",
+		       phase, slurm_diff_tv(&phase_tv, &now));
+	}
+	phase_tv = now;
+}
+
 static void _gres_reconfig(bool reconfig)
 {
 	struct node_record *node_ptr;
@@ -1580,6 +1621,12 @@ static int _restore_job_dependencies(void)
 
 	assoc_mgr_clear_used_info();
 	job_iterator = list_iterator_create(job_list);
+	/* Reverse dependency edges are rebuilt by update_job_dependency() */
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		job_ptr->dependent_cnt = 0;
+		xfree(job_ptr->dependent_ids);
+	}
+	list_iterator_reset(job_iterator);
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
 		(void) build_feature_list(job_ptr);
 
@@ -1075,7 +1075,7 @@ static bool _job_overlap(time_t start_time, uint16_t flags,
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
 		if (IS_JOB_RUNNING(job_ptr)		&&
 		    (job_ptr->end_time > start_time)	&&
-		    (bit_overlap(job_ptr->node_bitmap, node_bitmap) > 0)) {
+		    (bit_overlap_any(job_ptr->node_bitmap, node_bitmap) > 0)) {
 			overlap = true;
 			break;
 		}
@@ -1114,7 +1114,7 @@ static bool _resv_overlap(time_t start_time, time_t end_time,
 			continue;	/* skip self */
 		if (resv_ptr->node_bitmap == NULL)
 			continue;	/* no specific nodes in reservation */
-		if (!bit_overlap(resv_ptr->node_bitmap, node_bitmap))
+		if (!bit_overlap_any(resv_ptr->node_bitmap, node_bitmap))
 			continue;	/* no overlap */
 
 		for (i=0; ((i<7) && (!rc)); i++) {  /* look forward one week */
@@ -2313,7 +2313,7 @@ static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt)
 		return SLURM_SUCCESS;
 
 	if (delta_node_cnt > 0) {	/* Must decrease node count */
-		if (bit_overlap(resv_ptr->node_bitmap, idle_node_bitmap)) {
+		if (bit_overlap_any(resv_ptr->node_bitmap, idle_node_bitmap)) {
 			/* Start by eliminating idle nodes from reservation */
 			tmp1_bitmap = bit_copy(resv_ptr->node_bitmap);
 			bit_and(tmp1_bitmap, idle_node_bitmap);
@@ -2321,16 +2321,13 @@ static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt)
 			if (i > delta_node_cnt) {
 				tmp2_bitmap = bit_pick_cnt(tmp1_bitmap,
 							   delta_node_cnt);
-				bit_not(tmp2_bitmap);
-				bit_and(resv_ptr->node_bitmap, tmp2_bitmap);
+				bit_and_not(resv_ptr->node_bitmap, tmp2_bitmap);
 				FREE_NULL_BITMAP(tmp1_bitmap);
 				FREE_NULL_BITMAP(tmp2_bitmap);
 				delta_node_cnt = 0;	/* ALL DONE */
 			} else if (i) {
-				bit_not(idle_node_bitmap);
-				bit_and(resv_ptr->node_bitmap,
-					idle_node_bitmap);
-				bit_not(idle_node_bitmap);
+				bit_and_not(resv_ptr->node_bitmap,
+					    idle_node_bitmap);
 				resv_ptr->node_cnt = bit_set_count(
 						resv_ptr->node_bitmap);
 				delta_node_cnt = resv_ptr->node_cnt -
@@ -2406,9 +2403,7 @@ static int  _select_nodes(resv_desc_msg_t *resv_desc_ptr,
 			    (resv_ptr->start_time >= resv_desc_ptr->end_time) ||
 			    (resv_ptr->end_time   <= resv_desc_ptr->start_time))
 				continue;
-			bit_not(resv_ptr->node_bitmap);
-			bit_and(node_bitmap, resv_ptr->node_bitmap);
-			bit_not(resv_ptr->node_bitmap);
+			bit_and_not(node_bitmap, resv_ptr->node_bitmap);
 		}
 		list_iterator_destroy(iter);
 	}
@@ -2534,9 +2529,7 @@ static bitstr_t *_pick_idle_nodes(bitstr_t *avail_bitmap,
 			continue;
 		if (job_ptr->end_time < resv_desc_ptr->start_time)
 			continue;
-		bit_not(job_ptr->node_bitmap);
-		bit_and(avail_bitmap, job_ptr->node_bitmap);
-		bit_not(job_ptr->node_bitmap);
+		bit_and_not(avail_bitmap, job_ptr->node_bitmap);
 	}
 	list_iterator_destroy(job_iterator);
 	ret_bitmap = select_g_resv_test(avail_bitmap, resv_desc_ptr->node_cnt);
@@ -2889,9 +2882,7 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 			    (res2_ptr->start_time >= job_end_time) ||
 			    (res2_ptr->end_time   <= job_start_time))
 				continue;
-			bit_not(res2_ptr->node_bitmap);
-			bit_and(*node_bitmap, res2_ptr->node_bitmap);
-			bit_not(res2_ptr->node_bitmap);
+			bit_and_not(*node_bitmap, res2_ptr->node_bitmap);
 			overlap_resv = true;
 		}
 		list_iterator_destroy(iter);
@@ -2944,9 +2935,7 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				    (lic_resv_time > resv_ptr->end_time))
 					lic_resv_time = resv_ptr->end_time;
 			}
-			bit_not(resv_ptr->node_bitmap);
-			bit_and(*node_bitmap, resv_ptr->node_bitmap);
-			bit_not(resv_ptr->node_bitmap);
+			bit_and_not(*node_bitmap, resv_ptr->node_bitmap);
 		}
 		list_iterator_destroy(iter);
 
@@ -92,6 +92,18 @@
 #define MAX_SERVER_THREADS 256
 #endif
 
+/* Number of threads in the pool which services incoming RPCs. Connections
+ * beyond this count (up to MAX_SERVER_THREADS) are queued by priority. */
+#ifndef RPC_WORKER_THREADS
+#define RPC_WORKER_THREADS 64
+#endif
+
+/* Queued RPCs of normal or low priority waiting for longer than this many
+ * microseconds are serviced ahead of newer higher priority RPCs */
+#ifndef RPC_QUEUE_AGE_LIMIT
+#define RPC_QUEUE_AGE_LIMIT 1000000
+#endif
+
 /* Perform full slurmctld's state every PERIODIC_CHECKPOINT seconds */
 #ifndef PERIODIC_CHECKPOINT
 #define	PERIODIC_CHECKPOINT	300
@@ -130,6 +142,12 @@
 #define PERIODIC_NODE_ACCT 300
 #endif
 
+/* Log slurmctld lock statistics every PERIODIC_LOCK_STATS seconds
+ * if SlurmctldDebug is verbose or higher */
+#ifndef PERIODIC_LOCK_STATS
+#define PERIODIC_LOCK_STATS 3600
+#endif
+
 /* Pathname of group file record for checking update times */
 #ifndef GROUP_FILE
 #define GROUP_FILE	"/etc/group"
@@ -144,6 +162,24 @@
  *  General configuration parameters and data structures
 \*****************************************************************************/
 
+/* Priority classes of the RPC queue, see controller.c */
+typedef enum {
+	RPC_PRIO_HIGH,		/* node registration and job completion */
+	RPC_PRIO_NORMAL,
+	RPC_PRIO_LOW,		/* information queries */
+	RPC_PRIO_CNT
+} rpc_prio_t;
+
+typedef struct rpc_queue_stats {
+	uint32_t count;		/* RPCs serviced */
+	uint32_t depth;		/* RPCs currently queued */
+	uint32_t depth_max;
+	uint64_t wait_usec;	/* total time queued after receipt */
+	uint32_t wait_max_usec;
+	uint64_t run_usec;	/* total time processing */
+	uint32_t run_max_usec;
+} rpc_queue_stats_t;
+
 typedef struct slurmctld_config {
 	int	daemonize;
 	bool	resume_backup;
@@ -170,6 +206,40 @@ typedef struct slurmctld_config {
 } slurmctld_config_t;
 
 extern slurmctld_config_t slurmctld_config;
+
+/* Controller performance statistics reported by the REQUEST_STATS_INFO RPC,
+ * times are in microseconds. Each group of fields is only updated by the
+ * thread performing that work (job scheduler, backfill or state save).
+ * The scheduler and backfill fields are updated with the job write lock,
+ * the state save fields with the state save thread's mutex. */
+typedef struct diag_stats {
+	time_t   time_start;		/* time statistics were last reset */
+
+	uint32_t schedule_cycle_counter;
+	uint32_t schedule_cycle_last;
+	uint32_t schedule_cycle_max;
+	uint64_t schedule_cycle_sum;
+	uint64_t schedule_cycle_depth;	/* jobs tested, all cycles */
+	uint32_t schedule_queue_len;	/* jobs queued, last cycle */
+
+	uint32_t bf_cycle_counter;
+	uint32_t bf_cycle_last;
+	uint32_t bf_cycle_max;
+	uint64_t bf_cycle_sum;
+	uint64_t bf_depth_sum;		/* jobs tested, all cycles */
+	uint32_t bf_last_depth;		/* jobs tested, last cycle */
+	uint32_t bf_queue_len;		/* jobs queued, last cycle */
+	uint32_t bf_backfilled_jobs;	/* jobs started by backfill */
+	time_t   bf_when_last_cycle;
+	uint16_t bf_active;		/* backfill cycle in progress */
+
+	uint32_t state_save_counter;
+	uint32_t state_save_last;
+	uint32_t state_save_max;
+	uint64_t state_save_sum;
+} diag_stats_t;
+
+extern diag_stats_t slurmctld_diag_stats;
 extern int   bg_recover;		/* state recovery mode */
 extern char *slurmctld_cluster_name;	/* name of cluster */
 extern void *acct_db_conn;
@@ -359,9 +429,14 @@ struct job_details {
 	uint16_t cpus_per_task;		/* number of processors required for
 					 * each task */
 	List depend_list;		/* list of job_ptr:state pairs */
+	bool depend_blocked;		/* dependencies remain, do not retest
+					 * until a job in depend_list starts,
+					 * ends or is purged */
 	char *dependency;		/* wait for other jobs */
 	char *orig_dependency;		/* original value (for archiving) */
 	uint16_t env_cnt;		/* size of env_sup (see below) */
+	char *env_key;			/* batch_store key of batch job's
+					 * environment */
 	char **env_sup;			/* supplemental environment variables
 					 * as set by Moab */
 	bitstr_t *exc_node_bitmap;	/* bitmap of excluded nodes */
@@ -404,6 +479,7 @@ struct job_details {
 	uint16_t requeue;		/* controls ability requeue job */
 	char *restart_dir;	        /* restart execution from ckpt images
 					 * in this dir */
+	char *script_key;		/* batch_store key of batch script */
 	uint16_t shared;		/* 1 if job can share nodes,
 					 * 0 if job cannot share nodes,
 					 * any other value accepts the default
@@ -451,6 +527,9 @@ struct job_record {
                                          * 1 if cr is enabled */
 	uint32_t db_index;              /* used only for database
 					 * plugins */
+	uint32_t dependent_cnt;		/* count of dependent_ids */
+	uint32_t *dependent_ids;	/* IDs of jobs with a dependency upon
+					 * this one (reverse of depend_list) */
 	uint32_t derived_ec;		/* highest exit code of all job steps */
 	struct job_details *details;	/* job details */
 	uint16_t direct_set_prio;	/* Priority set directly if
@@ -467,6 +546,16 @@ struct job_record {
 	uint32_t group_id;		/* group submitted under */
 	uint32_t job_id;		/* job ID */
 	struct job_record *job_next;	/* next entry with same hash index */
+	struct job_record *job_next_name; /* next entry with same name
+					 * hash index */
+	struct job_record **job_pprev_name; /* link to this entry in the
+					 * name hash, NULL if not indexed */
+	struct job_record *job_next_user; /* next entry with same user
+					 * hash index */
+	struct job_record **job_pprev_user; /* link to this entry in the
+					 * user hash, NULL if not indexed */
+	uint32_t job_queue_seq;		/* identifies this job's current
+					 * entries in the pending job queue */
 	job_resources_t *job_resrcs;	/* details of allocated cores */
 	uint16_t job_state;	        /* state of the job */
 	uint16_t kill_on_node_fail;	/* 1 if job should be killed on
@@ -1341,6 +1430,8 @@ extern void node_no_resp_msg(void);
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN protocol_version - slurm protocol version of client
+ * IN update_time - with SHOW_DELTA, pack only jobs changed since this time
+ *	as a RESPONSE_JOB_INFO_DELTA message (SHOW_DETAIL must not be set)
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -1348,7 +1439,32 @@ extern void node_no_resp_msg(void);
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid,
-			  uint16_t protocol_version);
+			  uint16_t protocol_version, time_t update_time);
+
+/*
+ * pack_all_jobs_cached - dump all job information for all jobs from the
+ *	response pre-packed by an earlier pack_all_jobs() call if no job or
+ *	partition has changed since then
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * IN update_time - with SHOW_DELTA, pack only jobs changed since this time
+ * IN snapshot - if set and jobs changed since the response was packed,
+ *	send it anyway, stamped with the time it was packed so that the
+ *	client's next request picks up the later changes. Used while the job
+ *	lock is held by a writer, so that readers need not wait for it.
+ *	Not done if partitions changed or the client already has newer data.
+ * RET SLURM_SUCCESS or SLURM_ERROR if pack_all_jobs() must be called
+ * NOTE: READ lock_slurmctld config and partition before entry, the job
+ *	lock is not needed
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ */
+extern int pack_all_jobs_cached(char **buffer_ptr, int *buffer_size,
+				uint16_t show_flags, uid_t uid,
+				uint16_t protocol_version, time_t update_time,
+				bool snapshot);
 
 /*
  * pack_all_node - dump all configuration and node information for all nodes
@@ -1358,6 +1474,8 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  * IN show_flags - node filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN protocol_version - slurm protocol version of client
+ * IN update_time - with SHOW_DELTA, pack only nodes changed since this time
+ *	as a RESPONSE_NODE_INFO_DELTA message
  * global: node_record_table_ptr - pointer to global node table
  * NOTE: the caller must xfree the buffer at *buffer_ptr
  * NOTE: change slurm_load_node() in api/node_info.c when data format changes
@@ -1365,7 +1483,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  */
 extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
-			   uint16_t protocol_version);
+			   uint16_t protocol_version, time_t update_time);
 
 /*
  * pack_ctld_job_step_info_response_msg - packs job step info
@@ -1441,6 +1559,23 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 			uint32_t job_id, uint16_t show_flags, uid_t uid,
 			uint16_t protocol_version);
 
+/*
+ * pack_user_jobs - dump information for the jobs of one user and/or with
+ *	one name in machine independent form (for network transmission),
+ *	found through the job user and name indexes
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN user_id - ID of user whose jobs are wanted, NO_VAL for any user
+ * IN job_name - name of jobs wanted, NULL for any name
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ */
+extern void pack_user_jobs(char **buffer_ptr, int *buffer_size,
+			   uint32_t user_id, char *job_name,
+			   uint16_t show_flags, uid_t uid,
+			   uint16_t protocol_version);
+
 /* part_filter_clear - Clear the partition's hidden flag based upon a user's
  * group access. This must follow a call to part_filter_set() */
 extern void part_filter_clear(void);
@@ -1470,7 +1605,7 @@ extern bool partition_in_use(char *part_name);
 void purge_old_job(void);
 
 /*
- * rehash_jobs - Create or rebuild the job hash table.
+ * rehash_jobs - Create the job hash table. It grows as needed afterwards.
  * NOTE: run lock_slurmctld before entry: Read config, write job
  */
 extern void rehash_jobs(void);
@@ -1521,6 +1656,28 @@ extern void run_health_check(void);
 /* save_all_state - save entire slurmctld state for later recovery */
 extern void save_all_state(void);
 
+/*
+ * get_rpc_queue_stats - Get a copy of the RPC queue statistics
+ * OUT stats - statistics for each rpc_prio_t, RPC_PRIO_CNT records
+ * OUT conn_depth - connections accepted but not yet received
+ * OUT worker_cnt - RPC worker threads
+ */
+extern void get_rpc_queue_stats(rpc_queue_stats_t *stats,
+				uint32_t *conn_depth, uint32_t *worker_cnt);
+
+/* reset_rpc_queue_stats - Clear RPC queue statistics, other than the
+ *	current queue depths */
+extern void reset_rpc_queue_stats(void);
+
+/* rpc_prio_string - Return the name of an RPC priority class, e.g. "high" */
+extern char *rpc_prio_string(rpc_prio_t prio);
+
+/* log_rpc_queue_stats - Log RPC queue statistics */
+extern void log_rpc_queue_stats(void);
+
+/* rpc_msg_prio - Identify the priority class of an RPC */
+extern rpc_prio_t rpc_msg_prio(slurm_msg_type_t msg_type);
+
 /* send all info for the controller to accounting */
 extern void send_all_to_accounting(time_t event_time);
 
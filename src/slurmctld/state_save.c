@@ -46,6 +46,8 @@
 #endif                          /* WITH_PTHREADS */
 
 #include "src/common/macros.h"
+#include "src/common/timers.h"
+#include "src/slurmctld/batch_store.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/slurmctld.h"
@@ -57,8 +59,32 @@ static pthread_mutex_t state_save_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  state_save_cond = PTHREAD_COND_INITIALIZER;
 static int save_jobs = 0, save_nodes = 0, save_parts = 0;
 static int save_front_end = 0, save_triggers = 0, save_resv = 0;
+static int save_batch_store = 0;
 static bool run_save_thread = true;
 
+/* Record statistics for one pass of the state save thread */
+static void _do_diag_stats(long delta_t)
+{
+	slurm_mutex_lock(&state_save_lock);
+	slurmctld_diag_stats.state_save_counter++;
+	slurmctld_diag_stats.state_save_sum += delta_t;
+	slurmctld_diag_stats.state_save_last = delta_t;
+	if (delta_t > slurmctld_diag_stats.state_save_max)
+		slurmctld_diag_stats.state_save_max = delta_t;
+	slurm_mutex_unlock(&state_save_lock);
+}
+
+/* Clear the state save statistics of slurmctld_diag_stats */
+extern void reset_state_save_stats(void)
+{
+	slurm_mutex_lock(&state_save_lock);
+	slurmctld_diag_stats.state_save_counter = 0;
+	slurmctld_diag_stats.state_save_sum = 0;
+	slurmctld_diag_stats.state_save_last = 0;
+	slurmctld_diag_stats.state_save_max = 0;
+	slurm_mutex_unlock(&state_save_lock);
+}
+
 /* fsync() and close() a file,
  * Execute fsync() and close() multiple times if necessary and log failures
  * RET 0 on success or -1 on error */
@@ -91,6 +117,15 @@ extern int fsync_and_close(int fd, char *file_type)
 	return rc;
 }
 
+/* Queue writing of batch job scripts and environments */
+extern void schedule_batch_store_save(void)
+{
+	slurm_mutex_lock(&state_save_lock);
+	save_batch_store++;
+	pthread_cond_broadcast(&state_save_cond);
+	slurm_mutex_unlock(&state_save_lock);
+}
+
 /* Queue saving of front_end state information */
 extern void schedule_front_end_save(void)
 {
@@ -167,6 +202,7 @@ extern void *slurmctld_state_save(void *no_data)
 	double save_delay;
 	bool run_save;
 	int save_count;
+	DEF_TIMERS;
 
 	while (1) {
 		/* wait for work to perform */
@@ -174,7 +210,7 @@ extern void *slurmctld_state_save(void *no_data)
 		while (1) {
 			save_count = save_jobs + save_nodes + save_parts +
 				     save_front_end + save_resv +
-				     save_triggers;
+				     save_triggers + save_batch_store;
 			now = time(NULL);
 			save_delay = difftime(now, last_save);
 			if (save_count &&
@@ -197,6 +233,8 @@ extern void *slurmctld_state_save(void *no_data)
 			}
 		}
 
+		START_TIMER;
+
 		/* save front_end node info if necessary */
 		run_save = false;
 		/* slurm_mutex_lock(&state_save_lock); done above */
@@ -219,6 +257,19 @@ extern void *slurmctld_state_save(void *no_data)
 		if (run_save)
 			(void)dump_all_job_state();
 
+		/* batch scripts referenced by the job state are written
+		 * by dump_all_job_state(), this removes unreferenced ones
+		 * and retries failed writes */
+		run_save = false;
+		slurm_mutex_lock(&state_save_lock);
+		if (save_batch_store) {
+			run_save = true;
+			save_batch_store = 0;
+		}
+		slurm_mutex_unlock(&state_save_lock);
+		if (run_save)
+			(void)batch_store_flush();
+
 		/* save node info if necessary */
 		run_save = false;
 		slurm_mutex_lock(&state_save_lock);
@@ -262,6 +313,9 @@ extern void *slurmctld_state_save(void *no_data)
 		slurm_mutex_unlock(&state_save_lock);
 		if (run_save)
 			(void)trigger_state_save();
+
+		END_TIMER;
+		_do_diag_stats(DELTA_TIMER);
 	}
 }
 
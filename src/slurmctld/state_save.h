@@ -45,6 +45,12 @@
  * RET 0 on success or -1 on error */
 extern int fsync_and_close(int fd, char *file_type);
 
+/* Clear the state save statistics of slurmctld_diag_stats */
+extern void reset_state_save_stats(void);
+
+/* Queue writing of batch job scripts and environments */
+extern void schedule_batch_store_save(void);
+
 /* Queue saving of front_end state information */
 extern void schedule_front_end_save(void);
 
@@ -1034,8 +1034,7 @@ _pick_step_nodes (struct job_record  *job_ptr,
 				selected_nodes = NULL;
 			} else {
 				nodes_picked = bit_copy(selected_nodes);
-				bit_not(selected_nodes);
-				bit_and(nodes_avail, selected_nodes);
+				bit_and_not(nodes_avail, selected_nodes);
 				FREE_NULL_BITMAP(selected_nodes);
 			}
 		}
@@ -1235,8 +1234,7 @@ _pick_step_nodes (struct job_record  *job_ptr,
 				if (cpu_cnt == 0) {
 					/* Node not usable (memory insufficient
 					 * to allocate any CPUs, etc.) */
-					bit_not(node_tmp);
-					bit_and(nodes_avail, node_tmp);
+					bit_and_not(nodes_avail, node_tmp);
 					FREE_NULL_BITMAP(node_tmp);
 					continue;
 				}
@@ -1631,10 +1629,8 @@ static void _step_dealloc_lps(struct step_record *step_ptr)
 	xassert(job_resrcs_ptr->core_bitmap_used);
 	if (step_ptr->core_bitmap_job) {
 		/* Mark the job's cores as no longer in use */
-		bit_not(step_ptr->core_bitmap_job);
-		bit_and(job_resrcs_ptr->core_bitmap_used,
-			step_ptr->core_bitmap_job);
-		/* no need for bit_not(step_ptr->core_bitmap_job); */
+		bit_and_not(job_resrcs_ptr->core_bitmap_used,
+			    step_ptr->core_bitmap_job);
 		FREE_NULL_BITMAP(step_ptr->core_bitmap_job);
 	}
 #endif
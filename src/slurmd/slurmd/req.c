@@ -56,6 +56,10 @@
 #include <utime.h>
 #include <grp.h>
 
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+
 #include "src/common/env.h"
 #include "src/common/fd.h"
 #include "src/common/forward.h"
@@ -155,6 +159,7 @@ static int  _rpc_health_check(slurm_msg_t *);
 static int  _rpc_step_complete(slurm_msg_t *msg);
 static int  _rpc_stat_jobacct(slurm_msg_t *msg);
 static int  _rpc_list_pids(slurm_msg_t *msg);
+static void _rpc_io_relay_port(slurm_msg_t *msg);
 static int  _rpc_daemon_status(slurm_msg_t *msg);
 static int  _run_prolog(uint32_t jobid, uid_t uid, char *resv_id,
 			char **spank_job_env, uint32_t spank_job_env_size);
@@ -168,8 +173,9 @@ static int  _waiter_init (uint32_t jobid);
 static int  _waiter_complete (uint32_t jobid);
 
 static bool _steps_completed_now(uint32_t jobid);
+static int  _uncompress_bcast_block(file_bcast_msg_t *req);
 static int  _valid_sbcast_cred(file_bcast_msg_t *req, uid_t req_uid,
-			       uint16_t block_no);
+			       uint32_t block_no);
 static void _wait_state_completed(uint32_t jobid, int max_delay);
 static long _get_job_uid(uint32_t jobid);
 
@@ -353,6 +359,10 @@ slurmd_req(slurm_msg_t *msg)
 		rc = _rpc_list_pids(msg);
 		slurm_free_job_step_id_msg(msg->data);
 		break;
+	case REQUEST_IO_RELAY_PORT:
+		_rpc_io_relay_port(msg);
+		slurm_free_job_step_id_msg(msg->data);
+		break;
 	case REQUEST_DAEMON_STATUS:
 		_rpc_daemon_status(msg);
 		/* No body to free */
@@ -2240,6 +2250,40 @@ _rpc_list_pids(slurm_msg_t *msg)
         return SLURM_SUCCESS;
 }
 
+/*
+ * Report the port on which a local slurmstepd relays stdio for the
+ * slurmstepds below it in the step's reverse tree. Those slurmstepds
+ * run this request with the job owner's credentials. A port of zero
+ * means that the step is not (yet) running here or has no relay.
+ */
+static void
+_rpc_io_relay_port(slurm_msg_t *msg)
+{
+	job_step_id_msg_t *req = (job_step_id_msg_t *)msg->data;
+	return_code_msg_t rc_msg;
+	slurm_msg_t resp_msg;
+	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	long job_uid;
+	int fd;
+
+	rc_msg.return_code = 0;
+	job_uid = _get_job_uid(req->job_id);
+	if ((job_uid < 0) ||
+	    ((req_uid != job_uid) && !_slurm_authorized_user(req_uid))) {
+		debug("io_relay_port from uid %ld for job %u denied",
+		      (long) req_uid, req->job_id);
+	} else if ((fd = stepd_connect(conf->spooldir, conf->node_name,
+				       req->job_id, req->step_id)) >= 0) {
+		rc_msg.return_code = stepd_io_relay_port(fd);
+		close(fd);
+	}
+
+	slurm_msg_t_copy(&resp_msg, msg);
+	resp_msg.msg_type = RESPONSE_IO_RELAY_PORT;
+	resp_msg.data     = &rc_msg;
+	slurm_send_node_msg(msg->conn_fd, &resp_msg);
+}
+
 /*
  *  For the specified job_id: reply to slurmctld,
  *   sleep(configured kill_wait), then send SIGKILL
@@ -2385,7 +2429,7 @@ _init_groups(uid_t my_uid, gid_t my_gid)
  * Munge without generating a credential replay error
  * RET SLURM_SUCCESS or an error code */
 static int
-_valid_sbcast_cred(file_bcast_msg_t *req, uid_t req_uid, uint16_t block_no)
+_valid_sbcast_cred(file_bcast_msg_t *req, uid_t req_uid, uint32_t block_no)
 {
 	int rc = SLURM_SUCCESS;
 	uint32_t job_id;
@@ -2417,11 +2461,52 @@ _valid_sbcast_cred(file_bcast_msg_t *req, uid_t req_uid, uint16_t block_no)
 	return rc;
 }
 
+/* Replace a compressed sbcast block with its uncompressed data */
+static int
+_uncompress_bcast_block(file_bcast_msg_t *req)
+{
+#ifdef HAVE_ZLIB
+	uLongf data_len = req->uncomp_len;
+	char *data;
+	int rc;
+
+	if (req->compress != BCAST_COMPRESS_ZLIB) {
+		error("sbcast: unknown compression type %u", req->compress);
+		return ESLURM_NOT_SUPPORTED;
+	}
+	if (req->uncomp_len > BCAST_MAX_BLOCK_SIZE) {
+		error("sbcast: block %u of `%s` too large, %u bytes",
+		      req->block_no, req->fname, req->uncomp_len);
+		return SLURM_ERROR;
+	}
+
+	data = xmalloc(MAX(req->uncomp_len, 1));
+	rc = uncompress((Bytef *) data, &data_len, (Bytef *) req->block,
+			req->block_len);
+	if ((rc != Z_OK) || (data_len != req->uncomp_len)) {
+		error("sbcast: block %u of `%s` uncompress error %d",
+		      req->block_no, req->fname, rc);
+		xfree(data);
+		return SLURM_ERROR;
+	}
+	xfree(req->block);
+	req->block     = data;
+	req->block_len = data_len;
+	req->compress  = BCAST_COMPRESS_NONE;
+	return SLURM_SUCCESS;
+#else
+	error("sbcast: compressed data received, but slurmd was built "
+	      "without zlib");
+	return ESLURM_NOT_SUPPORTED;
+#endif
+}
+
 static int
 _rpc_file_bcast(slurm_msg_t *msg)
 {
 	file_bcast_msg_t *req = msg->data;
 	int fd, flags, offset, inx, rc;
+	bool append = (req->block_offset == NO_VAL64);
 	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
 	gid_t req_gid = g_slurm_auth_get_gid(msg->auth_cred, NULL);
 	pid_t child;
@@ -2445,6 +2530,9 @@ _rpc_file_bcast(slurm_msg_t *msg)
 
 	info("sbcast req_uid=%u fname=%s block_no=%u",
 	     req_uid, req->fname, req->block_no);
+	if ((req->compress != BCAST_COMPRESS_NONE) &&
+	    ((rc = _uncompress_bcast_block(req)) != SLURM_SUCCESS))
+		return rc;
 	child = fork();
 	if (child == -1) {
 		error("sbcast: fork failure");
@@ -2470,6 +2558,8 @@ _rpc_file_bcast(slurm_msg_t *msg)
 		exit(errno);
 	}
 
+	/* Blocks with an offset may arrive out of order, but the first
+	 * block always arrives before the others */
 	flags = O_WRONLY;
 	if (req->block_no == 1) {
 		flags |= O_CREAT;
@@ -2477,7 +2567,7 @@ _rpc_file_bcast(slurm_msg_t *msg)
 			flags |= O_TRUNC;
 		else
 			flags |= O_EXCL;
-	} else
+	} else if (append)
 		flags |= O_APPEND;
 
 	fd = open(req->fname, flags, 0700);
@@ -2489,8 +2579,14 @@ _rpc_file_bcast(slurm_msg_t *msg)
 
 	offset = 0;
 	while (req->block_len - offset) {
-		inx = write(fd, &req->block[offset],
-			    (req->block_len - offset));
+		if (append) {
+			inx = write(fd, &req->block[offset],
+				    (req->block_len - offset));
+		} else {
+			inx = pwrite(fd, &req->block[offset],
+				     (req->block_len - offset),
+				     (off_t) (req->block_offset + offset));
+		}
 		if (inx == -1) {
 			if ((errno == EINTR) || (errno == EAGAIN))
 				continue;
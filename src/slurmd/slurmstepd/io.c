@@ -76,7 +76,9 @@
 #include "src/common/macros.h"
 #include "src/common/fd.h"
 #include "src/common/list.h"
+#include "src/common/net.h"
 #include "src/common/read_config.h"
+#include "src/common/slurm_auth.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xsignal.h"
 #include "src/common/xstring.h"
@@ -129,6 +131,9 @@ struct client_io_info {
 
 	/* true if writing to a file, false if writing to a socket */
 	bool is_local_file;
+
+	/* true if connected to the parent slurmstepd's relay (tree I/O) */
+	bool to_parent;
 };
 
 
@@ -191,6 +196,80 @@ struct task_read_info {
 	bool		 eof_msg_sent;
 };
 
+/**********************************************************************
+ * Tree I/O relay declarations
+ *
+ * With TASK_IO_TREE a slurmstepd with children in the step's reverse tree
+ * accepts their stdio connections and passes their io_hdr framed output
+ * on to its own client (srun or its parent slurmstepd), while stdin and
+ * connection tests from that client are passed down to them.
+ **********************************************************************/
+#define IO_RELAY_RETRIES	10	/* attempts to find parent's relay */
+#define IO_RELAY_RETRY_USEC	200000	/* delay between those attempts */
+
+static bool _relay_listen_readable(eio_obj_t *);
+static int  _relay_listen_read(eio_obj_t *, List);
+
+struct io_operations relay_listen_ops = {
+	.readable = &_relay_listen_readable,
+	.handle_read = &_relay_listen_read,
+};
+
+static bool _relay_init_readable(eio_obj_t *);
+static int  _relay_init_read(eio_obj_t *, List);
+
+struct io_operations relay_init_ops = {
+	.readable = &_relay_init_readable,
+	.handle_read = &_relay_init_read,
+};
+
+/* A child's connection until its io init msg has been read */
+struct relay_init_info {
+#ifndef NDEBUG
+#define RELAY_INIT_MAGIC  0x10105
+	int                   magic;
+#endif
+	slurmd_job_t    *job;		 /* pointer back to job data   */
+	eio_obj_t *listen_obj;		 /* relay listening socket     */
+	Buf buffer;			 /* io init msg read so far    */
+};
+
+static bool _relay_readable(eio_obj_t *);
+static bool _relay_writable(eio_obj_t *);
+static int  _relay_read(eio_obj_t *, List);
+static int  _relay_write(eio_obj_t *, List);
+
+struct io_operations relay_ops = {
+	.readable = &_relay_readable,
+	.writable = &_relay_writable,
+	.handle_read = &_relay_read,
+	.handle_write = &_relay_write,
+};
+
+struct relay_io_info {
+#ifndef NDEBUG
+#define RELAY_IO_MAGIC  0x10104
+	int                   magic;
+#endif
+	slurmd_job_t    *job;		 /* pointer back to job data   */
+
+	/* incoming variables, framed messages from the child */
+	struct slurm_io_header header;
+	struct io_buf *in_msg;
+	int32_t in_remaining;
+	bool in_eof;
+
+	/* eof messages still expected from the child's subtree */
+	int stdout_objs;
+	int stderr_objs;
+
+	/* outgoing variables, framed messages to the child */
+	List msg_queue;
+	struct io_buf *out_msg;
+	int32_t out_remaining;
+	bool out_eof;
+};
+
 /**********************************************************************
  * Pseudo terminal declarations
  **********************************************************************/
@@ -209,6 +288,9 @@ static void *_window_manager(void *arg);
  **********************************************************************/
 static void *_io_thr(void *);
 static int _send_io_init_msg(int sock, srun_key_t *key, slurmd_job_t *job);
+static int _add_initial_client(int sock, srun_info_t *srun, slurmd_job_t *job,
+			       int stdout_tasks, int stderr_tasks,
+			       bool to_parent);
 static void _send_eof_msg(struct task_read_info *out);
 static struct io_buf *_task_build_message(struct task_read_info *out,
 					  slurmd_job_t *job, cbuf_t cbuf);
@@ -221,6 +303,12 @@ static bool _incoming_buf_free(slurmd_job_t *job);
 static bool _outgoing_buf_free(slurmd_job_t *job);
 static int  _send_connection_okay_response(slurmd_job_t *job);
 static struct io_buf *_build_connection_okay_message(slurmd_job_t *job);
+static bool _io_output_done(slurmd_job_t *job);
+static void _route_msg_client_to_relays(slurmd_job_t *job,
+					struct slurm_io_header *header,
+					struct io_buf *in_msg);
+static void _route_msg_relay_to_client(slurmd_job_t *job,
+				       struct io_buf *msg);
 
 /**********************************************************************
  * IO client socket functions
@@ -244,7 +332,9 @@ _client_readable(eio_obj_t *obj)
 		return false;
 	}
 
-	if (obj->shutdown) {
+	/* The tasks of relayed slurmstepds may still want stdin */
+	if (obj->shutdown && (client->job->io_relay_cnt == 0 ||
+			      obj != client->job->io_uplink)) {
 		debug5("  false, shutdown");
 		shutdown(obj->fd, SHUT_RD);
 		client->in_eof = true;
@@ -303,6 +393,16 @@ _client_writable(eio_obj_t *obj)
 	    || !list_is_empty(client->msg_queue))
 		return true;
 
+	/* Nothing more will be relayed, let the parent see the eof now
+	 * rather than when this slurmstepd exits */
+	if (client->to_parent && client->in_eof
+	    && _io_output_done(client->job)) {
+		debug3("Closing stdio connection to parent slurmstepd");
+		close(obj->fd);
+		obj->fd = -1;
+		client->out_eof = true;
+	}
+
 	debug5("  false");
 	return false;
 }
@@ -354,6 +454,19 @@ _client_read(eio_obj_t *obj, List objs)
 			client->in_msg = NULL;
 			return SLURM_ERROR;
 		}
+		/* With tree I/O, srun names the node to be tested */
+		if ((client->job->task_flags & TASK_IO_TREE) &&
+		    (client->header.gtaskid != client->job->nodeid)) {
+			if (obj == client->job->io_uplink) {
+				_route_msg_client_to_relays(client->job,
+							    &client->header,
+							    client->in_msg);
+			}
+			list_enqueue(client->job->free_incoming,
+				     client->in_msg);
+			client->in_msg = NULL;
+			return SLURM_SUCCESS;
+		}
 		if (_send_connection_okay_response(client->job)) {
 			/*
 			 * If we get here because of a failed
@@ -432,6 +545,19 @@ _client_read(eio_obj_t *obj, List objs)
 				break;
 			}
 		}
+
+		/* Pass stdin not (only) meant for the local tasks down to
+		 * the relayed slurmstepds */
+		if ((obj == client->job->io_uplink) &&
+		    ((client->header.type == SLURM_IO_ALLSTDIN) ||
+		     (client->in_msg->ref_count == 0))) {
+			_route_msg_client_to_relays(client->job,
+						    &client->header,
+						    client->in_msg);
+		}
+		if (client->in_msg->ref_count == 0)
+			list_enqueue(client->job->free_incoming,
+				     client->in_msg);
 	}
 	client->in_msg = NULL;
 	debug4("Leaving  _client_read");
@@ -809,6 +935,591 @@ again:
 	return SLURM_SUCCESS;
 }
 
+/**********************************************************************
+ * Tree I/O relay functions
+ **********************************************************************/
+/*
+ * Pass the io init msg of a newly accepted child on to srun, which
+ * validates it again and learns which connection now carries that node.
+ */
+static void
+_relay_node_init(slurmd_job_t *job, struct slurm_io_init_msg *init)
+{
+	struct io_buf *msg;
+	struct slurm_io_header header;
+	Buf packbuf;
+
+	if (_outgoing_buf_free(job))
+		msg = list_dequeue(job->free_outgoing);
+	else
+		msg = alloc_io_buf();	/* must not be lost, see eof msg */
+
+	header.type = SLURM_IO_NODE_INIT;
+	header.ltaskid = 0;  /* Unused */
+	header.gtaskid = 0;  /* Unused */
+	header.length = io_init_msg_packed_size();
+
+	packbuf = create_buf(msg->data, io_hdr_packed_size() + header.length);
+	if (!packbuf)
+		fatal("Failure to allocate memory for a message header");
+	io_hdr_pack(&header, packbuf);
+	io_init_msg_pack(init, packbuf);
+	msg->length = io_hdr_packed_size() + header.length;
+
+	/* free the Buf packbuf, but not the memory to which it points */
+	packbuf->head = NULL;
+	free_buf(packbuf);
+
+	_route_msg_relay_to_client(job, msg);
+}
+
+/*
+ * Send an eof message for a stream of a lost child, so that srun does
+ * not wait for it forever.
+ */
+static void
+_relay_send_eof(slurmd_job_t *job, uint16_t type)
+{
+	struct io_buf *msg;
+	struct slurm_io_header header;
+	Buf packbuf;
+
+	if (_outgoing_buf_free(job))
+		msg = list_dequeue(job->free_outgoing);
+	else
+		msg = alloc_io_buf();
+
+	header.type = type;
+	header.ltaskid = (uint16_t)-1;
+	header.gtaskid = (uint16_t)-1;
+	header.length = 0; /* eof */
+
+	packbuf = create_buf(msg->data, io_hdr_packed_size());
+	if (!packbuf)
+		fatal("Failure to allocate memory for a message header");
+	io_hdr_pack(&header, packbuf);
+	msg->length = io_hdr_packed_size();
+
+	packbuf->head = NULL;
+	free_buf(packbuf);
+
+	_route_msg_relay_to_client(job, msg);
+}
+
+static void
+_relay_close(eio_obj_t *obj)
+{
+	struct relay_io_info *relay = (struct relay_io_info *) obj->arg;
+	slurmd_job_t *job = relay->job;
+	struct io_buf *msg;
+
+	if (relay->stdout_objs > 0 || relay->stderr_objs > 0) {
+		error("Lost stdio relay connection with %d stdout and "
+		      "%d stderr streams open",
+		      relay->stdout_objs, relay->stderr_objs);
+	}
+	for ( ; relay->stdout_objs > 0; relay->stdout_objs--)
+		_relay_send_eof(job, SLURM_IO_STDOUT);
+	for ( ; relay->stderr_objs > 0; relay->stderr_objs--)
+		_relay_send_eof(job, SLURM_IO_STDERR);
+
+	if (relay->out_msg != NULL) {
+		_free_incoming_msg(relay->out_msg, job);
+		relay->out_msg = NULL;
+	}
+	while ((msg = list_dequeue(relay->msg_queue)))
+		_free_incoming_msg(msg, job);
+
+	close(obj->fd);
+	obj->fd = -1;
+	relay->in_eof = true;
+	relay->out_eof = true;
+	job->io_relay_cnt--;
+	debug3("Stdio relay closed, %d remain open", job->io_relay_cnt);
+}
+
+static void
+_relay_create(int fd, slurmd_job_t *job, struct slurm_io_init_msg *init)
+{
+	struct relay_io_info *relay;
+	eio_obj_t *obj;
+
+	relay = xmalloc(sizeof(struct relay_io_info));
+#ifndef NDEBUG
+	relay->magic = RELAY_IO_MAGIC;
+#endif
+	relay->job = job;
+	relay->stdout_objs = init->stdout_objs;
+	relay->stderr_objs = init->stderr_objs;
+	/* No destructor, the queued messages are shared with other queues
+	 * and are returned to the job's free lists by _relay_close() */
+	relay->msg_queue = list_create(NULL);
+
+	_relay_node_init(job, init);
+
+	/* io_relay_cnt was already incremented when fd was accepted */
+	obj = eio_obj_create(fd, &relay_ops, (void *)relay);
+	list_append(job->io_relays, (void *)obj);
+	eio_new_obj(job->eio, (void *)obj);
+	debug3("Relaying stdio of node %u", init->nodeid);
+}
+
+/*
+ * Read what is available of a child's io init msg without blocking.
+ * RET 1 if the msg is complete, 0 if more is expected, -1 on error or if
+ * the child closed the connection first.
+ */
+static int
+_relay_init_recv(eio_obj_t *obj)
+{
+	struct relay_init_info *info = (struct relay_init_info *) obj->arg;
+	Buf buffer = info->buffer;
+	int n;
+
+again:
+	n = read(obj->fd, get_buf_data(buffer) + get_buf_offset(buffer),
+		 remaining_buf(buffer));
+	if (n < 0) {
+		if (errno == EINTR)
+			goto again;
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			return 0;
+		debug("stdio relay io init msg read: %m");
+		return -1;
+	}
+	if (n == 0)
+		return -1;
+	set_buf_offset(buffer, get_buf_offset(buffer) + n);
+	if (remaining_buf(buffer) > 0)
+		return 0;
+	return 1;
+}
+
+/*
+ * Stop reading a child's io init msg. If the msg is complete and valid,
+ * the connection becomes a relay, otherwise it is closed.
+ */
+static void
+_relay_init_done(eio_obj_t *obj, bool complete)
+{
+	struct relay_init_info *info = (struct relay_init_info *) obj->arg;
+	slurmd_job_t *job = info->job;
+	srun_info_t *srun = list_peek(job->sruns);
+	struct slurm_io_init_msg init;
+
+	if (complete) {
+		set_buf_offset(info->buffer, 0);
+		if ((io_init_msg_unpack(&init, info->buffer) != SLURM_SUCCESS)
+		    || (io_init_msg_validate(&init,
+					     (char *) srun->key->data) < 0))
+			complete = false;
+	}
+	free_buf(info->buffer);
+	info->buffer = NULL;
+
+	if (complete) {
+		_relay_create(obj->fd, job, &init);
+	} else {
+		error("Rejecting stdio relay connection");
+		close(obj->fd);
+		job->io_relay_cnt--;
+		/* Let the relay listening socket see the new count */
+		eio_signal_wakeup(job->eio);
+	}
+	obj->fd = -1;
+}
+
+static bool
+_relay_init_readable(eio_obj_t *obj)
+{
+	struct relay_init_info *info = (struct relay_init_info *) obj->arg;
+	int rc;
+
+	if (obj->fd == -1)
+		return false;
+	xassert(info->magic == RELAY_INIT_MAGIC);
+
+	/* A child writes its io init msg right after connecting, so once
+	 * the step's I/O is shutting down there is no point waiting for
+	 * the rest of it */
+	if (obj->shutdown || info->listen_obj->shutdown) {
+		rc = _relay_init_recv(obj);
+		_relay_init_done(obj, (rc == 1));
+		return false;
+	}
+	return true;
+}
+
+static int
+_relay_init_read(eio_obj_t *obj, List objs)
+{
+	int rc;
+
+	rc = _relay_init_recv(obj);
+	if (rc != 0)
+		_relay_init_done(obj, (rc == 1));
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Accept all pending connections from the children's slurmstepds. Their
+ * io init msg is read by a separate eio object for each connection, so
+ * that a connection which does not send it can not block the I/O thread.
+ */
+static void
+_relay_accept(eio_obj_t *listen_obj, slurmd_job_t *job)
+{
+	struct relay_init_info *info;
+	eio_obj_t *obj;
+	int sd;
+
+	while (1) {
+		if ((sd = accept(listen_obj->fd, NULL, NULL)) < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK) &&
+			    (errno != ECONNABORTED))
+				error("Unable to accept stdio relay: %m");
+			return;
+		}
+
+		fd_set_nonblocking(sd);
+		fd_set_close_on_exec(sd);
+
+		info = xmalloc(sizeof(struct relay_init_info));
+#ifndef NDEBUG
+		info->magic = RELAY_INIT_MAGIC;
+#endif
+		info->job = job;
+		info->listen_obj = listen_obj;
+		info->buffer = init_buf(io_init_msg_packed_size());
+
+		/* Counted as a relay so that the step's I/O does not
+		 * finish while the child's io init msg is expected */
+		job->io_relay_cnt++;
+		obj = eio_obj_create(sd, &relay_init_ops, (void *)info);
+		eio_new_obj(job->eio, (void *)obj);
+	}
+}
+
+static bool
+_relay_listen_readable(eio_obj_t *obj)
+{
+	slurmd_job_t *job = (slurmd_job_t *) obj->arg;
+
+	if (obj->fd == -1)
+		return false;
+
+	/* Keep accepting while any child is relaying through us, so that
+	 * late children are not refused while we still run anyway */
+	if (obj->shutdown && job->io_relay_cnt == 0) {
+		_relay_accept(obj, job);
+		if (job->io_relay_cnt == 0) {
+			debug3("Closing stdio relay socket");
+			job->io_relay_port = 0;
+			close(obj->fd);
+			obj->fd = -1;
+			return false;
+		}
+	}
+	return true;
+}
+
+static int
+_relay_listen_read(eio_obj_t *obj, List objs)
+{
+	_relay_accept(obj, (slurmd_job_t *) obj->arg);
+	return SLURM_SUCCESS;
+}
+
+static bool
+_relay_readable(eio_obj_t *obj)
+{
+	struct relay_io_info *relay = (struct relay_io_info *) obj->arg;
+
+	xassert(relay->magic == RELAY_IO_MAGIC);
+
+	/* Unlike a client, a child is read until it closes the connection,
+	 * even after shutdown, so that none of its output is lost */
+	if (relay->in_eof)
+		return false;
+
+	if (relay->in_msg != NULL || _outgoing_buf_free(relay->job))
+		return true;
+
+	return false;
+}
+
+/*
+ * Read a framed message from a child and pass it on unchanged.
+ */
+static int
+_relay_read(eio_obj_t *obj, List objs)
+{
+	struct relay_io_info *relay = (struct relay_io_info *) obj->arg;
+	slurmd_job_t *job = relay->job;
+	struct slurm_io_init_msg init;
+	Buf packbuf;
+	void *buf;
+	int n;
+
+	xassert(relay->magic == RELAY_IO_MAGIC);
+
+	/*
+	 * Read the header, if a message read is not already in progress
+	 */
+	if (relay->in_msg == NULL) {
+		if (!_outgoing_buf_free(job))
+			return SLURM_SUCCESS;
+		relay->in_msg = list_dequeue(job->free_outgoing);
+		n = io_hdr_read_fd(obj->fd, &relay->header);
+		if ((n > 0) && (relay->header.length > MAX_MSG_LEN)) {
+			error("Relayed message length of %u exceeds maximum "
+			      "of %u", relay->header.length, MAX_MSG_LEN);
+			n = -1;
+		}
+		if (n <= 0) { /* got eof or fatal error */
+			list_enqueue(job->free_outgoing, relay->in_msg);
+			relay->in_msg = NULL;
+			_relay_close(obj);
+			return SLURM_SUCCESS;
+		}
+
+		/* The message is passed on with its header */
+		packbuf = create_buf(relay->in_msg->data, io_hdr_packed_size());
+		if (!packbuf)
+			fatal("Failure to allocate memory for a message "
+			      "header");
+		io_hdr_pack(&relay->header, packbuf);
+		packbuf->head = NULL;
+		free_buf(packbuf);
+		relay->in_msg->length = io_hdr_packed_size() +
+					relay->header.length;
+		relay->in_remaining = relay->header.length;
+	}
+
+	/*
+	 * Read the body
+	 */
+	if (relay->in_remaining > 0) {
+		buf = relay->in_msg->data +
+			(relay->in_msg->length - relay->in_remaining);
+	again:
+		if ((n = read(obj->fd, buf, relay->in_remaining)) < 0) {
+			if (errno == EINTR)
+				goto again;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return SLURM_SUCCESS;
+			debug5("  error in _relay_read: %m");
+		}
+		if (n <= 0) { /* got eof (or unhandled error) */
+			list_enqueue(job->free_outgoing, relay->in_msg);
+			relay->in_msg = NULL;
+			_relay_close(obj);
+			return SLURM_SUCCESS;
+		}
+		relay->in_remaining -= n;
+		if (relay->in_remaining > 0)
+			return SLURM_SUCCESS;
+	}
+
+	/*
+	 * Account for the streams of the subtree before passing it on
+	 */
+	if (relay->header.type == SLURM_IO_NODE_INIT) {
+		packbuf = create_buf(relay->in_msg->data + io_hdr_packed_size(),
+				     relay->header.length);
+		if (packbuf && (io_init_msg_unpack(&init, packbuf) ==
+				SLURM_SUCCESS)) {
+			relay->stdout_objs += init.stdout_objs;
+			relay->stderr_objs += init.stderr_objs;
+		}
+		if (packbuf) {
+			packbuf->head = NULL;
+			free_buf(packbuf);
+		}
+	} else if (relay->header.length == 0) {
+		if (relay->header.type == SLURM_IO_STDOUT)
+			relay->stdout_objs--;
+		else if (relay->header.type == SLURM_IO_STDERR)
+			relay->stderr_objs--;
+	}
+
+	_route_msg_relay_to_client(job, relay->in_msg);
+	relay->in_msg = NULL;
+	return SLURM_SUCCESS;
+}
+
+static bool
+_relay_writable(eio_obj_t *obj)
+{
+	struct relay_io_info *relay = (struct relay_io_info *) obj->arg;
+
+	xassert(relay->magic == RELAY_IO_MAGIC);
+
+	if (relay->out_eof)
+		return false;
+
+	if (relay->out_msg != NULL || !list_is_empty(relay->msg_queue))
+		return true;
+
+	return false;
+}
+
+/*
+ * Write stdin and connection test messages to a child.
+ */
+static int
+_relay_write(eio_obj_t *obj, List objs)
+{
+	struct relay_io_info *relay = (struct relay_io_info *) obj->arg;
+	struct io_buf *msg;
+	void *buf;
+	int n;
+
+	xassert(relay->magic == RELAY_IO_MAGIC);
+
+	if (relay->out_msg == NULL) {
+		relay->out_msg = list_dequeue(relay->msg_queue);
+		if (relay->out_msg == NULL)
+			return SLURM_SUCCESS;
+		relay->out_remaining = relay->out_msg->length;
+	}
+
+	buf = relay->out_msg->data +
+		(relay->out_msg->length - relay->out_remaining);
+again:
+	if ((n = write(obj->fd, buf, relay->out_remaining)) < 0) {
+		if (errno == EINTR) {
+			goto again;
+		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+			return SLURM_SUCCESS;
+		} else {
+			/* The read side sees the failure as well */
+			debug("Stdio relay write failed: %m");
+			relay->out_eof = true;
+			_free_incoming_msg(relay->out_msg, relay->job);
+			relay->out_msg = NULL;
+			while ((msg = list_dequeue(relay->msg_queue)))
+				_free_incoming_msg(msg, relay->job);
+			return SLURM_SUCCESS;
+		}
+	}
+	relay->out_remaining -= n;
+	if (relay->out_remaining > 0)
+		return SLURM_SUCCESS;
+
+	_free_incoming_msg(relay->out_msg, relay->job);
+	relay->out_msg = NULL;
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Copy a message read by a client, whose buffer holds only the body, into
+ * a framed message queued for every child.
+ */
+static void
+_route_msg_client_to_relays(slurmd_job_t *job,
+			    struct slurm_io_header *header,
+			    struct io_buf *in_msg)
+{
+	struct relay_io_info *relay;
+	struct io_buf *msg;
+	eio_obj_t *eio;
+	ListIterator relays;
+	Buf packbuf;
+
+	if (job->io_relay_cnt == 0)
+		return;
+
+	if (_incoming_buf_free(job))
+		msg = list_dequeue(job->free_incoming);
+	else
+		msg = alloc_io_buf();
+
+	packbuf = create_buf(msg->data, io_hdr_packed_size());
+	if (!packbuf)
+		fatal("Failure to allocate memory for a message header");
+	io_hdr_pack(header, packbuf);
+	packbuf->head = NULL;
+	free_buf(packbuf);
+	if (header->length)
+		memcpy(msg->data + io_hdr_packed_size(), in_msg->data,
+		       header->length);
+	msg->length = io_hdr_packed_size() + header->length;
+	msg->ref_count = 0;
+
+	relays = list_iterator_create(job->io_relays);
+	if (!relays)
+		fatal("Could not allocate iterator");
+	while ((eio = list_next(relays))) {
+		relay = (struct relay_io_info *)eio->arg;
+		xassert(relay->magic == RELAY_IO_MAGIC);
+		if (relay->out_eof)
+			continue;
+		if (list_enqueue(relay->msg_queue, msg))
+			msg->ref_count++;
+	}
+	list_iterator_destroy(relays);
+
+	if (msg->ref_count == 0)
+		list_enqueue(job->free_incoming, msg);
+}
+
+/*
+ * Queue a framed message from a child for the client that this slurmstepd
+ * itself sends its output to. It is neither cached nor sent to attached
+ * clients, which get the child's output from the child.
+ */
+static void
+_route_msg_relay_to_client(slurmd_job_t *job, struct io_buf *msg)
+{
+	struct client_io_info *client;
+
+	msg->ref_count = 1;
+	if (job->io_uplink) {
+		client = (struct client_io_info *)job->io_uplink->arg;
+		xassert(client->magic == CLIENT_IO_MAGIC);
+		if (!client->out_eof) {
+			list_enqueue(client->msg_queue, msg);
+			return;
+		}
+	}
+	_free_outgoing_msg(msg, job);
+}
+
+/* True once all of the local tasks' output has been queued and no child
+ * relays through this slurmstepd any more */
+static bool
+_io_output_done(slurmd_job_t *job)
+{
+	struct task_read_info *out;
+	ListIterator objs;
+	eio_obj_t *eio;
+	bool done = true;
+	int i;
+
+	if (job->io_relay_cnt > 0)
+		return false;
+
+	for (i = 0; (i < 2) && done; i++) {
+		objs = list_iterator_create(i ? job->stderr_eio_objs :
+						job->stdout_eio_objs);
+		if (!objs)
+			fatal("Could not allocate iterator");
+		while ((eio = list_next(objs))) {
+			out = (struct task_read_info *)eio->arg;
+			if (!out->eof_msg_sent) {
+				done = false;
+				break;
+			}
+		}
+		list_iterator_destroy(objs);
+	}
+	return done;
+}
+
 /**********************************************************************
  * Pseudo terminal functions
  **********************************************************************/
@@ -1228,7 +1939,7 @@ _build_connection_okay_message(slurmd_job_t *job)
 
 	header.type = SLURM_IO_CONNECTION_TEST;
 	header.ltaskid = 0;  /* Unused */
-	header.gtaskid = 0;  /* Unused */
+	header.gtaskid = job->nodeid;  /* Tested node, for tree I/O */
 	header.length = 0;
 
 	packbuf = create_buf(msg->data, io_hdr_packed_size());
@@ -1518,8 +2229,6 @@ io_initial_client_connect(srun_info_t *srun, slurmd_job_t *job,
 			  int stdout_tasks, int stderr_tasks)
 {
 	int sock = -1;
-	struct client_io_info *client;
-	eio_obj_t *obj;
 
 	debug4 ("adding IO connection (logical node rank %d)", job->nodeid);
 
@@ -1542,9 +2251,29 @@ io_initial_client_connect(srun_info_t *srun, slurmd_job_t *job,
 		return SLURM_ERROR;
 	}
 
+	return _add_initial_client(sock, srun, job, stdout_tasks, stderr_tasks,
+				   false);
+}
+
+/*
+ * Set up the eio object of the first client on a connected socket.
+ * A relay of the parent slurmstepd must get our io init msg; srun would
+ * notice the lost connection itself.
+ */
+static int
+_add_initial_client(int sock, srun_info_t *srun, slurmd_job_t *job,
+		    int stdout_tasks, int stderr_tasks, bool to_parent)
+{
+	struct client_io_info *client;
+	eio_obj_t *obj;
+
 	fd_set_blocking(sock);  /* just in case... */
 
-	_send_io_init_msg(sock, srun->key, job);
+	if ((_send_io_init_msg(sock, srun->key, job) != SLURM_SUCCESS) &&
+	    to_parent) {
+		close(sock);
+		return SLURM_ERROR;
+	}
 
 	debug5("  back from _send_io_init_msg");
 	fd_set_nonblocking(sock);
@@ -1563,15 +2292,120 @@ io_initial_client_connect(srun_info_t *srun, slurmd_job_t *job,
 	client->labelio = false;
 	client->label_width = 0;
 	client->is_local_file = false;
+	client->to_parent = to_parent;
 
 	obj = eio_obj_create(sock, &client_ops, (void *)client);
 	list_append(job->clients, (void *)obj);
 	eio_new_initial_obj(job->eio, (void *)obj);
+	job->io_uplink = obj;
 	debug5("Now handling %d IO Client object(s)", list_count(job->clients));
 
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Ask the parent's slurmd for the port of the parent slurmstepd's relay,
+ * waiting a little for that slurmstepd to start. Returns 0 if none.
+ */
+static uint16_t
+_get_parent_relay_port(slurmd_job_t *job, slurm_addr_t *addr)
+{
+	slurm_msg_t req, resp;
+	job_step_id_msg_t msg;
+	uint16_t port = 0;
+	int i, rc;
+
+	memset(&msg, 0, sizeof(job_step_id_msg_t));
+	msg.job_id = job->jobid;
+	msg.step_id = job->stepid;
+
+	for (i = 0; (i < IO_RELAY_RETRIES) && (port == 0); i++) {
+		if (i)
+			usleep(IO_RELAY_RETRY_USEC);
+		slurm_msg_t_init(&req);
+		slurm_msg_t_init(&resp);
+		req.msg_type = REQUEST_IO_RELAY_PORT;
+		req.data = &msg;
+		req.address = *addr;
+
+		if (slurm_send_recv_node_msg(&req, &resp, 0) < 0) {
+			debug("Unable to get stdio relay port of parent: %m");
+			break;
+		}
+		if (resp.auth_cred)
+			g_slurm_auth_destroy(resp.auth_cred);
+		if (resp.msg_type == RESPONSE_IO_RELAY_PORT) {
+			rc = ((return_code_msg_t *) resp.data)->return_code;
+			if ((rc > 0) && (rc <= 0xffff))
+				port = (uint16_t) rc;
+		} else {
+			/* an older slurmd, tree I/O is not possible */
+			i = IO_RELAY_RETRIES;
+		}
+		slurm_free_msg_data(resp.msg_type, resp.data);
+	}
+
+	return port;
+}
+
+int
+io_parent_client_connect(srun_info_t *srun, slurmd_job_t *job,
+			 int stdout_tasks, int stderr_tasks)
+{
+	slurm_addr_t addr;
+	uint16_t port;
+	int rank, parent_rank, sock;
+
+	slurm_mutex_lock(&step_complete.lock);
+	rank = step_complete.rank;
+	parent_rank = step_complete.parent_rank;
+	addr = step_complete.parent_addr;
+	slurm_mutex_unlock(&step_complete.lock);
+
+	if ((rank <= 0) || (parent_rank < 0))
+		return SLURM_ERROR;
+
+	if ((port = _get_parent_relay_port(job, &addr)) == 0) {
+		debug("No stdio relay at rank %d, connecting IO directly",
+		      parent_rank);
+		return SLURM_ERROR;
+	}
+
+	addr.sin_port = htons(port);
+	if ((sock = (int) slurm_open_stream(&addr)) < 0) {
+		error("connect io to rank %d: %m", parent_rank);
+		return SLURM_ERROR;
+	}
+	debug4("connected IO to relay of rank %d", parent_rank);
+
+	return _add_initial_client(sock, srun, job, stdout_tasks, stderr_tasks,
+				   true);
+}
+
+int
+io_relay_listen(slurmd_job_t *job)
+{
+	eio_obj_t *obj;
+	short port;
+	int fd;
+
+	if (net_stream_listen(&fd, &port) < 0) {
+		error("Unable to create stdio relay socket: %m");
+		return SLURM_ERROR;
+	}
+	fd_set_nonblocking(fd);
+	fd_set_close_on_exec(fd);
+
+	job->io_relays = list_create(NULL);
+	obj = eio_obj_create(fd, &relay_listen_ops, (void *)job);
+	eio_new_initial_obj(job->eio, (void *)obj);
+	job->io_relay_port = (uint16_t) port;
+	debug3("Relaying stdio of child nodes on port %hu",
+	       job->io_relay_port);
+
+	return SLURM_SUCCESS;
+}
+
 /*
  * Initiate a TCP connection back to a waiting client (e.g. srun).
  *
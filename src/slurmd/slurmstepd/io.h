@@ -87,6 +87,23 @@ void free_io_buf(struct io_buf *buf);
 int io_initial_client_connect(srun_info_t *srun, slurmd_job_t *job, 
 			      int stdout_tasks, int stderr_tasks);
 
+/*
+ * Like io_initial_client_connect, but connect to the stdio relay of the
+ * parent slurmstepd in the step's reverse tree (TASK_IO_TREE). Fails if
+ * this node has no parent or the parent offers no relay, in which case
+ * the caller should connect to srun directly.
+ */
+int io_parent_client_connect(srun_info_t *srun, slurmd_job_t *job,
+			     int stdout_tasks, int stderr_tasks);
+
+/*
+ * Listen for the stdio connections of this slurmstepd's children in the
+ * step's reverse tree and relay their I/O (TASK_IO_TREE). The port is
+ * kept in job->io_relay_port for the children to ask slurmd for.
+ * Must be called before the IO engine is started.
+ */
+int io_relay_listen(slurmd_job_t *job);
+
 /* 
  * Initiate a TCP connection back to a waiting client (e.g. srun).
  *
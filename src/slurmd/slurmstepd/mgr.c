@@ -545,6 +545,20 @@ _setup_normal_io(slurmd_job_t *job)
 			}
 		}
 
+		/* With tree I/O, relay the children's stdio and send our own
+		 * through the parent slurmstepd, falling back to srun */
+		if (job->task_flags & TASK_IO_TREE) {
+			slurm_mutex_lock(&step_complete.lock);
+			ii = step_complete.children;
+			slurm_mutex_unlock(&step_complete.lock);
+			if ((ii > 0) && (io_relay_listen(job) < 0))
+				error("Unable to relay stdio of child nodes");
+			if (io_parent_client_connect(srun, job,
+						     srun_stdout_tasks,
+						     srun_stderr_tasks) == 0)
+				goto claim;
+		}
+
 		if(io_initial_client_connect(srun, job, srun_stdout_tasks,
 					     srun_stderr_tasks) < 0) {
 			rc = ESLURMD_IO_ERROR;
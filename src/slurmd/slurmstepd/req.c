@@ -88,6 +88,7 @@ static int _handle_stat_jobacct(int fd, slurmd_job_t *job, uid_t uid);
 static int _handle_task_info(int fd, slurmd_job_t *job);
 static int _handle_list_pids(int fd, slurmd_job_t *job);
 static int _handle_reconfig(int fd, slurmd_job_t *job, uid_t uid);
+static int _handle_io_relay_port(int fd, slurmd_job_t *job);
 static bool _msg_socket_readable(eio_obj_t *obj);
 static int _msg_socket_accept(eio_obj_t *obj, List objs);
 
@@ -539,6 +540,10 @@ _handle_request(int fd, slurmd_job_t *job, uid_t uid, gid_t gid)
 		debug("Handling REQUEST_JOB_NOTIFY");
 		rc = _handle_notify_job(fd, job, uid);
 		break;
+	case REQUEST_STEP_IO_RELAY_PORT:
+		debug("Handling REQUEST_STEP_IO_RELAY_PORT");
+		rc = _handle_io_relay_port(fd, job);
+		break;
 	default:
 		error("Unrecognized request: %d", req);
 		rc = SLURM_FAILURE;
@@ -1144,6 +1149,16 @@ rwfail:
 	return SLURM_FAILURE;
 }
 
+static int
+_handle_io_relay_port(int fd, slurmd_job_t *job)
+{
+	safe_write(fd, &job->io_relay_port, sizeof(uint16_t));
+
+	return SLURM_SUCCESS;
+rwfail:
+	return SLURM_FAILURE;
+}
+
 static int
 _handle_suspend(int fd, slurmd_job_t *job, uid_t uid)
 {
@@ -173,6 +173,16 @@ typedef struct slurmd_job {
 	List outgoing_cache;  /* cache of outgoing stdio messages
 			       * used when a new client attaches
 			       */
+	eio_obj_t *io_uplink; /* client connected to srun, or to the
+			       * parent slurmstepd with TASK_IO_TREE
+			       */
+	List io_relays;       /* List of eio_obj_t for the slurmstepds
+			       * relaying stdio through this one
+			       */
+	int io_relay_cnt;     /* Count of io_relays not yet closed, and
+			       * of connections awaiting their io init msg
+			       */
+	uint16_t io_relay_port; /* port accepting io_relays, 0 if none */
 
 	uint8_t	buffered_stdio; /* stdio buffering flag, 1 for line-buffering,
 				 * 0 for no buffering
@@ -171,12 +171,16 @@ _print_job ( bool clear_old )
 {
 	static job_info_msg_t * old_job_ptr = NULL, * new_job_ptr;
 	int error_code;
-	uint16_t show_flags = 0;
-	uint32_t job_id = 0;
+	uint16_t show_flags = 0, delta_flag = 0;
+	uint32_t job_id = 0, user_id = NO_VAL;
 
 	if (params.all_flag || (params.job_list && list_count(params.job_list)))
 		show_flags |= SHOW_ALL;
 
+	/* Transfer only changed jobs when polling */
+	if (params.iterate)
+		delta_flag = SHOW_DELTA;
+
 	/* We require detail data when CPUs are requested */
 	if (params.format && strstr(params.format, "C"))
 		show_flags |= SHOW_DETAIL;
@@ -188,6 +192,14 @@ _print_job ( bool clear_old )
 		job_id_ptr = list_next(iterator);
 		job_id = *job_id_ptr;
 		list_iterator_destroy(iterator);
+	} else if (params.user_list && (list_count(params.user_list) == 1)) {
+		/* load only this user's jobs */
+		ListIterator iterator;
+		uint32_t *user_id_ptr;
+		iterator = list_iterator_create(params.user_list);
+		user_id_ptr = list_next(iterator);
+		user_id = *user_id_ptr;
+		list_iterator_destroy(iterator);
 	}
 
 	if (old_job_ptr) {
@@ -197,10 +209,14 @@ _print_job ( bool clear_old )
 			error_code = slurm_load_job(
 				&new_job_ptr, job_id,
 				show_flags);
+		} else if (user_id != NO_VAL) {
+			error_code = slurm_load_job_user(
+				&new_job_ptr, user_id, NULL,
+				show_flags);
 		} else {
 			error_code = slurm_load_jobs(
 				old_job_ptr->last_update,
-				&new_job_ptr, show_flags);
+				&new_job_ptr, show_flags | delta_flag);
 		}
 		if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
@@ -210,9 +226,12 @@ _print_job ( bool clear_old )
 		}
 	} else if (job_id) {
 		error_code = slurm_load_job(&new_job_ptr, job_id, show_flags);
+	} else if (user_id != NO_VAL) {
+		error_code = slurm_load_job_user(&new_job_ptr, user_id, NULL,
+						 show_flags);
 	} else {
 		error_code = slurm_load_jobs((time_t) NULL, &new_job_ptr,
-					     show_flags);
+					     show_flags | delta_flag);
 	}
 
 	if (error_code) {
@@ -220,7 +239,7 @@ _print_job ( bool clear_old )
 		return SLURM_ERROR;
 	}
 	old_job_ptr = new_job_ptr;
-	if (job_id)
+	if (job_id || (user_id != NO_VAL))
 		old_job_ptr->last_update = (time_t) 0;
 
 	if (params.verbose) {
@@ -183,6 +183,7 @@
 #define LONG_OPT_GRES            0x151
 #define LONG_OPT_ALPS            0x152
 #define LONG_OPT_REQ_SWITCH      0x153
+#define LONG_OPT_IO_TREE         0x154
 
 extern char **environ;
 
@@ -378,6 +379,7 @@ static void _opt_default()
 
 	opt.labelio = false;
 	opt.unbuffered = false;
+	opt.io_tree = false;
 	opt.overcommit = false;
 	opt.shared = (uint16_t)NO_VAL;
 	opt.exclusive = false;
@@ -788,6 +790,7 @@ static void set_options(const int argc, char **argv)
 		{"help",             no_argument,       0, LONG_OPT_HELP},
 		{"hint",             required_argument, 0, LONG_OPT_HINT},
 		{"ioload-image",     required_argument, 0, LONG_OPT_RAMDISK_IMAGE},
+		{"io-tree",          no_argument,       0, LONG_OPT_IO_TREE},
 		{"jobid",            required_argument, 0, LONG_OPT_JOBID},
 		{"linux-image",      required_argument, 0, LONG_OPT_LINUX_IMAGE},
 		{"mail-type",        required_argument, 0, LONG_OPT_MAIL_TYPE},
@@ -1482,6 +1485,9 @@ static void set_options(const int argc, char **argv)
 			opt.req_switch = _get_int(optarg, "switches",
 				true);
 			break;
+		case LONG_OPT_IO_TREE:
+			opt.io_tree = true;
+			break;
 		default:
 			if (spank_process_option (opt_char, optarg) < 0) {
 				exit(error_exit);
@@ -2323,6 +2329,7 @@ static void _opt_list(void)
 		info("immediate      : %d secs", (opt.immediate - 1));
 	info("label output   : %s", tf_(opt.labelio));
 	info("unbuffered IO  : %s", tf_(opt.unbuffered));
+	info("tree IO        : %s", tf_(opt.io_tree));
 	info("overcommit     : %s", tf_(opt.overcommit));
 	info("threads        : %d", opt.max_threads);
 	if (opt.time_limit == INFINITE)
@@ -2481,6 +2488,8 @@ static void _help(void)
 "  -H, --hold                  submit job in held state\n"
 "  -i, --input=in              location of stdin redirection\n"
 "  -I, --immediate[=secs]      exit if resources not available in \"secs\"\n"
+"      --io-tree               forward stdout/err through other nodes of the\n"
+"                              step rather than directly to srun\n"
 "      --jobid=id              run under already allocated job\n"
 "  -J, --job-name=jobname      name of job\n"
 "  -k, --no-kill               do not kill job on node failure\n"
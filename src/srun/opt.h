@@ -158,6 +158,7 @@ typedef struct srun_options {
 	bool hold;		/* --hold, -H			*/
 	bool labelio;		/* --label-output, -l		*/
 	bool unbuffered;        /* --unbuffered,   -u           */
+	bool io_tree;		/* --io-tree			*/
 	bool allocate;		/* --allocate, 	   -A		*/
 	bool noshell;		/* --no-shell                   */
 	bool overcommit;	/* --overcommit,   -O		*/
@@ -458,6 +458,7 @@ int srun(int ac, char **av)
 	launch_params.slurmd_debug = opt.slurmd_debug;
 	launch_params.buffered_stdio = !opt.unbuffered;
 	launch_params.labelio = opt.labelio ? true : false;
+	launch_params.io_tree = opt.io_tree;
 	launch_params.remote_output_filename =fname_remote_string(job->ofname);
 	launch_params.remote_input_filename = fname_remote_string(job->ifname);
 	launch_params.remote_error_filename = fname_remote_string(job->efname);
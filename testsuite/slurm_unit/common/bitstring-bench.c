@@ -0,0 +1,184 @@
+/*****************************************************************************\
+ *  bitstring-bench.c - micro-benchmark of src/common/bitstring.c primitives
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://www.schedmd.com/slurmdocs/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Usage: bitstring-bench [SCALE]
+ *
+ * Times each bitstring primitive on bitmaps of 1k to 200k bits and reports
+ * the mean nanoseconds per call. Every primitive processes roughly the same
+ * number of bits (SCALE million, default 64) at each size. The "copy+..."
+ * and "not+and+not" rows time the multi-call sequences that bit_overlap()
+ * and bit_and_not() replace. The "sparse" rows use a bitmap allocated by
+ * bit_alloc_sparse() with the same single bit set as the "b3" operand.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "src/common/bitstring.h"
+
+#define BENCH_SIZES	4
+
+static int bench_size[BENCH_SIZES] = { 1000, 10000, 50000, 200000 };
+static volatile int sink;	/* keeps results from being optimized away */
+
+static bitstr_t *b1, *b2, *b3, *s3;
+static char fmt_buf[64];
+
+static void _set_count(void)	{ sink += bit_set_count(b1); }
+static void _ffs(void)		{ sink += bit_ffs(b3); }
+static void _fls(void)		{ sink += bit_fls(b3); }
+static void _ffc(void)		{ sink += bit_ffc(b2); }
+static void _nffc(void)		{ sink += bit_nffc(b2, 64); }
+static void _nset_max(void)	{ sink += bit_nset_max_count(b2); }
+static void _and(void)		{ bit_and(b1, b2); }
+static void _or(void)		{ bit_or(b1, b2); }
+static void _and_not(void)	{ bit_and_not(b1, b3); }
+static void _super_set(void)	{ sink += bit_super_set(b3, b2); }
+static void _equal(void)	{ sink += bit_equal(b2, b2); }
+static void _overlap(void)	{ sink += bit_overlap(b1, b2); }
+static void _overlap_any(void)	{ sink += bit_overlap_any(b1, b3); }
+static void _get_bit_num(void)	{ sink += bit_get_bit_num(b3, 0); }
+static void _fmt(void)		{ bit_fmt(fmt_buf, sizeof(fmt_buf), b3); }
+static void _s_ffs(void)	{ sink += bit_ffs(s3); }
+static void _s_fls(void)	{ sink += bit_fls(s3); }
+static void _s_set_count(void)	{ sink += bit_set_count(s3); }
+static void _s_overlap(void)	{ sink += bit_overlap(s3, b2); }
+static void _s_and(void)	{ bit_and(s3, b2); }
+static void _s_fmt(void)	{ bit_fmt(fmt_buf, sizeof(fmt_buf), s3); }
+
+static void _copy_and_count(void)
+{
+	bitstr_t *tmp = bit_copy(b1);
+
+	bit_and(tmp, b2);
+	sink += bit_set_count(tmp);
+	bit_free(tmp);
+}
+
+static void _not_and_not(void)
+{
+	bit_not(b3);
+	bit_and(b1, b3);
+	bit_not(b3);
+}
+
+static struct {
+	char *name;
+	void (*func)(void);
+} bench[] = {
+	{ "bit_set_count",	_set_count },
+	{ "bit_ffs",		_ffs },
+	{ "bit_fls",		_fls },
+	{ "bit_ffc",		_ffc },
+	{ "bit_nffc",		_nffc },
+	{ "bit_nset_max_count",	_nset_max },
+	{ "bit_and",		_and },
+	{ "bit_or",		_or },
+	{ "bit_and_not",	_and_not },
+	{ "not+and+not",	_not_and_not },
+	{ "bit_super_set",	_super_set },
+	{ "bit_equal",		_equal },
+	{ "bit_overlap",	_overlap },
+	{ "copy+and+count",	_copy_and_count },
+	{ "bit_overlap_any",	_overlap_any },
+	{ "bit_get_bit_num",	_get_bit_num },
+	{ "bit_fmt",		_fmt },
+	{ "sparse bit_ffs",	_s_ffs },
+	{ "sparse bit_fls",	_s_fls },
+	{ "sparse set_count",	_s_set_count },
+	{ "sparse overlap",	_s_overlap },
+	{ "sparse bit_and",	_s_and },
+	{ "sparse bit_fmt",	_s_fmt },
+	{ NULL, NULL }
+};
+
+/* Build the operands for nbits: b1 is dense, b2 has all but its last bit
+ * set, b3 and s3 have only their middle bit set */
+static void _setup(int nbits)
+{
+	int i;
+
+	b1 = bit_alloc(nbits);
+	b2 = bit_alloc(nbits);
+	b3 = bit_alloc(nbits);
+	s3 = bit_alloc_sparse(nbits);
+	if (!b1 || !b2 || !b3 || !s3) {
+		fprintf(stderr, "bit_alloc failure\n");
+		exit(1);
+	}
+	for (i = 0; i < nbits; i += 3)
+		bit_set(b1, i);
+	bit_nset(b2, 0, nbits - 2);
+	bit_set(b3, nbits / 2);
+	bit_set(s3, nbits / 2);
+}
+
+static void _teardown(void)
+{
+	bit_free(b1);
+	bit_free(b2);
+	bit_free(b3);
+	bit_free(s3);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct timeval tv1, tv2;
+	double usec;
+	long scale = 64, iters;
+	int i, j, k;
+
+	if (argc > 1)
+		scale = strtol(argv[1], NULL, 10);
+	if (scale < 1)
+		scale = 1;
+
+	printf("%-20s", "ns/call");
+	for (j = 0; j < BENCH_SIZES; j++)
+		printf("%12d", bench_size[j]);
+	printf("\n");
+
+	for (i = 0; bench[i].name; i++) {
+		printf("%-20s", bench[i].name);
+		for (j = 0; j < BENCH_SIZES; j++) {
+			_setup(bench_size[j]);
+			iters = (scale * 1000000) / bench_size[j];
+			bench[i].func();	/* warm the cache */
+			gettimeofday(&tv1, NULL);
+			for (k = 0; k < iters; k++)
+				bench[i].func();
+			gettimeofday(&tv2, NULL);
+			usec = (tv2.tv_sec - tv1.tv_sec) * 1000000.0 +
+			       (tv2.tv_usec - tv1.tv_usec);
+			printf("%12.1f", usec * 1000.0 / iters);
+			_teardown();
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -179,6 +179,106 @@ main(int argc, char *argv[])
 		bit_free(bs);
 	}
 
+	note("Testing word boundaries");
+	{
+		bitstr_t *bs1 = bit_alloc(1000);
+		bitstr_t *bs2 = bit_alloc(1000);
+		int inx[1000], i;
+
+		for (i = 0; i < 1000; i++)
+			inx[i] = 1;
+		TEST(bit_ffs(bs1) == -1, "ffs empty");
+		TEST(bit_fls(bs1) == -1, "fls empty");
+		bit_not(bs1);	/* also sets unused bits of last word */
+		TEST(bit_set_count(bs1) == 1000, "not count");
+		TEST(bit_ffc(bs1) == -1, "ffc full");
+		TEST(bit_fls(bs1) == 999, "fls full");
+		TEST(bit_nset_max_count(bs1) == 1000, "nset_max_count full");
+		TEST(int_and_set_count(inx, 1000, bs1) == 1000, "int_and");
+		bit_clear(bs1, 999);
+		TEST(bit_fls(bs1) == 998, "fls");
+		TEST(bit_ffc(bs1) == 999, "ffc");
+		TEST(bit_nffs(bs1, 999) == 0, "nffs");
+
+		bit_set(bs2, 63);
+		bit_set(bs2, 64);
+		bit_set(bs2, 640);
+		TEST(bit_super_set(bs2, bs1), "super_set");
+		TEST(!bit_super_set(bs1, bs2), "super_set");
+		TEST(bit_overlap(bs1, bs2) == 3, "overlap");
+		TEST(bit_overlap_any(bs1, bs2), "overlap_any");
+		TEST(bit_get_bit_num(bs2, 2) == 640, "get_bit_num");
+		TEST(bit_get_pos_num(bs2, 640) == 2, "get_pos_num");
+
+		bit_and_not(bs1, bs2);
+		TEST(bit_set_count(bs1) == 996, "and_not");
+		TEST(!bit_test(bs1, 640), "and_not");
+		TEST(bit_set_count(bs2) == 3, "and_not source");
+		TEST(!bit_overlap_any(bs1, bs2), "overlap_any");
+		TEST(bit_overlap(bs1, bs2) == 0, "overlap");
+
+		bit_nclear(bs1, 0, 998);
+		bit_set(bs1, 997);
+		bit_set(bs1, 998);
+		TEST(bit_nffs(bs1, 2) == 997, "nffs at end");
+		TEST(bit_nffc(bs1, 997) == 0, "nffc");
+		bit_free(bs1);
+		bit_free(bs2);
+	}
+
+	note("Testing sparse bitstrings");
+	{
+		bitstr_t *bs1 = bit_alloc_sparse(100000);
+		bitstr_t *bs2 = bit_alloc(100000);
+		bitstr_t *bs3;
+		char tmpstr[1024];
+
+		TEST(bit_ffs(bs1) == -1, "sparse ffs empty");
+		TEST(bit_fls(bs1) == -1, "sparse fls empty");
+		bit_set(bs1, 40000);
+		bit_set(bs1, 70001);
+		bit_nset(bs1, 90000, 90099);
+		TEST(bit_ffs(bs1) == 40000, "sparse ffs");
+		TEST(bit_fls(bs1) == 90099, "sparse fls");
+		TEST(bit_ffs_from_bit(bs1, 40001) == 70001, "sparse ffs_from");
+		TEST(bit_set_count(bs1) == 102, "sparse count");
+		TEST(bit_get_bit_num(bs1, 2) == 90000, "sparse get_bit_num");
+		TEST(!strcmp(bit_fmt(tmpstr, sizeof(tmpstr), bs1),
+			     "40000,70001,90000-90099"), "sparse fmt");
+
+		bit_nset(bs2, 60000, 99999);
+		TEST(bit_overlap(bs1, bs2) == 101, "sparse overlap");
+		TEST(bit_overlap_any(bs2, bs1), "sparse overlap_any");
+		TEST(!bit_super_set(bs1, bs2), "sparse super_set");
+		bs3 = bit_copy(bs1);
+		bit_and(bs3, bs2);
+		TEST(bit_ffs(bs3) == 70001, "sparse and");
+		TEST(bit_set_count(bs3) == 101, "sparse and");
+		TEST(bit_super_set(bs3, bs2), "sparse super_set");
+		bit_and_not(bs3, bs2);
+		TEST(bit_ffs(bs3) == -1, "sparse and_not");
+
+		bit_clear(bs1, 40000);
+		bit_nclear(bs1, 90000, 90099);
+		TEST(bit_ffs(bs1) == 70001, "sparse clear");
+		TEST(bit_fls(bs1) == 70001, "sparse clear");
+		bit_copybits(bs3, bs2);
+		TEST(bit_ffs(bs3) == 60000, "sparse copybits");
+		bit_not(bs3);
+		TEST(bit_fls(bs3) == 59999, "sparse not");
+		bit_nclear(bs3, 0, 99999);
+		bit_or(bs3, bs1);
+		TEST(bit_equal(bs3, bs1), "sparse or");
+		bs3 = bit_realloc(bs3, 200000);
+		bit_set(bs3, 199999);
+		TEST(bit_set_count(bs3) == 2, "sparse realloc");
+		TEST(bit_fls(bs3) == 199999, "sparse realloc");
+
+		bit_free(bs1);
+		bit_free(bs2);
+		bit_free(bs3);
+	}
+
 	note("Testing bit_unfmt");
 	{
 		bitstr_t *bs = bit_alloc(1024);
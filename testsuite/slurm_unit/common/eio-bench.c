@@ -0,0 +1,177 @@
+/*****************************************************************************\
+ *  eio-bench.c - micro-benchmark of the src/common/eio.c event loop
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://www.schedmd.com/slurmdocs/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Usage: eio-bench [EVENTS]
+ *
+ * Times eio_handle_mainloop() with 100 to 10k objects, each reading a
+ * socket, and reports the mean nanoseconds per dispatched event for the
+ * poll() and (where available) epoll backends. A single byte is passed
+ * around the ring of objects, so one object is ready at a time while all
+ * of them are waited for, as with the stdio connections of a large job
+ * step. The two ends of a socketpair are two objects. Each run dispatches
+ * EVENTS events (default 100000). Without epoll support both rows time
+ * poll().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "src/common/eio.h"
+#include "src/common/fd.h"
+#include "src/common/log.h"
+
+#define BENCH_SIZES	3
+
+static int bench_size[BENCH_SIZES] = { 100, 1000, 10000 };
+
+static int *sfd;		/* socket of each object */
+static int nobjs;
+static long events, max_events;
+
+static bool _readable(eio_obj_t *obj)
+{
+	return (events < max_events);
+}
+
+/* Take the token and pass it on to the next object */
+static int _read(eio_obj_t *obj, List objs)
+{
+	int i = (int) (long) obj->arg;
+	char c;
+
+	if (read(obj->fd, &c, 1) != 1)
+		return SLURM_SUCCESS;
+	events++;
+	/* the peer of the next object's socket makes it readable */
+	if (write(sfd[((i + 1) % nobjs) ^ 1], &c, 1) != 1) {
+		fprintf(stderr, "write failure\n");
+		exit(1);
+	}
+	return SLURM_SUCCESS;
+}
+
+static struct io_operations bench_ops = {
+	.readable	= _readable,
+	.handle_read	= _read,
+};
+
+/* Return ns per event, or a negative value if the sockets can't be made.
+ * "size" must be even. */
+static double _run(int size, bool use_poll)
+{
+	eio_handle_t *eio;
+	struct timeval tv1, tv2;
+	double usec;
+	int i;
+	char c = 0;
+
+	nobjs = size;
+	sfd = malloc(size * sizeof(int));
+	eio = eio_handle_create();
+	if (!sfd || !eio) {
+		fprintf(stderr, "allocation failure\n");
+		exit(1);
+	}
+	if (use_poll)
+		eio_handle_use_poll(eio);
+
+	for (i = 0; i < size; i += 2) {
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, &sfd[i]) < 0) {
+			while (--i >= 0)
+				close(sfd[i]);
+			usec = -1.0;
+			goto fini;
+		}
+	}
+	for (i = 0; i < size; i++) {
+		fd_set_nonblocking(sfd[i]);
+		eio_new_initial_obj(eio, eio_obj_create(sfd[i], &bench_ops,
+							(void *) (long) i));
+	}
+
+	events = 0;
+	if (write(sfd[1], &c, 1) != 1) {
+		fprintf(stderr, "write failure\n");
+		exit(1);
+	}
+	gettimeofday(&tv1, NULL);
+	eio_handle_mainloop(eio);
+	gettimeofday(&tv2, NULL);
+	usec = (tv2.tv_sec - tv1.tv_sec) * 1000000.0 +
+	       (tv2.tv_usec - tv1.tv_usec);
+
+	for (i = 0; i < size; i++)
+		close(sfd[i]);
+fini:
+	eio_handle_destroy(eio);
+	free(sfd);
+	return usec * 1000.0 / max_events;
+}
+
+int
+main(int argc, char *argv[])
+{
+	log_options_t opts = LOG_OPTS_STDERR_ONLY;
+	struct rlimit rlim;
+	double ns;
+	int i, j;
+
+	log_init("eio-bench", opts, 0, NULL);
+
+	max_events = 100000;
+	if (argc > 1)
+		max_events = strtol(argv[1], NULL, 10);
+	if (max_events < 1)
+		max_events = 1;
+
+	/* One fd per object */
+	if (getrlimit(RLIMIT_NOFILE, &rlim) == 0) {
+		rlim.rlim_cur = rlim.rlim_max;
+		(void) setrlimit(RLIMIT_NOFILE, &rlim);
+	}
+
+	printf("%-20s", "ns/event");
+	for (j = 0; j < BENCH_SIZES; j++)
+		printf("%12d", bench_size[j]);
+	printf("\n");
+
+	for (i = 0; i < 2; i++) {
+		printf("%-20s", i ? "epoll" : "poll");
+		for (j = 0; j < BENCH_SIZES; j++) {
+			ns = _run(bench_size[j], i == 0);
+			if (ns < 0)
+				printf("%12s", "no fds");
+			else
+				printf("%12.1f", ns);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+/* Test of src/plugins/select/cons_res/job_test.c
+ */
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <src/common/bitstring.h>
+#include <src/plugins/select/cons_res/select_cons_res.h>
+
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NODE_CNT 4
+
+/* Not static in job_test.c, but not exported by its header */
+extern bitstr_t *_make_core_bitmap(bitstr_t *node_map);
+
+/* Stubs for the rest of the select/cons_res plugin and slurmctld */
+uint32_t select_debug_flags = 0;
+uint16_t select_fast_schedule = 0;
+struct node_res_record *select_node_record = NULL;
+
+/* Nodes with 1, 3, 2 and 4 cores */
+static uint32_t core_offset[NODE_CNT + 1] = { 0, 1, 4, 6, 10 };
+
+extern uint32_t cr_get_coremap_offset(uint32_t node_index)
+{
+	return core_offset[node_index];
+}
+
+extern void cr_sort_part_rows(struct part_res_record *p_ptr)
+{
+}
+
+int cr_dist(struct job_record *job_ptr, const uint16_t cr_type)
+{
+	return SLURM_SUCCESS;
+}
+
+extern int drain_nodes(char *nodes, char *reason, uint32_t reason_uid)
+{
+	return SLURM_SUCCESS;
+}
+
+/* Return true if exactly the cores of the nodes in node_map are set */
+static bool _cores_match(bitstr_t *core_map, bitstr_t *node_map)
+{
+	int n, c;
+
+	if (bit_size(core_map) != core_offset[NODE_CNT])
+		return false;
+	for (n = 0; n < NODE_CNT; n++) {
+		for (c = core_offset[n]; c < core_offset[n + 1]; c++) {
+			if (bit_test(core_map, c) != bit_test(node_map, n))
+				return false;
+		}
+	}
+	return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+	bitstr_t *node_map = bit_alloc(NODE_CNT), *core_map;
+
+	note("Testing _make_core_bitmap");
+
+	core_map = _make_core_bitmap(node_map);
+	TEST(core_map && (bit_set_count(core_map) == 0),
+	     "no nodes, no cores");
+	bit_free(core_map);
+
+	bit_set(node_map, 2);
+	core_map = _make_core_bitmap(node_map);
+	TEST(core_map && _cores_match(core_map, node_map),
+	     "cores of preceding unselected nodes not set");
+	bit_free(core_map);
+
+	bit_set(node_map, 0);
+	bit_set(node_map, 3);
+	core_map = _make_core_bitmap(node_map);
+	TEST(core_map && _cores_match(core_map, node_map),
+	     "cores of first and last nodes set");
+	bit_free(core_map);
+
+	bit_nset(node_map, 0, NODE_CNT - 1);
+	core_map = _make_core_bitmap(node_map);
+	TEST(core_map && (bit_set_count(core_map) == core_offset[NODE_CNT]),
+	     "all nodes, all cores");
+	bit_free(core_map);
+
+	bit_free(node_map);
+	totals();
+	return failed;
+}
@@ -0,0 +1,90 @@
+/* Test of src/slurmctld/job_journal.c
+ */
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <src/common/pack.h>
+#include <src/slurmctld/job_journal.h>
+
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define JOB_CNT 3
+
+/* Pack JOB_CNT job records, the last field of the second job is last32 */
+static void _pack_jobs(Buf buffer, job_state_rec_t *recs, uint32_t last32)
+{
+	int i;
+
+	for (i = 0; i < JOB_CNT; i++) {
+		job_journal_rec_begin(buffer, &recs[i], 100 + i);
+		pack32(100 + i, buffer);
+		packstr("job name", buffer);
+		pack32((i == 1) ? last32 : 0, buffer);
+		job_journal_rec_end(buffer, &recs[i]);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	Buf old_buf = init_buf(0), new_buf = init_buf(0), journal;
+	job_state_rec_t old_recs[JOB_CNT], new_recs[JOB_CNT];
+	uint32_t upd_cnt, del_cnt, rec_size;
+	uint16_t rec_type;
+
+	_pack_jobs(old_buf, old_recs, 1);
+	_pack_jobs(new_buf, new_recs, 2);
+
+	set_buf_offset(new_buf, 0);
+	unpack32(&rec_size, new_buf);
+	TEST(rec_size == new_recs[0].size, "record size prefix");
+	TEST(new_recs[0].offset == sizeof(uint32_t), "record offset");
+	TEST(new_recs[1].size == old_recs[1].size, "records same size");
+	TEST(new_recs[0].hash == old_recs[0].hash, "same record, same hash");
+	TEST(new_recs[1].hash != old_recs[1].hash,
+	     "last field changed, hash changed");
+
+	note("Testing unchanged jobs");
+	journal = init_buf(0);
+	job_journal_pack(journal, old_buf, old_recs, JOB_CNT,
+			 old_recs, JOB_CNT, 1, &upd_cnt, &del_cnt);
+	TEST((upd_cnt == 0) && (del_cnt == 0), "no journal records");
+	TEST(get_buf_offset(journal) == 0, "empty journal");
+	free_buf(journal);
+
+	note("Testing change of the last packed field");
+	journal = init_buf(0);
+	job_journal_pack(journal, new_buf, new_recs, JOB_CNT,
+			 old_recs, JOB_CNT, 1, &upd_cnt, &del_cnt);
+	TEST((upd_cnt == 1) && (del_cnt == 0), "one update record");
+	set_buf_offset(journal, sizeof(uint32_t));
+	unpack16(&rec_type, journal);
+	TEST(rec_type == JOB_JOURNAL_UPDATE, "update record type");
+	free_buf(journal);
+
+	note("Testing removed and new jobs");
+	journal = init_buf(0);
+	job_journal_pack(journal, new_buf, new_recs + 1, JOB_CNT - 1,
+			 old_recs, JOB_CNT - 1, 1, &upd_cnt, &del_cnt);
+	TEST((upd_cnt == 2) && (del_cnt == 1),
+	     "two update records, one delete record");
+	free_buf(journal);
+
+	free_buf(old_buf);
+	free_buf(new_buf);
+	totals();
+	return failed;
+}